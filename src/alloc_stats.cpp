@@ -0,0 +1,83 @@
+/**
+ * @file alloc_stats.cpp
+ * @brief 堆分配计数：全局 operator new/delete 转到 malloc/free，每次分配增加一个全局计数和一个线程计数
+ *        计数使用 relaxed 原子操作与线程局部变量，开销可以忽略，发布版本也保留
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+#include "alloc_stats.h"
+
+static std::atomic<uint64_t> s_total{0};
+static thread_local uint64_t s_thread_count = 0;
+
+static void *alloc_stats_alloc(std::size_t size){
+    s_total.fetch_add(1, std::memory_order_relaxed);
+    s_thread_count++;
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size){
+    void *p = alloc_stats_alloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size){
+    void *p = alloc_stats_alloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept{
+    return alloc_stats_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept{
+    return alloc_stats_alloc(size);
+}
+
+void operator delete(void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+extern "C"{
+
+uint64_t alloc_stats_total(void){
+    return s_total.load(std::memory_order_relaxed);
+}
+
+uint64_t alloc_stats_thread(void){
+    return s_thread_count;
+}
+
+}
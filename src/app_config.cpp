@@ -0,0 +1,45 @@
+/**
+ * @file app_config.cpp
+ * @brief rtt-shell 用户配置目录
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdlib>
+#include <string>
+#include <filesystem>
+#include <system_error>
+
+#include "app_config.h"
+
+namespace fs = std::filesystem;
+
+static std::string s_config_dir;
+
+extern "C"{
+
+const char *app_config_dir(void){
+    if(!s_config_dir.empty())
+        return s_config_dir.c_str();
+#if defined(_WIN32) || defined(_WIN64)
+    const char *base = std::getenv("APPDATA");
+    const char *name = "rtt-shell";
+#else
+    const char *base = std::getenv("HOME");
+    const char *name = ".rtt-shell";
+#endif
+    if(!base || !*base)
+        return nullptr;
+    fs::path dir = fs::path(base) / name;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if(!fs::is_directory(dir, ec))
+        return nullptr;
+    s_config_dir = dir.string();
+    return s_config_dir.c_str();
+}
+
+}
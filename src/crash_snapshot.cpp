@@ -0,0 +1,275 @@
+/**
+ * @file crash_snapshot.cpp
+ * @brief 崩溃快照：匹配到故障特征时暂停内核，读取寄存器与 ELF 中的 RAM 区域并生成 ELF core 文件
+ *        为了尽快释放内核(看门狗)，内核暂停期间只做大块内存读取，文件写入在释放内核之后进行
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+
+#include "jlink_api.h"
+#include "elf_file.h"
+#include "stream_pattern.h"
+#include "crash_snapshot.h"
+
+#define CRASH_SNAPSHOT_MAX_REGIONS      32
+#define CRASH_SNAPSHOT_CHUNK_SIZE       0x10000     // 单次 JLINK_ReadMemEx 的传输大小
+#define CRASH_SNAPSHOT_REG_NUM          17          // R0-R15 + xPSR
+#define CRASH_SNAPSHOT_SIGNAL           11          // core 文件中记录的信号(SIGSEGV)
+
+/* ARM Linux elf_prstatus 布局，gdb 依此解析 core 文件中的寄存器 */
+#define PRSTATUS_SIZE                   148
+#define PRSTATUS_CURSIG_OFFSET          12
+#define PRSTATUS_REG_OFFSET             72
+#define PRSTATUS_REG_NUM                18          // r0-r15, cpsr, orig_r0
+#define NOTE_NAME                       "CORE"
+#define NOTE_NAME_SIZE                  8           // "CORE\0" 按4字节对齐
+#define NT_PRSTATUS                     1
+
+struct snapshot_region{
+    struct elf_region region;
+    std::vector<uint8_t> data;
+};
+
+static struct elf_region s_regions[CRASH_SNAPSHOT_MAX_REGIONS];
+static int s_region_num = 0;
+static std::string s_out_dir;
+static crash_snapshot_action_t s_action = CRASH_SNAPSHOT_RESUME;
+/* RTT 线程、SWO 线程都会输入，每个通道独立匹配 */
+static stream_pattern_set_t *s_patterns = stream_pattern_set_create();
+static std::mutex s_mtx;
+static std::condition_variable s_cv;
+static bool s_req_stop = false;
+static bool s_triggered = false;
+static std::string s_trigger_reason;
+static std::thread *s_thread = nullptr;
+
+static void put_le32(uint8_t *p, uint32_t v){
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+    p[2] = uint8_t(v >> 16);
+    p[3] = uint8_t(v >> 24);
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+    return double(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()) / 1000.0;
+}
+
+/**
+ * @brief                   写 ELF core 文件：一个 PT_NOTE(NT_PRSTATUS) 加每个 RAM 区域一个 PT_LOAD
+ */
+static int core_file_write(const std::string &path, const uint32_t *regs, const std::vector<snapshot_region> &regions){
+    const uint32_t phnum = uint32_t(regions.size() + 1);
+    const uint32_t note_offset = uint32_t(sizeof(struct elf32_ehdr) + sizeof(struct elf32_phdr) * phnum);
+    const uint32_t note_size = 12 + NOTE_NAME_SIZE + PRSTATUS_SIZE;
+
+    struct elf32_ehdr ehdr = {};
+    std::memcpy(ehdr.e_ident, "\x7f" "ELF", 4);
+    ehdr.e_ident[4] = 1;        // ELFCLASS32
+    ehdr.e_ident[5] = 1;        // ELFDATA2LSB
+    ehdr.e_ident[6] = 1;        // EV_CURRENT
+    ehdr.e_type = ELF_ET_CORE;
+    ehdr.e_machine = ELF_EM_ARM;
+    ehdr.e_version = 1;
+    ehdr.e_phoff = sizeof(struct elf32_ehdr);
+    ehdr.e_ehsize = sizeof(struct elf32_ehdr);
+    ehdr.e_phentsize = sizeof(struct elf32_phdr);
+    ehdr.e_phnum = uint16_t(phnum);
+
+    std::vector<struct elf32_phdr> phdrs(phnum);
+    phdrs[0] = {};
+    phdrs[0].p_type = ELF_PT_NOTE;
+    phdrs[0].p_offset = note_offset;
+    phdrs[0].p_filesz = note_size;
+    uint32_t offset = note_offset + note_size;
+    for(size_t i = 0; i < regions.size(); i++){
+        struct elf32_phdr &phdr = phdrs[i + 1];
+        phdr = {};
+        phdr.p_type = ELF_PT_LOAD;
+        phdr.p_offset = offset;
+        phdr.p_vaddr = regions[i].region.addr;
+        phdr.p_paddr = regions[i].region.addr;
+        phdr.p_filesz = regions[i].region.size;
+        phdr.p_memsz = regions[i].region.size;
+        phdr.p_flags = ELF_PF_R | ELF_PF_W;
+        phdr.p_align = 1;
+        offset += regions[i].region.size;
+    }
+
+    uint8_t note[12 + NOTE_NAME_SIZE + PRSTATUS_SIZE] = {};
+    put_le32(note + 0, sizeof(NOTE_NAME));
+    put_le32(note + 4, PRSTATUS_SIZE);
+    put_le32(note + 8, NT_PRSTATUS);
+    std::memcpy(note + 12, NOTE_NAME, sizeof(NOTE_NAME));
+    uint8_t *prstatus = note + 12 + NOTE_NAME_SIZE;
+    put_le32(prstatus, CRASH_SNAPSHOT_SIGNAL);
+    prstatus[PRSTATUS_CURSIG_OFFSET] = CRASH_SNAPSHOT_SIGNAL;
+    for(int i = 0; i < CRASH_SNAPSHOT_REG_NUM; i++)
+        put_le32(prstatus + PRSTATUS_REG_OFFSET + i * 4, regs[i]);
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+        return -1;
+    file.write(reinterpret_cast<const char*>(&ehdr), sizeof(ehdr));
+    file.write(reinterpret_cast<const char*>(phdrs.data()), std::streamsize(phdrs.size() * sizeof(struct elf32_phdr)));
+    file.write(reinterpret_cast<const char*>(note), sizeof(note));
+    for(auto &region : regions)
+        file.write(reinterpret_cast<const char*>(region.data.data()), std::streamsize(region.data.size()));
+    return file.good() ? 0 : -1;
+}
+
+static void crash_snapshot_thread(void){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    while(true){
+        s_cv.wait(lck, []{ return s_triggered || s_req_stop; });
+        if(s_req_stop)
+            break;
+        std::string reason = s_trigger_reason;
+        lck.unlock();
+        crash_snapshot_capture(reason.c_str());
+        lck.lock();
+        s_triggered = false;
+    }
+}
+
+extern "C"{
+
+int crash_snapshot_start(const char *elf_path, const char *out_dir, crash_snapshot_action_t action){
+    elf_file_t *elf = elf_file_open(elf_path);
+    if(!elf){
+        std::printf("crash snapshot: open elf %s failed\n", elf_path);
+        return -1;
+    }
+    s_region_num = elf_file_ram_regions(elf, s_regions, CRASH_SNAPSHOT_MAX_REGIONS);
+    elf_file_close(elf);
+    if(s_region_num == 0){
+        std::printf("crash snapshot: no RAM region found in %s\n", elf_path);
+        return -1;
+    }
+    s_out_dir = out_dir ? out_dir : ".";
+    s_action = action;
+    s_req_stop = false;
+    s_triggered = false;
+    s_thread = new std::thread(crash_snapshot_thread);
+    return 0;
+}
+
+void crash_snapshot_stop(void){
+    if(s_thread){
+        {
+            std::lock_guard<std::mutex> lck(s_mtx);
+            s_req_stop = true;
+        }
+        s_cv.notify_one();
+        s_thread->join();
+        delete s_thread;
+        s_thread = nullptr;
+    }
+    stream_pattern_set_clear(s_patterns);
+}
+
+int crash_snapshot_add_pattern(const char *pattern){
+    return stream_pattern_set_add(s_patterns, pattern);
+}
+
+void crash_snapshot_feed(int channel, const char *data, size_t len){
+    if(!s_thread)
+        return;
+    if(stream_pattern_set_feed(s_patterns, channel, data, len) == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        if(s_triggered)
+            return;
+        s_triggered = true;
+        s_trigger_reason = "fault";
+    }
+    s_cv.notify_one();
+}
+
+int crash_snapshot_capture(const char *reason){
+    uint32_t reg_index[CRASH_SNAPSHOT_REG_NUM];
+    uint32_t regs[PRSTATUS_REG_NUM] = {};
+    uint8_t reg_status[CRASH_SNAPSHOT_REG_NUM];
+    std::vector<snapshot_region> regions(static_cast<size_t>(s_region_num));
+    size_t total = 0;
+    size_t failed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    if(JLINK_IsHalted() <= 0 && JLINK_Halt() != 0){
+        std::printf("crash snapshot: halt failed\r\n");
+        return -1;
+    }
+    auto halted = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < CRASH_SNAPSHOT_REG_NUM; i++)
+        reg_index[i] = JLINK_CM_REG_R0 + i;
+    if(JLINK_ReadRegs(reg_index, regs, reg_status, CRASH_SNAPSHOT_REG_NUM) < 0)
+        std::printf("crash snapshot: read registers failed\r\n");
+
+    for(int i = 0; i < s_region_num; i++){
+        snapshot_region &region = regions[size_t(i)];
+        region.region = s_regions[i];
+        region.data.assign(region.region.size, 0);
+        for(uint32_t off = 0; off < region.region.size; off += CRASH_SNAPSHOT_CHUNK_SIZE){
+            uint32_t len = std::min<uint32_t>(CRASH_SNAPSHOT_CHUNK_SIZE, region.region.size - off);
+            if(JLINK_ReadMemEx(region.region.addr + off, len, region.data.data() + off, 0) != int(len))
+                failed += len;
+        }
+        total += region.region.size;
+    }
+    auto read_done = std::chrono::steady_clock::now();
+
+    switch(s_action){
+        case CRASH_SNAPSHOT_RESUME:
+            JLINK_Go();
+            break;
+        case CRASH_SNAPSHOT_RESET:
+            JLINK_Reset();
+            JLINK_Go();
+            break;
+        case CRASH_SNAPSHOT_HALT:
+            break;
+    }
+    auto released = std::chrono::steady_clock::now();
+
+    char name[64];
+    std::time_t tt = std::time(nullptr);
+    std::tm bt;
+#if defined(_MSC_VER)
+    localtime_s(&bt, &tt);
+#else
+    localtime_r(&tt, &bt);
+#endif
+    std::strftime(name, sizeof(name), "core-%Y%m%d-%H%M%S", &bt);
+    std::string path = (std::filesystem::path(s_out_dir) / (std::string(name) + "-" + reason + ".elf")).string();
+    int ret = core_file_write(path, regs, regions);
+
+    double read_ms = elapsed_ms(halted, read_done);
+    std::printf("crash snapshot: %s, read %zu bytes in %.1f ms (%.1f KB/s)%s, halted for %.1f ms, pc=%#x\r\n",
+        reason, total, read_ms, read_ms > 0 ? double(total) / read_ms * 1000.0 / 1024.0 : 0.0,
+        failed ? ", some reads failed" : "", elapsed_ms(start, released), regs[JLINK_CM_REG_R15]);
+    if(ret < 0){
+        std::printf("crash snapshot: write %s failed\r\n", path.c_str());
+        return -1;
+    }
+    std::printf("crash snapshot: saved to %s\r\n", path.c_str());
+    return 0;
+}
+
+}
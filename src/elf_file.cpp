@@ -0,0 +1,173 @@
+/**
+ * @file elf_file.cpp
+ * @brief 固件 ELF 文件解析(32位小端)
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "mapped_file.h"
+#include "elf_file.h"
+
+#define ELF_CLASS_32            1
+#define ELF_DATA_LSB            1
+#define ELF_SHT_NOBITS          8
+
+struct elf_file{
+    mapped_file_t *mf;
+    const uint8_t *data;
+    size_t size;
+    struct elf32_ehdr ehdr;
+    std::vector<struct elf32_phdr> phdrs;
+    std::vector<struct elf32_shdr> shdrs;
+};
+
+/* 映射区域内的结构体不保证对齐，统一拷贝后使用 */
+template <typename T>
+static bool elf_read(const elf_file_t *elf, uint64_t offset, T *out){
+    if(offset + sizeof(T) > elf->size)
+        return false;
+    std::memcpy(out, elf->data + offset, sizeof(T));
+    return true;
+}
+
+static const char *elf_string(const elf_file_t *elf, const struct elf32_shdr &strtab, uint32_t offset){
+    if(strtab.sh_type == ELF_SHT_NOBITS || offset >= strtab.sh_size || 
+        uint64_t(strtab.sh_offset) + strtab.sh_size > elf->size)
+        return nullptr;
+    const char *str = reinterpret_cast<const char*>(elf->data + strtab.sh_offset + offset);
+    /* 确保字符串在节内结束 */
+    if(!std::memchr(str, '\0', strtab.sh_size - offset))
+        return nullptr;
+    return str;
+}
+
+extern "C"{
+
+elf_file_t *elf_file_open(const char *path){
+    mapped_file_t *mf = mapped_file_open(path);
+    if(!mf)
+        return nullptr;
+    elf_file_t *elf = new elf_file_t{};
+    elf->mf = mf;
+    elf->data = mapped_file_data(mf);
+    elf->size = mapped_file_size(mf);
+    if(!elf_read(elf, 0, &elf->ehdr) || std::memcmp(elf->ehdr.e_ident, "\x7f" "ELF", 4) != 0 ||
+        elf->ehdr.e_ident[4] != ELF_CLASS_32 || elf->ehdr.e_ident[5] != ELF_DATA_LSB){
+        elf_file_close(elf);
+        return nullptr;
+    }
+    for(uint32_t i = 0; i < elf->ehdr.e_phnum; i++){
+        struct elf32_phdr phdr;
+        if(!elf_read(elf, uint64_t(elf->ehdr.e_phoff) + uint64_t(i) * elf->ehdr.e_phentsize, &phdr))
+            break;
+        elf->phdrs.push_back(phdr);
+    }
+    for(uint32_t i = 0; i < elf->ehdr.e_shnum; i++){
+        struct elf32_shdr shdr;
+        if(!elf_read(elf, uint64_t(elf->ehdr.e_shoff) + uint64_t(i) * elf->ehdr.e_shentsize, &shdr))
+            break;
+        elf->shdrs.push_back(shdr);
+    }
+    return elf;
+}
+
+void elf_file_close(elf_file_t *elf){
+    if(!elf)
+        return;
+    mapped_file_close(elf->mf);
+    delete elf;
+}
+
+uint16_t elf_file_machine(const elf_file_t *elf){
+    return elf->ehdr.e_machine;
+}
+
+int elf_file_ram_regions(const elf_file_t *elf, struct elf_region *regions, int max){
+    std::vector<struct elf_region> list;
+    for(auto &phdr : elf->phdrs){
+        if(phdr.p_type != ELF_PT_LOAD || !(phdr.p_flags & ELF_PF_W) || phdr.p_memsz == 0)
+            continue;
+        list.push_back({phdr.p_vaddr, phdr.p_memsz});
+    }
+    std::sort(list.begin(), list.end(), [](const elf_region &a, const elf_region &b){ return a.addr < b.addr; });
+    int num = 0;
+    for(auto &region : list){
+        if(num > 0 && uint64_t(regions[num - 1].addr) + regions[num - 1].size >= region.addr){
+            uint64_t end = std::max(uint64_t(regions[num - 1].addr) + regions[num - 1].size, uint64_t(region.addr) + region.size);
+            regions[num - 1].size = uint32_t(end - regions[num - 1].addr);
+            continue;
+        }
+        if(num >= max)
+            break;
+        regions[num++] = region;
+    }
+    return num;
+}
+
+int elf_file_for_each_symbol(const elf_file_t *elf, void (*cb)(void *ctx, const struct elf_symbol *sym), void *ctx){
+    int num = 0;
+    for(auto &shdr : elf->shdrs){
+        if(shdr.sh_type != ELF_SHT_SYMTAB || shdr.sh_link >= elf->shdrs.size() || shdr.sh_entsize < sizeof(struct elf32_sym))
+            continue;
+        const struct elf32_shdr &strtab = elf->shdrs[shdr.sh_link];
+        for(uint32_t off = 0; off + sizeof(struct elf32_sym) <= shdr.sh_size; off += shdr.sh_entsize){
+            struct elf32_sym raw;
+            if(!elf_read(elf, uint64_t(shdr.sh_offset) + off, &raw))
+                break;
+            uint8_t type = ELF_ST_TYPE(raw.st_info);
+            if((type != ELF_STT_FUNC && type != ELF_STT_OBJECT) || raw.st_shndx == 0)
+                continue;
+            struct elf_symbol sym;
+            sym.name = elf_string(elf, strtab, raw.st_name);
+            if(!sym.name || !*sym.name)
+                continue;
+            sym.addr = type == ELF_STT_FUNC && elf->ehdr.e_machine == ELF_EM_ARM ? raw.st_value & ~1u : raw.st_value;
+            sym.size = raw.st_size;
+            sym.type = type;
+            cb(ctx, &sym);
+            num++;
+        }
+    }
+    return num;
+}
+
+int elf_file_find_symbol(const elf_file_t *elf, const char *name, struct elf_symbol *sym){
+    struct find_ctx{
+        const char *name;
+        struct elf_symbol *sym;
+        bool found;
+    } ctx = {name, sym, false};
+    elf_file_for_each_symbol(elf, [](void *arg, const struct elf_symbol *s){
+        find_ctx *c = static_cast<find_ctx*>(arg);
+        if(!c->found && std::strcmp(s->name, c->name) == 0){
+            *c->sym = *s;
+            c->found = true;
+        }
+    }, &ctx);
+    return ctx.found ? 0 : -1;
+}
+
+const uint8_t *elf_file_section(const elf_file_t *elf, const char *name, uint32_t *size){
+    if(elf->ehdr.e_shstrndx >= elf->shdrs.size())
+        return nullptr;
+    const struct elf32_shdr &shstrtab = elf->shdrs[elf->ehdr.e_shstrndx];
+    for(auto &shdr : elf->shdrs){
+        const char *section_name = elf_string(elf, shstrtab, shdr.sh_name);
+        if(!section_name || std::strcmp(section_name, name) != 0)
+            continue;
+        if(shdr.sh_type == ELF_SHT_NOBITS || uint64_t(shdr.sh_offset) + shdr.sh_size > elf->size)
+            return nullptr;
+        *size = shdr.sh_size;
+        return elf->data + shdr.sh_offset;
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,301 @@
+/**
+ * @file flight_recorder.cpp
+ * @brief 飞行记录仪：内存环形缓冲区保存最近的原始 RTT 数据，触发时导出前后一段时间的数据
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <csignal>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+
+#include "capture_file.h"
+#include "stream_pattern.h"
+#include "flight_recorder.h"
+
+#define FLIGHT_RECORDER_SIGNAL_POLL_MS      100
+#define FLIGHT_RECORDER_DUMP_CHUNK          0x10000     // 导出时每次持锁扫描和复制的字节数
+
+static const size_t s_record_header_size = sizeof(struct capture_record_header);
+
+/* 环形缓冲区，s_head/s_tail 为单调递增的字节位置，取模后得到缓冲区下标 */
+static std::vector<uint8_t> s_ring;
+static uint64_t s_head = 0;
+static uint64_t s_tail = 0;
+static std::mutex s_ring_mtx;
+
+/* RTT 线程、SWO 线程都会写入，每个通道独立匹配 */
+static stream_pattern_set_t *s_patterns = stream_pattern_set_create();
+static std::mutex s_mtx;
+static std::condition_variable s_cv;
+static bool s_req_stop = false;
+static bool s_triggered = false;
+static std::string s_trigger_reason;
+static uint64_t s_trigger_us = 0;
+static std::chrono::steady_clock::time_point s_trigger_time;
+static std::atomic<bool> s_signal_trigger{false};
+static uint64_t s_pre_us = 0;
+static uint64_t s_post_us = 0;
+static std::string s_dump_dir;
+static std::thread *s_thread = nullptr;
+
+static inline uint64_t now_us(void){
+    using namespace std::chrono;
+    return uint64_t(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+static void ring_copy_in(uint64_t pos, const void *src, size_t len){
+    size_t off = size_t(pos % s_ring.size());
+    size_t first = std::min(len, s_ring.size() - off);
+    std::memcpy(s_ring.data() + off, src, first);
+    if(first < len)
+        std::memcpy(s_ring.data(), static_cast<const uint8_t*>(src) + first, len - first);
+}
+
+static void ring_copy_out(uint64_t pos, void *dst, size_t len){
+    size_t off = size_t(pos % s_ring.size());
+    size_t first = std::min(len, s_ring.size() - off);
+    std::memcpy(dst, s_ring.data() + off, first);
+    if(first < len)
+        std::memcpy(static_cast<uint8_t*>(dst) + first, s_ring.data(), len - first);
+}
+
+#ifdef SIGUSR1
+static void flight_recorder_signal_handler(int sig){
+    (void)sig;
+    s_signal_trigger.store(true);
+}
+#endif
+
+/**
+ * @brief                   导出 [trigger - pre, trigger + post] 范围内的记录
+ *                          生成 .rttcap(带时间戳的记录) 与 .raw(原始数据拼接) 两个文件
+ */
+static void flight_recorder_dump(const std::string &reason, uint64_t trigger_us){
+    std::vector<uint8_t> records;
+    std::string raw;
+    std::vector<uint8_t> chunk(FLIGHT_RECORDER_DUMP_CHUNK);
+    uint64_t begin_us = trigger_us > s_pre_us ? trigger_us - s_pre_us : 0;
+    uint64_t end_us = trigger_us + s_post_us;
+    uint64_t pos, head;
+    uint64_t lost = 0;
+    {
+        std::lock_guard<std::mutex> lck(s_ring_mtx);
+        pos = s_tail;
+        head = s_head;
+    }
+    /* 每次持锁只扫描一块，写入不会被整个导出阻塞；位置单调递增，s_tail 越过 pos 说明这部分记录在复制前已被覆盖 */
+    while(pos < head){
+        size_t used = 0;
+        size_t scanned = 0;
+        size_t need = 0;
+        {
+            std::lock_guard<std::mutex> lck(s_ring_mtx);
+            if(pos < s_tail){
+                lost += s_tail - pos;
+                pos = s_tail;
+            }
+            while(pos < head && scanned < chunk.size()){
+                struct capture_record_header hdr;
+                ring_copy_out(pos, &hdr, s_record_header_size);
+                size_t record_size = s_record_header_size + hdr.len;
+                if(hdr.timestamp_us >= begin_us && hdr.timestamp_us <= end_us){
+                    if(used + record_size > chunk.size()){
+                        need = record_size;
+                        break;
+                    }
+                    ring_copy_out(pos, chunk.data() + used, record_size);
+                    used += record_size;
+                }
+                scanned += record_size;
+                pos += record_size;
+            }
+        }
+        /* 单条记录比块大时在锁外扩大后重新复制 */
+        if(used == 0 && need > chunk.size()){
+            chunk.resize(need);
+            continue;
+        }
+        for(size_t off = 0; off < used; ){
+            struct capture_record_header hdr;
+            std::memcpy(&hdr, chunk.data() + off, s_record_header_size);
+            size_t record_size = s_record_header_size + hdr.len;
+            records.insert(records.end(), chunk.begin() + std::ptrdiff_t(off), chunk.begin() + std::ptrdiff_t(off + record_size));
+            raw.append(reinterpret_cast<const char*>(chunk.data() + off + s_record_header_size), hdr.len);
+            off += record_size;
+        }
+    }
+    if(lost)
+        std::printf("flight recorder: %llu bytes were overwritten before they could be dumped\r\n", (unsigned long long)lost);
+
+    char name[64];
+    std::time_t tt = std::time_t(trigger_us / 1000000);
+    std::tm bt;
+#if defined(_MSC_VER)
+    localtime_s(&bt, &tt);
+#else
+    localtime_r(&tt, &bt);
+#endif
+    std::strftime(name, sizeof(name), "flight-%Y%m%d-%H%M%S", &bt);
+    std::filesystem::path base = std::filesystem::path(s_dump_dir) / (std::string(name) + "-" + reason);
+
+    struct capture_file_header file_hdr = {};
+    std::memcpy(file_hdr.magic, CAPTURE_FILE_MAGIC, CAPTURE_FILE_MAGIC_SIZE);
+    file_hdr.version = CAPTURE_FILE_VERSION;
+    std::ofstream cap(base.string() + ".rttcap", std::ios::out | std::ios::binary | std::ios::trunc);
+    std::ofstream raw_file(base.string() + ".raw", std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!cap.is_open() || !raw_file.is_open()){
+        std::printf("flight recorder: open %s failed\r\n", base.string().c_str());
+        return;
+    }
+    cap.write(reinterpret_cast<const char*>(&file_hdr), sizeof(file_hdr));
+    cap.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size()));
+    raw_file.write(raw.data(), std::streamsize(raw.size()));
+    std::printf("flight recorder: %s, dumped %zu bytes to %s.rttcap\r\n", reason.c_str(), raw.size(), base.string().c_str());
+}
+
+static void flight_recorder_thread(void){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    while(true){
+        s_cv.wait_for(lck, std::chrono::milliseconds(FLIGHT_RECORDER_SIGNAL_POLL_MS));
+        if(s_signal_trigger.exchange(false) && !s_triggered){
+            s_triggered = true;
+            s_trigger_reason = "signal";
+            s_trigger_us = now_us();
+            s_trigger_time = std::chrono::steady_clock::now();
+        }
+        if(!s_triggered){
+            if(s_req_stop)
+                break;
+            continue;
+        }
+        /* 等待触发后的数据记录完毕，退出时立即导出 */
+        auto deadline = s_trigger_time + std::chrono::microseconds(s_post_us);
+        s_cv.wait_until(lck, deadline, []{ return s_req_stop; });
+        std::string reason = s_trigger_reason;
+        uint64_t trigger_us = s_trigger_us;
+        lck.unlock();
+        flight_recorder_dump(reason, trigger_us);
+        lck.lock();
+        s_triggered = false;
+        if(s_req_stop)
+            break;
+    }
+}
+
+extern "C"{
+
+int flight_recorder_start(size_t size_mb, double pre_seconds, double post_seconds, const char *dump_dir){
+    if(size_mb == 0)
+        return -1;
+    try{
+        s_ring.assign(size_mb * 1024 * 1024, 0);
+    }catch(const std::bad_alloc &){
+        std::printf("flight recorder: allocate %zu MB failed\n", size_mb);
+        return -1;
+    }
+    s_head = 0;
+    s_tail = 0;
+    s_pre_us = uint64_t(pre_seconds * 1e6);
+    s_post_us = uint64_t(post_seconds * 1e6);
+    s_dump_dir = dump_dir ? dump_dir : ".";
+    s_req_stop = false;
+    s_triggered = false;
+    s_signal_trigger.store(false);
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, flight_recorder_signal_handler);
+#endif
+    s_thread = new std::thread(flight_recorder_thread);
+    return 0;
+}
+
+void flight_recorder_stop(void){
+    if(s_thread){
+        {
+            std::lock_guard<std::mutex> lck(s_mtx);
+            s_req_stop = true;
+        }
+        s_cv.notify_one();
+        s_thread->join();
+        delete s_thread;
+        s_thread = nullptr;
+    }
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, SIG_DFL);
+#endif
+    stream_pattern_set_clear(s_patterns);
+    s_ring.clear();
+    s_ring.shrink_to_fit();
+}
+
+int flight_recorder_add_pattern(const char *pattern){
+    return stream_pattern_set_add(s_patterns, pattern);
+}
+
+void flight_recorder_append(int channel, const char *data, size_t len){
+    if(s_ring.empty() || len == 0)
+        return;
+    struct capture_record_header hdr;
+    hdr.timestamp_us = now_us();
+    hdr.channel = uint16_t(channel);
+    hdr.flags = 0;
+
+    /* 单次数据超过整个缓冲区时只保留最后部分 */
+    const char *record_data = data;
+    size_t record_len = len;
+    if(record_len + s_record_header_size > s_ring.size()){
+        record_data += record_len - (s_ring.size() - s_record_header_size);
+        record_len = s_ring.size() - s_record_header_size;
+    }
+    hdr.len = uint32_t(record_len);
+    {
+        std::lock_guard<std::mutex> lck(s_ring_mtx);
+        while(s_head + s_record_header_size + record_len - s_tail > s_ring.size()){
+            struct capture_record_header old;
+            ring_copy_out(s_tail, &old, s_record_header_size);
+            s_tail += s_record_header_size + old.len;
+        }
+        ring_copy_in(s_head, &hdr, s_record_header_size);
+        ring_copy_in(s_head + s_record_header_size, record_data, record_len);
+        s_head += s_record_header_size + record_len;
+    }
+}
+
+void flight_recorder_write(int channel, const char *data, size_t len){
+    if(s_ring.empty() || len == 0)
+        return;
+    flight_recorder_append(channel, data, len);
+    if(stream_pattern_set_feed(s_patterns, channel, data, len) > 0)
+        flight_recorder_trigger("pattern");
+}
+
+void flight_recorder_trigger(const char *reason){
+    if(!s_thread)
+        return;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        if(s_triggered)
+            return;
+        s_triggered = true;
+        s_trigger_reason = reason;
+        s_trigger_us = now_us();
+        s_trigger_time = std::chrono::steady_clock::now();
+    }
+    s_cv.notify_one();
+}
+
+}
@@ -0,0 +1,137 @@
+/**
+ * @file hexdump.cpp
+ * @brief 二进制数据的十六进制行格式化(偏移、十六进制、ASCII)
+ *        整行且没有高亮时用 SSE2 一次转换 16 字节：半字节比较后加偏移得到字符，
+ *        再按 "xx " 的间隔重排；不足一行或有高亮的行逐字节输出
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HEXDUMP_USE_SSE2 1
+#endif
+
+#include "hexdump.h"
+
+#define HEXDUMP_HIGHLIGHT_ON        "\x1B[1;33m"
+#define HEXDUMP_HIGHLIGHT_OFF       "\x1B[0m"
+#define HEXDUMP_HEX_COLUMN_SIZE     (HEXDUMP_ROW_SIZE * 3)
+
+static const char s_hex_digits[] = "0123456789abcdef";
+
+static size_t hexdump_offset(char *out, uint64_t offset){
+    int digits = 8;
+    while(digits < 16 && (offset >> (digits * 4)))
+        digits++;
+    for(int i = digits - 1; i >= 0; i--){
+        out[i] = s_hex_digits[offset & 0xf];
+        offset >>= 4;
+    }
+    return size_t(digits);
+}
+
+#ifdef HEXDUMP_USE_SSE2
+static inline __m128i hexdump_nibble_ascii(__m128i nibble){
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(nibble, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibble, _mm_set1_epi8('0')), letter);
+}
+
+/**
+ * @brief                   整行 16 字节的十六进制列和 ASCII 列
+ */
+static char *hexdump_row_sse2(char *p, const uint8_t *row){
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+    __m128i hi = hexdump_nibble_ascii(_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)));
+    __m128i lo = hexdump_nibble_ascii(_mm_and_si128(v, _mm_set1_epi8(0x0f)));
+    __m128i first = _mm_unpacklo_epi8(hi, lo);
+    __m128i second = _mm_unpackhi_epi8(hi, lo);
+    char pairs[HEXDUMP_ROW_SIZE * 2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pairs), first);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pairs + 16), second);
+    for(int i = 0; i < HEXDUMP_ROW_SIZE; i++){
+        p[i * 3] = pairs[i * 2];
+        p[i * 3 + 1] = pairs[i * 2 + 1];
+        p[i * 3 + 2] = ' ';
+    }
+    p += HEXDUMP_HEX_COLUMN_SIZE;
+    *p++ = ' ';
+    *p++ = '|';
+    /* 0x20~0x7e 原样显示，其余显示为 '.'，有符号比较时 0x80 以上为负数 */
+    __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1f)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x7f)));
+    __m128i ascii = _mm_or_si128(_mm_and_si128(printable, v), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), ascii);
+    p += HEXDUMP_ROW_SIZE;
+    *p++ = '|';
+    return p;
+}
+
+static inline bool hexdump_row_equal(const uint8_t *row, const uint8_t *prev){
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff;
+}
+#endif
+
+static char *hexdump_highlight(char *p, bool *on, bool changed){
+    if(changed == *on)
+        return p;
+    *on = changed;
+    const char *seq = changed ? HEXDUMP_HIGHLIGHT_ON : HEXDUMP_HIGHLIGHT_OFF;
+    size_t len = std::strlen(seq);
+    std::memcpy(p, seq, len);
+    return p + len;
+}
+
+/**
+ * @brief                   逐字节输出，处理不足一行和与上一行不同的字节
+ */
+static char *hexdump_row_scalar(char *p, const uint8_t *row, size_t len, const uint8_t *prev){
+    bool on = false;
+    for(size_t i = 0; i < HEXDUMP_ROW_SIZE; i++){
+        if(i >= len){
+            p = hexdump_highlight(p, &on, false);
+            *p++ = ' ';
+            *p++ = ' ';
+            *p++ = ' ';
+            continue;
+        }
+        p = hexdump_highlight(p, &on, prev && row[i] != prev[i]);
+        *p++ = s_hex_digits[row[i] >> 4];
+        *p++ = s_hex_digits[row[i] & 0xf];
+        *p++ = ' ';
+    }
+    p = hexdump_highlight(p, &on, false);
+    *p++ = ' ';
+    *p++ = '|';
+    for(size_t i = 0; i < len; i++){
+        p = hexdump_highlight(p, &on, prev && row[i] != prev[i]);
+        *p++ = row[i] >= 0x20 && row[i] < 0x7f ? char(row[i]) : '.';
+    }
+    p = hexdump_highlight(p, &on, false);
+    *p++ = '|';
+    return p;
+}
+
+extern "C"{
+
+size_t hexdump_format_row(char *out, uint64_t offset, const uint8_t *row, size_t len, const uint8_t *prev){
+    char *p = out + hexdump_offset(out, offset);
+    *p++ = ' ';
+    *p++ = ' ';
+#ifdef HEXDUMP_USE_SSE2
+    if(len == HEXDUMP_ROW_SIZE && (!prev || hexdump_row_equal(row, prev))){
+        p = hexdump_row_sse2(p, row);
+        return size_t(p - out);
+    }
+#endif
+    p = hexdump_row_scalar(p, row, len, prev);
+    return size_t(p - out);
+}
+
+}
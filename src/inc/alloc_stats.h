@@ -0,0 +1,41 @@
+/**
+ * @file alloc_stats.h
+ * @brief 堆分配计数：替换全局 operator new，统计进程和当前线程的分配次数，用于检查接收处理路径是否有分配
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _ALLOC_STATS_H_
+#define _ALLOC_STATS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  进程启动以来所有线程 operator new 的次数
+ * @return uint64_t         分配次数
+ */
+extern uint64_t alloc_stats_total(void);
+
+/**
+ * @brief  当前线程 operator new 的次数，两次调用之差为其间本线程的分配次数
+ * @return uint64_t         分配次数
+ */
+extern uint64_t alloc_stats_thread(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _ALLOC_STATS_H_
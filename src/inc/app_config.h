@@ -0,0 +1,35 @@
+/**
+ * @file app_config.h
+ * @brief rtt-shell 用户配置目录
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _APP_CONFIG_H_
+#define _APP_CONFIG_H_
+
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  获取 rtt-shell 配置目录，不存在时自动创建
+ *         Linux/macOS: $HOME/.rtt-shell  Windows: %APPDATA%\rtt-shell
+ * @return const char*      目录路径, 获取失败返回 NULL
+ */
+extern const char *app_config_dir(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _APP_CONFIG_H_
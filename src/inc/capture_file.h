@@ -0,0 +1,47 @@
+/**
+ * @file capture_file.h
+ * @brief 原始 RTT 数据捕获文件格式(.rttcap)
+ *        文件头之后是连续的记录，每条记录为记录头加上 len 字节原始数据，所有字段为小端
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _CAPTURE_FILE_H_
+#define _CAPTURE_FILE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define CAPTURE_FILE_MAGIC          "RTTSHCAP"
+#define CAPTURE_FILE_MAGIC_SIZE     8
+#define CAPTURE_FILE_VERSION        1
+
+struct capture_file_header {
+    char magic[CAPTURE_FILE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct capture_record_header {
+    uint64_t timestamp_us;          ///< 接收时间，自 1970-01-01 起的微秒数
+    uint32_t len;                   ///< 数据长度
+    uint16_t channel;               ///< RTT 通道号
+    uint16_t flags;                 ///< 保留
+};
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _CAPTURE_FILE_H_
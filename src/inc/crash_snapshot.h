@@ -0,0 +1,74 @@
+/**
+ * @file crash_snapshot.h
+ * @brief 崩溃快照：匹配到故障特征时暂停内核，读取寄存器与 ELF 中的 RAM 区域并生成 ELF core 文件
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _CRASH_SNAPSHOT_H_
+#define _CRASH_SNAPSHOT_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief 快照完成后对目标的操作
+ */
+typedef enum {
+    CRASH_SNAPSHOT_RESUME = 0,      ///< 继续运行
+    CRASH_SNAPSHOT_RESET = 1,       ///< 复位后运行
+    CRASH_SNAPSHOT_HALT = 2,        ///< 保持暂停
+} crash_snapshot_action_t;
+
+/**
+ * @brief  启动崩溃快照功能
+ * @param  elf_path         固件 ELF 文件，用于获取 RAM 区域
+ * @param  out_dir          core 文件输出目录
+ * @param  action           快照完成后对目标的操作
+ * @return int              0 成功, -1 失败
+ */
+extern int crash_snapshot_start(const char *elf_path, const char *out_dir, crash_snapshot_action_t action);
+
+/**
+ * @brief  停止崩溃快照功能
+ */
+extern void crash_snapshot_stop(void);
+
+/**
+ * @brief  添加故障特征字符串，需在 start 之前调用
+ * @param  pattern          故障特征字符串，例如 "HardFault"
+ * @return int              0 成功, -1 失败
+ */
+extern int crash_snapshot_add_pattern(const char *pattern);
+
+/**
+ * @brief  输入接收数据进行故障特征匹配，匹配后由快照线程立即执行快照
+ * @param  channel          输入通道(RTT 通道号或 SWO_CHANNEL_BASE + 端口)，每个通道独立匹配
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void crash_snapshot_feed(int channel, const char *data, size_t len);
+
+/**
+ * @brief  同步执行一次快照
+ * @param  reason           快照原因，写入 core 文件名
+ * @return int              0 成功, -1 失败
+ */
+extern int crash_snapshot_capture(const char *reason);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _CRASH_SNAPSHOT_H_
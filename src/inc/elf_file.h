@@ -0,0 +1,161 @@
+/**
+ * @file elf_file.h
+ * @brief 固件 ELF 文件解析(32位小端)
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _ELF_FILE_H_
+#define _ELF_FILE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define ELF_ET_CORE             4
+#define ELF_EM_ARM              40
+#define ELF_PT_LOAD             1
+#define ELF_PT_NOTE             4
+#define ELF_PF_X                1
+#define ELF_PF_W                2
+#define ELF_PF_R                4
+#define ELF_SHT_SYMTAB          2
+#define ELF_STT_OBJECT          1
+#define ELF_STT_FUNC            2
+#define ELF_ST_TYPE(info)       ((info) & 0x0f)
+
+struct elf32_ehdr {
+    uint8_t  e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+struct elf32_phdr {
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+};
+
+struct elf32_shdr {
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint32_t sh_flags;
+    uint32_t sh_addr;
+    uint32_t sh_offset;
+    uint32_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint32_t sh_addralign;
+    uint32_t sh_entsize;
+};
+
+struct elf32_sym {
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    uint8_t  st_info;
+    uint8_t  st_other;
+    uint16_t st_shndx;
+};
+
+struct elf_region {
+    uint32_t addr;
+    uint32_t size;
+};
+
+struct elf_symbol {
+    const char *name;               ///< 指向映射区域内的字符串表，ELF 关闭后失效
+    uint32_t addr;                  ///< 地址，Thumb 函数已去掉最低位
+    uint32_t size;
+    uint8_t type;                   ///< ELF_STT_*
+};
+
+typedef struct elf_file elf_file_t;
+
+/**
+ * @brief  打开并映射 ELF 文件
+ * @param  path             ELF 文件路径
+ * @return elf_file_t*      ELF 对象, 不是有效的32位小端 ELF 时返回NULL
+ */
+extern elf_file_t *elf_file_open(const char *path);
+
+/**
+ * @brief  关闭 ELF 文件
+ * @param  elf              ELF 对象
+ */
+extern void elf_file_close(elf_file_t *elf);
+
+/**
+ * @brief  获取 ELF 的机器类型
+ * @param  elf              ELF 对象
+ * @return uint16_t         e_machine
+ */
+extern uint16_t elf_file_machine(const elf_file_t *elf);
+
+/**
+ * @brief  获取 ELF 中可写的 PT_LOAD 段(即 RAM 区域)，相邻或重叠的段会被合并
+ * @param  elf              ELF 对象
+ * @param  regions          输出区域数组
+ * @param  max              数组大小
+ * @return int              区域数量
+ */
+extern int elf_file_ram_regions(const elf_file_t *elf, struct elf_region *regions, int max);
+
+/**
+ * @brief  遍历符号表中的函数与数据对象符号
+ * @param  elf              ELF 对象
+ * @param  cb               回调函数
+ * @param  ctx              回调上下文
+ * @return int              遍历的符号数量
+ */
+extern int elf_file_for_each_symbol(const elf_file_t *elf, void (*cb)(void *ctx, const struct elf_symbol *sym), void *ctx);
+
+/**
+ * @brief  按名字查找符号
+ * @param  elf              ELF 对象
+ * @param  name             符号名
+ * @param  sym              输出符号信息
+ * @return int              0 找到, -1 未找到
+ */
+extern int elf_file_find_symbol(const elf_file_t *elf, const char *name, struct elf_symbol *sym);
+
+/**
+ * @brief  按名字获取节内容
+ * @param  elf              ELF 对象
+ * @param  name             节名，例如 ".debug_line"
+ * @param  size             输出节大小
+ * @return const uint8_t*   节内容(映射区域内), 不存在时返回NULL
+ */
+extern const uint8_t *elf_file_section(const elf_file_t *elf, const char *name, uint32_t *size);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _ELF_FILE_H_
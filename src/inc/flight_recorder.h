@@ -0,0 +1,74 @@
+/**
+ * @file flight_recorder.h
+ * @brief 飞行记录仪：内存环形缓冲区保存最近的原始 RTT 数据，触发时导出前后一段时间的数据
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _FLIGHT_RECORDER_H_
+#define _FLIGHT_RECORDER_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  启动飞行记录仪，预分配环形缓冲区并启动导出线程
+ *         POSIX 平台上同时注册 SIGUSR1 作为触发信号
+ * @param  size_mb          环形缓冲区大小(MB)
+ * @param  pre_seconds      导出触发前多少秒的数据
+ * @param  post_seconds     触发后继续记录多少秒再导出
+ * @param  dump_dir         导出目录
+ * @return int              0 成功, -1 失败
+ */
+extern int flight_recorder_start(size_t size_mb, double pre_seconds, double post_seconds, const char *dump_dir);
+
+/**
+ * @brief  停止飞行记录仪，有未完成的触发时立即导出
+ */
+extern void flight_recorder_stop(void);
+
+/**
+ * @brief  添加触发字符串，接收数据中出现该字符串时触发导出，需在 start 之前调用
+ * @param  pattern          触发字符串
+ * @return int              0 成功, -1 失败
+ */
+extern int flight_recorder_add_pattern(const char *pattern);
+
+/**
+ * @brief  记录一段接收数据，稳态下只有一次 memcpy，不产生系统调用
+ * @param  channel          RTT 通道号，触发字符串在每个通道中独立匹配
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void flight_recorder_write(int channel, const char *data, size_t len);
+
+/**
+ * @brief  只记录一段数据，不匹配触发字符串，用于插件输出的二进制记录
+ * @param  channel          通道号
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void flight_recorder_append(int channel, const char *data, size_t len);
+
+/**
+ * @brief  手动触发导出(热键、断开连接等)
+ * @param  reason           触发原因，写入导出文件名
+ */
+extern void flight_recorder_trigger(const char *reason);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _FLIGHT_RECORDER_H_
@@ -0,0 +1,44 @@
+/**
+ * @file hexdump.h
+ * @brief 二进制数据的十六进制行格式化(偏移、十六进制、ASCII)
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _HEXDUMP_H_
+#define _HEXDUMP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define HEXDUMP_ROW_SIZE            16          // 每行字节数
+#define HEXDUMP_LINE_SIZE_MAX       512         // 一行格式化后的最大长度，包括高亮的转义序列
+
+/**
+ * @brief  格式化一行: "偏移  xx xx .. xx  |ASCII|"，不含换行
+ * @param  out              输出缓存，至少 HEXDUMP_LINE_SIZE_MAX 字节
+ * @param  offset           本行第一个字节在流中的偏移
+ * @param  row              本行数据
+ * @param  len              本行长度，1~HEXDUMP_ROW_SIZE，不足一行时十六进制列补空格对齐
+ * @param  prev             上一行的 HEXDUMP_ROW_SIZE 字节，与之不同的字节高亮显示；NULL 不高亮
+ * @return size_t           输出长度
+ */
+extern size_t hexdump_format_row(char *out, uint64_t offset, const uint8_t *row, size_t len, const uint8_t *prev);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _HEXDUMP_H_
@@ -0,0 +1,79 @@
+/**
+ * @file itm_parser.h
+ * @brief ITM/DWT 数据包流式解析(SWO 数据)，支持数据包跨越多次数据块
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _ITM_PARSER_H_
+#define _ITM_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct itm_parser itm_parser_t;
+
+struct itm_parser_callbacks {
+    /** 激励端口数据，连续的同端口单字节数据包会合并为一次回调 */
+    void (*stimulus)(void *ctx, int port, const uint8_t *data, size_t len);
+    /** DWT PC 采样，sleep 非0时表示内核处于睡眠，pc 无效 */
+    void (*pc_sample)(void *ctx, uint32_t pc, int sleep);
+    /** 溢出数据包，之前有数据丢失 */
+    void (*overflow)(void *ctx);
+};
+
+struct itm_parser_stats {
+    uint64_t packets;               ///< 解析出的数据包数量
+    uint64_t stimulus_bytes;        ///< 激励端口数据字节数
+    uint64_t pc_samples;            ///< PC 采样数量(包括睡眠)
+    uint64_t overflows;             ///< 溢出数据包数量
+    uint64_t syncs;                 ///< 同步数据包数量
+    uint64_t errors;                ///< 无法识别的头字节数量
+};
+
+/**
+ * @brief  创建 ITM 解析器
+ * @param  cb               回调函数，不需要的回调可以为NULL
+ * @param  ctx              回调上下文
+ * @return itm_parser_t*    解析器, 失败返回NULL
+ */
+extern itm_parser_t *itm_parser_create(const struct itm_parser_callbacks *cb, void *ctx);
+
+/**
+ * @brief  销毁 ITM 解析器
+ * @param  parser           解析器
+ */
+extern void itm_parser_destroy(itm_parser_t *parser);
+
+/**
+ * @brief  输入一段 SWO 数据，解析状态在多次调用之间保持
+ * @param  parser           解析器
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void itm_parser_feed(itm_parser_t *parser, const uint8_t *data, size_t len);
+
+/**
+ * @brief  获取解析统计
+ * @param  parser           解析器
+ * @param  stats            输出统计
+ */
+extern void itm_parser_get_stats(const itm_parser_t *parser, struct itm_parser_stats *stats);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _ITM_PARSER_H_
@@ -29,6 +29,20 @@ extern int JLINK_TIF_Select(int tif);
 extern int JLINK_Connect(void);
 extern int JLINK_ExecCommand(const char *in, char *out, int size);
 extern void JLINK_EMU_GetProductName(char *out, int size);
+extern int JLINK_ReadMemEx(uint32_t addr, uint32_t num_bytes, void *data, uint32_t flags);
+extern int JLINK_WriteMem(uint32_t addr, uint32_t num_bytes, const void *data);
+extern char JLINK_HasError(void);
+extern void JLINK_ClrError(void);
+extern char JLINK_Halt(void);
+extern char JLINK_IsHalted(void);
+extern void JLINK_Go(void);
+extern int JLINK_Reset(void);
+extern int JLINK_ReadRegs(const uint32_t *reg_index, uint32_t *data, uint8_t *status, uint32_t num);
+
+/* Cortex-M 寄存器索引 */
+#define JLINK_CM_REG_R0             0
+#define JLINK_CM_REG_R15            15
+#define JLINK_CM_REG_XPSR           16
 
 #define RTT_DIRECTION_UP            0
 #define RTT_DIRECTION_DOWN          1
@@ -49,10 +63,46 @@ enum rtt_cmd{
     RTT_CMD_GET_STAT = 4
 };
 
+/* RTT_CMD_GET_STAT 的结果(JLINK_RTTERMINAL_STATUS) */
+struct rtt_stat {
+    uint32_t num_bytes_transferred;
+    uint32_t num_bytes_read;
+    int32_t host_overflow_count;
+    int32_t is_running;
+    int32_t num_up_buffers;
+    int32_t num_down_buffers;
+    uint32_t overflow_mask;
+    uint32_t dummy;
+};
+
 extern int JLINK_RTTERMINAL_Control(enum rtt_cmd cmd, void *data);
 extern int JLINK_RTTERMINAL_Read(int channel, char *data, int len);
 extern int JLINK_RTTERMINAL_Write(int channel, const char *data, int len);
 
+#define SWO_INTERFACE_UART          0
+
+enum swo_cmd{
+    SWO_CMD_START = 0,
+    SWO_CMD_STOP = 1,
+    SWO_CMD_FLUSH = 2,
+    SWO_CMD_GET_SPEED_INFO = 3,
+    SWO_CMD_GET_NUM_BYTES = 10,
+    SWO_CMD_SET_BUFFERSIZE_HOST = 20,
+    SWO_CMD_SET_BUFFERSIZE_EMU = 21,
+};
+
+struct swo_start_info {
+    uint32_t size_of_struct;
+    uint32_t interface;
+    uint32_t speed;
+};
+
+extern int JLINK_SWO_Control(uint32_t cmd, void *data);
+extern void JLINK_SWO_Read(uint8_t *data, uint32_t offset, uint32_t *num_bytes);
+extern int JLINK_SWO_EnableTarget(uint32_t cpu_speed, uint32_t swo_speed, int mode, uint32_t port_mask);
+extern int JLINK_SWO_DisableTarget(uint32_t port_mask);
+extern int JLINK_SWO_GetCompatibleSpeeds(uint32_t cpu_speed, uint32_t max_swo_speed, uint32_t *speeds, uint32_t num);
+
 #ifdef __cplusplus
 #if __cplusplus
 }
@@ -19,8 +19,34 @@ extern "C"{
 #endif /* __cplusplus */
 
 extern int jlink_lib_init(void);
+
+/**
+ * @brief  停止记录(写完记录文件)或回放，卸载 J-Link 库
+ */
 extern void jlink_lib_deinit(void);
 
+/**
+ * @brief  记录之后的每次 JLINK_* 调用(参数、返回值、返回的数据和时间)到紧凑的二进制文件，在 jlink_lib_init 之后调用
+ * @param  path             记录文件路径
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_lib_record(const char *path);
+
+/**
+ * @brief  代替 jlink_lib_init，之后的 JLINK_* 调用不访问 J-Link，而是按顺序返回记录文件中的结果
+ *         每个函数(RTT 读写和控制、SWO 控制再按通道或命令)的调用分别按记录的顺序回放，与调用所在的线程无关
+ * @param  path             jlink_lib_record 生成的记录文件
+ * @param  speed            时间倍率，1 为按记录的时间返回，2 为两倍速，0 不等待
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_lib_replay(const char *path, double speed);
+
+/**
+ * @brief  设置回放结束回调，所有 RTT 读取的记录都回放完后，在下一次 RTT 读取的线程中调用一次
+ * @param  cb               回调函数
+ */
+extern void jlink_lib_replay_set_end_callback(void (*cb)(void));
+
 #ifdef __cplusplus
 #if __cplusplus
 }
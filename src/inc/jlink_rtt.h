@@ -11,6 +11,7 @@
 #ifndef _JLINK_RTT_H_
 #define _JLINK_RTT_H_
 
+#include <stdint.h>
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -18,6 +19,21 @@ extern "C"{
 #endif
 #endif /* __cplusplus */
 
+struct rtt_desc;
+
+/**
+ * @brief RTT 统计
+ */
+struct jlink_rtt_stats {
+    uint64_t rx_bytes;              ///< 所有上行通道接收的字节数
+    uint64_t tx_bytes;              ///< 写入下行通道的字节数
+    uint64_t tx_drops;              ///< 写入超时丢弃数据的次数
+    int      host_overflows;        ///< J-Link 主机缓冲区溢出次数，-1 未知
+    int      fill;                  ///< 终端上行缓冲区的占用百分比，-1 未知(控制块地址未知)
+    uint64_t polls;                 ///< 终端通道的读取次数
+    uint64_t poll_time_us;          ///< 相邻两次读取间隔的总和，两次采样的差值相除得到这段时间的平均轮询间隔
+};
+
 /**
  * @brief  启动 J-Link RTT 功能
  * @param  tx_channel       发送数据通道号，一般情况下为0
@@ -28,6 +44,75 @@ extern "C"{
  */
 extern int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned long range);
 
+/**
+ * @brief  使用已知的控制块地址与缓冲区布局启动 J-Link RTT 功能，跳过缓冲区查找
+ * @param  tx_channel       发送数据通道号，小于0时不发送
+ * @param  rx_channel       接收数据通道号
+ * @param  cb_addr          RTT 控制块地址
+ * @param  up_num           上行缓冲区数量
+ * @param  down_num         下行缓冲区数量
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_rtt_start_known(int tx_channel, int rx_channel, unsigned long cb_addr, int up_num, int down_num);
+
+/**
+ * @brief  复位采集：复位并暂停内核，设置控制块地址并启动 RTT 后再释放内核，保证不丢失启动阶段的输出
+ *         从释放内核到读到第一个字节的时间会在收到数据时打印
+ * @param  tx_channel       发送数据通道号，小于0时不发送
+ * @param  rx_channel       接收数据通道号
+ * @param  cb_addr          RTT 控制块地址(ELF 中的 _SEGGER_RTT 或缓存的地址)
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_rtt_start_reset(int tx_channel, int rx_channel, unsigned long cb_addr);
+
+/**
+ * @brief  获取 RTT 控制块地址，需在 RTT 启动后调用
+ * @return unsigned long    控制块地址, J-Link 自动查找(未指定 addr)时返回 0
+ */
+extern unsigned long jlink_rtt_get_cb_addr(void);
+
+/**
+ * @brief  获取 RTT 缓冲区数量，需在 RTT 启动后调用
+ * @param  direction        RTT_DIRECTION_UP 或 RTT_DIRECTION_DOWN
+ * @return int              缓冲区数量, 未知时返回 -1
+ */
+extern int jlink_rtt_get_buffer_num(int direction);
+
+/**
+ * @brief  获取 RTT 缓冲区描述(名称、大小、标志)
+ * @param  direction        RTT_DIRECTION_UP 或 RTT_DIRECTION_DOWN
+ * @param  index            缓冲区索引
+ * @param  desc             输出缓冲区描述
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_rtt_get_buffer_desc(int direction, int index, struct rtt_desc *desc);
+
+/**
+ * @brief  按名称查找 RTT 缓冲区，需在 RTT 启动后调用
+ * @param  direction        RTT_DIRECTION_UP 或 RTT_DIRECTION_DOWN
+ * @param  name             缓冲区名称，例如 "SysView"
+ * @return int              缓冲区索引, 未找到返回 -1
+ */
+extern int jlink_rtt_find_buffer(int direction, const char *name);
+
+/**
+ * @brief  附加一个上行通道，RTT 线程每轮优先读空附加通道，再读取终端通道
+ *         回调在 RTT 线程中执行，需尽快返回
+ * @param  channel          上行通道号，不能与终端接收通道相同
+ * @param  cb               接收数据回调函数
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_rtt_attach_channel(int channel, void (*cb)(int channel, const char *data, size_t len));
+
+/**
+ * @brief  发送数据到指定的 RTT 下行通道，数据由 RTT 线程优先写入
+ * @param  channel          下行通道号
+ * @param  data             要发送的数据指针
+ * @param  len              要发送的数据长度
+ * @return int              放入发送队列的数据长度, -1 失败
+ */
+extern int jlink_rtt_transmit_channel(int channel, const char *data, int len);
+
 /**
  * @brief  停止 J-Link RTT 功能
  * @return int              0 成功, -1 失败
@@ -35,7 +120,14 @@ extern int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, u
 extern void jlink_rtt_stop(void);
 
 /**
- * @brief  设置接收数据回调函数
+ * @brief  获取 RTT 统计，可以在任意线程调用
+ *         溢出次数和缓冲区占用由 RTT 线程在下一次空闲时读取，返回的是上一次调用后读到的值
+ * @param  stats            输出统计
+ */
+extern void jlink_rtt_get_stats(struct jlink_rtt_stats *stats);
+
+/**
+ * @brief  设置接收数据回调函数，设置前读到的数据会缓存起来，设置后先交给回调
  * @param  rx_cb            接收数据回调函数指针
  */
 extern void jlink_rtt_set_recv_callback(void (*rx_cb)(const char *data, size_t len));
@@ -0,0 +1,75 @@
+/**
+ * @file jlink_speed.h
+ * @brief J-Link SWD/JTAG 速度自动校准
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _JLINK_SPEED_H_
+#define _JLINK_SPEED_H_
+
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  获取当前探针序列号
+ * @return unsigned int     序列号, 获取失败返回0
+ */
+extern unsigned int jlink_probe_sn(void);
+
+/**
+ * @brief  校验速度是否稳定：低速读取参考数据，再以 speed 重复读取并比较
+ *         需已连接目标，校验区域必须是内容不变的区域(如Flash中的向量表)
+ *         返回时 J-Link 速度为 speed(参考读取失败时为低速)
+ * @param  addr             校验读取地址
+ * @param  len              校验读取长度
+ * @param  speed            待校验的速度(kHz)
+ * @return int              0 稳定, -1 读取出错或数据不一致
+ */
+extern int jlink_speed_verify(unsigned long addr, unsigned int len, unsigned int speed);
+
+/**
+ * @brief  自动校准 SWD/JTAG 速度
+ *         以低速读取的数据作为参考，逐级提高 JLINK_SetSpeed 并重复读取校验，
+ *         出错后在最后稳定速度与出错速度之间二分回退，最终留出余量
+ *         校准结束后会以校准结果调用 JLINK_SetSpeed
+ * @param  addr             校验读取地址
+ * @param  len              校验读取长度
+ * @return int              校准得到的速度(kHz), -1 失败
+ */
+extern int jlink_speed_calibrate(unsigned long addr, unsigned int len);
+
+/**
+ * @brief  从缓存中读取探针+设备对应的校准速度
+ * @param  sn               探针序列号
+ * @param  device           设备名
+ * @param  if_type          接口类型
+ * @return int              速度(kHz), 无缓存返回 -1
+ */
+extern int jlink_speed_cache_load(unsigned int sn, const char *device, int if_type);
+
+/**
+ * @brief  保存探针+设备对应的校准速度到缓存
+ * @param  sn               探针序列号
+ * @param  device           设备名
+ * @param  if_type          接口类型
+ * @param  speed            速度(kHz)
+ * @return int              0 成功, -1 失败
+ */
+extern int jlink_speed_cache_save(unsigned int sn, const char *device, int if_type, int speed);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _JLINK_SPEED_H_
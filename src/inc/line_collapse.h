@@ -0,0 +1,88 @@
+/**
+ * @file line_collapse.h
+ * @brief 重复行折叠，连续相同的行只保留第一行，重复结束或超时后输出重复次数
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _LINE_COLLAPSE_H_
+#define _LINE_COLLAPSE_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define LINE_COLLAPSE_SUMMARY_SIZE      128
+
+typedef struct line_collapse line_collapse_t;
+
+/**
+ * @brief  创建重复行折叠器
+ * @return line_collapse_t* 折叠器
+ */
+extern line_collapse_t *line_collapse_create(void);
+
+/**
+ * @brief  销毁重复行折叠器
+ * @param  lc               折叠器
+ */
+extern void line_collapse_destroy(line_collapse_t *lc);
+
+/**
+ * @brief  输入一个完整的行
+ * @param  lc               折叠器
+ * @param  line             行内容，不含换行
+ * @param  len              行长度
+ * @param  timestamp        行的时间戳，用于重复统计
+ * @return int              >0 与上一行相同应丢弃，值为本段的重复次数; 0 新的行，
+ *                          之前的重复统计已结束，需要先调用 line_collapse_flush 输出统计再输出本行
+ */
+extern int line_collapse_push(line_collapse_t *lc, const char *line, size_t len, const char *timestamp);
+
+/**
+ * @brief  未完成的行是否为上一行的前缀(可能是重复行)
+ * @param  lc               折叠器
+ * @param  line             已收到的行内容
+ * @param  len              行长度
+ * @return int              1 是前缀; 0 不是，或还没有上一行
+ */
+extern int line_collapse_is_prefix(const line_collapse_t *lc, const char *line, size_t len);
+
+/**
+ * @brief  是否有未输出的重复统计
+ * @param  lc               折叠器
+ * @return int              1 有; 0 没有
+ */
+extern int line_collapse_pending(const line_collapse_t *lc);
+
+/**
+ * @brief  结束一段重复并生成统计 "last line repeated N times (first..last)"，
+ *         上一行仍保留，之后的重复重新计数
+ * @param  lc               折叠器
+ * @param  out              统计输出缓存
+ * @param  size             缓存大小，LINE_COLLAPSE_SUMMARY_SIZE 足够
+ * @return size_t           统计长度，0 表示没有重复
+ */
+extern size_t line_collapse_flush(line_collapse_t *lc, char *out, size_t size);
+
+/**
+ * @brief  丢弃上一行和重复统计，下一行一定作为新的行
+ * @param  lc               折叠器
+ */
+extern void line_collapse_reset(line_collapse_t *lc);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _LINE_COLLAPSE_H_
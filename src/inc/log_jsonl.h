@@ -0,0 +1,78 @@
+/**
+ * @file log_jsonl.h
+ * @brief JSON Lines 日志记录的序列化，直接写入调用者提供的缓存，不分配内存
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _LOG_JSONL_H_
+#define _LOG_JSONL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+struct log_jsonl_record{
+    uint64_t seq;                   ///< 本次会话内的记录序号
+    uint64_t host_us;               ///< 主机接收时间，自 1970-01-01 起的微秒数
+    const char *target_ts;          ///< 行首提取的目标时间戳，NULL 表示没有
+    size_t target_ts_len;
+    int channel;                    ///< RTT 通道号
+    const char *session;            ///< 会话 ID
+    const char *kind;               ///< 记录类型，NULL 为普通行，"repeat" 为重复行统计
+    const char *text;               ///< 行内容(UTF-8)
+    size_t text_len;
+    const char *note;               ///< 行注释，NULL 表示没有
+    size_t note_len;
+};
+
+/**
+ * @brief  一条记录序列化后的最大长度
+ * @param  rec              记录
+ * @return size_t           最大长度，包括结尾的换行
+ */
+extern size_t log_jsonl_bound(const struct log_jsonl_record *rec);
+
+/**
+ * @brief  序列化一条记录，以换行结尾
+ * @param  out              输出缓存，至少 log_jsonl_bound 字节
+ * @param  rec              记录
+ * @return size_t           写入的字节数
+ */
+extern size_t log_jsonl_format(char *out, const struct log_jsonl_record *rec);
+
+/**
+ * @brief  JSON 字符串转义，不含两侧引号
+ * @param  out              输出缓存，至少 len * 6 字节
+ * @param  data             数据
+ * @param  len              数据长度
+ * @return size_t           写入的字节数
+ */
+extern size_t log_jsonl_escape(char *out, const char *data, size_t len);
+
+/**
+ * @brief  提取行首方括号中的目标时间戳，如 "[  12.345678]"、"[00:00:01.234,567]"
+ * @param  line             行内容
+ * @param  len              行长度
+ * @param  ts               输出时间戳起始位置(不含方括号和两侧空格)
+ * @param  ts_len           输出时间戳长度
+ * @return int              1 提取成功; 0 行首没有时间戳
+ */
+extern int log_jsonl_target_ts(const char *line, size_t len, const char **ts, size_t *ts_len);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _LOG_JSONL_H_
@@ -0,0 +1,61 @@
+/**
+ * @file log_view.h
+ * @brief 大日志文件查看器：内存映射文件，按字节位置虚拟滚动，后台建立行号索引，按时间跳转，多线程过滤
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _LOG_VIEW_H_
+#define _LOG_VIEW_H_
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct log_view log_view_t;
+
+/**
+ * @brief  打开日志文件并切换到备用屏幕显示，行号索引在后台建立，不等待
+ * @param  path             日志文件(文本或 JSON Lines 格式)
+ * @param  rows             终端行数
+ * @param  cols             终端列数
+ * @param  jobs             过滤使用的线程数，0 为 CPU 核数
+ * @return log_view_t*      查看器，失败返回 NULL
+ */
+extern log_view_t *log_view_open(const char *path, int rows, int cols, int jobs);
+
+/**
+ * @brief  停止后台任务，恢复终端屏幕并关闭文件
+ * @param  lv               查看器
+ */
+extern void log_view_close(log_view_t *lv);
+
+/**
+ * @brief  处理按键，按键定义与分页模式相同(terminal_pager_key_t 或可打印的 ASCII 字符)
+ * @param  lv               查看器
+ * @param  key              按键
+ * @return int              1 退出; 0 继续
+ */
+extern int log_view_key(log_view_t *lv, int key);
+
+/**
+ * @brief  终端大小改变，整屏重绘
+ * @param  lv               查看器
+ * @param  rows             终端行数
+ * @param  cols             终端列数
+ */
+extern void log_view_resize(log_view_t *lv, int rows, int cols);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _LOG_VIEW_H_
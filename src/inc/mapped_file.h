@@ -0,0 +1,59 @@
+/**
+ * @file mapped_file.h
+ * @brief 只读内存映射文件
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct mapped_file mapped_file_t;
+
+/**
+ * @brief  以只读方式映射文件
+ * @param  path             文件路径
+ * @return mapped_file_t*   映射对象, 失败返回NULL
+ */
+extern mapped_file_t *mapped_file_open(const char *path);
+
+/**
+ * @brief  解除映射并关闭文件
+ * @param  mf               映射对象
+ */
+extern void mapped_file_close(mapped_file_t *mf);
+
+/**
+ * @brief  获取映射的数据指针
+ * @param  mf               映射对象
+ * @return const uint8_t*   数据指针，空文件返回NULL
+ */
+extern const uint8_t *mapped_file_data(const mapped_file_t *mf);
+
+/**
+ * @brief  获取文件大小
+ * @param  mf               映射对象
+ * @return size_t           文件大小
+ */
+extern size_t mapped_file_size(const mapped_file_t *mf);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _MAPPED_FILE_H_
@@ -0,0 +1,70 @@
+/**
+ * @file metrics.h
+ * @brief 从接收的行中提取数值，按序列保存在固定大小的环形缓冲区并统计
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define METRICS_RING_SIZE_DEFAULT       4096        // 每个序列保存的最近样本数
+
+/**
+ * @brief  添加一个提取规则，需要在 metrics_start 之前调用
+ *         "vbat,temp"            提取 "vbat=3712"、"temp: 41.2" 形式的键值，每个键一个序列
+ *         "ADC{ch} = {adc} mV"   按模板提取，{name} 处的数值记录到序列 name，{} 处的数值忽略
+ * @param  spec             规则
+ * @return int              0 成功 -1 规则无效
+ */
+extern int metrics_add(const char *spec);
+
+/**
+ * @brief  开始提取
+ * @param  ring_size        每个序列保存的样本数，0 使用默认值
+ * @param  csv_path         每个样本追加一行 "t_us,series,value" 的 CSV 文件，NULL 不记录
+ * @return int              0 成功 -1 失败
+ */
+extern int metrics_start(size_t ring_size, const char *csv_path);
+
+/**
+ * @brief  处理一行接收的数据
+ * @param  line             行内容，不含换行
+ * @param  len              行长度
+ * @param  time_us          接收时间，自 1970-01-01 起的微秒数
+ */
+extern void metrics_feed_line(const char *line, size_t len, uint64_t time_us);
+
+/**
+ * @brief  生成各序列最近样本的 last/min/max/mean/p99 表格和走势图
+ * @param  out              输出缓存
+ * @param  size             输出缓存大小
+ * @return size_t           输出长度，每行以 "\r\n" 结尾，没有提取规则时为0
+ */
+extern size_t metrics_table(char *out, size_t size);
+
+/**
+ * @brief  停止提取，打印统计表格并关闭 CSV 文件
+ */
+extern void metrics_stop(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _METRICS_H_
@@ -0,0 +1,54 @@
+/**
+ * @file pc_histogram.h
+ * @brief DWT PC 采样直方图，按函数统计热点
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _PC_HISTOGRAM_H_
+#define _PC_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  记录一个 PC 采样
+ * @param  pc               PC 值
+ * @param  sleep            非0时表示内核处于睡眠
+ */
+extern void pc_histogram_add(uint32_t pc, int sleep);
+
+/**
+ * @brief  获取采样总数(包括睡眠)
+ * @return uint64_t         采样总数
+ */
+extern uint64_t pc_histogram_total(void);
+
+/**
+ * @brief  打印采样最多的函数，已加载符号表时按函数合并，否则按地址统计
+ * @param  top              打印的条目数量
+ */
+extern void pc_histogram_print(size_t top);
+
+/**
+ * @brief  清空直方图
+ */
+extern void pc_histogram_reset(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _PC_HISTOGRAM_H_
@@ -0,0 +1,67 @@
+/**
+ * @file plugin_host.h
+ * @brief 插件加载与批量分发，插件 ABI 见 rtt_shell_plugin.h
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _PLUGIN_HOST_H_
+#define _PLUGIN_HOST_H_
+
+#include <stddef.h>
+
+#include "rtt_shell_plugin.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  加载插件并调用其注册函数
+ * @param  spec             "path" 或 "path:args"
+ * @return int              0 成功, -1 失败
+ */
+extern int plugin_host_load(const char *spec);
+
+/**
+ * @brief  注册编译在程序内的插件，与动态库插件使用相同的 ABI
+ * @param  name             插件名称，用于提示信息
+ * @param  entry            注册函数
+ * @param  args             传给注册函数的参数，可以为 NULL
+ * @return int              0 成功, -1 失败
+ */
+extern int plugin_host_add_builtin(const char *name, rtt_shell_plugin_register_t entry, const char *args);
+
+/**
+ * @brief  附加插件注册的 RTT 通道并启动插件线程，需在 RTT 启动后调用
+ * @param  rx_channel       终端接收通道号
+ * @return int              0 成功, -1 失败
+ */
+extern int plugin_host_start(int rx_channel);
+
+/**
+ * @brief  输入终端通道的数据
+ * @param  data             数据指针
+ * @param  len              数据长度
+ * @return int              1 有解码器接管了终端通道，数据不应再显示; 0 没有
+ */
+extern int plugin_host_feed_terminal(const char *data, size_t len);
+
+/**
+ * @brief  处理完剩余数据后停止插件线程，调用插件的 close 并卸载
+ */
+extern void plugin_host_stop(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _PLUGIN_HOST_H_
@@ -0,0 +1,70 @@
+/**
+ * @file profile.h
+ * @brief 探针/设备 profile 配置，保存连接参数以及学习到的 RTT 状态
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  读取 profile 配置文件(ini格式)并选择 profile
+ *         name 不为NULL时按名字选择，否则选择 sn 键与探针序列号相同的 profile
+ * @param  file             配置文件路径，为NULL时使用配置目录下的 profiles.ini
+ * @param  name             profile 名称，可为NULL
+ * @param  sn               探针序列号
+ * @return int              0 找到, -1 未找到
+ */
+extern int profile_load(const char *file, const char *name, unsigned int sn);
+
+/**
+ * @brief  选择名为name的 profile，不存在时以当前选择的 profile 为模板新建
+ * @param  name             profile 名称
+ */
+extern void profile_create(const char *name);
+
+/**
+ * @brief  获取当前选择的 profile 名称
+ * @return const char*      名称, 未选择时返回NULL
+ */
+extern const char *profile_name(void);
+
+/**
+ * @brief  读取当前 profile 中的键值
+ * @param  key              键
+ * @return const char*      值, 未选择 profile 或不存在时返回NULL
+ */
+extern const char *profile_get(const char *key);
+
+/**
+ * @brief  设置当前 profile 中的键值，未选择 profile 时忽略
+ * @param  key              键
+ * @param  value            值
+ */
+extern void profile_set(const char *key, const char *value);
+
+/**
+ * @brief  将所有 profile 写回配置文件
+ * @return int              0 成功, -1 失败
+ */
+extern int profile_save(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _PROFILE_H_
@@ -0,0 +1,48 @@
+/**
+ * @file protobuf_decoder.h
+ * @brief 遥测通道的 protobuf 解码，消息以 varint 长度前缀分隔(nanopb pb_encode_delimited)
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _PROTOBUF_DECODER_H_
+#define _PROTOBUF_DECODER_H_
+
+#include "rtt_shell_plugin.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define PROTOBUF_TELEMETRY_BUFFER_NAME      "Telemetry"
+
+/**
+ * @brief  加载描述文件并生成解码表，打开输出文件
+ * @param  desc_path        FileDescriptorSet 文件(protoc --descriptor_set_out)
+ * @param  type_name        消息类型全名，如 "pkg.Telemetry"，为 NULL 时使用最后一个文件中第一个没有被引用的消息
+ * @param  out_path         输出文件，.csv 为列式(每个标量字段一列)，其它为 JSON Lines
+ * @return int              0 成功, -1 失败
+ */
+extern int protobuf_decoder_load(const char *desc_path, const char *type_name, const char *out_path);
+
+/**
+ * @brief  插件注册函数，通过 plugin_host_add_builtin 注册，需先调用 protobuf_decoder_load
+ * @param  host             主机函数表
+ * @param  args             上行通道号，为空字符串时按名称 PROTOBUF_TELEMETRY_BUFFER_NAME 查找
+ * @return int              0 成功, -1 失败
+ */
+extern int protobuf_decoder_plugin_register(const struct rtt_shell_host *host, const char *args);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _PROTOBUF_DECODER_H_
@@ -0,0 +1,51 @@
+/**
+ * @file reprocess.h
+ * @brief 离线重新处理 .rttcap 捕获文件：按记录边界分块，多线程解析、过滤、格式化后按顺序输出
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _REPROCESS_H_
+#define _REPROCESS_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define REPROCESS_CHUNK_SIZE_DEFAULT    (4 * 1024 * 1024)       // 每个分块的数据量
+
+struct reprocess_options{
+    int channel;                        ///< 文本通道
+    int jsonl;                          ///< 非0 输出 JSON Lines，否则与 -l 日志相同的文本格式
+    int symbolize;                      ///< 非0 用已加载的符号表注释行中的地址
+    const char *const *filters;         ///< 只输出包含其中任一字符串的行，NULL 输出全部
+    size_t filter_num;
+    int jobs;                           ///< 线程数，0 为 CPU 核数
+    size_t chunk_size;                  ///< 分块的数据量，0 使用默认值
+};
+
+/**
+ * @brief  重新处理捕获文件，各文件按给定顺序输出
+ * @param  paths            捕获文件路径
+ * @param  num              文件数量
+ * @param  out_path         输出文件，NULL 输出到标准输出
+ * @param  opt              选项
+ * @return int              0 成功 -1 失败
+ */
+extern int reprocess_run(const char *const *paths, size_t num, const char *out_path, const struct reprocess_options *opt);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _REPROCESS_H_
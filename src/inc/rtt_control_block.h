@@ -0,0 +1,77 @@
+/**
+ * @file rtt_control_block.h
+ * @brief 通过内存读取直接访问目标上的 SEGGER RTT 控制块
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _RTT_CONTROL_BLOCK_H_
+#define _RTT_CONTROL_BLOCK_H_
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define RTT_CB_ID                   "SEGGER RTT"
+#define RTT_CB_ID_SIZE              16
+#define RTT_CB_HEADER_SIZE          24          // acID + MaxNumUpBuffers + MaxNumDownBuffers
+#define RTT_CB_BUFFER_DESC_SIZE     24          // 32位目标上 SEGGER_RTT_BUFFER_UP/DOWN 的大小
+#define RTT_CB_MAX_BUFFERS          64
+#define RTT_CB_NAME_SIZE            32
+
+/**
+ * @brief 目标内存中的 RTT 缓冲区描述(SEGGER_RTT_BUFFER_UP/DOWN)
+ */
+struct rtt_cb_buffer {
+    char name[RTT_CB_NAME_SIZE];
+    uint32_t buffer;                ///< pBuffer
+    uint32_t size;                  ///< SizeOfBuffer
+    uint32_t wr_off;                ///< WrOff
+    uint32_t rd_off;                ///< RdOff
+    uint32_t flags;                 ///< Flags
+};
+
+/**
+ * @brief  检查指定地址是否为有效的 RTT 控制块
+ * @param  addr             控制块地址
+ * @param  max_up           输出上行缓冲区数量，可为NULL
+ * @param  max_down         输出下行缓冲区数量，可为NULL
+ * @return int              0 有效, -1 无效或读取失败
+ */
+extern int rtt_cb_check(unsigned long addr, int *max_up, int *max_down);
+
+/**
+ * @brief  在目标内存范围内查找 RTT 控制块
+ * @param  addr             起始地址
+ * @param  range            查找范围(字节)
+ * @param  cb_addr          输出控制块地址
+ * @return int              0 找到, -1 未找到
+ */
+extern int rtt_cb_scan(unsigned long addr, unsigned long range, unsigned long *cb_addr);
+
+/**
+ * @brief  一次读取控制块中所有缓冲区描述，不依赖 J-Link RTT 功能
+ * @param  cb_addr          控制块地址
+ * @param  direction        RTT_DIRECTION_UP 或 RTT_DIRECTION_DOWN
+ * @param  bufs             输出缓冲区描述
+ * @param  max              bufs 的最大数量
+ * @return int              缓冲区数量, -1 失败
+ */
+extern int rtt_cb_read_buffers(unsigned long cb_addr, int direction, struct rtt_cb_buffer *bufs, int max);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _RTT_CONTROL_BLOCK_H_
@@ -0,0 +1,50 @@
+/**
+ * @file rtt_dump.h
+ * @brief 事后提取：直接从目标内存读取 RTT 上行缓冲区中的全部数据，不依赖 J-Link RTT 功能
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _RTT_DUMP_H_
+#define _RTT_DUMP_H_
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  查找 RTT 控制块，依次尝试: ELF 中的 _SEGGER_RTT 符号、缓存的地址、addr/range 范围查找、ELF 中的 RAM 区域查找
+ * @param  elf_path         固件 ELF 文件，可以为NULL
+ * @param  cached_addr      缓存的控制块地址，0 表示没有
+ * @param  addr             RTT 地址参数，range 为0时视为控制块地址
+ * @param  range            RTT 范围参数
+ * @param  cb_addr          输出控制块地址
+ * @return int              0 找到, -1 未找到
+ */
+extern int rtt_dump_locate(const char *elf_path, unsigned long cached_addr, unsigned long addr, unsigned long range, unsigned long *cb_addr);
+
+/**
+ * @brief  读取所有上行环形缓冲区的完整内容
+ *         每个缓冲区按时间顺序保存为原始文件: WrOff 之后已被读取但仍在内存中的历史数据，以及 RdOff 到 WrOff 之间未读取的数据
+ *         终端通道的数据同时送入终端显示与日志
+ * @param  cb_addr          控制块地址
+ * @param  shell_channel    终端通道号
+ * @param  out_dir          原始文件输出目录
+ * @param  halt             非0时读取前暂停内核，读取后恢复原来的运行状态
+ * @return int              0 成功, -1 失败
+ */
+extern int rtt_dump(unsigned long cb_addr, int shell_channel, const char *out_dir, int halt);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _RTT_DUMP_H_
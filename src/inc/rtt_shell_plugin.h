@@ -0,0 +1,120 @@
+/**
+ * @file rtt_shell_plugin.h
+ * @brief rtt-shell 插件 ABI，插件只需要包含本头文件，编译为动态库后用 --plugin 加载
+ *        插件导出 RTT_SHELL_PLUGIN_ENTRY 函数，在其中通过 host->register_channel 注册通道的解码器或数据接收器
+ *        主机按批次调用 process，每批包含多条 (时间戳, 数据) 记录，不会逐字节回调
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _RTT_SHELL_PLUGIN_H_
+#define _RTT_SHELL_PLUGIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/* ABI 版本，结构体只在末尾追加成员，删除或修改成员时增加版本号 */
+#define RTT_SHELL_PLUGIN_ABI_VERSION        1
+
+#define RTT_SHELL_PLUGIN_ENTRY              "rtt_shell_plugin_register"
+
+#ifdef _WIN32
+#define RTT_SHELL_PLUGIN_EXPORT             __declspec(dllexport)
+#else
+#define RTT_SHELL_PLUGIN_EXPORT             __attribute__((visibility("default")))
+#endif
+
+#define RTT_SHELL_CHANNEL_TERMINAL          (-1)        // 终端接收通道(-c 指定的通道)
+#define RTT_SHELL_CHANNEL_RECORD_BASE       0x200       // 插件输出的二进制记录的通道号起始值
+
+typedef enum {
+    RTT_SHELL_DECODER = 0,          ///< 解码器：通道的原始数据不再显示，由插件输出文本行
+    RTT_SHELL_SINK = 1,             ///< 接收器：只获得数据副本，不影响显示
+} rtt_shell_channel_kind_t;
+
+/**
+ * @brief 一条接收记录，data 只在 process 调用期间有效
+ */
+struct rtt_shell_record{
+    uint64_t timestamp_us;          ///< 主机接收时间，自 1970-01-01 起的微秒数
+    const uint8_t *data;
+    size_t len;
+};
+
+/**
+ * @brief 插件对一个通道的处理函数，由插件填写后传给 register_channel
+ *        主机只复制 size 字节，插件按旧版本头文件编译时，之后追加的成员视为 0
+ */
+struct rtt_shell_channel_ops{
+    uint32_t size;                  ///< sizeof(struct rtt_shell_channel_ops)
+    uint32_t abi_version;           ///< 插件编译时的 RTT_SHELL_PLUGIN_ABI_VERSION
+    const char *name;               ///< 名称，用于提示信息
+    int channel;                    ///< RTT 上行通道号、RTT_SHELL_CHANNEL_TERMINAL 或其它插件输出的记录通道号
+    rtt_shell_channel_kind_t kind;
+    void *ctx;                      ///< 原样传给 process 与 close
+    /**
+     * @brief 处理一批记录，在插件线程中调用，可以调用 host 的输出函数
+     * @param ctx           ops.ctx
+     * @param channel       通道号，终端通道为实际的通道号
+     * @param records       记录数组
+     * @param num           记录数量
+     */
+    void (*process)(void *ctx, int channel, const struct rtt_shell_record *records, size_t num);
+    /**
+     * @brief 卸载前调用，可以为 NULL
+     */
+    void (*close)(void *ctx);
+};
+
+/**
+ * @brief 主机提供给插件的函数，在插件卸载前一直有效
+ */
+struct rtt_shell_host{
+    uint32_t abi_version;           ///< 主机的 RTT_SHELL_PLUGIN_ABI_VERSION
+    void *host_ctx;                 ///< 调用以下函数时原样传入
+    /**
+     * @brief 注册通道处理函数，ops 的前 size 字节会被复制
+     * @return 0 成功, -1 失败
+     */
+    int (*register_channel)(void *host_ctx, const struct rtt_shell_channel_ops *ops);
+    /**
+     * @brief 输出一行文本到终端显示与日志，不需要换行符
+     */
+    void (*emit_line)(void *host_ctx, const char *text, size_t len);
+    /**
+     * @brief 输出一条二进制记录，写入飞行记录器，并交给注册了该记录通道的插件
+     * @param channel       记录通道号，大于等于 RTT_SHELL_CHANNEL_RECORD_BASE
+     */
+    void (*emit_record)(void *host_ctx, int channel, const void *data, size_t len);
+    /**
+     * @brief 发送数据到 RTT 下行通道
+     * @return 放入发送队列的数据长度, -1 失败
+     */
+    int (*transmit)(void *host_ctx, int channel, const void *data, size_t len);
+};
+
+/**
+ * @brief 插件入口函数类型，插件以 RTT_SHELL_PLUGIN_ENTRY 为名导出
+ * @param host              主机函数表
+ * @param args              --plugin path:args 中冒号之后的参数，没有时为空字符串
+ * @return int              0 成功, -1 失败(插件会被卸载)
+ */
+typedef int (*rtt_shell_plugin_register_t)(const struct rtt_shell_host *host, const char *args);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _RTT_SHELL_PLUGIN_H_
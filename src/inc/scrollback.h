@@ -0,0 +1,110 @@
+/**
+ * @file scrollback.h
+ * @brief 会话内的行历史：按块压缩保存，超过内存预算时丢弃最早的块，支持按序号读取和子串搜索
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _SCROLLBACK_H_
+#define _SCROLLBACK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define SCROLLBACK_BUDGET_DEFAULT       (64 * 1024 * 1024)      // 默认内存预算
+#define SCROLLBACK_BLOCK_SIZE           (64 * 1024)             // 未压缩块的大小，满后压缩
+
+typedef struct scrollback scrollback_t;
+
+/**
+ * @brief  创建行历史
+ * @param  budget           内存预算(字节)，包括压缩块和正在写入的块，0 使用默认值
+ * @return scrollback_t*    行历史
+ */
+extern scrollback_t *scrollback_create(size_t budget);
+
+/**
+ * @brief  销毁行历史
+ * @param  sb               行历史
+ */
+extern void scrollback_destroy(scrollback_t *sb);
+
+/**
+ * @brief  追加一行
+ * @param  sb               行历史
+ * @param  line             行内容，不含换行
+ * @param  len              行长度
+ * @param  time_us          行的时间，自 1970-01-01 起的微秒数
+ */
+extern void scrollback_append(scrollback_t *sb, const char *line, size_t len, uint64_t time_us);
+
+/**
+ * @brief  最早仍保存的行的序号，序号从 0 开始，丢弃的行不重新编号
+ * @param  sb               行历史
+ * @return uint64_t         序号
+ */
+extern uint64_t scrollback_first(const scrollback_t *sb);
+
+/**
+ * @brief  下一行的序号，等于追加过的总行数
+ * @param  sb               行历史
+ * @return uint64_t         序号
+ */
+extern uint64_t scrollback_end(const scrollback_t *sb);
+
+/**
+ * @brief  读取一行，需要时解压所在的块
+ * @param  sb               行历史
+ * @param  index            行序号
+ * @param  line             行内容，到下一次读取、搜索或追加前有效
+ * @param  len              行长度
+ * @param  time_us          行的时间，可以为 NULL
+ * @return int              0 成功 -1 序号不在保存的范围内
+ */
+extern int scrollback_get(scrollback_t *sb, uint64_t index, const char **line, size_t *len, uint64_t *time_us);
+
+/**
+ * @brief  搜索包含 pattern 的行
+ * @param  sb               行历史
+ * @param  pattern          要搜索的字符串，区分大小写
+ * @param  pattern_len      字符串长度
+ * @param  from             从这一行开始搜索(包含)
+ * @param  backward         非0 向前搜索
+ * @return int64_t          匹配的行序号，-1 没有找到
+ */
+extern int64_t scrollback_search(scrollback_t *sb, const char *pattern, size_t pattern_len, uint64_t from, int backward);
+
+/**
+ * @brief  在一行内查找子串，用于显示时标出匹配位置
+ * @param  data             数据
+ * @param  len              数据长度
+ * @param  pattern          要查找的字符串
+ * @param  pattern_len      字符串长度
+ * @return const char*      第一次出现的位置，NULL 没有找到
+ */
+extern const char *scrollback_find(const char *data, size_t len, const char *pattern, size_t pattern_len);
+
+/**
+ * @brief  当前占用的内存(字节)
+ * @param  sb               行历史
+ * @return size_t           压缩块和正在写入的块的大小
+ */
+extern size_t scrollback_memory(const scrollback_t *sb);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _SCROLLBACK_H_
@@ -0,0 +1,84 @@
+/**
+ * @file split_view.h
+ * @brief 分屏显示：每个上行通道一个窗格，窗格有自己的滚动区域和状态栏，按统一的帧时钟只重绘变化的单元格，
+ *        键盘输入发送到焦点窗格的下行通道
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _SPLIT_VIEW_H_
+#define _SPLIT_VIEW_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+struct split_view_pane{
+    int up_channel;                 // 上行通道，第一个窗格为终端通道，其余窗格由分屏显示附加到 RTT
+    int down_channel;               // 焦点在该窗格时键盘输入发送到的下行通道，-1 只读
+};
+
+/**
+ * @brief  开始分屏显示，需在 RTT 启动后、终端显示启动前调用
+ *         第一个窗格显示终端显示线程的输出(通过 split_view_write 写入)，其余窗格直接显示通道的原始数据
+ * @param  panes            窗格，从上到下排列
+ * @param  num              窗格数量
+ * @param  rows             终端行数
+ * @param  cols             终端列数
+ * @param  fps              最大帧率，0 使用默认值
+ * @return int              0 成功, -1 失败
+ */
+extern int split_view_start(const struct split_view_pane *panes, size_t num, int rows, int cols, int fps);
+
+/**
+ * @brief  停止分屏显示，光标移到屏幕底部，需在 RTT 停止前调用
+ */
+extern void split_view_stop(void);
+
+/**
+ * @brief  写入第一个窗格，可作为 terminal_display_record_set_output 的输出函数
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void split_view_write(const char *data, size_t len);
+
+/**
+ * @brief  暂停/恢复输出到终端，暂停期间数据照常接收，恢复时整屏重绘
+ *         可作为 terminal_display_record_set_output 的暂停函数，返回时正在输出的一帧已经完成
+ * @param  paused           1 暂停, 0 恢复
+ */
+extern void split_view_pause(int paused);
+
+/**
+ * @brief  终端大小改变，重新分配窗格并整屏重绘
+ * @param  rows             终端行数
+ * @param  cols             终端列数
+ */
+extern void split_view_resize(int rows, int cols);
+
+/**
+ * @brief  焦点移到下一个窗格
+ */
+extern void split_view_focus_next(void);
+
+/**
+ * @brief  焦点窗格的下行通道
+ * @return int              下行通道号, -1 只读窗格
+ */
+extern int split_view_focus_channel(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _SPLIT_VIEW_H_
@@ -0,0 +1,42 @@
+/**
+ * @file status_bar.h
+ * @brief 终端底部的状态栏：定期采样 RTT 与显示记录的计数，显示收发速率、行速率、积压、丢弃、目标缓冲区占用和轮询间隔
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _STATUS_BAR_H_
+#define _STATUS_BAR_H_
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define STATUS_BAR_RATE_DEFAULT         4           // 每秒更新次数
+#define STATUS_BAR_RATE_MAX             10
+
+/**
+ * @brief  开始定期更新状态栏，需要在 terminal_display_record_set_status_bar(1) 并启动显示记录之后调用
+ * @param  rate             每秒更新次数，0 使用默认值，最多 STATUS_BAR_RATE_MAX
+ * @return int              0 成功 -1 失败
+ */
+extern int status_bar_start(int rate);
+
+/**
+ * @brief  停止更新状态栏，需要在停止显示记录之前调用
+ */
+extern void status_bar_stop(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _STATUS_BAR_H_
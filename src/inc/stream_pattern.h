@@ -0,0 +1,103 @@
+/**
+ * @file stream_pattern.h
+ * @brief 流式字符串匹配，支持匹配内容跨越多次数据块
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _STREAM_PATTERN_H_
+#define _STREAM_PATTERN_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct stream_pattern stream_pattern_t;
+typedef struct stream_pattern_set stream_pattern_set_t;
+
+/**
+ * @brief  创建流式匹配器
+ * @param  pattern          要匹配的字符串
+ * @return stream_pattern_t* 匹配器, 失败返回NULL
+ */
+extern stream_pattern_t *stream_pattern_create(const char *pattern);
+
+/**
+ * @brief  销毁流式匹配器
+ * @param  sp               匹配器
+ */
+extern void stream_pattern_destroy(stream_pattern_t *sp);
+
+/**
+ * @brief  获取匹配器的匹配字符串
+ * @param  sp               匹配器
+ * @return const char*      匹配字符串
+ */
+extern const char *stream_pattern_str(const stream_pattern_t *sp);
+
+/**
+ * @brief  输入一段数据，匹配状态在多次调用之间保持
+ * @param  sp               匹配器
+ * @param  data             数据指针
+ * @param  len              数据长度
+ * @return int              本段数据中完成的匹配次数
+ */
+extern int stream_pattern_feed(stream_pattern_t *sp, const char *data, size_t len);
+
+/**
+ * @brief  清除跨数据块的部分匹配状态
+ * @param  sp               匹配器
+ */
+extern void stream_pattern_reset(stream_pattern_t *sp);
+
+/**
+ * @brief  创建匹配器集合，每个输入通道使用独立的匹配状态，匹配不会跨通道拼接，可以在多个线程中调用
+ * @return stream_pattern_set_t* 匹配器集合, 失败返回NULL
+ */
+extern stream_pattern_set_t *stream_pattern_set_create(void);
+
+/**
+ * @brief  销毁匹配器集合
+ * @param  set              匹配器集合
+ */
+extern void stream_pattern_set_destroy(stream_pattern_set_t *set);
+
+/**
+ * @brief  添加要匹配的字符串，之后出现的通道和已有的通道都会匹配
+ * @param  set              匹配器集合
+ * @param  pattern          要匹配的字符串
+ * @return int              0 成功, -1 失败
+ */
+extern int stream_pattern_set_add(stream_pattern_set_t *set, const char *pattern);
+
+/**
+ * @brief  清除所有字符串和各通道的匹配状态
+ * @param  set              匹配器集合
+ */
+extern void stream_pattern_set_clear(stream_pattern_set_t *set);
+
+/**
+ * @brief  输入一个通道的一段数据，通道第一次出现时创建它的匹配状态
+ * @param  set              匹配器集合
+ * @param  channel          输入通道，例如 RTT 通道号或 SWO 端口
+ * @param  data             数据指针
+ * @param  len              数据长度
+ * @return int              本段数据中所有字符串完成的匹配次数
+ */
+extern int stream_pattern_set_feed(stream_pattern_set_t *set, int channel, const char *data, size_t len);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _STREAM_PATTERN_H_
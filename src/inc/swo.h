@@ -0,0 +1,63 @@
+/**
+ * @file swo.h
+ * @brief SWO 数据采集：读取 J-Link SWO 数据并解析 ITM 激励端口输出与 DWT PC 采样
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _SWO_H_
+#define _SWO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/* 记录文件中 ITM 端口数据的通道号为 SWO_CHANNEL_BASE + 端口号，与 RTT 通道区分 */
+#define SWO_CHANNEL_BASE            0x100
+
+/**
+ * @brief  启动 SWO 采集，配置目标 SWO 输出并启动读取线程
+ *         PC 采样需要固件使能 DWT PCSAMPLENA，采样结果进入 pc_histogram
+ * @param  cpu_hz           目标内核时钟(Hz)
+ * @param  swo_hz           SWO 波特率，0 时选择 J-Link 支持的最高兼容速度
+ * @param  port_mask        使能的激励端口
+ * @param  record_path      保存原始 SWO 数据的文件，为NULL时不保存
+ * @return int              0 成功, -1 失败
+ */
+extern int swo_start(uint32_t cpu_hz, uint32_t swo_hz, uint32_t port_mask, const char *record_path);
+
+/**
+ * @brief  停止 SWO 采集并打印统计
+ */
+extern void swo_stop(void);
+
+/**
+ * @brief  设置激励端口数据回调，只回调 port_mask 中的端口
+ * @param  port_mask        需要回调的端口
+ * @param  cb               回调函数指针
+ */
+extern void swo_set_recv_callback(uint32_t port_mask, void (*cb)(int port, const char *data, size_t len));
+
+/**
+ * @brief  离线解析录制的原始 SWO 数据文件，激励端口数据通过回调输出
+ * @param  path             原始 SWO 数据文件
+ * @return int              0 成功, -1 失败
+ */
+extern int swo_decode_file(const char *path);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _SWO_H_
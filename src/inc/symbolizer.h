@@ -0,0 +1,71 @@
+/**
+ * @file symbolizer.h
+ * @brief 地址符号化：根据固件 ELF 把日志中的地址转换为 func+off (file:line)
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifndef _SYMBOLIZER_H_
+#define _SYMBOLIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+/**
+ * @brief  加载 ELF 符号表，以及可选的 .debug_line 行号表
+ * @param  elf_path         固件 ELF 文件
+ * @param  with_lines       非0时加载行号表
+ * @return int              加载的符号数量, -1 失败
+ */
+extern int symbolizer_load(const char *elf_path, int with_lines);
+
+/**
+ * @brief  释放符号表
+ */
+extern void symbolizer_unload(void);
+
+/**
+ * @brief  查询地址对应的符号
+ * @param  addr             地址
+ * @param  out              输出 "func+0x1a (file.c:42)"
+ * @param  size             输出缓冲区大小
+ * @return int              输出长度, 地址不属于任何符号时返回 -1
+ */
+extern int symbolizer_lookup(uint32_t addr, char *out, size_t size);
+
+/**
+ * @brief  查询地址所属的符号名
+ * @param  addr             地址
+ * @param  offset           输出地址相对符号起始的偏移，可以为NULL
+ * @return const char*      符号名, 地址不属于任何符号时返回NULL
+ */
+extern const char *symbolizer_function(uint32_t addr, uint32_t *offset);
+
+/**
+ * @brief  为一行文本中的十六进制地址生成注释
+ *         识别 0x 开头的十六进制数与独立的8位十六进制数，只输出能符号化的地址
+ * @param  line             行文本
+ * @param  len              行长度
+ * @param  out              输出注释，例如 " <0x0800abcd=func+0x1a (file.c:42)>"
+ * @param  size             输出缓冲区大小
+ * @return size_t           注释长度, 没有可符号化的地址时返回0
+ */
+extern size_t symbolizer_annotate(const char *line, size_t len, char *out, size_t size);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _SYMBOLIZER_H_
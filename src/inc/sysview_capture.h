@@ -0,0 +1,44 @@
+/**
+ * @file sysview_capture.h
+ * @brief SystemView 通道采集：与交互终端同时运行，把 SystemView 上行通道的数据保存为 .SVDat 文件
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _SYSVIEW_CAPTURE_H_
+#define _SYSVIEW_CAPTURE_H_
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define SYSVIEW_BUFFER_NAME             "SysView"
+
+/**
+ * @brief  开始 SystemView 采集，需在 RTT 启动后调用
+ *         附加上行通道(优先读取)，并在下行通道发送开始命令，目标无响应时周期性重发
+ * @param  path             输出 .SVDat 文件路径
+ * @param  up_channel       SystemView 上行通道，小于0时按名称 "SysView" 查找
+ * @param  down_channel     SystemView 下行通道，小于0时按名称 "SysView" 查找，找不到则与上行通道相同
+ * @return int              0 成功, -1 失败
+ */
+extern int sysview_capture_start(const char *path, int up_channel, int down_channel);
+
+/**
+ * @brief  停止 SystemView 采集：发送停止命令并关闭文件，需在 RTT 停止前调用
+ */
+extern void sysview_capture_stop(void);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _SYSVIEW_CAPTURE_H_
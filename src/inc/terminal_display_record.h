@@ -10,6 +10,8 @@
 #ifndef _TERMINAL_DISPLAY_RECORD_H_
 #define _TERMINAL_DISPLAY_RECORD_H_
 
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -17,6 +19,32 @@ extern "C"{
 #endif
 #endif /* __cplusplus */
 
+typedef enum {
+    TERMINAL_LOG_TEXT = 0,          ///< "[时间]>>>  内容" 文本行
+    TERMINAL_LOG_JSONL = 1,         ///< 每行一条 JSON 记录
+} terminal_log_format_t;
+
+/* 分页模式的按键，可打印的 ASCII 字符直接使用字符值 */
+typedef enum {
+    TERMINAL_PAGER_KEY_UP = 0x100,
+    TERMINAL_PAGER_KEY_DOWN,
+    TERMINAL_PAGER_KEY_PAGE_UP,
+    TERMINAL_PAGER_KEY_PAGE_DOWN,
+    TERMINAL_PAGER_KEY_HOME,
+    TERMINAL_PAGER_KEY_END,
+    TERMINAL_PAGER_KEY_ENTER,
+    TERMINAL_PAGER_KEY_BACKSPACE,
+    TERMINAL_PAGER_KEY_ESC,
+} terminal_pager_key_t;
+
+/* 接收统计 */
+struct terminal_display_stats {
+    uint64_t bytes;                 ///< 处理的数据量
+    uint64_t lines;                 ///< 处理的行数
+    uint64_t allocations;           ///< 接收、解析、显示和记录路径上的堆分配次数
+    uint64_t backlog;               ///< 已接收、等待显示线程处理的字节数
+};
+
 /**
  * @brief 启动终端显示记录功能
  * 
@@ -37,6 +65,13 @@ extern void terminal_display_record_stop(void);
  */
 extern void terminal_display_record_write(const char* data, size_t size);
 
+/**
+ * @brief 获取接收统计，可以在任意线程调用
+ *
+ * @param stats 统计结果
+ */
+extern void terminal_display_record_get_stats(struct terminal_display_stats *stats);
+
 /**
  * @brief 设置终端显示记录功能的退出信号回调函数
  * 
@@ -44,6 +79,125 @@ extern void terminal_display_record_write(const char* data, size_t size);
  */
 extern void terminal_display_record_quit_signal_set_callback(void (*callback)(void));
 
+/**
+ * @brief 设置行注释函数，每行结束时调用，返回的注释以暗色追加到显示，并追加到日志
+ * 
+ * @param annotator 行注释函数指针，返回注释长度，0 表示不注释
+ */
+extern void terminal_display_record_set_line_annotator(size_t (*annotator)(const char *line, size_t len, char *out, size_t size));
+
+/**
+ * @brief 设置行回调，每行结束时在显示线程中调用
+ * 
+ * @param callback 行回调函数指针，time_us 为行开始接收的时间，自 1970-01-01 起的微秒数
+ */
+extern void terminal_display_record_set_line_callback(void (*callback)(const char *line, size_t len, uint64_t time_us));
+
+/**
+ * @brief 在接收的行之间以暗色插入提示，不写入日志
+ * 
+ * @param text 提示内容，每行以 "\r\n" 结尾
+ * @param len 提示长度
+ */
+extern void terminal_display_record_notice(const char *text, size_t len);
+
+/**
+ * @brief 使用虚拟屏幕显示，只输出变化的单元格，帧率不超过 fps，需要在启动前设置
+ * 
+ * @param rows 终端行数，0 表示直接输出到终端
+ * @param cols 终端列数
+ * @param fps 最大帧率，0 使用默认值
+ */
+extern void terminal_display_record_set_vscreen(int rows, int cols, int fps);
+
+/**
+ * @brief 显示的数据交给 output 输出而不是直接写到终端(例如分屏显示的一个窗格)，需要在启动前设置
+ *
+ * @param output 输出函数，在显示线程中调用，分页时也照常调用
+ * @param pause 进入分页前以 1 调用，退出分页后以 0 调用，期间 output 的使用者不能写终端，可以为 NULL
+ */
+extern void terminal_display_record_set_output(void (*output)(const char *data, size_t len), void (*pause)(int paused));
+
+/**
+ * @brief 折叠连续重复的行，重复结束或超过 timeout_ms 后输出 "last line repeated N times"，需要在启动前设置
+ * 
+ * @param display 是否折叠显示
+ * @param log 是否折叠日志文件
+ * @param timeout_ms 重复持续时输出统计的间隔，0 使用默认值
+ */
+extern void terminal_display_record_set_collapse(int display, int log, int timeout_ms);
+
+/**
+ * @brief 设置日志文件格式，需要在启动前设置
+ * 
+ * @param format 日志格式
+ * @param channel 记录到 JSON 中的 RTT 通道号
+ */
+extern void terminal_display_record_set_log_format(terminal_log_format_t format, int channel);
+
+/**
+ * @brief 设置十六进制显示模式(偏移、十六进制、ASCII)，数据不再按终端控制字符解析，高亮和限速需要在启动前设置
+ * 
+ * @param enable 是否以十六进制显示
+ * @param highlight 是否高亮与上一行不同的字节
+ * @param rate 每秒最多显示的行数，超过时定期显示最新的行并提示丢弃的字节数，日志仍记录全部数据，0 使用默认值
+ */
+extern void terminal_display_record_set_hexdump(int enable, int highlight, int rate);
+
+/**
+ * @brief 在文本和十六进制显示之间切换
+ */
+extern void terminal_display_record_toggle_hexdump(void);
+
+/**
+ * @brief 终端大小改变，虚拟屏幕在下一帧整屏重绘，分页显示立即重绘；启动前调用设置初始大小
+ * 
+ * @param rows 终端行数
+ * @param cols 终端列数
+ */
+extern void terminal_display_record_resize(int rows, int cols);
+
+/**
+ * @brief 终端最后一行保留给状态栏，上面的行作为滚动区域，需要在启动前设置，不能与 terminal_display_record_set_output 同时使用
+ *
+ * @param enable 是否显示状态栏
+ */
+extern void terminal_display_record_set_status_bar(int enable);
+
+/**
+ * @brief 更新状态栏内容，由显示线程在两批数据之间绘制，分页时在退出分页后显示
+ *
+ * @param text 一行 ASCII 文本，超出终端宽度的部分不显示
+ * @param len 文本长度
+ */
+extern void terminal_display_record_set_status(const char *text, size_t len);
+
+/**
+ * @brief 设置行历史的内存预算，超过时丢弃最早的行，需要在启动前设置
+ * 
+ * @param budget 字节数，0 不保存行历史(不能进入分页模式)
+ */
+extern void terminal_display_record_set_scrollback(size_t budget);
+
+/**
+ * @brief 进入或退出分页模式：实时显示暂停，接收、日志和行回调照常进行，可以浏览和搜索行历史
+ */
+extern void terminal_display_record_toggle_pager(void);
+
+/**
+ * @brief 是否在分页模式，此时按键应通过 terminal_display_record_pager_key 交给分页显示
+ * 
+ * @return int 1 在分页模式; 0 不在
+ */
+extern int terminal_display_record_pager_active(void);
+
+/**
+ * @brief 分页模式的按键，q 或 Esc 退出分页模式
+ * 
+ * @param key 可打印的 ASCII 字符或 terminal_pager_key_t
+ */
+extern void terminal_display_record_pager_key(int key);
+
 #ifdef __cplusplus
 #if __cplusplus
 }
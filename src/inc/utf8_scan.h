@@ -0,0 +1,49 @@
+/**
+ * @file utf8_scan.h
+ * @brief 可显示文本段的扫描与 UTF-8 校验
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _UTF8_SCAN_H_
+#define _UTF8_SCAN_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define UTF8_SCAN_BLOCK_SIZE        16          // 向量扫描的块大小，不足一块的数据不扫描
+
+/**
+ * @brief  按块跳过合法 UTF-8 的可显示文本(不含 C0 控制字符与 DEL)
+ * @param  data             数据指针，必须位于字符边界
+ * @param  len              数据长度
+ * @return size_t           跳过的字节数，总是停在字符边界；遇到控制字符、非法序列或不足一块时停止，
+ *                          停止处附近的字节需要用 utf8_sequence_check 逐个字符处理
+ */
+extern size_t utf8_scan_text(const char *data, size_t len);
+
+/**
+ * @brief  校验 data 开头的一个字符
+ * @param  data             数据指针
+ * @param  len              数据长度，大于0
+ * @return int              >0 合法字符的字节数; 0 数据不足，已有的字节都合法; <0 非法，
+ *                          绝对值为应替换为一个 U+FFFD 的字节数(最大非法子序列)
+ */
+extern int utf8_sequence_check(const char *data, size_t len);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _UTF8_SCAN_H_
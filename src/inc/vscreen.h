@@ -0,0 +1,92 @@
+/**
+ * @file vscreen.h
+ * @brief 虚拟屏幕：在内存中维护终端单元格，按帧输出与上一帧的差异
+ *        屏幕区域位于主机终端的当前光标处，滚出顶部的行作为普通文本输出，保留在主机终端的回滚历史中
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _VSCREEN_H_
+#define _VSCREEN_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct vscreen vscreen_t;
+
+/**
+ * @brief  创建虚拟屏幕
+ * @param  rows             行数
+ * @param  cols             列数
+ * @return vscreen_t*       虚拟屏幕, 失败返回NULL
+ */
+extern vscreen_t *vscreen_create(int rows, int cols);
+
+/**
+ * @brief  销毁虚拟屏幕
+ * @param  vs               虚拟屏幕
+ */
+extern void vscreen_destroy(vscreen_t *vs);
+
+/**
+ * @brief  写入终端数据(文本、控制字符与转义序列)，只更新内存中的屏幕
+ * @param  vs               虚拟屏幕
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void vscreen_write(vscreen_t *vs, const char *data, size_t len);
+
+/**
+ * @brief  修改屏幕大小，下一帧整屏重绘
+ * @param  vs               虚拟屏幕
+ * @param  rows             行数
+ * @param  cols             列数
+ */
+extern void vscreen_resize(vscreen_t *vs, int rows, int cols);
+
+/**
+ * @brief  把区域固定在主机屏幕的指定位置，用于多个区域分屏显示：按绝对位置输出，滚出顶部的行丢弃，
+ *         擦除只影响区域内的列，下一帧整个区域重绘
+ * @param  vs               虚拟屏幕
+ * @param  row              区域第一行在主机屏幕上的行号(从1开始)，0 恢复为跟随光标的区域
+ * @param  col              区域第一列在主机屏幕上的列号(从1开始)
+ */
+extern void vscreen_set_origin(vscreen_t *vs, int row, int col);
+
+/**
+ * @brief  主机屏幕的内容未知(被其它输出覆盖)，下一帧整个区域重绘
+ * @param  vs               虚拟屏幕
+ */
+extern void vscreen_invalidate(vscreen_t *vs);
+
+/**
+ * @brief  上一帧之后屏幕是否有变化
+ * @param  vs               虚拟屏幕
+ * @return int              1 有变化, 0 没有
+ */
+extern int vscreen_dirty(const vscreen_t *vs);
+
+/**
+ * @brief  生成一帧：滚出的行、变化的单元格与光标位置，一次性交给 out 输出
+ * @param  vs               虚拟屏幕
+ * @param  out              输出函数
+ * @param  ctx              输出函数上下文
+ */
+extern void vscreen_render(vscreen_t *vs, void (*out)(void *ctx, const char *data, size_t len), void *ctx);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _VSCREEN_H_
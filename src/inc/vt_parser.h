@@ -0,0 +1,100 @@
+/**
+ * @file vt_parser.h
+ * @brief 表驱动的 VT500 兼容转义序列解析器
+ *        文本与转义序列以输入缓冲区中的范围回调，只有跨越数据块的序列才会复制到解析器内部的固定缓冲区
+ *        文本按 UTF-8 校验，非法字节替换为 U+FFFD，跨越数据块的字符在下一个数据块补全
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _VT_PARSER_H_
+#define _VT_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+#define VT_PARSER_MAX_PARAMS        16
+#define VT_PARSER_MAX_INTERMEDIATES 2
+#define VT_PARSER_SEQ_BUF_SIZE      256         // 跨数据块序列的最大长度，超过时丢弃该序列
+
+typedef struct vt_parser vt_parser_t;
+
+/**
+ * @brief 一个完整的转义序列
+ */
+struct vt_sequence {
+    const char *data;                               ///< 序列的原始字节(从 ESC 开始)
+    size_t len;                                     ///< 序列长度
+    uint8_t final;                                  ///< 结束字符，字符串序列为其引导字符(']'、'P'等)
+    uint8_t private_marker;                         ///< CSI 私有标记('?'、'>'等)，没有时为0
+    uint8_t intermediate_num;
+    uint8_t intermediates[VT_PARSER_MAX_INTERMEDIATES];
+    uint8_t param_num;
+    uint16_t params[VT_PARSER_MAX_PARAMS];          ///< 省略的参数为0
+};
+
+struct vt_parser_callbacks {
+    /** 可显示的合法 UTF-8 文本，通常是输入中的一段连续范围，补全的字符与 U+FFFD 来自解析器内部 */
+    void (*print)(void *ctx, const char *data, size_t len);
+    /** C0 控制字符 */
+    void (*execute)(void *ctx, uint8_t c);
+    /** ESC 序列 */
+    void (*esc_dispatch)(void *ctx, const struct vt_sequence *seq);
+    /** CSI 序列 */
+    void (*csi_dispatch)(void *ctx, const struct vt_sequence *seq);
+    /** OSC/DCS/SOS/PM/APC 字符串序列，以 BEL 结束时包含 BEL，以 ST 结束时 ST 作为单独的 ESC 序列回调 */
+    void (*string_dispatch)(void *ctx, const struct vt_sequence *seq);
+};
+
+/**
+ * @brief  创建解析器
+ * @param  cb               回调函数，不需要的回调可以为NULL
+ * @param  ctx              回调上下文
+ * @return vt_parser_t*     解析器
+ */
+extern vt_parser_t *vt_parser_create(const struct vt_parser_callbacks *cb, void *ctx);
+
+/**
+ * @brief  销毁解析器
+ * @param  vt               解析器
+ */
+extern void vt_parser_destroy(vt_parser_t *vt);
+
+/**
+ * @brief  输入一段数据，未完成的序列在多次调用之间保持
+ * @param  vt               解析器
+ * @param  data             数据指针
+ * @param  len              数据长度
+ */
+extern void vt_parser_feed(vt_parser_t *vt, const char *data, size_t len);
+
+/**
+ * @brief  回到初始状态，丢弃未完成的序列
+ * @param  vt               解析器
+ */
+extern void vt_parser_reset(vt_parser_t *vt);
+
+/**
+ * @brief  获取被替换为 U+FFFD 的非法 UTF-8 字节数
+ * @param  vt               解析器
+ * @return uint64_t         字节数
+ */
+extern uint64_t vt_parser_invalid_bytes(const vt_parser_t *vt);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _VT_PARSER_H_
@@ -0,0 +1,63 @@
+/**
+ * @file work_pool.h
+ * @brief 任务窃取线程池：每个线程有自己的任务队列，空闲时从其它线程的队列中取任务
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#ifndef _WORK_POOL_H_
+#define _WORK_POOL_H_
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C"{
+#endif
+#endif /* __cplusplus */
+
+typedef struct work_pool work_pool_t;
+
+/**
+ * @brief  创建线程池
+ * @param  threads          线程数，0 为 CPU 核数
+ * @return work_pool_t*     线程池，失败返回 NULL
+ */
+extern work_pool_t *work_pool_create(int threads);
+
+/**
+ * @brief  等待所有任务完成后销毁线程池
+ * @param  pool             线程池
+ */
+extern void work_pool_destroy(work_pool_t *pool);
+
+/**
+ * @brief  线程数
+ * @param  pool             线程池
+ * @return int              线程数
+ */
+extern int work_pool_threads(const work_pool_t *pool);
+
+/**
+ * @brief  提交任务，按轮转放入各线程的队列，先提交的任务先执行
+ * @param  pool             线程池
+ * @param  fn               任务函数，在池中的线程执行
+ * @param  arg              任务参数
+ */
+extern void work_pool_submit(work_pool_t *pool, void (*fn)(void *arg), void *arg);
+
+/**
+ * @brief  等待已提交的任务全部完成
+ * @param  pool             线程池
+ */
+extern void work_pool_wait(work_pool_t *pool);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* __cplusplus */
+
+
+#endif // _WORK_POOL_H_
@@ -0,0 +1,219 @@
+/**
+ * @file itm_parser.cpp
+ * @brief ITM/DWT 数据包流式解析(SWO 数据)，支持数据包跨越多次数据块
+ *        printf 类输出通常是连续的单字节激励端口包(头, 数据, 头, 数据...)，
+ *        这种情况用 SSE2 一次校验 8 个包并提取数据，其余数据包走逐字节状态机
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ITM_PARSER_USE_SSE2 1
+#endif
+
+#include "itm_parser.h"
+
+#define ITM_HEADER_SYNC             0x00
+#define ITM_HEADER_OVERFLOW         0x70
+#define ITM_HEADER_GTS1             0x94
+#define ITM_HEADER_GTS2             0xB4
+#define ITM_DWT_ID_PC_SAMPLE        2
+#define ITM_SYNC_END                0x80
+#define ITM_CONTINUATION_MAX        7           // 时间戳/扩展包最多的后续字节数
+
+enum itm_parse_state{
+    ITM_PARSE_HEADER = 0,
+    ITM_PARSE_PAYLOAD,
+    ITM_PARSE_CONTINUATION,
+    ITM_PARSE_SYNC,
+};
+
+struct itm_parser{
+    struct itm_parser_callbacks cb;
+    void *ctx;
+    struct itm_parser_stats stats;
+    itm_parse_state state;
+    uint8_t header;
+    uint8_t need;
+    uint8_t got;
+    uint8_t payload[4];
+    int run_port;                       // run 中数据所属的端口，-1 表示 run 为空
+    std::vector<uint8_t> run;           // 合并中的激励端口数据
+};
+
+static void itm_flush_run(itm_parser_t *parser){
+    if(parser->run_port >= 0 && !parser->run.empty() && parser->cb.stimulus)
+        parser->cb.stimulus(parser->ctx, parser->run_port, parser->run.data(), parser->run.size());
+    parser->run.clear();
+    parser->run_port = -1;
+}
+
+static void itm_stimulus(itm_parser_t *parser, int port, const uint8_t *data, size_t len){
+    if(parser->run_port != port){
+        itm_flush_run(parser);
+        parser->run_port = port;
+    }
+    parser->run.insert(parser->run.end(), data, data + len);
+    parser->stats.stimulus_bytes += len;
+}
+
+static void itm_source_packet(itm_parser_t *parser){
+    parser->stats.packets++;
+    if(!(parser->header & 0x04)){
+        itm_stimulus(parser, parser->header >> 3, parser->payload, parser->need);
+        return;
+    }
+    if((parser->header >> 3) != ITM_DWT_ID_PC_SAMPLE)
+        return;
+    parser->stats.pc_samples++;
+    itm_flush_run(parser);
+    if(!parser->cb.pc_sample)
+        return;
+    if(parser->need == 4){
+        uint32_t pc = uint32_t(parser->payload[0]) | uint32_t(parser->payload[1]) << 8 |
+            uint32_t(parser->payload[2]) << 16 | uint32_t(parser->payload[3]) << 24;
+        parser->cb.pc_sample(parser->ctx, pc, 0);
+    }else{
+        parser->cb.pc_sample(parser->ctx, 0, 1);
+    }
+}
+
+/**
+ * @brief                   连续单字节激励端口包的快速路径
+ * @param  header           已确认的包头(端口, 长度1)
+ * @return size_t           处理的字节数(偶数，包含包头)
+ */
+static size_t itm_fast_stimulus(itm_parser_t *parser, uint8_t header, const uint8_t *data, size_t len){
+    size_t off = 0;
+#ifdef ITM_PARSER_USE_SSE2
+    const __m128i low_mask = _mm_set1_epi16(0x00ff);
+    const __m128i headers = _mm_set1_epi16(short(header));
+    uint8_t text[8];
+    while(len - off >= 16){
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + off));
+        __m128i eq = _mm_cmpeq_epi16(_mm_and_si128(v, low_mask), headers);
+        if(_mm_movemask_epi8(eq) != 0xffff)
+            break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(text), _mm_packus_epi16(_mm_srli_epi16(v, 8), _mm_setzero_si128()));
+        itm_stimulus(parser, header >> 3, text, sizeof(text));
+        off += 16;
+    }
+#endif
+    while(len - off >= 2 && data[off] == header){
+        itm_stimulus(parser, header >> 3, data + off + 1, 1);
+        off += 2;
+    }
+    parser->stats.packets += off / 2;
+    return off;
+}
+
+extern "C"{
+
+itm_parser_t *itm_parser_create(const struct itm_parser_callbacks *cb, void *ctx){
+    itm_parser_t *parser = new itm_parser_t;
+    parser->cb = cb ? *cb : itm_parser_callbacks{};
+    parser->ctx = ctx;
+    parser->stats = {};
+    parser->state = ITM_PARSE_HEADER;
+    parser->header = 0;
+    parser->need = 0;
+    parser->got = 0;
+    parser->run_port = -1;
+    return parser;
+}
+
+void itm_parser_destroy(itm_parser_t *parser){
+    delete parser;
+}
+
+void itm_parser_feed(itm_parser_t *parser, const uint8_t *data, size_t len){
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    while(p < end){
+        uint8_t b = *p;
+        switch(parser->state){
+            case ITM_PARSE_HEADER:
+                if((b & 0x07) == 0x01){
+                    size_t n = itm_fast_stimulus(parser, b, p, size_t(end - p));
+                    if(n > 0){
+                        p += n;
+                        continue;
+                    }
+                }
+                p++;
+                if(b == ITM_HEADER_SYNC){
+                    parser->state = ITM_PARSE_SYNC;
+                }else if(b == ITM_HEADER_OVERFLOW){
+                    parser->stats.packets++;
+                    parser->stats.overflows++;
+                    itm_flush_run(parser);
+                    if(parser->cb.overflow)
+                        parser->cb.overflow(parser->ctx);
+                }else if(b & 0x03){
+                    /* 激励端口或 DWT 硬件数据包，长度 1/2/4 */
+                    parser->header = b;
+                    parser->need = (b & 0x03) == 0x03 ? 4 : (b & 0x03);
+                    parser->got = 0;
+                    parser->state = ITM_PARSE_PAYLOAD;
+                }else if((b & 0x0f) == 0x00 || b == ITM_HEADER_GTS1 || b == ITM_HEADER_GTS2 || (b & 0x0b) == 0x08){
+                    /* 本地/全局时间戳与扩展包，C 位为1时有后续字节 */
+                    if(b & 0x80){
+                        parser->got = 0;
+                        parser->state = ITM_PARSE_CONTINUATION;
+                    }else{
+                        parser->stats.packets++;
+                    }
+                }else{
+                    parser->stats.errors++;
+                }
+                break;
+            case ITM_PARSE_PAYLOAD:
+                p++;
+                parser->payload[parser->got++] = b;
+                if(parser->got == parser->need){
+                    itm_source_packet(parser);
+                    parser->state = ITM_PARSE_HEADER;
+                }
+                break;
+            case ITM_PARSE_CONTINUATION:
+                p++;
+                if(!(b & 0x80)){
+                    parser->stats.packets++;
+                    parser->state = ITM_PARSE_HEADER;
+                }else if(++parser->got >= ITM_CONTINUATION_MAX){
+                    parser->stats.errors++;
+                    parser->state = ITM_PARSE_HEADER;
+                }
+                break;
+            case ITM_PARSE_SYNC:
+                if(b == ITM_HEADER_SYNC){
+                    p++;
+                }else if(b == ITM_SYNC_END){
+                    p++;
+                    parser->stats.packets++;
+                    parser->stats.syncs++;
+                    parser->state = ITM_PARSE_HEADER;
+                }else{
+                    /* 不完整的同步包，当前字节按包头重新解析 */
+                    parser->stats.errors++;
+                    parser->state = ITM_PARSE_HEADER;
+                }
+                break;
+        }
+    }
+    itm_flush_run(parser);
+}
+
+void itm_parser_get_stats(const itm_parser_t *parser, struct itm_parser_stats *stats){
+    *stats = parser->stats;
+}
+
+}
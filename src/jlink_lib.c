@@ -9,6 +9,10 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -16,14 +20,27 @@
     #define DYNLIB_OPEN(path) LoadLibrary(path)
     #define DYNLIB_GET(handle, name) GetProcAddress(handle, name)
     #define DYNLIB_CLOSE(handle) FreeLibrary(handle)
+    typedef CRITICAL_SECTION jlink_trace_mutex_t;
+    #define jlink_trace_mutex_init(m) InitializeCriticalSection(m)
+    #define jlink_trace_mutex_lock(m) EnterCriticalSection(m)
+    #define jlink_trace_mutex_unlock(m) LeaveCriticalSection(m)
+    #define jlink_trace_mutex_destroy(m) DeleteCriticalSection(m)
 #else
     #include <dlfcn.h>
+    #include <pthread.h>
     #define DYNLIB_HANDLE void*
     #define DYNLIB_OPEN(path) dlopen(path, RTLD_LAZY)
     #define DYNLIB_GET(handle, name) dlsym(handle, name)
     #define DYNLIB_CLOSE(handle) dlclose(handle)
+    typedef pthread_mutex_t jlink_trace_mutex_t;
+    #define jlink_trace_mutex_init(m) pthread_mutex_init(m, NULL)
+    #define jlink_trace_mutex_lock(m) pthread_mutex_lock(m)
+    #define jlink_trace_mutex_unlock(m) pthread_mutex_unlock(m)
+    #define jlink_trace_mutex_destroy(m) pthread_mutex_destroy(m)
 #endif
 
+#include "jlink_lib.h"
+
 #ifdef _WIN32
   #define JLINK_CALL __stdcall
 #else
@@ -42,90 +59,855 @@ static void (JLINK_CALL *jlink_emu_get_product_name)(char *out, int size);
 static int  (JLINK_CALL *jlink_rtterminal_control)(int cmd, void *data);
 static int  (JLINK_CALL *jlink_rtterminal_read)(int channel, char *data, int len);
 static int  (JLINK_CALL *jlink_rtterminal_write)(int channel, const char *data, int len);
+static int  (JLINK_CALL *jlink_read_mem_ex)(uint32_t addr, uint32_t num_bytes, void *data, uint32_t flags);
+static int  (JLINK_CALL *jlink_write_mem)(uint32_t addr, uint32_t num_bytes, const void *data);
+static char (JLINK_CALL *jlink_has_error)(void);
+static void (JLINK_CALL *jlink_clr_error)(void);
+static char (JLINK_CALL *jlink_halt)(void);
+static char (JLINK_CALL *jlink_is_halted)(void);
+static void (JLINK_CALL *jlink_go)(void);
+static int  (JLINK_CALL *jlink_reset)(void);
+static int  (JLINK_CALL *jlink_read_regs)(const uint32_t *reg_index, uint32_t *data, uint8_t *status, uint32_t num);
+static int  (JLINK_CALL *jlink_swo_control)(uint32_t cmd, void *data);
+static void (JLINK_CALL *jlink_swo_read)(uint8_t *data, uint32_t offset, uint32_t *num_bytes);
+static int  (JLINK_CALL *jlink_swo_enable_target)(uint32_t cpu_speed, uint32_t swo_speed, int mode, uint32_t port_mask);
+static int  (JLINK_CALL *jlink_swo_disable_target)(uint32_t port_mask);
+static int  (JLINK_CALL *jlink_swo_get_compatible_speeds)(uint32_t cpu_speed, uint32_t max_swo_speed, uint32_t *speeds, uint32_t num);
  
 static DYNLIB_HANDLE jlink_lib_handle = NULL;
 
+/*
+ * 调用记录与回放
+ * 记录文件以 JLINK_TRACE_MAGIC 开头，之后每条记录:
+ *   u8 函数 | varint 与同一流上一条记录的时间差(us) | varint 重复次数 | [varint 重复持续时间(us)]
+ *   | zigzag 返回值 | u8 参数个数 | zigzag 参数... | varint 输入长度 输入数据 | varint 输出长度 输出数据
+ * 流按函数区分，RTT 读写和控制、SWO 控制再按第一个参数(通道或命令)区分，读内存按地址和长度区分；
+ * 同一个流上连续相同且没有数据的调用(例如没有数据时的 RTT 轮询)合并为一条记录
+ * 回放时每个流按记录的顺序返回结果，不同线程的调用顺序不影响结果
+ */
+#define JLINK_TRACE_MAGIC               "JLTRACE1"
+#define JLINK_TRACE_MAGIC_SIZE          8
+#define JLINK_TRACE_MAX_ARGS            4
+#define JLINK_TRACE_STREAMS_INIT        16          // 流数组的初始容量，不够时加倍
+#define JLINK_TRACE_HEADER_MAX          96          // 记录中数据之前的部分的最大长度
+#define JLINK_TRACE_RTT_DESC_SIZE       48          // struct rtt_desc
+#define JLINK_TRACE_RTT_DESC_IN_SIZE    8           // struct rtt_desc 的 index 和 direction
+#define JLINK_TRACE_RTT_STAT_SIZE       32          // struct rtt_stat
+#define JLINK_TRACE_SWO_START_SIZE      12          // struct swo_start_info
+#define JLINK_TRACE_SLEEP_MAX_US        100000      // 回放等待时每次最多睡眠的时间
+
+/* 与 jlink_api.h 中的命令一致 */
+#define JLINK_TRACE_RTT_CMD_GET_DESC        2
+#define JLINK_TRACE_RTT_CMD_GET_NUM_BUF     3
+#define JLINK_TRACE_RTT_CMD_GET_STAT        4
+#define JLINK_TRACE_SWO_CMD_START           0
+#define JLINK_TRACE_SWO_CMD_FLUSH           2
+#define JLINK_TRACE_SWO_CMD_SET_BUFFERSIZE_HOST 20
+#define JLINK_TRACE_SWO_CMD_SET_BUFFERSIZE_EMU  21
+
+enum jlink_trace_mode{
+    JLINK_TRACE_OFF = 0,
+    JLINK_TRACE_RECORD,
+    JLINK_TRACE_REPLAY,
+};
+
+enum jlink_trace_func{
+    JLINK_TRACE_FN_EMU_SELECT_BY_USBSN = 1,
+    JLINK_TRACE_FN_OPEN,
+    JLINK_TRACE_FN_CLOSE,
+    JLINK_TRACE_FN_GET_SN,
+    JLINK_TRACE_FN_SET_SPEED,
+    JLINK_TRACE_FN_TIF_SELECT,
+    JLINK_TRACE_FN_CONNECT,
+    JLINK_TRACE_FN_EXEC_COMMAND,
+    JLINK_TRACE_FN_EMU_GET_PRODUCT_NAME,
+    JLINK_TRACE_FN_RTTERMINAL_CONTROL,
+    JLINK_TRACE_FN_RTTERMINAL_READ,
+    JLINK_TRACE_FN_RTTERMINAL_WRITE,
+    JLINK_TRACE_FN_READ_MEM_EX,
+    JLINK_TRACE_FN_WRITE_MEM,
+    JLINK_TRACE_FN_HAS_ERROR,
+    JLINK_TRACE_FN_CLR_ERROR,
+    JLINK_TRACE_FN_HALT,
+    JLINK_TRACE_FN_IS_HALTED,
+    JLINK_TRACE_FN_GO,
+    JLINK_TRACE_FN_RESET,
+    JLINK_TRACE_FN_READ_REGS,
+    JLINK_TRACE_FN_SWO_CONTROL,
+    JLINK_TRACE_FN_SWO_READ,
+    JLINK_TRACE_FN_SWO_ENABLE_TARGET,
+    JLINK_TRACE_FN_SWO_DISABLE_TARGET,
+    JLINK_TRACE_FN_SWO_GET_COMPATIBLE_SPEEDS,
+};
+
+/* 一次调用，输出数据可以分两段(例如 JLINK_ReadRegs 的寄存器值和状态)，依次保存 */
+struct jlink_trace_call{
+    uint8_t func;
+    uint8_t nargs;
+    int64_t args[JLINK_TRACE_MAX_ARGS];
+    int64_t ret;
+    const void *in;
+    uint32_t in_len;
+    const void *out[2];
+    uint32_t out_len[2];
+};
+
+/* 记录时每个流还没有写入的合并调用 */
+struct jlink_trace_stream{
+    uint8_t func;
+    int64_t key;
+    uint64_t last_us;                   // 上一条写入记录的时间
+    int pending;
+    uint64_t pending_us;                // 第一次调用的时间
+    uint64_t pending_end_us;            // 最后一次调用的时间
+    uint64_t pending_repeat;            // 第一次之后的重复次数
+    struct jlink_trace_call pending_call;
+};
+
+struct jlink_replay_record{
+    uint64_t time_us;
+    uint64_t span_us;
+    uint64_t repeat;
+    int64_t ret;
+    const uint8_t *out;
+    uint32_t out_len;
+};
+
+struct jlink_replay_stream{
+    uint8_t func;
+    int64_t key;
+    struct jlink_replay_record *records;
+    size_t num;
+    size_t cap;
+    size_t cursor;
+    uint64_t served;                    // 当前记录已返回的次数
+};
+
+static int s_trace_mode = JLINK_TRACE_OFF;
+static jlink_trace_mutex_t s_trace_mtx;
+static uint64_t s_trace_start_us = 0;
+static FILE *s_trace_file = NULL;
+static struct jlink_trace_stream *s_trace_streams = NULL;
+static size_t s_trace_stream_num = 0;
+static size_t s_trace_stream_cap = 0;
+static uint8_t *s_replay_data = NULL;
+static struct jlink_replay_stream *s_replay_streams = NULL;
+static size_t s_replay_stream_num = 0;
+static size_t s_replay_stream_cap = 0;
+static double s_replay_speed = 1.0;
+static size_t s_replay_reads_left = 0;              // 还没有回放完的 RTT 读记录
+static int s_replay_ended = 0;                      // 已经调用过回放结束回调
+static void (*s_replay_end_cb)(void) = NULL;
+
+static uint64_t jlink_trace_now_us(void){
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000u + 
+        (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000u / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+static void jlink_trace_sleep_us(uint64_t us){
+#ifdef _WIN32
+    Sleep((DWORD)((us + 999) / 1000));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(us / 1000000u);
+    ts.tv_nsec = (long)(us % 1000000u) * 1000;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static size_t jlink_trace_put_varint(uint8_t *p, uint64_t v){
+    size_t n = 0;
+    while(v >= 0x80){
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static int jlink_trace_get_varint(const uint8_t **p, const uint8_t *end, uint64_t *v){
+    uint64_t value = 0;
+    for(unsigned shift = 0; *p < end && shift < 64; shift += 7){
+        uint8_t c = *(*p)++;
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if(!(c & 0x80)){
+            *v = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static uint64_t jlink_trace_zigzag(int64_t v){
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t jlink_trace_unzigzag(uint64_t v){
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/**
+ * @brief                   读内存的流的键，地址在高 32 位，长度在低 32 位
+ */
+static int64_t jlink_trace_mem_key(uint32_t addr, uint32_t num_bytes){
+    return (int64_t)((uint64_t)addr << 32 | num_bytes);
+}
+
+/**
+ * @brief                   流的键：RTT 读写和控制、SWO 控制为第一个参数(通道或命令)，读内存为地址和长度，其他函数为 0
+ *                          不同线程读取不同的内存(例如 RTT 线程读取缓冲区占用)不会落在同一个流上
+ */
+static int64_t jlink_trace_key(uint8_t func, const int64_t *args, uint8_t nargs){
+    if(nargs && (func == JLINK_TRACE_FN_RTTERMINAL_CONTROL || func == JLINK_TRACE_FN_RTTERMINAL_READ || 
+        func == JLINK_TRACE_FN_RTTERMINAL_WRITE || func == JLINK_TRACE_FN_SWO_CONTROL))
+        return args[0];
+    if(nargs >= 2 && func == JLINK_TRACE_FN_READ_MEM_EX)
+        return jlink_trace_mem_key((uint32_t)args[0], (uint32_t)args[1]);
+    return 0;
+}
+
+static void jlink_trace_write(struct jlink_trace_stream *stream, const struct jlink_trace_call *call, 
+    uint64_t time_us, uint64_t repeat, uint64_t span_us){
+    uint8_t header[JLINK_TRACE_HEADER_MAX];
+    size_t n = 0;
+    uint32_t out_len = call->out_len[0] + call->out_len[1];
+    header[n++] = call->func;
+    n += jlink_trace_put_varint(header + n, time_us - stream->last_us);
+    n += jlink_trace_put_varint(header + n, repeat);
+    if(repeat)
+        n += jlink_trace_put_varint(header + n, span_us);
+    n += jlink_trace_put_varint(header + n, jlink_trace_zigzag(call->ret));
+    header[n++] = call->nargs;
+    for(uint8_t i = 0; i < call->nargs; i++)
+        n += jlink_trace_put_varint(header + n, jlink_trace_zigzag(call->args[i]));
+    n += jlink_trace_put_varint(header + n, call->in_len);
+    fwrite(header, 1, n, s_trace_file);
+    if(call->in_len)
+        fwrite(call->in, 1, call->in_len, s_trace_file);
+    n = jlink_trace_put_varint(header, out_len);
+    fwrite(header, 1, n, s_trace_file);
+    for(int i = 0; i < 2; i++){
+        if(call->out_len[i])
+            fwrite(call->out[i], 1, call->out_len[i], s_trace_file);
+    }
+    stream->last_us = time_us;
+}
+
+static void jlink_trace_flush_pending(struct jlink_trace_stream *stream){
+    if(!stream->pending)
+        return ;
+    jlink_trace_write(stream, &stream->pending_call, stream->pending_us, stream->pending_repeat, 
+        stream->pending_end_us - stream->pending_us);
+    stream->pending = 0;
+}
+
+static int jlink_trace_same(const struct jlink_trace_call *a, const struct jlink_trace_call *b){
+    if(a->ret != b->ret || a->nargs != b->nargs)
+        return 0;
+    return memcmp(a->args, b->args, sizeof(a->args[0]) * a->nargs) == 0;
+}
+
+/**
+ * @brief                   记录一次调用，没有数据的调用先暂存，与之后相同的调用合并
+ */
+static void jlink_trace_record(const struct jlink_trace_call *call){
+    int64_t key = jlink_trace_key(call->func, call->args, call->nargs);
+    int has_data = call->in_len || call->out_len[0] || call->out_len[1];
+    struct jlink_trace_stream *stream = NULL;
+    jlink_trace_mutex_lock(&s_trace_mtx);
+    /* 在锁内取时间，同一个流中记录的时间不会倒退，时间差和持续时间不会回绕 */
+    uint64_t now = jlink_trace_now_us() - s_trace_start_us;
+    if(!s_trace_file){
+        jlink_trace_mutex_unlock(&s_trace_mtx);
+        return ;
+    }
+    for(size_t i = 0; i < s_trace_stream_num; i++){
+        if(s_trace_streams[i].func == call->func && s_trace_streams[i].key == key){
+            stream = &s_trace_streams[i];
+            break;
+        }
+    }
+    if(!stream && s_trace_stream_num == s_trace_stream_cap){
+        size_t cap = s_trace_stream_cap ? s_trace_stream_cap * 2 : JLINK_TRACE_STREAMS_INIT;
+        struct jlink_trace_stream *streams = (struct jlink_trace_stream *)realloc(s_trace_streams, cap * sizeof(*streams));
+        if(streams){
+            s_trace_streams = streams;
+            s_trace_stream_cap = cap;
+        }
+    }
+    if(!stream && s_trace_stream_num < s_trace_stream_cap){
+        stream = &s_trace_streams[s_trace_stream_num++];
+        memset(stream, 0, sizeof(*stream));
+        stream->func = call->func;
+        stream->key = key;
+    }
+    if(!stream){
+        jlink_trace_mutex_unlock(&s_trace_mtx);
+        return ;
+    }
+    if(stream->pending && !has_data && jlink_trace_same(&stream->pending_call, call)){
+        stream->pending_repeat++;
+        stream->pending_end_us = now;
+    }else{
+        jlink_trace_flush_pending(stream);
+        if(has_data){
+            jlink_trace_write(stream, call, now, 0, 0);
+        }else{
+            stream->pending = 1;
+            stream->pending_us = now;
+            stream->pending_end_us = now;
+            stream->pending_repeat = 0;
+            stream->pending_call = *call;
+        }
+    }
+    jlink_trace_mutex_unlock(&s_trace_mtx);
+}
+
+static struct jlink_replay_stream *jlink_replay_stream_get(uint8_t func, int64_t key, int create){
+    for(size_t i = 0; i < s_replay_stream_num; i++){
+        if(s_replay_streams[i].func == func && s_replay_streams[i].key == key)
+            return &s_replay_streams[i];
+    }
+    if(!create)
+        return NULL;
+    if(s_replay_stream_num == s_replay_stream_cap){
+        size_t cap = s_replay_stream_cap ? s_replay_stream_cap * 2 : JLINK_TRACE_STREAMS_INIT;
+        struct jlink_replay_stream *streams = (struct jlink_replay_stream *)realloc(s_replay_streams, cap * sizeof(*streams));
+        if(!streams)
+            return NULL;
+        s_replay_streams = streams;
+        s_replay_stream_cap = cap;
+    }
+    struct jlink_replay_stream *stream = &s_replay_streams[s_replay_stream_num++];
+    memset(stream, 0, sizeof(*stream));
+    stream->func = func;
+    stream->key = key;
+    return stream;
+}
+
+/**
+ * @brief                   解析记录文件，每条记录放入所属的流
+ * @return int              0 成功, -1 文件格式错误
+ */
+static int jlink_replay_parse(const uint8_t *p, const uint8_t *end){
+    while(p < end){
+        struct jlink_replay_record record;
+        uint64_t dt, ret, nargs, arg, in_len, out_len;
+        int64_t args[JLINK_TRACE_MAX_ARGS] = {0};
+        uint8_t func = *p++;
+        record.span_us = 0;
+        if(jlink_trace_get_varint(&p, end, &dt) < 0 || jlink_trace_get_varint(&p, end, &record.repeat) < 0 ||
+            (record.repeat && jlink_trace_get_varint(&p, end, &record.span_us) < 0) || 
+            jlink_trace_get_varint(&p, end, &ret) < 0 || p >= end)
+            return -1;
+        nargs = *p++;
+        for(uint64_t i = 0; i < nargs; i++){
+            if(jlink_trace_get_varint(&p, end, &arg) < 0)
+                return -1;
+            if(i < JLINK_TRACE_MAX_ARGS)
+                args[i] = jlink_trace_unzigzag(arg);
+        }
+        if(jlink_trace_get_varint(&p, end, &in_len) < 0 || in_len > (uint64_t)(end - p))
+            return -1;
+        p += in_len;
+        if(jlink_trace_get_varint(&p, end, &out_len) < 0 || out_len > (uint64_t)(end - p))
+            return -1;
+        record.ret = jlink_trace_unzigzag(ret);
+        record.out = p;
+        record.out_len = (uint32_t)out_len;
+        p += out_len;
+
+        struct jlink_replay_stream *stream = jlink_replay_stream_get(func, 
+            jlink_trace_key(func, args, (uint8_t)(nargs < JLINK_TRACE_MAX_ARGS ? nargs : JLINK_TRACE_MAX_ARGS)), 1);
+        if(!stream)
+            return -1;
+        if(stream->num == stream->cap){
+            size_t cap = stream->cap ? stream->cap * 2 : 64;
+            struct jlink_replay_record *records = (struct jlink_replay_record *)realloc(stream->records, cap * sizeof(*records));
+            if(!records)
+                return -1;
+            stream->records = records;
+            stream->cap = cap;
+        }
+        record.time_us = (stream->num ? stream->records[stream->num - 1].time_us : 0) + dt;
+        stream->records[stream->num++] = record;
+        if(func == JLINK_TRACE_FN_RTTERMINAL_READ)
+            s_replay_reads_left++;
+    }
+    return 0;
+}
+
+/**
+ * @brief                   返回流中下一次调用的结果，按回放速度等到记录的时间
+ *                          输出数据依次复制到 out0 和 out1，流已经回放完时返回 0 并且没有输出
+ *                          所有 RTT 读记录都回放完后，下一次 RTT 读取时调用回放结束回调，此时最后的数据已经交给了读取方
+ * @return int64_t          记录的返回值
+ */
+static int64_t jlink_trace_replay(uint8_t func, int64_t key, void *out0, uint32_t size0, void *out1, uint32_t size1){
+    const struct jlink_replay_record *record = NULL;
+    uint64_t due_us = 0;
+    int end = 0;
+    jlink_trace_mutex_lock(&s_trace_mtx);
+    struct jlink_replay_stream *stream = jlink_replay_stream_get(func, key, 0);
+    if(stream && stream->cursor < stream->num){
+        record = &stream->records[stream->cursor];
+        /* 合并的重复调用均匀分布在持续时间内 */
+        due_us = record->time_us + (record->repeat ? record->span_us * stream->served / record->repeat : 0);
+        if(++stream->served > record->repeat){
+            stream->served = 0;
+            stream->cursor++;
+            if(func == JLINK_TRACE_FN_RTTERMINAL_READ)
+                s_replay_reads_left--;
+        }
+    }else if(func == JLINK_TRACE_FN_RTTERMINAL_READ && s_replay_reads_left == 0 && !s_replay_ended){
+        s_replay_ended = 1;
+        end = 1;
+    }
+    jlink_trace_mutex_unlock(&s_trace_mtx);
+    if(end && s_replay_end_cb)
+        s_replay_end_cb();
+    if(!record)
+        return 0;
+    if(s_replay_speed > 0){
+        uint64_t target = s_trace_start_us + (uint64_t)((double)due_us / s_replay_speed);
+        for(uint64_t now = jlink_trace_now_us(); now < target; now = jlink_trace_now_us())
+            jlink_trace_sleep_us(target - now < JLINK_TRACE_SLEEP_MAX_US ? target - now : JLINK_TRACE_SLEEP_MAX_US);
+    }
+    uint32_t len0 = record->out_len < size0 ? record->out_len : size0;
+    uint32_t len1 = record->out_len - len0 < size1 ? record->out_len - len0 : size1;
+    if(len0)
+        memcpy(out0, record->out, len0);
+    if(len1)
+        memcpy(out1, record->out + len0, len1);
+    return record->ret;
+}
+
+static uint32_t jlink_trace_strlen(const char *str, int size){
+    uint32_t len = 0;
+    if(!str || size <= 0)
+        return 0;
+    while(len < (uint32_t)size && str[len])
+        len++;
+    return len < (uint32_t)size ? len + 1 : len;
+}
+
+static uint32_t jlink_trace_rtt_control_in_size(int cmd){
+    if(cmd == JLINK_TRACE_RTT_CMD_GET_DESC)
+        return JLINK_TRACE_RTT_DESC_IN_SIZE;
+    if(cmd == JLINK_TRACE_RTT_CMD_GET_NUM_BUF)
+        return sizeof(int);
+    return 0;
+}
+
+static uint32_t jlink_trace_rtt_control_out_size(int cmd){
+    if(cmd == JLINK_TRACE_RTT_CMD_GET_DESC)
+        return JLINK_TRACE_RTT_DESC_SIZE;
+    if(cmd == JLINK_TRACE_RTT_CMD_GET_STAT)
+        return JLINK_TRACE_RTT_STAT_SIZE;
+    return 0;
+}
+
+static uint32_t jlink_trace_swo_control_in_size(uint32_t cmd){
+    if(cmd == JLINK_TRACE_SWO_CMD_START)
+        return JLINK_TRACE_SWO_START_SIZE;
+    if(cmd == JLINK_TRACE_SWO_CMD_FLUSH || cmd == JLINK_TRACE_SWO_CMD_SET_BUFFERSIZE_HOST || 
+        cmd == JLINK_TRACE_SWO_CMD_SET_BUFFERSIZE_EMU)
+        return sizeof(uint32_t);
+    return 0;
+}
+
 int JLINK_EMU_SelectByUSBSN(unsigned int usbsn){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_EMU_SELECT_BY_USBSN, 0, NULL, 0, NULL, 0);
     if(jlink_emu_select_by_usbsn){
-        return jlink_emu_select_by_usbsn(usbsn);
+        ret = jlink_emu_select_by_usbsn(usbsn);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_EMU_SELECT_BY_USBSN, .nargs = 1, .args = {usbsn}, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_Open(void){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_OPEN, 0, NULL, 0, NULL, 0);
     if(jlink_open){
-        return jlink_open();
+        ret = jlink_open();
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_OPEN, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_Close(void){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_CLOSE, 0, NULL, 0, NULL, 0);
     if(jlink_close){
-        return jlink_close();
+        ret = jlink_close();
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_CLOSE, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_GetSN(unsigned int *sn){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_GET_SN, 0, sn, sizeof(*sn), NULL, 0);
     if(jlink_get_sn){
-        return jlink_get_sn(sn);
+        ret = jlink_get_sn(sn);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_GET_SN, .ret = ret, 
+            .out = {sn}, .out_len = {ret >= 0 ? (uint32_t)sizeof(*sn) : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_SetSpeed(unsigned int speed){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_SET_SPEED, 0, NULL, 0, NULL, 0);
     if(jlink_set_speed){
-        return jlink_set_speed(speed);
+        ret = jlink_set_speed(speed);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SET_SPEED, .nargs = 1, .args = {speed}, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 int JLINK_TIF_Select(int tif){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_TIF_SELECT, 0, NULL, 0, NULL, 0);
     if(jlink_tif_select){
-        return jlink_tif_select(tif);
+        ret = jlink_tif_select(tif);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_TIF_SELECT, .nargs = 1, .args = {tif}, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_Connect(void){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_CONNECT, 0, NULL, 0, NULL, 0);
     if(jlink_connect){
-        return jlink_connect();
+        ret = jlink_connect();
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_CONNECT, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 int JLINK_ExecCommand(const char *in, char *out, int size){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_EXEC_COMMAND, 0, out, out && size > 0 ? (uint32_t)size : 0, NULL, 0);
     if(jlink_exec_command){
-        return jlink_exec_command(in, out, size);
+        ret = jlink_exec_command(in, out, size);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_EXEC_COMMAND, .nargs = 1, .args = {size}, .ret = ret, 
+            .in = in, .in_len = jlink_trace_strlen(in, INT32_MAX), .out = {out}, .out_len = {jlink_trace_strlen(out, size)}};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 void JLINK_EMU_GetProductName(char *out, int size){
+    if(s_trace_mode == JLINK_TRACE_REPLAY){
+        jlink_trace_replay(JLINK_TRACE_FN_EMU_GET_PRODUCT_NAME, 0, out, size > 0 ? (uint32_t)size : 0, NULL, 0);
+        return;
+    }
     if(jlink_emu_get_product_name){
         jlink_emu_get_product_name(out, size);
     }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_EMU_GET_PRODUCT_NAME, .nargs = 1, .args = {size}, 
+            .out = {out}, .out_len = {jlink_trace_strlen(out, size)}};
+        jlink_trace_record(&call);
+    }
 }
 
 int JLINK_RTTERMINAL_Control(int cmd, void *data){
+    int ret = -1;
+    uint32_t out_size = data ? jlink_trace_rtt_control_out_size(cmd) : 0;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_RTTERMINAL_CONTROL, cmd, data, out_size, NULL, 0);
     if(jlink_rtterminal_control){
-        return jlink_rtterminal_control(cmd, data);
+        ret = jlink_rtterminal_control(cmd, data);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_RTTERMINAL_CONTROL, .nargs = 1, .args = {cmd}, .ret = ret, 
+            .in = data, .in_len = data ? jlink_trace_rtt_control_in_size(cmd) : 0, 
+            .out = {data}, .out_len = {ret >= 0 ? out_size : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 
 
 int JLINK_RTTERMINAL_Read(int channel, char *data, int len){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_RTTERMINAL_READ, channel, data, len > 0 ? (uint32_t)len : 0, NULL, 0);
     if(jlink_rtterminal_read){
-        return jlink_rtterminal_read(channel, data, len);
+        ret = jlink_rtterminal_read(channel, data, len);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_RTTERMINAL_READ, .nargs = 2, .args = {channel, len}, .ret = ret, 
+            .out = {data}, .out_len = {ret > 0 ? (uint32_t)ret : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 int JLINK_RTTERMINAL_Write(int channel, const char *data, int len){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_RTTERMINAL_WRITE, channel, NULL, 0, NULL, 0);
     if(jlink_rtterminal_write){
-        return jlink_rtterminal_write(channel, data, len);
+        ret = jlink_rtterminal_write(channel, data, len);
     }
-    return -1;
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_RTTERMINAL_WRITE, .nargs = 2, .args = {channel, len}, .ret = ret, 
+            .in = data, .in_len = len > 0 ? (uint32_t)len : 0};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_ReadMemEx(uint32_t addr, uint32_t num_bytes, void *data, uint32_t flags){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_READ_MEM_EX, jlink_trace_mem_key(addr, num_bytes), data, num_bytes, NULL, 0);
+    if(jlink_read_mem_ex){
+        ret = jlink_read_mem_ex(addr, num_bytes, data, flags);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_READ_MEM_EX, .nargs = 3, .args = {addr, num_bytes, flags}, .ret = ret, 
+            .out = {data}, .out_len = {ret > 0 ? ((uint32_t)ret < num_bytes ? (uint32_t)ret : num_bytes) : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_WriteMem(uint32_t addr, uint32_t num_bytes, const void *data){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_WRITE_MEM, 0, NULL, 0, NULL, 0);
+    if(jlink_write_mem){
+        ret = jlink_write_mem(addr, num_bytes, data);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_WRITE_MEM, .nargs = 2, .args = {addr, num_bytes}, .ret = ret, 
+            .in = data, .in_len = num_bytes};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+char JLINK_HasError(void){
+    char ret = 1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (char)jlink_trace_replay(JLINK_TRACE_FN_HAS_ERROR, 0, NULL, 0, NULL, 0);
+    if(jlink_has_error){
+        ret = jlink_has_error();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_HAS_ERROR, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+void JLINK_ClrError(void){
+    if(s_trace_mode == JLINK_TRACE_REPLAY){
+        jlink_trace_replay(JLINK_TRACE_FN_CLR_ERROR, 0, NULL, 0, NULL, 0);
+        return;
+    }
+    if(jlink_clr_error){
+        jlink_clr_error();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_CLR_ERROR};
+        jlink_trace_record(&call);
+    }
+}
+
+char JLINK_Halt(void){
+    char ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (char)jlink_trace_replay(JLINK_TRACE_FN_HALT, 0, NULL, 0, NULL, 0);
+    if(jlink_halt){
+        ret = jlink_halt();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_HALT, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+char JLINK_IsHalted(void){
+    char ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (char)jlink_trace_replay(JLINK_TRACE_FN_IS_HALTED, 0, NULL, 0, NULL, 0);
+    if(jlink_is_halted){
+        ret = jlink_is_halted();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_IS_HALTED, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+void JLINK_Go(void){
+    if(s_trace_mode == JLINK_TRACE_REPLAY){
+        jlink_trace_replay(JLINK_TRACE_FN_GO, 0, NULL, 0, NULL, 0);
+        return;
+    }
+    if(jlink_go){
+        jlink_go();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_GO};
+        jlink_trace_record(&call);
+    }
+}
+
+int JLINK_Reset(void){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_RESET, 0, NULL, 0, NULL, 0);
+    if(jlink_reset){
+        ret = jlink_reset();
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_RESET, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_ReadRegs(const uint32_t *reg_index, uint32_t *data, uint8_t *status, uint32_t num){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_READ_REGS, 0, data, num * (uint32_t)sizeof(*data), status, num);
+    if(jlink_read_regs){
+        ret = jlink_read_regs(reg_index, data, status, num);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_READ_REGS, .nargs = 1, .args = {num}, .ret = ret, 
+            .in = reg_index, .in_len = num * (uint32_t)sizeof(*reg_index), 
+            .out = {data, status}, .out_len = {ret >= 0 ? num * (uint32_t)sizeof(*data) : 0, ret >= 0 ? num : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_SWO_Control(uint32_t cmd, void *data){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_SWO_CONTROL, cmd, NULL, 0, NULL, 0);
+    if(jlink_swo_control){
+        ret = jlink_swo_control(cmd, data);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SWO_CONTROL, .nargs = 1, .args = {cmd}, .ret = ret, 
+            .in = data, .in_len = data ? jlink_trace_swo_control_in_size(cmd) : 0};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+void JLINK_SWO_Read(uint8_t *data, uint32_t offset, uint32_t *num_bytes){
+    if(s_trace_mode == JLINK_TRACE_REPLAY){
+        /* 返回值为实际读取的字节数 */
+        *num_bytes = (uint32_t)jlink_trace_replay(JLINK_TRACE_FN_SWO_READ, 0, data, *num_bytes, NULL, 0);
+        return;
+    }
+    uint32_t size = *num_bytes;
+    if(jlink_swo_read){
+        jlink_swo_read(data, offset, num_bytes);
+    }else{
+        *num_bytes = 0;
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SWO_READ, .nargs = 2, .args = {offset, size}, .ret = *num_bytes, 
+            .out = {data}, .out_len = {*num_bytes < size ? *num_bytes : size}};
+        jlink_trace_record(&call);
+    }
+}
+
+int JLINK_SWO_EnableTarget(uint32_t cpu_speed, uint32_t swo_speed, int mode, uint32_t port_mask){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_SWO_ENABLE_TARGET, 0, NULL, 0, NULL, 0);
+    if(jlink_swo_enable_target){
+        ret = jlink_swo_enable_target(cpu_speed, swo_speed, mode, port_mask);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SWO_ENABLE_TARGET, .nargs = 4, 
+            .args = {cpu_speed, swo_speed, mode, port_mask}, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_SWO_DisableTarget(uint32_t port_mask){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_SWO_DISABLE_TARGET, 0, NULL, 0, NULL, 0);
+    if(jlink_swo_disable_target){
+        ret = jlink_swo_disable_target(port_mask);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SWO_DISABLE_TARGET, .nargs = 1, .args = {port_mask}, .ret = ret};
+        jlink_trace_record(&call);
+    }
+    return ret;
+}
+
+int JLINK_SWO_GetCompatibleSpeeds(uint32_t cpu_speed, uint32_t max_swo_speed, uint32_t *speeds, uint32_t num){
+    int ret = -1;
+    if(s_trace_mode == JLINK_TRACE_REPLAY)
+        return (int)jlink_trace_replay(JLINK_TRACE_FN_SWO_GET_COMPATIBLE_SPEEDS, 0, speeds, num * (uint32_t)sizeof(*speeds), NULL, 0);
+    if(jlink_swo_get_compatible_speeds){
+        ret = jlink_swo_get_compatible_speeds(cpu_speed, max_swo_speed, speeds, num);
+    }
+    if(s_trace_mode == JLINK_TRACE_RECORD){
+        struct jlink_trace_call call = {.func = JLINK_TRACE_FN_SWO_GET_COMPATIBLE_SPEEDS, .nargs = 3, 
+            .args = {cpu_speed, max_swo_speed, num}, .ret = ret, 
+            .out = {speeds}, .out_len = {ret > 0 ? ((uint32_t)ret < num ? (uint32_t)ret : num) * (uint32_t)sizeof(*speeds) : 0}};
+        jlink_trace_record(&call);
+    }
+    return ret;
 }
 
 
@@ -155,11 +937,29 @@ int jlink_lib_init(void){
     jlink_rtterminal_control = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_RTTERMINAL_Control");
     jlink_rtterminal_read = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_RTTERMINAL_Read");
     jlink_rtterminal_write = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_RTTERMINAL_Write");
+    jlink_read_mem_ex = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_ReadMemEx");
+    jlink_write_mem = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_WriteMem");
+    jlink_has_error = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_HasError");
+    jlink_clr_error = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_ClrError");
+    jlink_halt = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_Halt");
+    jlink_is_halted = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_IsHalted");
+    jlink_go = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_Go");
+    jlink_reset = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_Reset");
+    jlink_read_regs = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_ReadRegs");
+    jlink_swo_control = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_SWO_Control");
+    jlink_swo_read = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_SWO_Read");
+    jlink_swo_enable_target = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_SWO_EnableTarget");
+    jlink_swo_disable_target = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_SWO_DisableTarget");
+    jlink_swo_get_compatible_speeds = (void*) DYNLIB_GET(jlink_lib_handle, "JLINK_SWO_GetCompatibleSpeeds");
 
     if( !jlink_emu_select_by_usbsn || !jlink_open || 
         !jlink_close || !jlink_get_sn || !jlink_set_speed || !jlink_tif_select || 
         !jlink_connect || !jlink_exec_command || !jlink_emu_get_product_name || 
-        !jlink_rtterminal_control || !jlink_rtterminal_read || !jlink_rtterminal_write){
+        !jlink_rtterminal_control || !jlink_rtterminal_read || !jlink_rtterminal_write ||
+        !jlink_read_mem_ex || !jlink_write_mem || !jlink_has_error || !jlink_clr_error || !jlink_halt ||
+        !jlink_is_halted || !jlink_go || !jlink_reset || !jlink_read_regs ||
+        !jlink_swo_control || !jlink_swo_read || !jlink_swo_enable_target ||
+        !jlink_swo_disable_target || !jlink_swo_get_compatible_speeds){
         return -1;
     }
 
@@ -171,6 +971,83 @@ void jlink_lib_deinit(void){
         DYNLIB_CLOSE(jlink_lib_handle);
         jlink_lib_handle = NULL;
     }
+    /* 此时已经没有线程调用 J-Link 接口 */
+    if(s_trace_mode != JLINK_TRACE_OFF){
+        s_trace_mode = JLINK_TRACE_OFF;
+        jlink_trace_mutex_destroy(&s_trace_mtx);
+    }
+    if(s_trace_file){
+        for(size_t i = 0; i < s_trace_stream_num; i++)
+            jlink_trace_flush_pending(&s_trace_streams[i]);
+        fclose(s_trace_file);
+        s_trace_file = NULL;
+    }
+    free(s_trace_streams);
+    s_trace_streams = NULL;
+    s_trace_stream_num = 0;
+    s_trace_stream_cap = 0;
+    for(size_t i = 0; i < s_replay_stream_num; i++)
+        free(s_replay_streams[i].records);
+    free(s_replay_streams);
+    s_replay_streams = NULL;
+    s_replay_stream_num = 0;
+    s_replay_stream_cap = 0;
+    s_replay_reads_left = 0;
+    s_replay_ended = 0;
+    free(s_replay_data);
+    s_replay_data = NULL;
+}
+int jlink_lib_record(const char *path){
+    if(s_trace_mode != JLINK_TRACE_OFF)
+        return -1;
+    s_trace_file = fopen(path, "wb");
+    if(!s_trace_file){
+        printf("open jlink trace %s failed\n", path);
+        return -1;
+    }
+    fwrite(JLINK_TRACE_MAGIC, 1, JLINK_TRACE_MAGIC_SIZE, s_trace_file);
+    jlink_trace_mutex_init(&s_trace_mtx);
+    s_trace_stream_num = 0;
+    s_trace_start_us = jlink_trace_now_us();
+    s_trace_mode = JLINK_TRACE_RECORD;
+    return 0;
 }
 
+int jlink_lib_replay(const char *path, double speed){
+    FILE *fp;
+    long size;
+    if(s_trace_mode != JLINK_TRACE_OFF)
+        return -1;
+    fp = fopen(path, "rb");
+    if(!fp){
+        printf("open jlink trace %s failed\n", path);
+        return -1;
+    }
+    if(fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < JLINK_TRACE_MAGIC_SIZE || fseek(fp, 0, SEEK_SET) != 0){
+        printf("jlink trace %s is invalid\n", path);
+        fclose(fp);
+        return -1;
+    }
+    s_replay_data = (uint8_t *)malloc((size_t)size);
+    if(!s_replay_data || fread(s_replay_data, 1, (size_t)size, fp) != (size_t)size || 
+        memcmp(s_replay_data, JLINK_TRACE_MAGIC, JLINK_TRACE_MAGIC_SIZE) != 0 ||
+        jlink_replay_parse(s_replay_data + JLINK_TRACE_MAGIC_SIZE, s_replay_data + size) < 0){
+        printf("jlink trace %s is invalid\n", path);
+        fclose(fp);
+        jlink_lib_deinit();
+        return -1;
+    }
+    fclose(fp);
+    jlink_trace_mutex_init(&s_trace_mtx);
+    s_replay_speed = speed;
+    s_trace_start_us = jlink_trace_now_us();
+    s_trace_mode = JLINK_TRACE_REPLAY;
+    return 0;
+}
+
+void jlink_lib_replay_set_end_callback(void (*cb)(void)){
+    s_replay_end_cb = cb;
+}
+
+
 
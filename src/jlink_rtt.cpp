@@ -9,6 +9,7 @@
  */
 
 #include <cstdio>
+#include <cstring>
 #include <queue>
 #include <vector>
 #include <mutex>
@@ -18,17 +19,27 @@
 #include <atomic>
 
 #include "jlink_api.h"
+#include "rtt_control_block.h"
 #include "jlink_rtt.h"
 
 #define RTT_FIND_BUFFER_MAX_RETRY_COUNT 100
 #define RTT_FIND_BUFFER_DOWN_MAX_RETRY_COUNT 10
 #define RTT_FIND_BUFFER_DELAY_MS 100
+#define RTT_RESET_FIND_BUFFER_DELAY_MS 1    // 复位采集时目标刚启动，快速轮询缓冲区
 
 // Ctrl+C 超时检测相关参数
 #define CTRL_C_TIMEOUT_MS 200        // Ctrl+C 超时时间
 #define CTRL_C_ISOLATION_MS 50       // Ctrl+C 前后隔离时间
 #define CTRL_C_CHAR 0x03             // Ctrl+C 的ASCII码
 
+// 附加通道相关参数
+#define RTT_ATTACH_MAX_CHANNELS 4
+#define RTT_ATTACH_BUF_SIZE 0x4000
+#define RTT_ATTACH_MAX_READS 16      // 每轮最多连续读取附加通道的次数，避免饿死终端通道
+#define RTT_CHANNEL_WRITE_RETRY 10
+#define RTT_IDLE_POLL_US 100         // 没有数据时的轮询间隔
+#define RTT_EARLY_DATA_MAX 0x100000  // 接收回调设置前最多缓存的数据，超过后暂停读取，数据留在 J-Link 主机缓冲区
+
 static int s_rtt_up_buffer_num = 0;
 static int s_rtt_down_buffer_num = 0;
 static int s_rtt_tx_channel = -1;
@@ -37,20 +48,105 @@ static std::mutex s_mtx;
 static std::condition_variable s_cv;
 static std::queue<std::vector<char>> s_rtt_rx_queue;
 static char s_rtt_rx_buf[1024];
+static std::vector<char> s_rtt_early_data;              // 接收回调设置前读到的数据，只在 RTT 线程中访问
 static bool s_req_stop = false;
 static std::thread *s_rtt_thread = nullptr;
 
+/* 附加的上行通道，优先于终端通道读取；先写入条目再增加计数，读线程只读取计数以内的条目 */
+struct rtt_attached_channel{
+    int channel;
+    void (*cb)(int channel, const char *data, size_t len);
+};
+static rtt_attached_channel s_attached[RTT_ATTACH_MAX_CHANNELS];
+static std::atomic<int> s_attached_num{0};
+static char s_rtt_attach_buf[RTT_ATTACH_BUF_SIZE];
+static std::queue<std::pair<int, std::vector<char>>> s_rtt_channel_tx_queue;
+
+/* 复位采集：记录从释放内核到读到第一个字节的时间 */
+static bool s_reset_capture = false;
+static std::chrono::steady_clock::time_point s_reset_time;
+
 // Ctrl+C 超时检测相关变量
 static std::atomic<bool> s_ctrl_c_pending{false};
 static std::atomic<std::chrono::steady_clock::time_point> s_ctrl_c_sent_time{};
 static std::atomic<std::chrono::steady_clock::time_point> s_last_data_time{};
 static std::atomic<bool> s_ctrl_c_timeout_active{false};
 
+// 统计，计数只做 relaxed 累加；溢出次数和缓冲区占用在请求时由 RTT 线程读取
+static unsigned long s_rtt_cb_addr = 0;                 // 控制块地址，0 为未知
+static std::atomic<uint64_t> s_stat_rx_bytes{0};
+static std::atomic<uint64_t> s_stat_tx_bytes{0};
+static std::atomic<uint64_t> s_stat_tx_drops{0};
+static std::atomic<uint64_t> s_stat_polls{0};
+static std::atomic<uint64_t> s_stat_poll_time_us{0};
+static std::atomic<bool> s_stat_probe{false};
+static std::atomic<int> s_stat_host_overflows{-1};
+static std::atomic<int> s_stat_fill{-1};
+
 extern "C" { 
     static void (*s_rx_cb)(const char *data, size_t len) = nullptr;
     static void (*s_err_cb)(jlink_rtt_error_type_t error_type) = nullptr;
 }
 
+/**
+ * @brief                   读空附加通道
+ * @return bool             是否读到了数据
+ */
+static bool rtt_drain_attached(void){
+    bool has_data = false;
+    int num = s_attached_num.load(std::memory_order_acquire);
+    for(int i = 0; i < num; i++){
+        for(int n = 0; n < RTT_ATTACH_MAX_READS; n++){
+            int len = JLINK_RTTERMINAL_Read(s_attached[i].channel, s_rtt_attach_buf, sizeof(s_rtt_attach_buf));
+            if(len <= 0){
+                if(len < 0)
+                    std::printf("JLINK_RTTERMINAL_Read, channel = %d, len = %d\n", s_attached[i].channel, len);
+                break;
+            }
+            has_data = true;
+            s_stat_rx_bytes.fetch_add(uint64_t(len), std::memory_order_relaxed);
+            s_attached[i].cb(s_attached[i].channel, s_rtt_attach_buf, size_t(len));
+        }
+    }
+    return has_data;
+}
+
+static void rtt_channel_write(int channel, const std::vector<char> &data){
+    size_t off = 0;
+    for(int i = 0; off < data.size() && i < RTT_CHANNEL_WRITE_RETRY; i++){
+        int ret = JLINK_RTTERMINAL_Write(channel, data.data() + off, int(data.size() - off));
+        if(ret < 0)
+            break;
+        off += size_t(ret);
+        if(ret == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    s_stat_tx_bytes.fetch_add(off, std::memory_order_relaxed);
+    if(off < data.size()){
+        s_stat_tx_drops.fetch_add(1, std::memory_order_relaxed);
+        std::printf("JLINK_RTTERMINAL_Write, channel = %d, %zu bytes dropped\n", channel, data.size() - off);
+    }
+}
+
+/**
+ * @brief                   读取 J-Link 的主机溢出次数和终端上行缓冲区的占用，只在统计请求后执行一次
+ */
+static void rtt_stat_probe(void){
+    struct rtt_stat stat = {};
+    if(JLINK_RTTERMINAL_Control(RTT_CMD_GET_STAT, &stat) >= 0)
+        s_stat_host_overflows.store(stat.host_overflow_count, std::memory_order_relaxed);
+    if(s_rtt_cb_addr){
+        /* SizeOfBuffer、WrOff、RdOff */
+        uint32_t desc[3];
+        uint32_t addr = uint32_t(s_rtt_cb_addr + RTT_CB_HEADER_SIZE + unsigned(s_rtt_rx_channel) * RTT_CB_BUFFER_DESC_SIZE + 8);
+        if(JLINK_ReadMemEx(addr, sizeof(desc), desc, 0) == int(sizeof(desc)) && desc[0] && 
+            desc[1] < desc[0] && desc[2] < desc[0]){
+            uint32_t used = desc[1] >= desc[2] ? desc[1] - desc[2] : desc[0] - desc[2] + desc[1];
+            s_stat_fill.store(int(uint64_t(used) * 100 / desc[0]), std::memory_order_relaxed);
+        }
+    }
+}
+
 // 超时检测线程函数
 static void timeout_thread(void) {
     while (!s_req_stop) {
@@ -88,7 +184,9 @@ static void rtt_thread(void){
     };
     rtt_read_state read_state = RTT_RECV_TRY_READ;
     rtt_write_state write_state = RTT_SEND_TRY_WRITE;
+    auto last_poll = std::chrono::steady_clock::now();
     std::vector<char> data;
+    std::pair<int, std::vector<char>> channel_data;
     
     // 启动超时检测线程
     std::thread timeout_detector(timeout_thread);
@@ -96,6 +194,11 @@ static void rtt_thread(void){
     while(true){
         while(true){
             std::unique_lock<std::mutex> lck(s_mtx);
+            if(!s_rtt_channel_tx_queue.empty()){
+                channel_data = std::move(s_rtt_channel_tx_queue.front());
+                s_rtt_channel_tx_queue.pop();
+                goto process_channel_data;
+            }
             if(write_state == RTT_SEND_TRY_WRITE && (!s_rtt_rx_queue.empty() || !data.empty())){
                 /* 合并queue里面的多个数据包到data */
                 while(!s_rtt_rx_queue.empty()){
@@ -107,10 +210,15 @@ static void rtt_thread(void){
             if(s_req_stop)
                 goto quit;
 
+            if(s_stat_probe.exchange(false, std::memory_order_relaxed)){
+                lck.unlock();
+                rtt_stat_probe();
+                continue;
+            }
             if(read_state == RTT_RECV_TRY_READ)
                 goto process_read;
             
-            s_cv.wait_for(lck,std::chrono::microseconds(100));
+            s_cv.wait_for(lck,std::chrono::microseconds(RTT_IDLE_POLL_US));
             read_state = RTT_RECV_TRY_READ;
             write_state = RTT_SEND_TRY_WRITE;
         }
@@ -119,6 +227,7 @@ static void rtt_thread(void){
         int ret;
         ret = JLINK_RTTERMINAL_Write(s_rtt_tx_channel, data.data(), (int)data.size());
         if(ret > 0){
+            s_stat_tx_bytes.fetch_add(uint64_t(ret), std::memory_order_relaxed);
             data.erase(data.begin(), data.begin() + ret);
         }else if(ret == 0){
             write_state = RTT_SEND_BLOCK;
@@ -130,9 +239,34 @@ static void rtt_thread(void){
         }
         continue;
     }
+    process_channel_data:
+        rtt_channel_write(channel_data.first, channel_data.second);
+        continue;
     process_read:
+        /* 复位采集时内核在设置接收回调前就已运行，先缓存启动阶段的输出，设置回调后按顺序交出 */
+        auto rx_cb = s_rx_cb;
+        if(rx_cb && !s_rtt_early_data.empty()){
+            rx_cb(s_rtt_early_data.data(), s_rtt_early_data.size());
+            std::vector<char>().swap(s_rtt_early_data);
+        }
+        bool attached_data = rtt_drain_attached();
+        if(!rx_cb && s_rtt_early_data.size() >= RTT_EARLY_DATA_MAX){
+            read_state = RTT_RECV_IDLE;
+            continue;
+        }
         int len = JLINK_RTTERMINAL_Read(s_rtt_rx_channel, s_rtt_rx_buf, sizeof(s_rtt_rx_buf));
+        /* 实际的轮询间隔取决于系统的定时精度，不一定是 RTT_IDLE_POLL_US */
+        auto poll_time = std::chrono::steady_clock::now();
+        s_stat_poll_time_us.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(poll_time - last_poll).count()), 
+            std::memory_order_relaxed);
+        s_stat_polls.fetch_add(1, std::memory_order_relaxed);
+        last_poll = poll_time;
         if(len > 0){
+            if(s_reset_capture){
+                s_reset_capture = false;
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_reset_time).count();
+                std::printf("reset capture: first byte %.1f ms after reset\r\n", double(us) / 1000.0);
+            }
             // 收到下位机回复，重置Ctrl+C超时状态
             if (s_ctrl_c_pending.load()) {
                 s_ctrl_c_pending.store(false);
@@ -140,10 +274,15 @@ static void rtt_thread(void){
                 s_ctrl_c_sent_time.store(std::chrono::steady_clock::time_point{});
             }
             
-            if(s_rx_cb)
-                s_rx_cb(s_rtt_rx_buf, size_t(len));
+            s_stat_rx_bytes.fetch_add(uint64_t(len), std::memory_order_relaxed);
+            if(rx_cb)
+                rx_cb(s_rtt_rx_buf, size_t(len));
+            else
+                s_rtt_early_data.insert(s_rtt_early_data.end(), s_rtt_rx_buf, s_rtt_rx_buf + len);
         }else if(len == 0){
-            read_state = RTT_RECV_IDLE;
+            /* 附加通道仍有数据时不进入等待 */
+            if(!attached_data)
+                read_state = RTT_RECV_IDLE;
         }else{
             std::printf("JLINK_RTTERMINAL_Read, rx_channel = %d, len = %d\n", s_rtt_rx_channel, len);
             if(s_err_cb)
@@ -158,36 +297,34 @@ quit:
 }
 
 
-extern "C"{
-
-int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned long range){
-    char cmd[128];
-    bool set_search_addr = false;
+/**
+ * @brief                   启动 RTT 并检查通道
+ * @param  cmd              设置RTT地址的命令，为NULL时由J-Link自动查找
+ * @param  up_num           已知的上行缓冲区数量，小于0时通过 RTT_CMD_GET_NUM_BUF 查询
+ * @param  down_num         已知的下行缓冲区数量，小于0时通过 RTT_CMD_GET_NUM_BUF 查询
+ * @param  reset_capture    为true时内核处于复位后暂停状态，启动 RTT 后再释放内核
+ * @param  cb_addr          控制块地址，用于读取缓冲区占用，0 为未知
+ */
+static int rtt_start(int tx_channel, int rx_channel, const char *cmd, int up_num, int down_num, bool reset_capture, unsigned long cb_addr){
     int ret = 0;
     int direction;
-    s_rtt_up_buffer_num = -1;
-    s_rtt_down_buffer_num = -1;
+    int delay_ms = reset_capture ? RTT_RESET_FIND_BUFFER_DELAY_MS : RTT_FIND_BUFFER_DELAY_MS;
+    int retry_count = RTT_FIND_BUFFER_MAX_RETRY_COUNT * RTT_FIND_BUFFER_DELAY_MS / delay_ms;
+    s_rtt_up_buffer_num = up_num;
+    s_rtt_down_buffer_num = down_num;
     
     // 初始化Ctrl+C检测状态
     s_ctrl_c_pending.store(false);
     s_ctrl_c_timeout_active.store(false);
     s_ctrl_c_sent_time.store(std::chrono::steady_clock::time_point{});
     s_last_data_time.store(std::chrono::steady_clock::time_point{});
-    
-    if(addr && range){
-        std::snprintf(cmd, sizeof(cmd), "SetRTTSearchRanges %#lx %#lx", addr, range);
-        set_search_addr = true;
-    }else if(addr){
-        std::snprintf(cmd, sizeof(cmd), "SetRTTAddr %#lx", addr);
-        set_search_addr = true;
-    }
 
     if(rx_channel < 0){
         std::printf("rx_channel %d is invalid\n", rx_channel);
         return -1;
     }
 
-    if(set_search_addr){
+    if(cmd){
         ret = JLINK_ExecCommand(cmd, NULL, 0);
         if(ret < 0){
             std::printf("SetRTTSearchRanges or SetRTTAddr failed, ret = %d\n", ret);
@@ -200,12 +337,18 @@ int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned
         std::printf("JLINK_RTTERMINAL_Control RTT_CMD_START failed, ret = %d\n", ret);
         return -1;
     }
+    /* J-Link 已经开始轮询控制块地址，此时释放内核不会错过第一条输出 */
+    s_reset_capture = reset_capture;
+    if(reset_capture){
+        s_reset_time = std::chrono::steady_clock::now();
+        JLINK_Go();
+    }
     direction = RTT_DIRECTION_UP;
-    for(int i = 0; i < RTT_FIND_BUFFER_MAX_RETRY_COUNT; i++){
+    for(int i = 0; s_rtt_up_buffer_num < 0 && i < retry_count; i++){
         s_rtt_up_buffer_num = JLINK_RTTERMINAL_Control(RTT_CMD_GET_NUM_BUF, &direction);
         if(s_rtt_up_buffer_num >= 0)
             break;
-        std::this_thread::sleep_for(std::chrono::milliseconds(RTT_FIND_BUFFER_DELAY_MS));
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
     }
 
     if(s_rtt_up_buffer_num < 0){
@@ -224,7 +367,7 @@ int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned
 
     if(tx_channel >= 0){
         direction = RTT_DIRECTION_DOWN;
-        for(int i = 0; i < RTT_FIND_BUFFER_DOWN_MAX_RETRY_COUNT; i++){
+        for(int i = 0; s_rtt_down_buffer_num < 0 && i < RTT_FIND_BUFFER_DOWN_MAX_RETRY_COUNT; i++){
             s_rtt_down_buffer_num = JLINK_RTTERMINAL_Control(RTT_CMD_GET_NUM_BUF, &direction);
             if(s_rtt_down_buffer_num >= 0)
                 break;
@@ -246,20 +389,136 @@ int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned
     s_rtt_tx_channel = tx_channel;
 
     s_req_stop = false;
+    s_rtt_cb_addr = cb_addr;
+    s_stat_host_overflows.store(-1);
+    s_stat_fill.store(-1);
     s_rtt_rx_queue = std::queue<std::vector<char>>();
+    std::vector<char>().swap(s_rtt_early_data);
+    s_rtt_channel_tx_queue = std::queue<std::pair<int, std::vector<char>>>();
     // 启动接收线程
     s_rtt_thread = new std::thread(rtt_thread);
     return 0;
 }
 
+
+extern "C"{
+
+int jlink_rtt_start(int tx_channel, int rx_channel, unsigned long addr, unsigned long range){
+    char cmd[128];
+    const char *search_cmd = NULL;
+    
+    if(addr && range){
+        std::snprintf(cmd, sizeof(cmd), "SetRTTSearchRanges %#lx %#lx", addr, range);
+        search_cmd = cmd;
+    }else if(addr){
+        std::snprintf(cmd, sizeof(cmd), "SetRTTAddr %#lx", addr);
+        search_cmd = cmd;
+    }
+    /* 在线程启动前找出范围内的控制块，用于读取缓冲区占用和记录到 profile；完全自动查找时 J-Link 不提供地址 */
+    unsigned long cb_addr = range ? 0 : addr;
+    if(addr && range && rtt_cb_scan(addr, range, &cb_addr) < 0)
+        cb_addr = 0;
+    return rtt_start(tx_channel, rx_channel, search_cmd, -1, -1, false, cb_addr);
+}
+
+int jlink_rtt_start_known(int tx_channel, int rx_channel, unsigned long cb_addr, int up_num, int down_num){
+    char cmd[128];
+    std::snprintf(cmd, sizeof(cmd), "SetRTTAddr %#lx", cb_addr);
+    return rtt_start(tx_channel, rx_channel, cmd, up_num, down_num, false, cb_addr);
+}
+
+int jlink_rtt_start_reset(int tx_channel, int rx_channel, unsigned long cb_addr){
+    char cmd[128];
+    static const uint8_t zero_id[RTT_CB_ID_SIZE] = {};
+
+    if(JLINK_Reset() < 0){
+        std::printf("JLINK_Reset failed\n");
+        return -1;
+    }
+    if(JLINK_IsHalted() <= 0 && JLINK_Halt() != 0){
+        std::printf("JLINK_Halt failed\n");
+        return -1;
+    }
+    /* 清除上次运行遗留在 RAM 中的控制块标识，避免 J-Link 在固件初始化前连接到旧的控制块 */
+    if(JLINK_WriteMem(uint32_t(cb_addr), sizeof(zero_id), zero_id) < 0)
+        std::printf("clear stale RTT control block at %#lx failed\n", cb_addr);
+    std::snprintf(cmd, sizeof(cmd), "SetRTTAddr %#lx", cb_addr);
+    return rtt_start(tx_channel, rx_channel, cmd, -1, -1, true, cb_addr);
+}
+
+unsigned long jlink_rtt_get_cb_addr(void){
+    return s_rtt_cb_addr;
+}
+
+int jlink_rtt_get_buffer_num(int direction){
+    return direction == RTT_DIRECTION_UP ? s_rtt_up_buffer_num : s_rtt_down_buffer_num;
+}
+
+int jlink_rtt_get_buffer_desc(int direction, int index, struct rtt_desc *desc){
+    desc->index = uint32_t(index);
+    desc->direction = uint32_t(direction);
+    return JLINK_RTTERMINAL_Control(RTT_CMD_GET_DESC, desc) < 0 ? -1 : 0;
+}
+
 void jlink_rtt_stop(void){
+    if(!s_rtt_thread)
+        return;
     s_req_stop = true;
     s_rtt_thread->join();
     delete s_rtt_thread;
     s_rtt_thread = nullptr;
+    s_attached_num.store(0);
     JLINK_RTTERMINAL_Control(RTT_CMD_STOP, NULL);
 }
 
+int jlink_rtt_find_buffer(int direction, const char *name){
+    int num = jlink_rtt_get_buffer_num(direction);
+    for(int i = 0; i < num; i++){
+        struct rtt_desc desc = {};
+        if(jlink_rtt_get_buffer_desc(direction, i, &desc) < 0)
+            return -1;
+        desc.name[sizeof(desc.name) - 1] = '\0';
+        if(std::strcmp(desc.name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+int jlink_rtt_attach_channel(int channel, void (*cb)(int channel, const char *data, size_t len)){
+    int num = s_attached_num.load();
+    if(!cb || channel < 0 || channel == s_rtt_rx_channel || num >= RTT_ATTACH_MAX_CHANNELS)
+        return -1;
+    if(s_rtt_up_buffer_num >= 0 && channel >= s_rtt_up_buffer_num){
+        std::printf("attach channel %d is out of range %d\n", channel, s_rtt_up_buffer_num);
+        return -1;
+    }
+    s_attached[num].channel = channel;
+    s_attached[num].cb = cb;
+    s_attached_num.store(num + 1, std::memory_order_release);
+    return 0;
+}
+
+int jlink_rtt_transmit_channel(int channel, const char *data, int len){
+    if(channel < 0 || len <= 0 || (s_rtt_down_buffer_num >= 0 && channel >= s_rtt_down_buffer_num))
+        return -1;
+    std::unique_lock<std::mutex> lck(s_mtx);
+    s_rtt_channel_tx_queue.emplace(channel, std::vector<char>(data, data + len));
+    s_cv.notify_one();
+    return len;
+}
+
+void jlink_rtt_get_stats(struct jlink_rtt_stats *stats){
+    stats->rx_bytes = s_stat_rx_bytes.load(std::memory_order_relaxed);
+    stats->tx_bytes = s_stat_tx_bytes.load(std::memory_order_relaxed);
+    stats->tx_drops = s_stat_tx_drops.load(std::memory_order_relaxed);
+    stats->host_overflows = s_stat_host_overflows.load(std::memory_order_relaxed);
+    stats->fill = s_stat_fill.load(std::memory_order_relaxed);
+    stats->polls = s_stat_polls.load(std::memory_order_relaxed);
+    stats->poll_time_us = s_stat_poll_time_us.load(std::memory_order_relaxed);
+    /* 下一次空闲时更新溢出次数和缓冲区占用 */
+    s_stat_probe.store(true, std::memory_order_relaxed);
+}
+
 void jlink_rtt_set_recv_callback(void (*rx_cb)(const char *data, size_t len)){
     s_rx_cb = rx_cb;
 }
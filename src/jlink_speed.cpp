@@ -0,0 +1,228 @@
+/**
+ * @file jlink_speed.cpp
+ * @brief J-Link SWD/JTAG 速度自动校准实现
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+
+#include "jlink_api.h"
+#include "jlink_speed.h"
+#include "app_config.h"
+
+#define SPEED_CALIB_REF_KHZ             1000        // 参考数据读取速度
+#define SPEED_CALIB_REPEAT              4           // 每个速度的校验次数
+#define SPEED_CALIB_BISECT_MIN_KHZ      500         // 二分回退的最小分辨率
+#define SPEED_CALIB_MARGIN_PERCENT      20          // 最终速度预留的余量
+#define SPEED_CACHE_FILE_NAME           "speed.cache"
+
+static const unsigned int s_speed_steps[] = {
+    2000, 4000, 6000, 8000, 12000, 15000, 20000, 25000, 30000, 40000, 50000,
+};
+
+static std::vector<uint8_t> s_ref_buf;
+static std::vector<uint8_t> s_verify_buf;
+
+static int read_block(unsigned long addr, std::vector<uint8_t> &buf){
+    JLINK_ClrError();
+    int ret = JLINK_ReadMemEx(uint32_t(addr), uint32_t(buf.size()), buf.data(), 0);
+    if(ret != int(buf.size()) || JLINK_HasError())
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief                   在指定速度下重复读取并与参考数据比较
+ * @param  speed            速度(kHz)
+ * @param  kbps             输出读取吞吐量
+ * @return int              0 稳定, -1 不稳定
+ */
+static int speed_probe(unsigned long addr, unsigned int speed, double *kbps){
+    if(JLINK_SetSpeed(speed) < 0)
+        return -1;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < SPEED_CALIB_REPEAT; i++){
+        if(read_block(addr, s_verify_buf) < 0)
+            return -1;
+        if(std::memcmp(s_verify_buf.data(), s_ref_buf.data(), s_ref_buf.size()) != 0)
+            return -1;
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if(kbps)
+        *kbps = us > 0 ? double(s_ref_buf.size() * SPEED_CALIB_REPEAT) * 1000.0 / double(us) : 0.0;
+    return 0;
+}
+
+static std::string speed_cache_path(void){
+    const char *dir = app_config_dir();
+    if(!dir)
+        return std::string();
+    return (std::filesystem::path(dir) / SPEED_CACHE_FILE_NAME).string();
+}
+
+static bool parse_long(const std::string &str, long *value){
+    char *end = nullptr;
+    if(str.empty())
+        return false;
+    *value = std::strtol(str.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+/**
+ * @brief                   解析缓存行 "sn<TAB>device<TAB>if_type<TAB>speed"，设备名可能含有空格，所以用制表符分隔
+ * @return bool             false 格式不对
+ */
+static bool speed_cache_parse(const std::string &line, unsigned int *sn, std::string *device, int *if_type, int *speed){
+    std::istringstream iss(line);
+    std::string sn_str, if_type_str, speed_str;
+    long sn_value, if_type_value, speed_value;
+    if(!std::getline(iss, sn_str, '\t') || !std::getline(iss, *device, '\t') || 
+        !std::getline(iss, if_type_str, '\t') || !std::getline(iss, speed_str))
+        return false;
+    if(!parse_long(sn_str, &sn_value) || !parse_long(if_type_str, &if_type_value) || !parse_long(speed_str, &speed_value))
+        return false;
+    *sn = unsigned(sn_value);
+    *if_type = int(if_type_value);
+    *speed = int(speed_value);
+    return true;
+}
+
+extern "C"{
+
+unsigned int jlink_probe_sn(void){
+    unsigned int sn = 0;
+    /* DLL 中的 JLINK_GetSN 通过返回值给出序列号，这里同时兼容两种方式 */
+    int ret = JLINK_GetSN(&sn);
+    if(ret > 0)
+        return unsigned(ret);
+    return sn;
+}
+
+int jlink_speed_verify(unsigned long addr, unsigned int len, unsigned int speed){
+    if(len == 0)
+        return -1;
+    s_ref_buf.resize(len);
+    s_verify_buf.resize(len);
+    /* 参考数据在低速读取，待校验的速度每次读错的方式相同时也能发现 */
+    if(JLINK_SetSpeed(SPEED_CALIB_REF_KHZ) < 0 || read_block(addr, s_ref_buf) < 0)
+        return -1;
+    return speed_probe(addr, speed, nullptr);
+}
+
+int jlink_speed_calibrate(unsigned long addr, unsigned int len){
+    unsigned int good = 0;
+    unsigned int bad = 0;
+    double kbps = 0.0;
+
+    if(len == 0)
+        return -1;
+    s_ref_buf.resize(len);
+    s_verify_buf.resize(len);
+
+    /* 低速读取参考数据，并确认低速本身稳定 */
+    if(JLINK_SetSpeed(SPEED_CALIB_REF_KHZ) < 0 || read_block(addr, s_ref_buf) < 0){
+        std::printf("speed calibration: reference read at %u kHz failed\n", SPEED_CALIB_REF_KHZ);
+        return -1;
+    }
+    if(speed_probe(addr, SPEED_CALIB_REF_KHZ, &kbps) < 0){
+        std::printf("speed calibration: link unstable at %u kHz\n", SPEED_CALIB_REF_KHZ);
+        return -1;
+    }
+    good = SPEED_CALIB_REF_KHZ;
+
+    /* 逐级升速 */
+    for(unsigned int speed : s_speed_steps){
+        if(speed_probe(addr, speed, &kbps) < 0){
+            bad = speed;
+            std::printf("speed calibration: %5u kHz failed\n", speed);
+            break;
+        }
+        std::printf("speed calibration: %5u kHz ok (%.1f KB/s)\n", speed, kbps);
+        good = speed;
+    }
+
+    /* 出错后在稳定速度与出错速度之间二分回退 */
+    while(bad && bad - good > SPEED_CALIB_BISECT_MIN_KHZ){
+        unsigned int mid = good + (bad - good) / 2;
+        if(speed_probe(addr, mid, &kbps) < 0){
+            bad = mid;
+        }else{
+            good = mid;
+        }
+    }
+
+    unsigned int speed = good;
+    if(speed > SPEED_CALIB_REF_KHZ)
+        speed = std::max(unsigned(SPEED_CALIB_REF_KHZ), speed * (100 - SPEED_CALIB_MARGIN_PERCENT) / 100);
+
+    /* 以最终速度再确认一次 */
+    if(speed_probe(addr, speed, &kbps) < 0){
+        speed = SPEED_CALIB_REF_KHZ;
+        JLINK_SetSpeed(speed);
+    }
+    std::printf("speed calibration: highest stable %u kHz, using %u kHz\n", good, speed);
+    return int(speed);
+}
+
+int jlink_speed_cache_load(unsigned int sn, const char *device, int if_type){
+    std::string path = speed_cache_path();
+    if(path.empty() || !device)
+        return -1;
+    std::ifstream file(path);
+    std::string line;
+    while(std::getline(file, line)){
+        unsigned int line_sn;
+        std::string line_device;
+        int line_if_type;
+        int line_speed;
+        if(!speed_cache_parse(line, &line_sn, &line_device, &line_if_type, &line_speed))
+            continue;
+        if(line_sn == sn && line_device == device && line_if_type == if_type)
+            return line_speed;
+    }
+    return -1;
+}
+
+int jlink_speed_cache_save(unsigned int sn, const char *device, int if_type, int speed){
+    std::string path = speed_cache_path();
+    if(path.empty() || !device)
+        return -1;
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path);
+        std::string line;
+        while(std::getline(file, line)){
+            unsigned int line_sn;
+            std::string line_device;
+            int line_if_type;
+            int line_speed;
+            /* 丢弃格式不对的行(包括旧版本以空格分隔的行)和要替换的行 */
+            if(!speed_cache_parse(line, &line_sn, &line_device, &line_if_type, &line_speed) ||
+                (line_sn == sn && line_device == device && line_if_type == if_type))
+                continue;
+            lines.push_back(line);
+        }
+    }
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+        return -1;
+    for(auto &line : lines)
+        file << line << "\n";
+    file << sn << "\t" << device << "\t" << if_type << "\t" << speed << "\n";
+    return 0;
+}
+
+}
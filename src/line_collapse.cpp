@@ -0,0 +1,108 @@
+/**
+ * @file line_collapse.cpp
+ * @brief 重复行折叠，连续相同的行只保留第一行，重复结束或超时后输出重复次数
+ *        先比较长度和 FNV-1a 哈希，相同时再逐字节确认
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "line_collapse.h"
+
+struct line_collapse_run{
+    unsigned long long count;           // 被丢弃的重复行数
+    std::string first;                  // 第一个重复行的时间戳
+    std::string last;                   // 最后一个重复行的时间戳
+};
+
+struct line_collapse{
+    bool has_last;
+    std::string last_line;
+    uint64_t last_hash;
+    struct line_collapse_run run;       // 当前行的重复统计
+    struct line_collapse_run done;      // 已被新行结束、还未输出的统计
+};
+
+static uint64_t line_collapse_hash(const char *line, size_t len){
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < len; i++){
+        hash ^= uint8_t(line[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+extern "C"{
+
+line_collapse_t *line_collapse_create(void){
+    line_collapse_t *lc = new line_collapse_t;
+    lc->has_last = false;
+    lc->last_hash = 0;
+    lc->run.count = 0;
+    lc->done.count = 0;
+    return lc;
+}
+
+void line_collapse_destroy(line_collapse_t *lc){
+    delete lc;
+}
+
+int line_collapse_push(line_collapse_t *lc, const char *line, size_t len, const char *timestamp){
+    uint64_t hash = line_collapse_hash(line, len);
+    if(lc->has_last && hash == lc->last_hash && len == lc->last_line.size() && 
+        (len == 0 || std::memcmp(line, lc->last_line.data(), len) == 0)){
+        if(lc->run.count++ == 0)
+            lc->run.first = timestamp;
+        lc->run.last = timestamp;
+        return lc->run.count > 0x7fffffff ? 0x7fffffff : int(lc->run.count);
+    }
+    if(lc->run.count){
+        lc->done = lc->run;
+        lc->run.count = 0;
+    }
+    lc->has_last = true;
+    lc->last_line.assign(line, len);
+    lc->last_hash = hash;
+    return 0;
+}
+
+int line_collapse_is_prefix(const line_collapse_t *lc, const char *line, size_t len){
+    return lc->has_last && len <= lc->last_line.size() && (len == 0 || std::memcmp(line, lc->last_line.data(), len) == 0);
+}
+
+int line_collapse_pending(const line_collapse_t *lc){
+    return lc->run.count || lc->done.count;
+}
+
+size_t line_collapse_flush(line_collapse_t *lc, char *out, size_t size){
+    struct line_collapse_run *run = lc->done.count ? &lc->done : &lc->run;
+    int n;
+    if(run->count == 0 || size == 0)
+        return 0;
+    if(run->count == 1){
+        n = std::snprintf(out, size, "last line repeated 1 time (%s)", run->first.c_str());
+    }else{
+        n = std::snprintf(out, size, "last line repeated %llu times (%s..%s)", run->count, 
+            run->first.c_str(), run->last.c_str());
+    }
+    run->count = 0;
+    if(n < 0)
+        return 0;
+    return size_t(n) < size ? size_t(n) : size - 1;
+}
+
+void line_collapse_reset(line_collapse_t *lc){
+    lc->has_last = false;
+    lc->last_line.clear();
+    lc->run.count = 0;
+    lc->done.count = 0;
+}
+
+}
@@ -0,0 +1,186 @@
+/**
+ * @file log_jsonl.cpp
+ * @brief JSON Lines 日志记录的序列化，直接写入调用者提供的缓存，不分配内存
+ *        转义时 SSE2 每次检查 16 字节中是否有 '"'、'\\' 或控制字符，没有则整块复制
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOG_JSONL_USE_SSE2 1
+#endif
+
+#if defined(LOG_JSONL_USE_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "log_jsonl.h"
+
+#define LOG_JSONL_U64_SIZE          20          // uint64_t 的最大十进制位数
+#define LOG_JSONL_INT_SIZE          11
+#define LOG_JSONL_FIXED_SIZE        96          // 键名、引号、逗号等固定部分
+
+static const char s_hex[] = "0123456789abcdef";
+
+static inline char *log_jsonl_put(char *out, const char *str){
+    size_t len = std::strlen(str);
+    std::memcpy(out, str, len);
+    return out + len;
+}
+
+#ifdef LOG_JSONL_USE_SSE2
+static inline unsigned log_jsonl_ctz(unsigned mask){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+template <typename T>
+static inline char *log_jsonl_put_num(char *out, T value){
+    return std::to_chars(out, out + LOG_JSONL_U64_SIZE, value).ptr;
+}
+
+static inline char *log_jsonl_put_str(char *out, const char *data, size_t len){
+    *out++ = '"';
+    out += log_jsonl_escape(out, data, len);
+    *out++ = '"';
+    return out;
+}
+
+static inline char *log_jsonl_escape_char(char *out, uint8_t c){
+    *out++ = '\\';
+    switch(c){
+        case '"':   *out++ = '"'; break;
+        case '\\':  *out++ = '\\'; break;
+        case '\b':  *out++ = 'b'; break;
+        case '\f':  *out++ = 'f'; break;
+        case '\n':  *out++ = 'n'; break;
+        case '\r':  *out++ = 'r'; break;
+        case '\t':  *out++ = 't'; break;
+        default:
+            *out++ = 'u';
+            *out++ = '0';
+            *out++ = '0';
+            *out++ = s_hex[c >> 4];
+            *out++ = s_hex[c & 0x0f];
+            break;
+    }
+    return out;
+}
+
+extern "C"{
+
+size_t log_jsonl_escape(char *out, const char *data, size_t len){
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t *end = p + len;
+    char *start = out;
+
+#ifdef LOG_JSONL_USE_SSE2
+    const __m128i ctrl_max = _mm_set1_epi8(0x1f);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while(end - p >= 16){
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, ctrl_max), ctrl_max), 
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        unsigned mask = unsigned(_mm_movemask_epi8(special));
+        if(mask == 0){
+            p += 16;
+            out += 16;
+            continue;
+        }
+        /* 块内第一个需要转义的字符之前的部分已经复制 */
+        unsigned skip = log_jsonl_ctz(mask);
+        p += skip;
+        out += skip;
+        out = log_jsonl_escape_char(out, *p++);
+    }
+#endif
+    while(p < end){
+        uint8_t c = *p++;
+        if(c < 0x20 || c == '"' || c == '\\'){
+            out = log_jsonl_escape_char(out, c);
+        }else{
+            *out++ = char(c);
+        }
+    }
+    return size_t(out - start);
+}
+
+size_t log_jsonl_bound(const struct log_jsonl_record *rec){
+    size_t bound = LOG_JSONL_FIXED_SIZE + LOG_JSONL_U64_SIZE * 2 + LOG_JSONL_INT_SIZE;
+    bound += rec->target_ts ? rec->target_ts_len * 6 : 0;
+    bound += rec->session ? std::strlen(rec->session) * 6 : 0;
+    bound += rec->kind ? std::strlen(rec->kind) * 6 : 0;
+    bound += rec->text_len * 6;
+    bound += rec->note ? rec->note_len * 6 : 0;
+    return bound;
+}
+
+size_t log_jsonl_format(char *out, const struct log_jsonl_record *rec){
+    char *p = out;
+    p = log_jsonl_put(p, "{\"seq\":");
+    p = log_jsonl_put_num(p, rec->seq);
+    p = log_jsonl_put(p, ",\"host_us\":");
+    p = log_jsonl_put_num(p, rec->host_us);
+    if(rec->target_ts){
+        p = log_jsonl_put(p, ",\"target_ts\":");
+        p = log_jsonl_put_str(p, rec->target_ts, rec->target_ts_len);
+    }
+    p = log_jsonl_put(p, ",\"ch\":");
+    p = log_jsonl_put_num(p, rec->channel);
+    if(rec->session){
+        p = log_jsonl_put(p, ",\"session\":");
+        p = log_jsonl_put_str(p, rec->session, std::strlen(rec->session));
+    }
+    if(rec->kind){
+        p = log_jsonl_put(p, ",\"kind\":");
+        p = log_jsonl_put_str(p, rec->kind, std::strlen(rec->kind));
+    }
+    p = log_jsonl_put(p, ",\"text\":");
+    p = log_jsonl_put_str(p, rec->text, rec->text_len);
+    if(rec->note){
+        p = log_jsonl_put(p, ",\"note\":");
+        p = log_jsonl_put_str(p, rec->note, rec->note_len);
+    }
+    p = log_jsonl_put(p, "}\n");
+    return size_t(p - out);
+}
+
+int log_jsonl_target_ts(const char *line, size_t len, const char **ts, size_t *ts_len){
+    size_t begin = 1;
+    size_t i;
+    if(len < 3 || line[0] != '[')
+        return 0;
+    while(begin < len && line[begin] == ' ')
+        begin++;
+    if(begin >= len || line[begin] < '0' || line[begin] > '9')
+        return 0;
+    for(i = begin; i < len && line[i] != ']'; i++){
+        char c = line[i];
+        if(!((c >= '0' && c <= '9') || c == '.' || c == ':' || c == ',' || c == ' '))
+            return 0;
+    }
+    if(i >= len)
+        return 0;
+    while(i > begin && line[i - 1] == ' ')
+        i--;
+    *ts = line + begin;
+    *ts_len = i - begin;
+    return 1;
+}
+
+}
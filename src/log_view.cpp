@@ -0,0 +1,804 @@
+/**
+ * @file log_view.cpp
+ * @brief 大日志文件查看器：内存映射文件，以行首的字节偏移作为滚动位置，打开时不需要扫描整个文件
+ *        后台线程每 LOG_VIEW_INDEX_STEP 行记录一个行首偏移，用于显示行号、跳转到行号和按时间二分查找，
+ *        索引还没有覆盖的部分按字节二分；过滤把文件分块交给线程池并行查找，结果按文件顺序合并，边扫描边显示
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+
+#include "mapped_file.h"
+#include "scrollback.h"
+#include "work_pool.h"
+#include "terminal_display_record.h"
+#include "log_view.h"
+
+#define LOG_VIEW_INDEX_STEP         1024                // 每隔多少行记录一个行首偏移
+#define LOG_VIEW_INDEX_PUBLISH      (64 * 1024 * 1024)  // 建立索引时每扫描这么多数据更新一次进度
+#define LOG_VIEW_FILTER_CHUNK       (16 * 1024 * 1024)  // 过滤时每个任务扫描的数据量
+#define LOG_VIEW_FILTER_WINDOW      4                   // 每个线程最多领先合并位置的任务数
+#define LOG_VIEW_PROGRESS_MS        250                 // 后台任务刷新显示的最短间隔
+#define LOG_VIEW_LINE_SHOW_MAX      4096                // 每行最多输出的字节数，超出屏幕宽度的部分由终端截断
+#define LOG_VIEW_SEEK_LINEAR        (64 * 1024)         // 按时间二分缩小到这个范围后逐行查找
+#define LOG_VIEW_TIME_PROBE_LINES   16                  // 二分时向后查找带时间戳的行的最多行数
+#define LOG_VIEW_SEARCH_BLOCK       (1024 * 1024)       // 向前搜索时每次查找的数据量
+#define LOG_VIEW_NONE               UINT64_MAX
+
+struct log_view_filter{
+    std::string pattern;
+    std::vector<uint64_t> matches;      // 匹配行的行首偏移，受 log_view::mtx 保护
+    uint64_t scanned = 0;               // 已合并结果的数据量
+    bool done = false;
+    bool cancel = false;                // 受 log_view::mtx 保护
+    std::thread thread;
+};
+
+struct log_view_chunk{
+    struct log_view *lv;
+    log_view_filter *filter;
+    uint64_t begin;
+    uint64_t end;
+    std::vector<uint64_t> matches;
+    bool done;
+};
+
+struct log_view{
+    mapped_file_t *mf;
+    std::string path;
+    const char *data;
+    uint64_t size;
+    int jobs;
+    std::mutex mtx;                     // 保护索引、过滤结果、查看状态和终端输出
+    std::condition_variable cv;         // 过滤任务完成
+    std::vector<uint64_t> index;        // 第 k * LOG_VIEW_INDEX_STEP 行的行首偏移
+    uint64_t indexed;                   // 已建立索引的数据量
+    uint64_t lines;                     // 已建立索引的行数，完成后为总行数
+    bool index_done;
+    std::atomic<bool> stop{false};
+    std::thread index_thread;
+    std::unique_ptr<log_view_filter> filter;    // 当前的过滤，NULL 显示全部行
+    std::chrono::steady_clock::time_point next_progress;
+    int rows;
+    int cols;
+    uint64_t top;                       // 不过滤时为第一行的行首偏移，过滤时为 matches 中的位置
+    uint64_t match;                     // 搜索匹配的行，与 top 的含义相同，LOG_VIEW_NONE 为没有
+    std::string search;
+    bool search_backward;               // 上一次搜索的方向，n 沿该方向重复，N 反向
+    bool inputting;
+    char input_kind;                    // '/' '?' 搜索，'&' 过滤，':' 跳转到行号或时间
+    std::string input;
+    std::string message;
+};
+
+static uint64_t log_view_next_line(const log_view_t *lv, uint64_t pos){
+    if(pos >= lv->size)
+        return lv->size;
+    const char *lf = static_cast<const char*>(std::memchr(lv->data + pos, '\n', size_t(lv->size - pos)));
+    return lf ? uint64_t(lf - lv->data) + 1 : lv->size;
+}
+
+static uint64_t log_view_line_start(const log_view_t *lv, uint64_t pos){
+    while(pos > 0 && lv->data[pos - 1] != '\n')
+        pos--;
+    return pos;
+}
+
+/**
+ * @brief                   行内容的长度，不含换行和行尾的 '\r'
+ */
+static size_t log_view_line_len(const log_view_t *lv, uint64_t start){
+    uint64_t end = log_view_next_line(lv, start);
+    if(end > start && lv->data[end - 1] == '\n')
+        end--;
+    if(end > start && lv->data[end - 1] == '\r')
+        end--;
+    return size_t(end - start);
+}
+
+static uint64_t log_view_last_line(const log_view_t *lv){
+    uint64_t end = lv->size;
+    if(end && lv->data[end - 1] == '\n')
+        end--;
+    return log_view_line_start(lv, end);
+}
+
+static size_t log_view_page(const log_view_t *lv){
+    return size_t(std::max(1, lv->rows - 1));
+}
+
+/* 显示位置：不过滤时为行首偏移，过滤时为匹配结果中的位置 */
+static bool log_view_has(const log_view_t *lv, uint64_t pos){
+    if(lv->filter)
+        return pos < lv->filter->matches.size();
+    return lv->size > 0 && pos < lv->size;
+}
+
+static uint64_t log_view_offset(const log_view_t *lv, uint64_t pos){
+    return lv->filter ? lv->filter->matches[pos] : pos;
+}
+
+static bool log_view_step(const log_view_t *lv, uint64_t *pos, bool forward){
+    if(lv->filter){
+        if(forward ? *pos + 1 >= lv->filter->matches.size() : *pos == 0)
+            return false;
+        *pos = forward ? *pos + 1 : *pos - 1;
+        return true;
+    }
+    if(forward){
+        uint64_t next = log_view_next_line(lv, *pos);
+        if(next >= lv->size)
+            return false;
+        *pos = next;
+        return true;
+    }
+    if(*pos == 0)
+        return false;
+    *pos = log_view_line_start(lv, *pos - 1);
+    return true;
+}
+
+static void log_view_move(const log_view_t *lv, uint64_t *pos, size_t count, bool forward){
+    for(size_t i = 0; i < count && log_view_step(lv, pos, forward); i++){
+    }
+}
+
+/**
+ * @brief                   最后一页第一行的位置
+ */
+static uint64_t log_view_last_top(const log_view_t *lv){
+    uint64_t pos = 0;
+    if(lv->filter)
+        pos = lv->filter->matches.empty() ? 0 : lv->filter->matches.size() - 1;
+    else
+        pos = log_view_last_line(lv);
+    log_view_move(lv, &pos, log_view_page(lv) - 1, false);
+    return pos;
+}
+
+static void log_view_clamp(log_view_t *lv){
+    lv->top = std::min(lv->top, log_view_last_top(lv));
+}
+
+/**
+ * @brief                   已建立索引的偏移的行号(从 0 开始)
+ */
+static uint64_t log_view_line_number(const log_view_t *lv, uint64_t offset){
+    size_t k = size_t(std::upper_bound(lv->index.begin(), lv->index.end(), offset) - lv->index.begin()) - 1;
+    uint64_t number = uint64_t(k) * LOG_VIEW_INDEX_STEP;
+    for(uint64_t pos = lv->index[k]; pos < offset; number++){
+        const char *lf = static_cast<const char*>(std::memchr(lv->data + pos, '\n', size_t(offset - pos)));
+        if(!lf)
+            break;
+        pos = uint64_t(lf - lv->data) + 1;
+    }
+    return number;
+}
+
+static bool log_view_digits(const char *p, size_t n, int *value){
+    int v = 0;
+    for(size_t i = 0; i < n; i++){
+        if(p[i] < '0' || p[i] > '9')
+            return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    *value = v;
+    return true;
+}
+
+/**
+ * @brief                   "YYYY-mm-dd HH:MM:SS" 加可选的 ".mmm"，按本地时间转换为微秒
+ */
+static bool log_view_parse_datetime(const char *p, size_t len, uint64_t *us){
+    int year, mon, day, hour, min, sec, ms = 0;
+    if(len < 19 || p[4] != '-' || p[7] != '-' || p[10] != ' ' || p[13] != ':' || p[16] != ':')
+        return false;
+    if(!log_view_digits(p, 4, &year) || !log_view_digits(p + 5, 2, &mon) || !log_view_digits(p + 8, 2, &day) ||
+        !log_view_digits(p + 11, 2, &hour) || !log_view_digits(p + 14, 2, &min) || !log_view_digits(p + 17, 2, &sec))
+        return false;
+    if(len > 20 && p[19] == '.'){
+        /* 毫秒可以写 1 到 3 位 */
+        size_t n = 0;
+        for(; n < 3 && 20 + n < len && p[20 + n] >= '0' && p[20 + n] <= '9'; n++)
+            ms = ms * 10 + (p[20 + n] - '0');
+        for(; n < 3; n++)
+            ms *= 10;
+    }
+    std::tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = mon - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    tm.tm_sec = sec;
+    tm.tm_isdst = -1;
+    std::time_t t = std::mktime(&tm);
+    if(t < 0)
+        return false;
+    *us = uint64_t(t) * 1000000 + uint64_t(ms) * 1000;
+    return true;
+}
+
+/**
+ * @brief                   行的时间：文本日志为行首的 "[YYYY-mm-dd HH:MM:SS.mmm]"，JSON Lines 为 host_us
+ */
+static bool log_view_line_time(const log_view_t *lv, uint64_t start, uint64_t *us){
+    const char *line = lv->data + start;
+    size_t len = log_view_line_len(lv, start);
+    if(len > 1 && line[0] == '[')
+        return log_view_parse_datetime(line + 1, len - 1, us);
+    if(len > 0 && line[0] == '{'){
+        static const char key[] = "\"host_us\":";
+        const char *hit = scrollback_find(line, std::min<size_t>(len, 64), key, sizeof(key) - 1);
+        if(!hit)
+            return false;
+        uint64_t v = 0;
+        const char *p = hit + sizeof(key) - 1;
+        const char *end = line + len;
+        if(p >= end || *p < '0' || *p > '9')
+            return false;
+        for(; p < end && *p >= '0' && *p <= '9'; p++)
+            v = v * 10 + uint64_t(*p - '0');
+        *us = v;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief                   从 pos 开始向后找第一个带时间戳的行，重复统计等没有时间戳的行跳过
+ */
+static bool log_view_probe_time(const log_view_t *lv, uint64_t pos, uint64_t limit, uint64_t *us, uint64_t *line){
+    for(int i = 0; i < LOG_VIEW_TIME_PROBE_LINES && pos < limit; i++, pos = log_view_next_line(lv, pos)){
+        if(log_view_line_time(lv, pos, us)){
+            *line = pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief                   第一个时间不早于 target 的行：先在索引点中二分，再在两个索引点(或未索引的部分)之间按字节二分，最后逐行查找
+ */
+static uint64_t log_view_seek_time(const log_view_t *lv, uint64_t target){
+    uint64_t us;
+    uint64_t line;
+    size_t a = 0;
+    size_t b = lv->index.size();
+    while(b - a > 1){
+        size_t mid = a + (b - a) / 2;
+        if(!log_view_probe_time(lv, lv->index[mid], lv->size, &us, &line))
+            break;
+        if(us < target)
+            a = mid;
+        else
+            b = mid;
+    }
+    uint64_t lo = lv->index[a];
+    uint64_t hi = b < lv->index.size() ? lv->index[b] : lv->size;
+    while(hi - lo > LOG_VIEW_SEEK_LINEAR){
+        uint64_t mid = log_view_next_line(lv, lo + (hi - lo) / 2);
+        if(mid >= hi || !log_view_probe_time(lv, mid, hi, &us, &line))
+            break;
+        if(us < target)
+            lo = line;
+        else
+            hi = mid;
+    }
+    for(uint64_t pos = lo; pos < hi; pos = log_view_next_line(lv, pos)){
+        if(log_view_line_time(lv, pos, &us) && us >= target)
+            return pos;
+    }
+    return hi < lv->size ? hi : log_view_last_line(lv);
+}
+
+/**
+ * @brief                   行内容，控制字符显示为 '.'，pattern 的出现位置反色显示
+ */
+static void log_view_append_line(std::string &out, const char *line, size_t len, const std::string &pattern){
+    len = std::min<size_t>(len, LOG_VIEW_LINE_SHOW_MAX);
+    size_t highlight_end = 0;
+    const char *next_hit = pattern.empty() ? nullptr : scrollback_find(line, len, pattern.data(), pattern.size());
+    for(size_t i = 0; i < len; i++){
+        if(next_hit && line + i == next_hit){
+            out.append("\x1B[7m");
+            highlight_end = i + pattern.size();
+            next_hit = scrollback_find(line + highlight_end, len - highlight_end, pattern.data(), pattern.size());
+        }
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        out += c == '\t' ? ' ' : (c < 0x20 || c == 0x7f) ? '.' : char(c);
+        if(highlight_end && i + 1 == highlight_end){
+            out.append("\x1B[27m");
+            highlight_end = 0;
+        }
+    }
+    if(highlight_end)
+        out.append("\x1B[27m");
+}
+
+static void log_view_render(log_view_t *lv){
+    log_view_clamp(lv);
+    const std::string &pattern = lv->inputting && lv->input_kind != '&' && lv->input_kind != ':' ? lv->input :
+        !lv->search.empty() ? lv->search : lv->filter ? lv->filter->pattern : lv->search;
+    size_t page = log_view_page(lv);
+    std::string out;
+    uint64_t pos = lv->top;
+    bool valid = log_view_has(lv, pos);
+    for(size_t r = 0; r < page; r++){
+        out.append("\x1B[").append(std::to_string(r + 1)).append(";1H\x1B[2K");
+        if(!valid)
+            continue;
+        uint64_t offset = log_view_offset(lv, pos);
+        log_view_append_line(out, lv->data + offset, log_view_line_len(lv, offset), pattern);
+        valid = log_view_step(lv, &pos, true);
+    }
+    out.append("\x1B[").append(std::to_string(lv->rows)).append(";1H\x1B[2K");
+    if(lv->inputting){
+        out.append(1, lv->input_kind).append(lv->input);
+    }else{
+        char status[256];
+        int n = std::snprintf(status, sizeof(status), "%s  ", lv->path.c_str());
+        uint64_t offset = log_view_has(lv, lv->top) ? log_view_offset(lv, lv->top) : 0;
+        if(offset < lv->indexed || lv->index_done){
+            n += std::snprintf(status + n, sizeof(status) - size_t(n), "line %llu of %llu%s",
+                (unsigned long long)log_view_line_number(lv, offset) + 1, (unsigned long long)lv->lines, lv->index_done ? "" : "+");
+        }else{
+            n += std::snprintf(status + n, sizeof(status) - size_t(n), "line ?");
+        }
+        n += std::snprintf(status + n, sizeof(status) - size_t(n), " (%llu%%)",
+            lv->size ? (unsigned long long)(offset * 100 / lv->size) : 100ULL);
+        if(!lv->index_done)
+            n += std::snprintf(status + n, sizeof(status) - size_t(n), ", indexing %llu%%", (unsigned long long)(lv->indexed * 100 / lv->size));
+        if(lv->filter){
+            n += std::snprintf(status + n, sizeof(status) - size_t(n), "  &%s: %zu lines",
+                lv->filter->pattern.c_str(), lv->filter->matches.size());
+            if(!lv->filter->done && lv->size)
+                std::snprintf(status + n, sizeof(status) - size_t(n), ", scanning %llu%%", (unsigned long long)(lv->filter->scanned * 100 / lv->size));
+        }
+        out.append("\x1B[7m").append(status);
+        if(!lv->message.empty())
+            out.append("  ").append(lv->message);
+        out.append("  (q quit, / ? search, & filter, : line or time)\x1B[0m");
+    }
+    std::cout.write(out.data(), std::streamsize(out.size()));
+    std::cout << std::flush;
+}
+
+/**
+ * @brief                   后台任务的进度，最多每 LOG_VIEW_PROGRESS_MS 重绘一次，调用时持有 lv->mtx
+ */
+static void log_view_progress(log_view_t *lv, bool force){
+    auto now = std::chrono::steady_clock::now();
+    if(!force && now < lv->next_progress)
+        return ;
+    lv->next_progress = now + std::chrono::milliseconds(LOG_VIEW_PROGRESS_MS);
+    log_view_render(lv);
+}
+
+static void log_view_index_thread(log_view_t *lv){
+    std::vector<uint64_t> batch;
+    uint64_t pos = 0;
+    uint64_t line = 0;
+    uint64_t published = 0;
+    while(pos < lv->size && !lv->stop.load()){
+        const char *lf = static_cast<const char*>(std::memchr(lv->data + pos, '\n', size_t(lv->size - pos)));
+        line++;
+        if(!lf){
+            /* 最后一行没有换行 */
+            pos = lv->size;
+            break;
+        }
+        pos = uint64_t(lf - lv->data) + 1;
+        if(line % LOG_VIEW_INDEX_STEP == 0 && pos < lv->size)
+            batch.push_back(pos);
+        if(pos - published >= LOG_VIEW_INDEX_PUBLISH){
+            std::lock_guard<std::mutex> lck(lv->mtx);
+            lv->index.insert(lv->index.end(), batch.begin(), batch.end());
+            lv->indexed = pos;
+            lv->lines = line;
+            batch.clear();
+            published = pos;
+            log_view_progress(lv, false);
+        }
+    }
+    std::lock_guard<std::mutex> lck(lv->mtx);
+    lv->index.insert(lv->index.end(), batch.begin(), batch.end());
+    lv->indexed = pos;
+    lv->lines = line;
+    lv->index_done = pos >= lv->size;
+    if(!lv->stop.load())
+        log_view_progress(lv, true);
+}
+
+/**
+ * @brief                   在分块中查找匹配的行：处理行首位于 [begin, end) 的行，最后一行可以超过 end
+ */
+static void log_view_filter_task(void *arg){
+    log_view_chunk *chunk = static_cast<log_view_chunk*>(arg);
+    log_view_t *lv = chunk->lv;
+    const std::string &pattern = chunk->filter->pattern;
+    bool cancel;
+    {
+        std::lock_guard<std::mutex> lck(lv->mtx);
+        cancel = chunk->filter->cancel;
+    }
+    uint64_t pos = chunk->begin;
+    if(pos > 0 && lv->data[pos - 1] != '\n')
+        pos = log_view_next_line(lv, pos);
+    uint64_t end = chunk->end >= lv->size ? lv->size : log_view_next_line(lv, chunk->end - 1);
+    while(!cancel && pos < end){
+        const char *hit = scrollback_find(lv->data + pos, size_t(end - pos), pattern.data(), pattern.size());
+        if(!hit)
+            break;
+        uint64_t start = uint64_t(hit - lv->data);
+        while(start > pos && lv->data[start - 1] != '\n')
+            start--;
+        chunk->matches.push_back(start);
+        pos = log_view_next_line(lv, uint64_t(hit - lv->data));
+    }
+    std::lock_guard<std::mutex> lck(lv->mtx);
+    chunk->done = true;
+    lv->cv.notify_all();
+}
+
+static void log_view_filter_thread(log_view_t *lv, log_view_filter *filter){
+    size_t num = size_t((lv->size + LOG_VIEW_FILTER_CHUNK - 1) / LOG_VIEW_FILTER_CHUNK);
+    std::vector<log_view_chunk> chunks(num);
+    for(size_t i = 0; i < num; i++){
+        uint64_t begin = uint64_t(i) * LOG_VIEW_FILTER_CHUNK;
+        chunks[i] = log_view_chunk{lv, filter, begin, std::min<uint64_t>(lv->size, begin + LOG_VIEW_FILTER_CHUNK), {}, false};
+    }
+    work_pool_t *pool = work_pool_create(lv->jobs);
+    size_t window = size_t(work_pool_threads(pool)) * LOG_VIEW_FILTER_WINDOW;
+    size_t submitted = 0;
+    for(size_t i = 0; i < num; i++){
+        for(; submitted < num && submitted < i + window; submitted++)
+            work_pool_submit(pool, log_view_filter_task, &chunks[submitted]);
+        std::unique_lock<std::mutex> lck(lv->mtx);
+        lv->cv.wait(lck, [&chunks, i]{ return chunks[i].done; });
+        if(filter->cancel)
+            break;
+        filter->matches.insert(filter->matches.end(), chunks[i].matches.begin(), chunks[i].matches.end());
+        filter->scanned = chunks[i].end;
+        std::vector<uint64_t>().swap(chunks[i].matches);
+        log_view_progress(lv, false);
+    }
+    work_pool_destroy(pool);
+    std::lock_guard<std::mutex> lck(lv->mtx);
+    filter->done = true;
+    if(!filter->cancel)
+        log_view_progress(lv, true);
+}
+
+/**
+ * @brief                   替换当前的过滤，pattern 为空时显示全部行；不持有 lv->mtx 时调用
+ */
+static void log_view_set_filter(log_view_t *lv, const std::string &pattern){
+    std::unique_ptr<log_view_filter> old;
+    {
+        std::lock_guard<std::mutex> lck(lv->mtx);
+        old = std::move(lv->filter);
+        if(old){
+            old->cancel = true;
+            /* 回到不过滤时停在当前的行 */
+            if(old->matches.size() > lv->top)
+                lv->top = old->matches[lv->top];
+            else
+                lv->top = 0;
+        }
+    }
+    if(old && old->thread.joinable())
+        old->thread.join();
+    std::lock_guard<std::mutex> lck(lv->mtx);
+    lv->match = LOG_VIEW_NONE;
+    if(!pattern.empty()){
+        lv->filter = std::make_unique<log_view_filter>();
+        lv->filter->pattern = pattern;
+        lv->filter->done = lv->size == 0;
+        lv->top = 0;
+        lv->filter->thread = std::thread(log_view_filter_thread, lv, lv->filter.get());
+    }
+    log_view_render(lv);
+}
+
+/**
+ * @brief                   不过滤时在文件中查找：向后直接查找，向前每次在 LOG_VIEW_SEARCH_BLOCK 中取最后一个匹配
+ * @return uint64_t         匹配所在行的行首偏移，LOG_VIEW_NONE 没有找到
+ */
+static uint64_t log_view_find(const log_view_t *lv, uint64_t begin, uint64_t end, bool backward){
+    const std::string &pattern = lv->search;
+    if(!backward){
+        uint64_t limit = std::min(lv->size, end + pattern.size() - 1);
+        if(begin >= limit)
+            return LOG_VIEW_NONE;
+        const char *hit = scrollback_find(lv->data + begin, size_t(limit - begin), pattern.data(), pattern.size());
+        return hit ? log_view_line_start(lv, uint64_t(hit - lv->data)) : LOG_VIEW_NONE;
+    }
+    for(uint64_t block_end = end; block_end > begin; ){
+        uint64_t block_begin = block_end - std::min<uint64_t>(block_end - begin, LOG_VIEW_SEARCH_BLOCK);
+        uint64_t limit = std::min(lv->size, block_end + pattern.size() - 1);
+        const char *last = nullptr;
+        for(uint64_t pos = block_begin; pos < limit; ){
+            const char *hit = scrollback_find(lv->data + pos, size_t(limit - pos), pattern.data(), pattern.size());
+            if(!hit)
+                break;
+            last = hit;
+            pos = uint64_t(hit - lv->data) + 1;
+        }
+        if(last)
+            return log_view_line_start(lv, uint64_t(last - lv->data));
+        block_end = block_begin;
+    }
+    return LOG_VIEW_NONE;
+}
+
+/**
+ * @brief                   过滤时在匹配的行中逐行查找
+ */
+static uint64_t log_view_find_filtered(const log_view_t *lv, uint64_t begin, uint64_t end, bool backward){
+    const std::vector<uint64_t> &matches = lv->filter->matches;
+    end = std::min<uint64_t>(end, matches.size());
+    for(uint64_t i = 0; begin + i < end; i++){
+        uint64_t pos = backward ? end - 1 - i : begin + i;
+        uint64_t offset = matches[pos];
+        if(scrollback_find(lv->data + offset, log_view_line_len(lv, offset), lv->search.data(), lv->search.size()))
+            return pos;
+    }
+    return LOG_VIEW_NONE;
+}
+
+/**
+ * @brief                   从当前匹配(没有时从页面顶部)开始搜索，到头后从另一端继续，匹配行显示在页面上方三分之一处
+ */
+static void log_view_search(log_view_t *lv, bool backward){
+    if(lv->search.empty())
+        return ;
+    uint64_t from = lv->match != LOG_VIEW_NONE ? lv->match : lv->top;
+    uint64_t found;
+    if(lv->filter){
+        uint64_t end = lv->filter->matches.size();
+        found = backward ? log_view_find_filtered(lv, 0, from, true) : log_view_find_filtered(lv, from + (lv->match != LOG_VIEW_NONE), end, false);
+        if(found == LOG_VIEW_NONE){
+            found = backward ? log_view_find_filtered(lv, from, end, true) : log_view_find_filtered(lv, 0, from, false);
+            lv->message = "search wrapped";
+        }
+    }else{
+        uint64_t next = lv->match != LOG_VIEW_NONE ? log_view_next_line(lv, from) : from;
+        found = backward ? log_view_find(lv, 0, from, true) : log_view_find(lv, next, lv->size, false);
+        if(found == LOG_VIEW_NONE){
+            found = backward ? log_view_find(lv, from, lv->size, true) : log_view_find(lv, 0, next, false);
+            lv->message = "search wrapped";
+        }
+    }
+    if(found == LOG_VIEW_NONE){
+        lv->message = "pattern not found";
+        return ;
+    }
+    if(found == from && lv->match == from)
+        lv->message = "only match";
+    lv->match = found;
+    lv->top = found;
+    log_view_move(lv, &lv->top, log_view_page(lv) / 3, false);
+}
+
+/**
+ * @brief                   跳转到行号(全为数字)或时间("YYYY-mm-dd HH:MM:SS[.mmm]"，或 "HH:MM:SS[.mmm]" 使用当前行的日期)
+ */
+static void log_view_goto(log_view_t *lv, const std::string &target){
+    if(target.empty())
+        return ;
+    if(target.find_first_not_of("0123456789") == std::string::npos){
+        uint64_t number = std::strtoull(target.c_str(), nullptr, 10);
+        number = number ? number - 1 : 0;
+        if(lv->filter){
+            lv->top = number;
+            return ;
+        }
+        if(number >= lv->lines && !lv->index_done){
+            lv->message = "line " + target + " is not indexed yet";
+            return ;
+        }
+        number = std::min(number, lv->lines ? lv->lines - 1 : 0);
+        uint64_t pos = lv->index[size_t(number / LOG_VIEW_INDEX_STEP)];
+        log_view_move(lv, &pos, size_t(number % LOG_VIEW_INDEX_STEP), true);
+        lv->top = pos;
+        return ;
+    }
+    std::string datetime = target;
+    if(target.size() >= 8 && target[2] == ':'){
+        uint64_t us;
+        uint64_t line;
+        uint64_t offset = log_view_has(lv, lv->top) ? log_view_offset(lv, lv->top) : 0;
+        if(!log_view_probe_time(lv, offset, lv->size, &us, &line) && !log_view_probe_time(lv, 0, lv->size, &us, &line)){
+            lv->message = "no timestamp in the log";
+            return ;
+        }
+        std::time_t t = std::time_t(us / 1000000);
+        std::tm bt;
+#if defined(_MSC_VER)
+        localtime_s(&bt, &t);
+#else
+        localtime_r(&t, &bt);
+#endif
+        char date[16];
+        std::strftime(date, sizeof(date), "%Y-%m-%d ", &bt);
+        datetime = date + target;
+    }
+    uint64_t us;
+    if(!log_view_parse_datetime(datetime.data(), datetime.size(), &us)){
+        lv->message = "expected a line number, YYYY-mm-dd HH:MM:SS or HH:MM:SS";
+        return ;
+    }
+    uint64_t offset = log_view_seek_time(lv, us);
+    if(lv->filter){
+        const std::vector<uint64_t> &matches = lv->filter->matches;
+        lv->top = uint64_t(std::lower_bound(matches.begin(), matches.end(), offset) - matches.begin());
+    }else{
+        lv->top = offset;
+    }
+}
+
+extern "C"{
+
+log_view_t *log_view_open(const char *path, int rows, int cols, int jobs){
+    mapped_file_t *mf = mapped_file_open(path);
+    if(!mf){
+        std::printf("open %s failed\n", path);
+        return nullptr;
+    }
+    log_view_t *lv = new log_view_t;
+    lv->mf = mf;
+    lv->path = path;
+    lv->data = reinterpret_cast<const char*>(mapped_file_data(mf));
+    lv->size = mapped_file_size(mf);
+    lv->jobs = jobs;
+    lv->index.push_back(0);
+    lv->indexed = 0;
+    lv->lines = 0;
+    lv->index_done = lv->size == 0;
+    lv->rows = rows > 1 ? rows : 24;
+    lv->cols = cols > 0 ? cols : 80;
+    lv->top = 0;
+    lv->match = LOG_VIEW_NONE;
+    lv->search_backward = false;
+    lv->inputting = false;
+    lv->input_kind = 0;
+    std::cout << "\x1B[?1049h\x1B[?7l\x1B[?25l";
+    {
+        std::lock_guard<std::mutex> lck(lv->mtx);
+        log_view_render(lv);
+    }
+    lv->index_thread = std::thread(log_view_index_thread, lv);
+    return lv;
+}
+
+void log_view_close(log_view_t *lv){
+    if(!lv)
+        return ;
+    lv->stop = true;
+    log_view_set_filter(lv, std::string());
+    lv->index_thread.join();
+    std::cout << "\x1B[2J\x1B[?7h\x1B[?25h\x1B[?1049l" << std::flush;
+    mapped_file_close(lv->mf);
+    delete lv;
+}
+
+int log_view_key(log_view_t *lv, int key){
+    std::string filter;
+    {
+        std::lock_guard<std::mutex> lck(lv->mtx);
+        size_t page = log_view_page(lv);
+        if(lv->inputting){
+            switch (key) {
+                case TERMINAL_PAGER_KEY_ENTER:
+                    lv->inputting = false;
+                    if(lv->input_kind == '&'){
+                        filter = lv->input;
+                        goto set_filter;
+                    }
+                    if(lv->input_kind == ':'){
+                        log_view_goto(lv, lv->input);
+                    }else if(!lv->input.empty()){
+                        lv->search = lv->input;
+                        lv->search_backward = lv->input_kind == '?';
+                        lv->match = LOG_VIEW_NONE;
+                        log_view_search(lv, lv->search_backward);
+                    }
+                    break;
+                case TERMINAL_PAGER_KEY_ESC:
+                    lv->inputting = false;
+                    break;
+                case TERMINAL_PAGER_KEY_BACKSPACE:
+                    if(!lv->input.empty())
+                        lv->input.pop_back();
+                    break;
+                default:
+                    if(key >= 0x20 && key <= 0x7e)
+                        lv->input += char(key);
+                    break;
+            }
+            log_view_render(lv);
+            return 0;
+        }
+        lv->message.clear();
+        switch (key) {
+            case 'q':
+            case TERMINAL_PAGER_KEY_ESC:
+                return 1;
+            case TERMINAL_PAGER_KEY_UP:
+            case 'k':
+                log_view_step(lv, &lv->top, false);
+                break;
+            case TERMINAL_PAGER_KEY_DOWN:
+            case TERMINAL_PAGER_KEY_ENTER:
+            case 'j':
+                log_view_step(lv, &lv->top, true);
+                break;
+            case TERMINAL_PAGER_KEY_PAGE_UP:
+            case 'b':
+                log_view_move(lv, &lv->top, page, false);
+                break;
+            case TERMINAL_PAGER_KEY_PAGE_DOWN:
+            case ' ':
+            case 'f':
+                log_view_move(lv, &lv->top, page, true);
+                break;
+            case TERMINAL_PAGER_KEY_HOME:
+            case 'g':
+                lv->top = 0;
+                break;
+            case TERMINAL_PAGER_KEY_END:
+            case 'G':
+                lv->top = log_view_last_top(lv);
+                break;
+            case '/':
+            case '?':
+            case '&':
+            case ':':
+                lv->inputting = true;
+                lv->input_kind = char(key);
+                lv->input = key == '&' && lv->filter ? lv->filter->pattern : std::string();
+                break;
+            case 'n':
+            case 'N':
+                log_view_search(lv, lv->search_backward != (key == 'N'));
+                break;
+            default:
+                break;
+        }
+        log_view_render(lv);
+        return 0;
+    }
+set_filter:
+    log_view_set_filter(lv, filter);
+    return 0;
+}
+
+void log_view_resize(log_view_t *lv, int rows, int cols){
+    std::lock_guard<std::mutex> lck(lv->mtx);
+    if(rows > 1)
+        lv->rows = rows;
+    if(cols > 0)
+        lv->cols = cols;
+    log_view_render(lv);
+}
+
+}
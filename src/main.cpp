@@ -13,20 +13,50 @@
 #include <chrono>
 #include <iostream>
 #include <atomic>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
 
 #include "cpp-terminal/key.hpp"
 #include "cpp-terminal/terminal.hpp"
 #include "cpp-terminal/input.hpp"
 #include "cpp-terminal/event.hpp"
+#include "cpp-terminal/screen.hpp"
 
 #include "cxxopts.hpp"
 #include "jlink_lib.h"
 #include "jlink_api.h"
 #include "jlink_rtt.h"
+#include "jlink_speed.h"
+#include "profile.h"
+#include "rtt_control_block.h"
 #include "terminal_display_record.h"
+#include "flight_recorder.h"
+#include "crash_snapshot.h"
+#include "symbolizer.h"
+#include "sysview_capture.h"
+#include "swo.h"
+#include "pc_histogram.h"
+#include "rtt_dump.h"
+#include "elf_file.h"
+#include "plugin_host.h"
+#include "protobuf_decoder.h"
+#include "metrics.h"
+#include "reprocess.h"
+#include "log_view.h"
+#include "split_view.h"
+#include "alloc_stats.h"
+#include "status_bar.h"
 
+#define SPEED_AUTO_CONNECT_KHZ      1000        // 自动校准前的连接速度
+#define SPEED_VERIFY_LEN            1024        // 速度校验读取长度
+#define METRICS_TABLE_SIZE          0x10000     // 热键显示的统计表格缓存大小
 
 static std::atomic<bool> s_req_stop(false);
+static int s_rx_channel = 0;
+static int s_tx_channel = 0;
+static bool s_split_view = false;
+static bool s_cmd_prefix = false;
 
 static std::string to_lower_locale(const std::string& str, const std::locale& loc = std::locale()) {
     std::string result = str;
@@ -48,9 +78,11 @@ static void terminal_rtt_err_handler(jlink_rtt_error_type_t error_type){
             break;
         case RTT_ERROR_READ_FAILED:
             std::cout << "RTT read error: Connection may be lost, program will exit" << std::endl;
+            flight_recorder_trigger("disconnect");
             break;
         case RTT_ERROR_WRITE_FAILED:
             std::cout << "RTT write error: Connection may be lost, program will exit" << std::endl;
+            flight_recorder_trigger("disconnect");
             break;
         case RTT_ERROR_TX_CHANNEL_INVALID:
             std::cout << "Transmit channel invalid: Cannot send Ctrl+C signal, program will exit" << std::endl;
@@ -63,6 +95,222 @@ static void terminal_rtt_err_handler(jlink_rtt_error_type_t error_type){
     s_req_stop.store(true);
     Term::push_event(Term::Event());
 }
+static void jlink_replay_end_handler(void){
+    std::cout << "J-Link trace replay finished, program will exit" << std::endl;
+    s_req_stop.store(true);
+    Term::push_event(Term::Event());
+}
+
+static void rtt_rx_handler(const char *data, size_t len){
+    flight_recorder_write(s_rx_channel, data, len);
+    crash_snapshot_feed(s_rx_channel, data, len);
+    if(!plugin_host_feed_terminal(data, len))
+        terminal_display_record_write(data, len);
+}
+
+/**
+ * @brief                   键盘输入发送到目标，分屏时发送到焦点窗格的下行通道，只读窗格丢弃
+ */
+static void terminal_transmit(const char *data, int len){
+    if(s_split_view){
+        int channel = split_view_focus_channel();
+        if(channel < 0)
+            return;
+        if(channel != s_tx_channel){
+            jlink_rtt_transmit_channel(channel, data, len);
+            return;
+        }
+    }
+    jlink_rtt_transmit(data, len);
+}
+
+static void swo_rx_handler(int port, const char *data, size_t len){
+    flight_recorder_write(SWO_CHANNEL_BASE + port, data, len);
+    crash_snapshot_feed(SWO_CHANNEL_BASE + port, data, len);
+    terminal_display_record_write(data, len);
+}
+
+static void swo_decode_output(int port, const char *data, size_t len){
+    (void)port;
+    std::fwrite(data, 1, len, stdout);
+}
+
+/**
+ * @brief                   处理命令前缀(Ctrl+])之后的按键
+ * @param  key              按键
+ * @return bool             true 按键已被处理, false 需要作为普通按键发送给目标
+ */
+static bool command_key_process(Term::Key key){
+    if(!s_cmd_prefix){
+        if(key == Term::Key::Ctrl_CloseBracket){
+            s_cmd_prefix = true;
+            return true;
+        }
+        return false;
+    }
+    s_cmd_prefix = false;
+    switch(key){
+        case Term::Key::Ctrl_CloseBracket:
+            /* 连续两次前缀时发送前缀字符本身 */
+            return false;
+        case Term::Key::d:
+            flight_recorder_trigger("hotkey");
+            return true;
+        case Term::Key::x:
+            terminal_display_record_toggle_hexdump();
+            return true;
+        case Term::Key::p:
+            terminal_display_record_toggle_pager();
+            return true;
+        case Term::Key::Tab:
+            split_view_focus_next();
+            return true;
+        case Term::Key::m:{
+            std::vector<char> table(METRICS_TABLE_SIZE);
+            terminal_display_record_notice(table.data(), metrics_table(table.data(), table.size()));
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+/* 命令行显式指定的参数优先，其次才使用 profile 中的值 */
+static std::optional<std::string> profile_option(const cxxopts::ParseResult &args, const char *key){
+    if(args.count(key))
+        return std::nullopt;
+    const char *value = profile_get(key);
+    if(!value)
+        return std::nullopt;
+    return std::string(value);
+}
+
+static std::vector<int> parse_channel(const std::string &str){
+    std::vector<int> channel;
+    std::istringstream iss(str);
+    std::string item;
+    while(std::getline(iss, item, ','))
+        channel.push_back(std::atoi(item.c_str()));
+    return channel;
+}
+
+/**
+ * @brief                   分屏的窗格：第一个为终端通道，之后为 "up[:down]" 列表，没有指定下行通道时使用同号的下行缓冲区(存在时)
+ */
+static std::vector<struct split_view_pane> parse_panes(const std::string &str, int rx_channel, int tx_channel){
+    std::vector<struct split_view_pane> panes = {{rx_channel, tx_channel}};
+    std::istringstream iss(str);
+    std::string item;
+    int down_num = jlink_rtt_get_buffer_num(RTT_DIRECTION_DOWN);
+    while(std::getline(iss, item, ',')){
+        if(item.empty())
+            continue;
+        struct split_view_pane pane;
+        size_t colon = item.find(':');
+        pane.up_channel = std::atoi(item.c_str());
+        if(colon != std::string::npos)
+            pane.down_channel = std::atoi(item.c_str() + colon + 1);
+        else
+            pane.down_channel = pane.up_channel < down_num ? pane.up_channel : -1;
+        panes.push_back(pane);
+    }
+    return panes;
+}
+
+static std::string to_hex(unsigned long value){
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%#lx", value);
+    return buf;
+}
+
+/**
+ * @brief                   ELF 中 _SEGGER_RTT 的地址，没有 --elf 或找不到符号时返回 0
+ */
+static unsigned long elf_rtt_cb_addr(const cxxopts::ParseResult &args){
+    if(!args.count("elf"))
+        return 0;
+    elf_file_t *elf = elf_file_open(args["elf"].as<std::string>().c_str());
+    struct elf_symbol sym;
+    int ret = elf ? elf_file_find_symbol(elf, "_SEGGER_RTT", &sym) : -1;
+    elf_file_close(elf);
+    return ret == 0 ? sym.addr : 0;
+}
+
+/**
+ * @brief                   将 RTT 控制块地址和缓冲区布局记录到当前 profile，在设置接收回调之前调用
+ *                          J-Link 自动查找时不提供控制块地址，此时使用 ELF 中经过校验的 _SEGGER_RTT
+ */
+static void profile_learn_rtt(const cxxopts::ParseResult &args){
+    unsigned long cb_addr = jlink_rtt_get_cb_addr();
+    if(!cb_addr){
+        cb_addr = elf_rtt_cb_addr(args);
+        if(cb_addr && rtt_cb_check(cb_addr, nullptr, nullptr) < 0)
+            cb_addr = 0;
+    }
+    if(cb_addr)
+        profile_set("rtt_cb_addr", to_hex(cb_addr).c_str());
+
+    for(int direction : {RTT_DIRECTION_UP, RTT_DIRECTION_DOWN}){
+        int num = jlink_rtt_get_buffer_num(direction);
+        std::string layout;
+        for(int i = 0; i < num; i++){
+            struct rtt_desc desc = {};
+            if(jlink_rtt_get_buffer_desc(direction, i, &desc) < 0)
+                break;
+            desc.name[sizeof(desc.name) - 1] = '\0';
+            if(!layout.empty())
+                layout += ",";
+            layout += std::string(desc.name) + ":" + std::to_string(desc.size);
+        }
+        if(num < 0)
+            continue;
+        profile_set(direction == RTT_DIRECTION_UP ? "up_buffers" : "down_buffers", std::to_string(num).c_str());
+        profile_set(direction == RTT_DIRECTION_UP ? "up_layout" : "down_layout", layout.c_str());
+    }
+}
+
+/**
+ * @brief                   复位采集使用的控制块地址：ELF 中的 _SEGGER_RTT，其次是 profile 缓存，最后是 --addr
+ *                          复位后 RAM 尚未初始化，无法通过查找得到
+ */
+static unsigned long reset_capture_cb_addr(const cxxopts::ParseResult &args, unsigned long addr, unsigned long range){
+    if(unsigned long elf_addr = elf_rtt_cb_addr(args))
+        return elf_addr;
+    if(const char *cached = profile_get("rtt_cb_addr"))
+        return std::strtoul(cached, nullptr, 0);
+    return range ? 0 : addr;
+}
+
+/* 分页模式的按键，其它按键忽略 */
+static int key_to_pager(Term::Key key){
+    switch(key){
+        case Term::Key::ArrowUp:
+            return TERMINAL_PAGER_KEY_UP;
+        case Term::Key::ArrowDown:
+            return TERMINAL_PAGER_KEY_DOWN;
+        case Term::Key::PageUp:
+            return TERMINAL_PAGER_KEY_PAGE_UP;
+        case Term::Key::PageDown:
+            return TERMINAL_PAGER_KEY_PAGE_DOWN;
+        case Term::Key::Home:
+            return TERMINAL_PAGER_KEY_HOME;
+        case Term::Key::End:
+            return TERMINAL_PAGER_KEY_END;
+        case Term::Key::Enter:
+            return TERMINAL_PAGER_KEY_ENTER;
+        case Term::Key::Backspace:
+            return TERMINAL_PAGER_KEY_BACKSPACE;
+        case Term::Key::Esc:
+            return TERMINAL_PAGER_KEY_ESC;
+        default:
+            break;
+    }
+    std::string str = key.str();
+    if(key.isASCII() && str.size() == 1)
+        return str[0];
+    return -1;
+}
+
 static std::optional<std::string> key_to_escape(Term::Key key){
     if(key.isExtendedASCII())
         return key.str();
@@ -92,19 +340,96 @@ int main(int argc, char* argv[])
     int if_type = 1;
     int rx_channel = 0;
     int tx_channel = 0;
+    unsigned int sn = 0;
+    unsigned int speed = SPEED_AUTO_CONNECT_KHZ;
+    bool speed_auto = false;
+    unsigned long rtt_addr = 0;
+    unsigned long rtt_range = 0;
+    std::string profile_file;
+    std::string device;
+    std::string if_name;
+    std::string speed_arg;
+    std::vector<int> channel;
+    std::string log_file_path;
+    const char *log_file_path_cstr = nullptr;
+    std::string command;
+    uint32_t swo_ports = 0;
+
+    /* 第一个参数不是选项时作为子命令 */
+    if(argc > 1 && argv[1][0] != '-'){
+        command = argv[1];
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     cxxopts::Options options("rtt-shell", "JLink RTT Shell");
+    options.positional_help("| swo-decode <file> | reprocess <file.rttcap>... | view <log> | dump-rtt");
     options.add_options()
         ("h,help", "Print help")
         ("d,device", "JLink device name", cxxopts::value<std::string>()->default_value("MCXN947_M33_0"))
         ("i,if", "JLink interface name (JTAG or SWD or cJTAG)", cxxopts::value<std::string>()->default_value("swd"))
-        ("s,speed", "JLink speed", cxxopts::value<int>()->default_value("4000"))
+        ("s,speed", "JLink speed in kHz, 'auto' (cached calibration) or 'calibrate' (force recalibration)", cxxopts::value<std::string>()->default_value("4000"))
+        ("speed_addr", "Read-only address used to verify link speed (0xXXXXXXXX)", cxxopts::value<unsigned long>()->default_value("0"))
         ("c,channel", "RTT channel number (rx,tx)", cxxopts::value<std::vector<int>>()->default_value("0,0"))
         ("a,addr", "RTT address (0xXXXXXXXX)", cxxopts::value<unsigned long>()->default_value("0"))
         ("r,range", "RTT range (0xXXXXXXXX)", cxxopts::value<unsigned long>()->default_value("0"))
         ("v,version", "Print version")
         ("l,out_log", "Output log file name", cxxopts::value<std::string>())
+        ("log_format", "Output log format (text or jsonl)", cxxopts::value<std::string>()->default_value("text"))
+        ("p,profile", "Load connection parameters from the named profile (default: match probe serial)", cxxopts::value<std::string>())
+        ("save_profile", "Save the connection parameters of this session as the named profile", cxxopts::value<std::string>())
+        ("profile_file", "Profile file (default: profiles.ini in the config directory)", cxxopts::value<std::string>())
+        ("flight_mb", "Flight recorder ring size in MB, 0 to disable (dump hotkey: Ctrl+] d, SIGUSR1)", cxxopts::value<size_t>()->default_value("0"))
+        ("flight_trigger", "Dump the flight recorder when the received data contains this pattern", cxxopts::value<std::vector<std::string>>())
+        ("flight_pre", "Seconds of data before the trigger to dump", cxxopts::value<double>()->default_value("10"))
+        ("flight_post", "Seconds of data after the trigger to dump", cxxopts::value<double>()->default_value("2"))
+        ("flight_dir", "Flight recorder dump directory", cxxopts::value<std::string>()->default_value("."))
+        ("e,elf", "Firmware ELF file", cxxopts::value<std::string>())
+        ("crash_trigger", "Halt the core and save an ELF core file (needs --elf) when the received data contains this pattern", cxxopts::value<std::vector<std::string>>())
+        ("crash_action", "Action after a crash snapshot (resume, reset or halt)", cxxopts::value<std::string>()->default_value("resume"))
+        ("crash_dir", "Crash snapshot output directory", cxxopts::value<std::string>()->default_value("."))
+        ("sysview", "Capture the SystemView channel to this .SVDat file while the shell stays interactive", cxxopts::value<std::string>())
+        ("sysview_channel", "SystemView up,down channel (default: find the \"SysView\" buffer)", cxxopts::value<std::string>())
+        ("symbolize", "Annotate addresses in received lines with func+off (file:line) from --elf")
+        ("swo", "Also capture ITM output and DWT PC samples over SWO")
+        ("swo_cpu_hz", "Target core clock in Hz, required by --swo", cxxopts::value<uint32_t>()->default_value("0"))
+        ("swo_hz", "SWO baud rate, 0 for the highest compatible", cxxopts::value<uint32_t>()->default_value("0"))
+        ("swo_ports", "ITM stimulus port mask shown in the terminal", cxxopts::value<std::string>()->default_value("0x1"))
+        ("swo_record", "Save the raw SWO stream to this file (replay with swo-decode)", cxxopts::value<std::string>())
+        ("pc_top", "Number of functions in the PC sample histogram", cxxopts::value<size_t>()->default_value("20"))
+        ("reset_capture", "Reset the target and start RTT before releasing the core, so no boot output is lost (needs --elf, a profile or --addr)")
+        ("dump_dir", "dump-rtt: directory for the raw up buffer contents", cxxopts::value<std::string>()->default_value("."))
+        ("dump_running", "dump-rtt: read the buffers without halting the core")
+        ("vscreen", "Render through a virtual screen, redrawing only changed cells so overwritten frames are skipped")
+        ("vscreen_fps", "Frame rate cap of --vscreen and --panes", cxxopts::value<int>()->default_value("30"))
+        ("panes", "Split the screen into panes: the terminal channel, then these up channels as up[:down], e.g. 1,2:3 (focus: Ctrl+] Tab)", cxxopts::value<std::string>())
+        ("collapse", "Collapse repeated lines in the display, the log or both (display, log or all)", cxxopts::value<std::string>()->implicit_value("all"))
+        ("collapse_timeout", "Milliseconds after which the repeat count of a continuing run is printed", cxxopts::value<int>()->default_value("1000"))
+        ("hexdump", "Show the received channel as a hex dump instead of terminal text (toggle: Ctrl+] x)")
+        ("hexdump_highlight", "Highlight bytes of the hex dump that differ from the previous row")
+        ("hexdump_rate", "Maximum hex dump rows shown per second, newer rows are shown in bursts beyond it", cxxopts::value<int>()->default_value("1000"))
+        ("metric", "Extract numbers from received lines: keys (\"vbat,temp\" for vbat=3712) or a template (\"ADC{ch} = {adc} mV\"), may be repeated (table: Ctrl+] m)", cxxopts::value<std::vector<std::string>>())
+        ("metrics_ring", "Samples kept per metric series for min/max/mean/p99", cxxopts::value<size_t>()->default_value("4096"))
+        ("metrics_csv", "Append every extracted sample to this CSV file", cxxopts::value<std::string>())
+        ("scrollback_mb", "Memory budget in MB of the compressed in-session scrollback, 0 to disable (pager: Ctrl+] p)", cxxopts::value<size_t>()->default_value("64"))
+        ("stats", "Print received bytes, lines and heap allocations per MB of the receive path at exit")
+        ("status_bar", "Show rx/tx rate, lines/s, backlog, tx drops, host overflows, target buffer fill and average poll interval on the last terminal row")
+        ("status_bar_rate", "Status bar updates per second (max 10)", cxxopts::value<int>()->default_value("4"))
+        ("jlink_record", "Record every J-Link DLL call with its arguments, results and timing to this trace file", cxxopts::value<std::string>())
+        ("jlink_replay", "Replay a --jlink_record trace instead of using a J-Link probe", cxxopts::value<std::string>())
+        ("replay_speed", "Timing of --jlink_replay: 1 as recorded, 2 twice as fast, 0 without waiting", cxxopts::value<double>()->default_value("1"))
+        ("telemetry", "Decode length-delimited protobuf messages from the telemetry channel into this file (.csv for columns, otherwise JSON Lines)", cxxopts::value<std::string>())
+        ("telemetry_desc", "FileDescriptorSet of the telemetry messages (protoc --descriptor_set_out)", cxxopts::value<std::string>())
+        ("telemetry_type", "Full name of the telemetry message type (default: first message of the last file)", cxxopts::value<std::string>())
+        ("telemetry_channel", "Telemetry up channel (default: find the \"Telemetry\" buffer)", cxxopts::value<int>()->default_value("-1"))
+        ("plugin", "Load a decoder/sink plugin (path or path:args), may be repeated", cxxopts::value<std::vector<std::string>>())
+        ("filter", "reprocess: keep only lines containing this string, may be repeated", cxxopts::value<std::vector<std::string>>())
+        ("jobs", "reprocess/view: worker threads, 0 for all cores", cxxopts::value<int>()->default_value("0"))
+        ("input", "Input files of the subcommand", cxxopts::value<std::vector<std::string>>())
         ;
 
+    options.parse_positional({"input"});
     cxxopts::ParseResult args = options.parse(argc, argv);
 
     if(args.count("help")){
@@ -115,13 +440,138 @@ int main(int argc, char* argv[])
         std::cout << "rtt-shell version: " << RTT_SHELL_VERSION << std::endl;
         return 0;
     }
+    swo_ports = uint32_t(std::strtoul(args["swo_ports"].as<std::string>().c_str(), nullptr, 0));
+    if(command == "swo-decode"){
+        if(!args.count("input")){
+            std::cout << "usage: rtt-shell swo-decode <file> [--elf firmware.elf] [--swo_ports mask]" << std::endl;
+            return -1;
+        }
+        if(args.count("elf") && symbolizer_load(args["elf"].as<std::string>().c_str(), 0) < 0)
+            std::cout << "symbolizer_load failed" << std::endl;
+        swo_set_recv_callback(swo_ports, swo_decode_output);
+        ret = swo_decode_file(args["input"].as<std::vector<std::string>>()[0].c_str());
+        pc_histogram_print(args["pc_top"].as<size_t>());
+        symbolizer_unload();
+        return ret;
+    }else if(command == "reprocess"){
+        if(!args.count("input")){
+            std::cout << "usage: rtt-shell reprocess <file.rttcap>... [-l out] [--log_format jsonl] [-c channel] [--filter text] [--elf firmware.elf --symbolize] [--jobs n]" << std::endl;
+            return -1;
+        }
+        std::vector<std::string> inputs = args["input"].as<std::vector<std::string>>();
+        std::vector<const char *> paths;
+        for(auto &input : inputs)
+            paths.push_back(input.c_str());
+        std::vector<std::string> filters = args.count("filter") ? args["filter"].as<std::vector<std::string>>() : std::vector<std::string>();
+        std::vector<const char *> filter_cstrs;
+        for(auto &filter : filters)
+            filter_cstrs.push_back(filter.c_str());
+        struct reprocess_options reprocess_opt = {};
+        reprocess_opt.channel = args["channel"].as<std::vector<int>>()[0];
+        reprocess_opt.jsonl = to_lower_locale(args["log_format"].as<std::string>()) == "jsonl";
+        reprocess_opt.filters = filter_cstrs.data();
+        reprocess_opt.filter_num = filter_cstrs.size();
+        reprocess_opt.jobs = args["jobs"].as<int>();
+        if(args.count("symbolize")){
+            if(!args.count("elf") || symbolizer_load(args["elf"].as<std::string>().c_str(), 1) < 0)
+                std::cout << "symbolizer_load failed" << std::endl;
+            else
+                reprocess_opt.symbolize = 1;
+        }
+        ret = reprocess_run(paths.data(), paths.size(), args.count("out_log") ? args["out_log"].as<std::string>().c_str() : nullptr, &reprocess_opt);
+        symbolizer_unload();
+        return ret;
+    }else if(command == "view"){
+        if(!args.count("input")){
+            std::cout << "usage: rtt-shell view <log> [--jobs n]" << std::endl;
+            return -1;
+        }
+        Term::terminal.setOptions(Term::Option::NoMouseFocus, Term::Option::Raw, Term::Option::NoSignalKeys, Term::Option::Cursor);
+        Term::Screen screen = Term::screen_size();
+        log_view_t *lv = log_view_open(args["input"].as<std::vector<std::string>>()[0].c_str(), 
+            int(screen.rows()), int(screen.columns()), args["jobs"].as<int>());
+        if(!lv)
+            return -1;
+        for(bool quit = false; !quit; ){
+            Term::Event event = Term::read_event();
+            switch(event.type()){
+                case Term::Event::Type::Key:{
+                    Term::Key key(event);
+                    if(key == Term::Key::Ctrl_C){
+                        quit = true;
+                        break;
+                    }
+                    if(int view_key = key_to_pager(key); view_key >= 0)
+                        quit = log_view_key(lv, view_key) != 0;
+                    break;
+                }
+                case Term::Event::Type::CopyPaste:{
+                    std::string key_str(event);
+                    for(char c : key_str)
+                        log_view_key(lv, (unsigned char)c);
+                    break;
+                }
+                case Term::Event::Type::Screen:{
+                    Term::Screen resized(event);
+                    log_view_resize(lv, int(resized.rows()), int(resized.columns()));
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        log_view_close(lv);
+        return 0;
+    }else if(!command.empty() && command != "dump-rtt"){
+        std::cout << "unknown command: " << command << std::endl;
+        return -1;
+    }
     // if(!args.count("device")){
     //     std::cout << "device is required" << std::endl;
     //     return -1;
     // }
 
-    std::string if_name = to_lower_locale(args["if"].as<std::string>());
+    if(args.count("jlink_replay")){
+        if(jlink_lib_replay(args["jlink_replay"].as<std::string>().c_str(), args["replay_speed"].as<double>()) < 0){
+            std::cout << "jlink_lib_replay failed" << std::endl;
+            return -1;
+        }
+        jlink_lib_replay_set_end_callback(jlink_replay_end_handler);
+    }else{
+        if(jlink_lib_init() < 0){
+            std::cout << "jlink_lib_init failed" << std::endl;
+            return -1;
+        }
+        if(args.count("jlink_record") && jlink_lib_record(args["jlink_record"].as<std::string>().c_str()) < 0){
+            std::cout << "jlink_lib_record failed" << std::endl;
+            return -1;
+        }
+    }
+    ret = JLINK_Open();
+    if(ret < 0){
+        std::cout << "JLINK_Open failed ret:" << ret << std::endl;
+        return -1;
+    }
+
+    sn = jlink_probe_sn();
+    profile_file = args.count("profile_file") ? args["profile_file"].as<std::string>() : std::string();
+    if(args.count("profile")){
+        std::string name = args["profile"].as<std::string>();
+        if(profile_load(profile_file.empty() ? nullptr : profile_file.c_str(), name.c_str(), sn) < 0 &&
+            !args.count("save_profile")){
+            std::cout << "profile " << name << " not found" << std::endl;
+            goto close;
+        }
+    }else{
+        profile_load(profile_file.empty() ? nullptr : profile_file.c_str(), nullptr, sn);
+    }
+    if(args.count("save_profile"))
+        profile_create(args["save_profile"].as<std::string>().c_str());
+    if(profile_name())
+        std::cout << "Using profile: " << profile_name() << std::endl;
 
+    device = profile_option(args, "device").value_or(args["device"].as<std::string>());
+    if_name = to_lower_locale(profile_option(args, "if").value_or(args["if"].as<std::string>()));
     if(if_name == "jtag"){
         if_type = 0;
     }else if(if_name == "swd"){
@@ -130,40 +580,50 @@ int main(int argc, char* argv[])
         if_type = 2;
     }else{
         std::cout << "interface name is invalid" << std::endl;
-        return -1;
+        goto close;
+    }
+
+    if(auto value = profile_option(args, "channel"); value.has_value()){
+        channel = parse_channel(*value);
+    }else{
+        channel = args["channel"].as<std::vector<int>>();
     }
-    std::vector<int> channel = args["channel"].as<std::vector<int>>();
     if(channel.size() != 2){
         std::cout << "channel is invalid" << std::endl;
-        return -1;
+        goto close;
     }
     rx_channel = channel[0];
     tx_channel = channel[1];
 
-    std::string log_file_path;
-    const char *log_file_path_cstr = nullptr;
-    if(args.count("out_log")){
-        log_file_path = args["out_log"].as<std::string>();
-        log_file_path_cstr = log_file_path.c_str();
-    }
-
+    rtt_addr = profile_option(args, "addr").has_value() ? 
+        std::strtoul(profile_get("addr"), nullptr, 0) : args["addr"].as<unsigned long>();
+    rtt_range = profile_option(args, "range").has_value() ? 
+        std::strtoul(profile_get("range"), nullptr, 0) : args["range"].as<unsigned long>();
 
-    if(jlink_lib_init() < 0){
-        std::cout << "jlink_lib_init failed" << std::endl;
-        return -1;
+    speed_arg = to_lower_locale(profile_option(args, "speed").value_or(args["speed"].as<std::string>()));
+    speed_auto = speed_arg == "auto" || speed_arg == "calibrate";
+    if(!speed_auto){
+        char *end = nullptr;
+        speed = unsigned(std::strtoul(speed_arg.c_str(), &end, 10));
+        if(speed_arg.empty() || *end != '\0' || speed == 0){
+            std::cout << "speed is invalid" << std::endl;
+            goto close;
+        }
     }
-    ret = JLINK_Open();
-    if(ret < 0){
-        std::cout << "JLINK_Open failed ret:" << ret << std::endl;
-        return -1;
+
+    if(args.count("out_log")){
+        log_file_path = args["out_log"].as<std::string>();
+    }else if(const char *value = profile_get("out_log")){
+        log_file_path = value;
     }
+    log_file_path_cstr = log_file_path.empty() ? nullptr : log_file_path.c_str();
 
-    if(JLINK_ExecCommand(("device=" + args["device"].as<std::string>()).c_str(), NULL, 0) < 0){
+    if(JLINK_ExecCommand(("device=" + device).c_str(), NULL, 0) < 0){
         std::cout << "JLINK_ExecCommand failed" << std::endl;
         goto close;
     }
     JLINK_TIF_Select(if_type);
-    if(JLINK_SetSpeed(unsigned(args["speed"].as<int>())) < 0){
+    if(JLINK_SetSpeed(speed) < 0){
         std::cout << "JLINK_SetSpeed failed" << std::endl;
         goto close;
     }
@@ -172,21 +632,217 @@ int main(int argc, char* argv[])
         std::cout << "JLINK_Connect failed" << std::endl;
         goto close;
     }
-    ret = jlink_rtt_start(tx_channel, rx_channel, args["addr"].as<unsigned long>(), args["range"].as<unsigned long>());
-    if(ret < 0){
+    if(speed_auto){
+        unsigned long speed_addr = args["speed_addr"].as<unsigned long>();
+        int auto_speed = -1;
+        if(speed_arg == "auto"){
+            const char *learned = profile_get("calibrated_speed");
+            auto_speed = learned ? std::atoi(learned) : jlink_speed_cache_load(sn, device.c_str(), if_type);
+            if(auto_speed > 0 && jlink_speed_verify(speed_addr, SPEED_VERIFY_LEN, unsigned(auto_speed)) < 0){
+                std::cout << "cached speed " << auto_speed << " kHz is unstable, recalibrating" << std::endl;
+                auto_speed = -1;
+            }
+        }
+        if(auto_speed <= 0){
+            auto_speed = jlink_speed_calibrate(speed_addr, SPEED_VERIFY_LEN);
+            if(auto_speed < 0){
+                std::cout << "JLink speed calibration failed" << std::endl;
+                goto close;
+            }
+            jlink_speed_cache_save(sn, device.c_str(), if_type, auto_speed);
+            profile_set("calibrated_speed", std::to_string(auto_speed).c_str());
+        }
+        std::cout << "JLink speed: " << auto_speed << " kHz" << std::endl;
+    }
+
+    /* 事后提取直接读取目标内存，不启动 J-Link RTT */
+    if(command == "dump-rtt"){
+        unsigned long cb_addr = 0;
+        const char *cached = profile_get("rtt_cb_addr");
+        if(rtt_dump_locate(args.count("elf") ? args["elf"].as<std::string>().c_str() : nullptr, 
+            cached ? std::strtoul(cached, nullptr, 0) : 0, rtt_addr, rtt_range, &cb_addr) < 0){
+            std::cout << "RTT control block not found, use --elf, --addr or --range" << std::endl;
+            goto close;
+        }
+        if(terminal_display_record_start(log_file_path_cstr) < 0){
+            std::cout << "terminal_display_record_start failed" << std::endl;
+            goto close;
+        }
+        if(rtt_dump(cb_addr, rx_channel, args["dump_dir"].as<std::string>().c_str(), !args.count("dump_running")) < 0)
+            std::cout << "dump-rtt failed" << std::endl;
+        terminal_display_record_stop();
+        goto close;
+    }
+
+    /* 复位采集使用已知的控制块地址；否则 profile 中学习到的控制块仍然有效时，跳过控制块与缓冲区的查找 */
+    ret = -1;
+    if(args.count("reset_capture")){
+        unsigned long cb_addr = reset_capture_cb_addr(args, rtt_addr, rtt_range);
+        if(!cb_addr){
+            std::cout << "reset capture needs the RTT control block address (--elf, profile or --addr)" << std::endl;
+            goto close;
+        }
+        ret = jlink_rtt_start_reset(tx_channel, rx_channel, cb_addr);
+    }else if(!args.count("addr") && profile_get("rtt_cb_addr") && profile_get("up_buffers") && profile_get("down_buffers")){
+        unsigned long cb_addr = std::strtoul(profile_get("rtt_cb_addr"), nullptr, 0);
+        int up_num = -1;
+        int down_num = -1;
+        if(rtt_cb_check(cb_addr, &up_num, &down_num) == 0 && 
+            up_num == std::atoi(profile_get("up_buffers")) && down_num == std::atoi(profile_get("down_buffers"))){
+            ret = jlink_rtt_start_known(tx_channel, rx_channel, cb_addr, up_num, down_num);
+        }else{
+            std::cout << "profile RTT control block is stale, searching" << std::endl;
+        }
+    }
+    if(ret < 0 && !args.count("reset_capture"))
+        ret = jlink_rtt_start(tx_channel, rx_channel, rtt_addr, rtt_range);
+    if(ret < 0 && args.count("swo")){
+        std::cout << "jlink_rtt_start failed, continuing with SWO only" << std::endl;
+    }else if(ret < 0){
         std::cout << "jlink_rtt_start failed" << std::endl;
         goto close;
     }
 
+    if(profile_name()){
+        if(args.count("save_profile")){
+            profile_set("sn", std::to_string(sn).c_str());
+            profile_set("device", device.c_str());
+            profile_set("if", if_name.c_str());
+            profile_set("speed", speed_arg.c_str());
+            profile_set("channel", (std::to_string(rx_channel) + "," + std::to_string(tx_channel)).c_str());
+            if(rtt_addr)
+                profile_set("addr", to_hex(rtt_addr).c_str());
+            if(rtt_range)
+                profile_set("range", to_hex(rtt_range).c_str());
+            if(log_file_path_cstr)
+                profile_set("out_log", log_file_path_cstr);
+        }
+        profile_learn_rtt(args);
+        if(profile_save() < 0)
+            std::cout << "profile_save failed" << std::endl;
+    }
+
+    s_tx_channel = tx_channel;
+    {
+        Term::Screen screen = Term::screen_size();
+        terminal_display_record_resize(int(screen.rows()), int(screen.columns()));
+        if(args.count("panes")){
+            /* 窗格自带虚拟屏幕，忽略 --vscreen */
+            std::vector<struct split_view_pane> panes = parse_panes(args["panes"].as<std::string>(), rx_channel, tx_channel);
+            if(split_view_start(panes.data(), panes.size(), int(screen.rows()), int(screen.columns()), args["vscreen_fps"].as<int>()) == 0){
+                terminal_display_record_set_output(split_view_write, split_view_pause);
+                s_split_view = true;
+            }
+        }else if(args.count("vscreen")){
+            terminal_display_record_set_vscreen(int(screen.rows()), int(screen.columns()), args["vscreen_fps"].as<int>());
+        }
+    }
+    terminal_display_record_set_scrollback(args["scrollback_mb"].as<size_t>() * 1024 * 1024);
+    if(to_lower_locale(args["log_format"].as<std::string>()) == "jsonl")
+        terminal_display_record_set_log_format(TERMINAL_LOG_JSONL, rx_channel);
+    if(args.count("collapse")){
+        std::string collapse = to_lower_locale(args["collapse"].as<std::string>());
+        terminal_display_record_set_collapse(collapse == "display" || collapse == "all", 
+            collapse == "log" || collapse == "all", args["collapse_timeout"].as<int>());
+    }
+    terminal_display_record_set_hexdump(int(args.count("hexdump")), int(args.count("hexdump_highlight")), 
+        args["hexdump_rate"].as<int>());
+    /* 分屏时每个窗格有自己的状态行 */
+    terminal_display_record_set_status_bar(args.count("status_bar") && !s_split_view);
     ret = terminal_display_record_start(log_file_path_cstr);
     if(ret < 0){
         std::cout << "terminal_display_record_start failed" << std::endl;
         goto terminal_display_record_start_error;
     }
+    if(args.count("status_bar") && !s_split_view)
+        status_bar_start(args["status_bar_rate"].as<int>());
 
     Term::terminal.setOptions(Term::Option::NoMouseFocus, Term::Option::Raw, Term::Option::NoSignalKeys, Term::Option::Cursor);
 
-    jlink_rtt_set_recv_callback(terminal_display_record_write);
+    s_rx_channel = rx_channel;
+    if(args["flight_mb"].as<size_t>() > 0){
+        if(args.count("flight_trigger")){
+            for(auto &pattern : args["flight_trigger"].as<std::vector<std::string>>())
+                flight_recorder_add_pattern(pattern.c_str());
+        }
+        if(flight_recorder_start(args["flight_mb"].as<size_t>(), args["flight_pre"].as<double>(), 
+            args["flight_post"].as<double>(), args["flight_dir"].as<std::string>().c_str()) < 0){
+            std::cout << "flight_recorder_start failed" << std::endl;
+        }
+    }
+
+    if(args.count("crash_trigger")){
+        std::string action_name = to_lower_locale(args["crash_action"].as<std::string>());
+        crash_snapshot_action_t action = CRASH_SNAPSHOT_RESUME;
+        if(action_name == "reset"){
+            action = CRASH_SNAPSHOT_RESET;
+        }else if(action_name == "halt"){
+            action = CRASH_SNAPSHOT_HALT;
+        }
+        for(auto &pattern : args["crash_trigger"].as<std::vector<std::string>>())
+            crash_snapshot_add_pattern(pattern.c_str());
+        if(!args.count("elf") || crash_snapshot_start(args["elf"].as<std::string>().c_str(), 
+            args["crash_dir"].as<std::string>().c_str(), action) < 0){
+            std::cout << "crash_snapshot_start failed" << std::endl;
+        }
+    }
+
+    /* PC 采样直方图同样需要符号表，只有 --symbolize 才加载行号表 */
+    if(args.count("symbolize") || (args.count("swo") && args.count("elf"))){
+        if(!args.count("elf") || symbolizer_load(args["elf"].as<std::string>().c_str(), int(args.count("symbolize"))) < 0){
+            std::cout << "symbolizer_load failed" << std::endl;
+        }else if(args.count("symbolize")){
+            terminal_display_record_set_line_annotator(symbolizer_annotate);
+        }
+    }
+
+    if(args.count("metric")){
+        bool valid = true;
+        for(auto &spec : args["metric"].as<std::vector<std::string>>())
+            valid = metrics_add(spec.c_str()) == 0 && valid;
+        if(!valid || metrics_start(args["metrics_ring"].as<size_t>(), 
+            args.count("metrics_csv") ? args["metrics_csv"].as<std::string>().c_str() : nullptr) < 0){
+            std::cout << "metrics_start failed" << std::endl;
+        }else{
+            terminal_display_record_set_line_callback(metrics_feed_line);
+        }
+    }
+
+    if(args.count("sysview")){
+        std::vector<int> sysview_channel = args.count("sysview_channel") ? 
+            parse_channel(args["sysview_channel"].as<std::string>()) : std::vector<int>();
+        if(sysview_capture_start(args["sysview"].as<std::string>().c_str(), 
+            sysview_channel.size() > 0 ? sysview_channel[0] : -1, sysview_channel.size() > 1 ? sysview_channel[1] : -1) < 0){
+            std::cout << "sysview_capture_start failed" << std::endl;
+        }
+    }
+
+    if(args.count("telemetry")){
+        int telemetry_channel = args["telemetry_channel"].as<int>();
+        if(!args.count("telemetry_desc") || protobuf_decoder_load(args["telemetry_desc"].as<std::string>().c_str(), 
+            args.count("telemetry_type") ? args["telemetry_type"].as<std::string>().c_str() : nullptr, 
+            args["telemetry"].as<std::string>().c_str()) < 0 ||
+            plugin_host_add_builtin("protobuf", protobuf_decoder_plugin_register, 
+            telemetry_channel >= 0 ? std::to_string(telemetry_channel).c_str() : "") < 0){
+            std::cout << "telemetry decoder start failed (--telemetry_desc is required)" << std::endl;
+        }
+    }
+    if(args.count("plugin")){
+        for(auto &spec : args["plugin"].as<std::vector<std::string>>())
+            plugin_host_load(spec.c_str());
+    }
+    if(plugin_host_start(rx_channel) < 0)
+        std::cout << "plugin_host_start failed" << std::endl;
+
+    if(args.count("swo")){
+        swo_set_recv_callback(swo_ports, swo_rx_handler);
+        if(args["swo_cpu_hz"].as<uint32_t>() == 0 || swo_start(args["swo_cpu_hz"].as<uint32_t>(), args["swo_hz"].as<uint32_t>(), 
+            swo_ports, args.count("swo_record") ? args["swo_record"].as<std::string>().c_str() : nullptr) < 0){
+            std::cout << "swo_start failed (--swo_cpu_hz is required)" << std::endl;
+        }
+    }
+
+    jlink_rtt_set_recv_callback(rtt_rx_handler);
     jlink_rtt_set_error_callback(terminal_rtt_err_handler);
     terminal_display_record_quit_signal_set_callback(terminal_display_record_quit_signal_handler);
     
@@ -196,14 +852,32 @@ int main(int argc, char* argv[])
         switch(event.type()){
             case Term::Event::Type::Key:{
                 Term::Key key(event);
+                if(command_key_process(key))
+                    continue;
+                if(terminal_display_record_pager_active()){
+                    if(int pager_key = key_to_pager(key); pager_key >= 0)
+                        terminal_display_record_pager_key(pager_key);
+                    continue;
+                }
                 if(auto escape = key_to_escape(key); escape.has_value()){
-                    jlink_rtt_transmit(escape->c_str(), int(escape->size()));
+                    terminal_transmit(escape->c_str(), int(escape->size()));
                     continue;
                 }
             }
             case Term::Event::Type::CopyPaste:{
                 std::string key_str(event);
-                jlink_rtt_transmit(key_str.c_str(), int(key_str.size()));
+                if(terminal_display_record_pager_active()){
+                    for(char c : key_str)
+                        terminal_display_record_pager_key((unsigned char)c);
+                    continue;
+                }
+                terminal_transmit(key_str.c_str(), int(key_str.size()));
+                continue;
+            }
+            case Term::Event::Type::Screen:{
+                Term::Screen screen(event);
+                terminal_display_record_resize(int(screen.rows()), int(screen.columns()));
+                split_view_resize(int(screen.rows()), int(screen.columns()));
                 continue;
             }
             default:
@@ -212,9 +886,29 @@ int main(int argc, char* argv[])
         if(s_req_stop.load())
             break;
     }
+    /* SystemView 的停止命令由 RTT 线程发送；之后停止 RTT 线程，不会再有数据送到插件和显示 */
+    sysview_capture_stop();
+    jlink_rtt_stop();
+    swo_stop();
+    plugin_host_stop();
+    status_bar_stop();
     terminal_display_record_stop();
+    if(args.count("stats")){
+        struct terminal_display_stats stats;
+        terminal_display_record_get_stats(&stats);
+        std::printf("received %llu bytes, %llu lines, %llu allocations (%.1f per MB, %llu in total)\n", 
+            (unsigned long long)stats.bytes, (unsigned long long)stats.lines, (unsigned long long)stats.allocations, 
+            stats.bytes ? double(stats.allocations) * 1024 * 1024 / double(stats.bytes) : 0.0, 
+            (unsigned long long)alloc_stats_total());
+    }
+    pc_histogram_print(args["pc_top"].as<size_t>());
+    metrics_stop();
 terminal_display_record_start_error:
+    split_view_stop();
     jlink_rtt_stop();
+    flight_recorder_stop();
+    crash_snapshot_stop();
+    symbolizer_unload();
 close:
     if(JLINK_Close() < 0){
         std::printf("JLINK_Close failed\n");
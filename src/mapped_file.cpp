@@ -0,0 +1,111 @@
+/**
+ * @file mapped_file.cpp
+ * @brief 只读内存映射文件
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+struct mapped_file{
+    const uint8_t *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
+
+extern "C"{
+
+mapped_file_t *mapped_file_open(const char *path){
+    mapped_file_t *mf = new mapped_file_t{};
+#ifdef _WIN32
+    mf->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, 
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(mf->file == INVALID_HANDLE_VALUE)
+        goto error;
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(mf->file, &size)){
+        CloseHandle(mf->file);
+        goto error;
+    }
+    mf->size = size_t(size.QuadPart);
+    if(mf->size){
+        mf->mapping = CreateFileMappingA(mf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(!mf->mapping){
+            CloseHandle(mf->file);
+            goto error;
+        }
+        mf->data = static_cast<const uint8_t*>(MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0));
+        if(!mf->data){
+            CloseHandle(mf->mapping);
+            CloseHandle(mf->file);
+            goto error;
+        }
+    }
+#else
+    struct stat st;
+    mf->fd = open(path, O_RDONLY);
+    if(mf->fd < 0)
+        goto error;
+    if(fstat(mf->fd, &st) < 0){
+        close(mf->fd);
+        goto error;
+    }
+    mf->size = size_t(st.st_size);
+    if(mf->size){
+        void *addr = mmap(nullptr, mf->size, PROT_READ, MAP_PRIVATE, mf->fd, 0);
+        if(addr == MAP_FAILED){
+            close(mf->fd);
+            goto error;
+        }
+        mf->data = static_cast<const uint8_t*>(addr);
+    }
+#endif
+    return mf;
+error:
+    delete mf;
+    return nullptr;
+}
+
+void mapped_file_close(mapped_file_t *mf){
+    if(!mf)
+        return;
+#ifdef _WIN32
+    if(mf->data){
+        UnmapViewOfFile(mf->data);
+        CloseHandle(mf->mapping);
+    }
+    CloseHandle(mf->file);
+#else
+    if(mf->data)
+        munmap(const_cast<uint8_t*>(mf->data), mf->size);
+    close(mf->fd);
+#endif
+    delete mf;
+}
+
+const uint8_t *mapped_file_data(const mapped_file_t *mf){
+    return mf->data;
+}
+
+size_t mapped_file_size(const mapped_file_t *mf){
+    return mf->size;
+}
+
+}
@@ -0,0 +1,410 @@
+/**
+ * @file metrics.cpp
+ * @brief 从接收的行中提取数值，按序列保存在固定大小的环形缓冲区并统计
+ *        键值规则只在 '=' 或 ':' 处回看键名，模板规则先查找第一段文字再依次匹配；
+ *        数值用整数累加尾数再乘 10 的幂得到，不经过 strtod；CSV 中直接写入原文，不重新格式化
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+
+#include "metrics.h"
+
+#define METRICS_TEMPLATE_FIELD_MAX      16          // 一个模板最多的占位符数
+#define METRICS_SPARK_WIDTH             32          // 走势图显示的最近样本数
+#define METRICS_CSV_FLUSH_SIZE          0x10000
+#define METRICS_CSV_FLUSH_US            1000000     // CSV 缓存最长保留时间
+#define METRICS_MANTISSA_MAX            100000000000000000ULL   // 超过后的数字只计入指数
+
+struct metrics_series{
+    std::string name;
+    std::vector<double> ring;
+    size_t pos;                         // 下一个写入位置
+    size_t num;                         // ring 中的样本数
+    uint64_t total;                     // 累计样本数
+    double last;
+};
+
+struct metrics_template{
+    std::vector<std::string> literals;  // literals[i] 位于第 i 个占位符之前，最后一项位于最后一个占位符之后
+    std::vector<int> series;            // 每个占位符对应的序列，-1 表示忽略
+};
+
+static std::mutex s_mtx;
+static std::vector<metrics_series> s_series;
+static std::vector<std::pair<std::string, int>> s_keys;     // 键名 -> 序列
+static std::vector<metrics_template> s_templates;
+static bool s_started = false;
+static std::FILE *s_csv = nullptr;
+static std::string s_csv_buf;
+static uint64_t s_csv_flush_us = 0;
+
+static const double s_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static inline bool metrics_is_digit(char c){
+    return c >= '0' && c <= '9';
+}
+
+static inline bool metrics_is_key_char(char c){
+    return metrics_is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.' || c == '-';
+}
+
+static inline int metrics_hex_value(char c){
+    if(metrics_is_digit(c))
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief                   解析整数、小数、科学计数法或 0x 开头的十六进制整数
+ * @return size_t           解析的字符数，0 表示不是数字
+ */
+static size_t metrics_parse_number(const char *str, const char *end, double *value){
+    const char *p = str;
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int exp10 = 0;
+    int digits = 0;
+
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    if(end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && metrics_hex_value(p[2]) >= 0){
+        p += 2;
+        for(int v; p < end && (v = metrics_hex_value(*p)) >= 0; p++)
+            mantissa = (mantissa << 4) | uint64_t(v);
+        *value = negative ? -double(mantissa) : double(mantissa);
+        return size_t(p - str);
+    }
+    for(; p < end && metrics_is_digit(*p); p++, digits++){
+        if(mantissa < METRICS_MANTISSA_MAX){
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+        }else{
+            exp10++;
+        }
+    }
+    if(p < end && *p == '.'){
+        for(p++; p < end && metrics_is_digit(*p); p++, digits++){
+            if(mantissa < METRICS_MANTISSA_MAX){
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                exp10--;
+            }
+        }
+    }
+    if(digits == 0)
+        return 0;
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char *e = p + 1;
+        bool exp_negative = false;
+        int exp = 0;
+        if(e < end && (*e == '-' || *e == '+')){
+            exp_negative = *e == '-';
+            e++;
+        }
+        if(e < end && metrics_is_digit(*e)){
+            for(; e < end && metrics_is_digit(*e); e++)
+                exp = std::min(exp * 10 + (*e - '0'), 10000);
+            exp10 += exp_negative ? -exp : exp;
+            p = e;
+        }
+    }
+    double v = double(mantissa);
+    if(exp10 < 0 && exp10 >= -22){
+        v /= s_pow10[-exp10];
+    }else if(exp10 > 0 && exp10 <= 22){
+        v *= s_pow10[exp10];
+    }else if(exp10 != 0){
+        v *= std::pow(10.0, exp10);
+    }
+    *value = negative ? -v : v;
+    return size_t(p - str);
+}
+
+static int metrics_series_get(const std::string &name){
+    for(size_t i = 0; i < s_series.size(); i++){
+        if(s_series[i].name == name)
+            return int(i);
+    }
+    s_series.push_back(metrics_series{name, {}, 0, 0, 0, 0});
+    return int(s_series.size() - 1);
+}
+
+/**
+ * @brief                   记录一个样本
+ * @param  text             数值的原文，十进制数直接写入 CSV
+ */
+static void metrics_push(int index, double value, std::string_view text, uint64_t time_us){
+    metrics_series &s = s_series[size_t(index)];
+    s.ring[s.pos] = value;
+    s.pos = (s.pos + 1) % s.ring.size();
+    s.num = std::min(s.num + 1, s.ring.size());
+    s.total++;
+    s.last = value;
+    if(!s_csv)
+        return ;
+    char value_str[64];
+    char *end = std::to_chars(value_str, value_str + sizeof(value_str), time_us).ptr;
+    s_csv_buf.append(value_str, size_t(end - value_str)).append(1, ',').append(s.name).append(1, ',');
+    if(text.find_first_of("xX") == std::string_view::npos && text[0] != '+' && text[0] != '.'){
+        s_csv_buf.append(text);
+    }else{
+        int len = std::snprintf(value_str, sizeof(value_str), "%.17g", value);
+        s_csv_buf.append(value_str, size_t(len));
+    }
+    s_csv_buf += '\n';
+}
+
+static void metrics_feed_keys(const char *line, const char *end, uint64_t time_us){
+    for(const char *p = line; p < end; p++){
+        if(*p != '=' && *p != ':')
+            continue;
+        const char *key_end = p;
+        while(key_end > line && key_end[-1] == ' ')
+            key_end--;
+        const char *key = key_end;
+        while(key > line && metrics_is_key_char(key[-1]))
+            key--;
+        if(key == key_end)
+            continue;
+        std::string_view name(key, size_t(key_end - key));
+        auto it = std::find_if(s_keys.begin(), s_keys.end(), [&name](const std::pair<std::string, int> &k){
+            return k.first == name;
+        });
+        if(it == s_keys.end())
+            continue;
+        const char *v = p + 1;
+        while(v < end && *v == ' ')
+            v++;
+        double value;
+        size_t n = metrics_parse_number(v, end, &value);
+        if(n == 0)
+            continue;
+        metrics_push(it->second, value, std::string_view(v, n), time_us);
+        p = v + n - 1;
+    }
+}
+
+static void metrics_feed_template(const metrics_template &t, const char *line, const char *end, uint64_t time_us){
+    std::string_view text(line, size_t(end - line));
+    const std::string &head = t.literals[0];
+    size_t start = 0;
+    while(start <= text.size()){
+        size_t pos = head.empty() ? start : text.find(head, start);
+        if(pos == std::string_view::npos)
+            return ;
+        const char *p = line + pos + head.size();
+        double values[METRICS_TEMPLATE_FIELD_MAX];
+        std::string_view texts[METRICS_TEMPLATE_FIELD_MAX];
+        bool matched = true;
+        for(size_t i = 0; i < t.series.size() && matched; i++){
+            while(p < end && *p == ' ')
+                p++;
+            size_t n = metrics_parse_number(p, end, &values[i]);
+            const std::string &literal = t.literals[i + 1];
+            texts[i] = std::string_view(p, n);
+            p += n;
+            matched = n > 0 && size_t(end - p) >= literal.size() && std::memcmp(p, literal.data(), literal.size()) == 0;
+            p += literal.size();
+        }
+        if(matched){
+            for(size_t i = 0; i < t.series.size(); i++){
+                if(t.series[i] >= 0)
+                    metrics_push(t.series[i], values[i], texts[i], time_us);
+            }
+            return ;
+        }
+        /* 没有开头文字的模板只从行首匹配 */
+        if(head.empty())
+            return ;
+        start = pos + 1;
+    }
+}
+
+static void metrics_csv_write(void){
+    if(!s_csv || s_csv_buf.empty())
+        return ;
+    std::fwrite(s_csv_buf.data(), 1, s_csv_buf.size(), s_csv);
+    std::fflush(s_csv);
+    s_csv_buf.clear();
+}
+
+/**
+ * @brief                   最近 METRICS_SPARK_WIDTH 个样本的走势，按其最小最大值分为 8 级
+ */
+static void metrics_sparkline(const metrics_series &s, std::string &out){
+    static const char *const bars[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    size_t num = std::min<size_t>(s.num, METRICS_SPARK_WIDTH);
+    size_t first = (s.pos + s.ring.size() - num) % s.ring.size();
+    double lo = INFINITY;
+    double hi = -INFINITY;
+    for(size_t i = 0; i < num; i++){
+        double v = s.ring[(first + i) % s.ring.size()];
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+    for(size_t i = 0; i < num; i++){
+        double v = s.ring[(first + i) % s.ring.size()];
+        int level = hi > lo ? int((v - lo) / (hi - lo) * 7.0 + 0.5) : 3;
+        out += bars[std::clamp(level, 0, 7)];
+    }
+}
+
+extern "C"{
+
+int metrics_add(const char *spec){
+    std::string str(spec);
+    if(str.find('{') == std::string::npos){
+        size_t start = 0;
+        while(start <= str.size()){
+            size_t comma = str.find(',', start);
+            std::string key = str.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            if(!key.empty() && std::find_if(s_keys.begin(), s_keys.end(),
+                [&key](const std::pair<std::string, int> &k){ return k.first == key; }) == s_keys.end())
+                s_keys.emplace_back(key, metrics_series_get(key));
+            if(comma == std::string::npos)
+                break;
+            start = comma + 1;
+        }
+        return s_keys.empty() ? -1 : 0;
+    }
+
+    metrics_template t;
+    std::string literal;
+    bool named = false;
+    for(size_t i = 0; i < str.size(); i++){
+        if(str[i] != '{'){
+            literal += str[i];
+            continue;
+        }
+        size_t close = str.find('}', i);
+        if(close == std::string::npos || t.series.size() >= METRICS_TEMPLATE_FIELD_MAX){
+            std::printf("metrics: invalid template \"%s\"\n", spec);
+            return -1;
+        }
+        std::string name = str.substr(i + 1, close - i - 1);
+        t.literals.push_back(literal);
+        t.series.push_back(name.empty() ? -1 : metrics_series_get(name));
+        named = named || !name.empty();
+        literal.clear();
+        i = close;
+    }
+    t.literals.push_back(literal);
+    if(!named){
+        std::printf("metrics: template \"%s\" has no named field\n", spec);
+        return -1;
+    }
+    s_templates.push_back(t);
+    return 0;
+}
+
+int metrics_start(size_t ring_size, const char *csv_path){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(s_series.empty())
+        return -1;
+    if(ring_size == 0)
+        ring_size = METRICS_RING_SIZE_DEFAULT;
+    for(auto &s : s_series){
+        s.ring.assign(ring_size, 0.0);
+        s.pos = 0;
+        s.num = 0;
+        s.total = 0;
+    }
+    if(csv_path){
+        s_csv = std::fopen(csv_path, "wb");
+        if(!s_csv){
+            std::printf("metrics: open %s failed\n", csv_path);
+            return -1;
+        }
+        s_csv_buf = "t_us,series,value\n";
+    }
+    s_started = true;
+    return 0;
+}
+
+void metrics_feed_line(const char *line, size_t len, uint64_t time_us){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(!s_started)
+        return ;
+    const char *end = line + len;
+    if(!s_keys.empty())
+        metrics_feed_keys(line, end, time_us);
+    for(const auto &t : s_templates)
+        metrics_feed_template(t, line, end, time_us);
+    if(s_csv_buf.size() >= METRICS_CSV_FLUSH_SIZE || time_us >= s_csv_flush_us + METRICS_CSV_FLUSH_US){
+        metrics_csv_write();
+        s_csv_flush_us = time_us;
+    }
+}
+
+size_t metrics_table(char *out, size_t size){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(!s_started || size == 0)
+        return 0;
+    std::string table;
+    char line[256];
+    std::vector<double> sorted;
+    std::snprintf(line, sizeof(line), "%-16s %11s %11s %11s %11s %11s %10s  trend (last %zu samples)\r\n",
+        "series", "last", "min", "max", "mean", "p99", "samples", s_series.empty() ? size_t(0) : s_series[0].ring.size());
+    table += line;
+    for(const auto &s : s_series){
+        if(s.num == 0){
+            std::snprintf(line, sizeof(line), "%-16s %11s\r\n", s.name.c_str(), "-");
+            table += line;
+            continue;
+        }
+        sorted.assign(s.ring.begin(), s.ring.begin() + long(s.num));
+        double sum = 0;
+        for(double v : sorted)
+            sum += v;
+        auto minmax = std::minmax_element(sorted.begin(), sorted.end());
+        double lo = *minmax.first;
+        double hi = *minmax.second;
+        size_t p99 = (s.num * 99 + 99) / 100 - 1;
+        std::nth_element(sorted.begin(), sorted.begin() + long(p99), sorted.end());
+        std::snprintf(line, sizeof(line), "%-16s %11.6g %11.6g %11.6g %11.6g %11.6g %10llu  ", s.name.c_str(), s.last,
+            lo, hi, sum / double(s.num), sorted[p99], (unsigned long long)s.total);
+        table += line;
+        metrics_sparkline(s, table);
+        table += "\r\n";
+    }
+    size_t len = std::min(table.size(), size);
+    std::memcpy(out, table.data(), len);
+    return len;
+}
+
+void metrics_stop(void){
+    if(!s_started)
+        return ;
+    std::vector<char> table(512 * (s_series.size() + 1));
+    size_t len = metrics_table(table.data(), table.size());
+    std::fwrite(table.data(), 1, len, stdout);
+    std::unique_lock<std::mutex> lck(s_mtx);
+    s_started = false;
+    metrics_csv_write();
+    if(s_csv){
+        std::fclose(s_csv);
+        s_csv = nullptr;
+    }
+}
+
+}
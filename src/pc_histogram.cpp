@@ -0,0 +1,84 @@
+/**
+ * @file pc_histogram.cpp
+ * @brief DWT PC 采样直方图，按函数统计热点
+ *        采样时只按 PC 计数，打印时才符号化并按函数合并
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+
+#include "symbolizer.h"
+#include "pc_histogram.h"
+
+static std::unordered_map<uint32_t, uint64_t> s_pc_count;
+static uint64_t s_sleep_count = 0;
+static uint64_t s_total = 0;
+static std::mutex s_mtx;
+
+extern "C"{
+
+void pc_histogram_add(uint32_t pc, int sleep){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    s_total++;
+    if(sleep){
+        s_sleep_count++;
+        return;
+    }
+    s_pc_count[pc]++;
+}
+
+uint64_t pc_histogram_total(void){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    return s_total;
+}
+
+void pc_histogram_print(size_t top){
+    std::unordered_map<std::string, uint64_t> func_count;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        if(s_total == 0)
+            return;
+        for(auto &item : s_pc_count){
+            const char *name = symbolizer_function(item.first, nullptr);
+            char addr[16];
+            if(!name){
+                std::snprintf(addr, sizeof(addr), "%#010x", item.first);
+                name = addr;
+            }
+            func_count[name] += item.second;
+        }
+        if(s_sleep_count)
+            func_count["<sleep>"] += s_sleep_count;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> sorted(func_count.begin(), func_count.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, uint64_t> &a, const std::pair<std::string, uint64_t> &b){
+        return a.second > b.second;
+    });
+    uint64_t total = 0;
+    for(auto &item : sorted)
+        total += item.second;
+    std::printf("PC samples: %llu\r\n", (unsigned long long)total);
+    for(size_t i = 0; i < sorted.size() && i < top; i++){
+        std::printf("  %6.2f%%  %10llu  %s\r\n", double(sorted[i].second) * 100.0 / double(total),
+            (unsigned long long)sorted[i].second, sorted[i].first.c_str());
+    }
+}
+
+void pc_histogram_reset(void){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    s_pc_count.clear();
+    s_sleep_count = 0;
+    s_total = 0;
+}
+
+}
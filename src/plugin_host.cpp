@@ -0,0 +1,357 @@
+/**
+ * @file plugin_host.cpp
+ * @brief 插件加载与批量分发，插件 ABI 见 rtt_shell_plugin.h
+ *        RTT 线程只把数据追加到所在通道的批次中，插件线程每次取走所有批次，每个通道调用一次 process
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #define DYNLIB_HANDLE HMODULE
+    #define DYNLIB_OPEN(path) LoadLibraryA(path)
+    #define DYNLIB_GET(handle, name) GetProcAddress(handle, name)
+    #define DYNLIB_CLOSE(handle) FreeLibrary(handle)
+#else
+    #include <dlfcn.h>
+    #define DYNLIB_HANDLE void*
+    #define DYNLIB_OPEN(path) dlopen(path, RTLD_NOW | RTLD_LOCAL)
+    #define DYNLIB_GET(handle, name) dlsym(handle, name)
+    #define DYNLIB_CLOSE(handle) dlclose(handle)
+#endif
+
+#include "rtt_shell_plugin.h"
+#include "jlink_rtt.h"
+#include "flight_recorder.h"
+#include "terminal_display_record.h"
+#include "plugin_host.h"
+
+#define PLUGIN_HOST_PENDING_MAX         (16 * 1024 * 1024)      // 插件处理不过来时最多积压的数据，超过后丢弃
+
+struct plugin_batch_record{
+    uint64_t timestamp_us;
+    size_t off;
+    size_t len;
+};
+
+/* 一个通道积压的数据，清空时保留容量，稳态下不分配内存 */
+struct plugin_batch{
+    int channel;
+    std::vector<uint8_t> data;
+    std::vector<plugin_batch_record> records;
+};
+
+struct plugin_lib{
+    DYNLIB_HANDLE handle;
+    std::string path;
+    struct rtt_shell_host host;     // 插件可以保存 host 指针，在卸载前保持有效
+};
+
+static std::vector<plugin_lib*> s_libs;
+static std::vector<rtt_shell_channel_ops> s_ops;
+static int s_rx_channel = -1;
+static bool s_terminal_decoder = false;
+static bool s_terminal_subscribed = false;                   // 有插件注册了终端通道
+static std::mutex s_mtx;
+static std::condition_variable s_cv;
+static std::vector<plugin_batch> s_pending;
+static size_t s_pending_bytes = 0;
+static size_t s_pending_records = 0;
+static uint64_t s_dropped_bytes = 0;
+static bool s_running = false;
+static bool s_req_stop = false;
+static std::thread *s_thread = nullptr;
+
+static uint64_t now_us(void){
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief                   追加一条记录到通道的批次，需要持有 s_mtx
+ */
+static void plugin_host_feed_locked(int channel, const void *data, size_t len){
+    if(len == 0 || !s_running)
+        return;
+    if(s_pending_bytes + len > PLUGIN_HOST_PENDING_MAX){
+        s_dropped_bytes += len;
+        return;
+    }
+    plugin_batch *batch = nullptr;
+    for(auto &b : s_pending){
+        if(b.channel == channel){
+            batch = &b;
+            break;
+        }
+    }
+    if(!batch){
+        s_pending.emplace_back();
+        batch = &s_pending.back();
+        batch->channel = channel;
+    }
+    batch->records.push_back({now_us(), batch->data.size(), len});
+    batch->data.insert(batch->data.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + len);
+    s_pending_bytes += len;
+    s_pending_records++;
+    s_cv.notify_one();
+}
+
+static void plugin_host_feed(int channel, const void *data, size_t len){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    plugin_host_feed_locked(channel, data, len);
+}
+
+static void plugin_host_rx_handler(int channel, const char *data, size_t len){
+    plugin_host_feed(channel, data, len);
+}
+
+extern "C"{
+
+static int plugin_host_register_channel(void *host_ctx, const struct rtt_shell_channel_ops *ops){
+    const char *path = static_cast<const char*>(host_ctx);
+    /* 至少要包含 process，按插件给出的大小复制，主机新增的成员保持为 0 */
+    struct rtt_shell_channel_ops copy = {};
+    if(!ops || ops->size < offsetof(rtt_shell_channel_ops, process) + sizeof(copy.process)){
+        std::printf("plugin %s: invalid channel ops, rebuild the plugin with the current rtt_shell_plugin.h\n", path);
+        return -1;
+    }
+    std::memcpy(&copy, ops, std::min<size_t>(ops->size, sizeof(copy)));
+    copy.size = sizeof(copy);
+    if(!copy.process || copy.abi_version != RTT_SHELL_PLUGIN_ABI_VERSION){
+        std::printf("plugin %s: invalid channel ops\n", path);
+        return -1;
+    }
+    if(copy.channel < 0 && copy.channel != RTT_SHELL_CHANNEL_TERMINAL){
+        std::printf("plugin %s: invalid channel %d\n", path, copy.channel);
+        return -1;
+    }
+    if(s_running){
+        std::printf("plugin %s: channels must be registered while loading\n", path);
+        return -1;
+    }
+    s_ops.push_back(copy);
+    return 0;
+}
+
+static void plugin_host_emit_line(void *host_ctx, const char *text, size_t len){
+    (void)host_ctx;
+    /* 文本和换行一次写入，避免中间插入其它数据；缓存保留容量，稳态下不分配内存 */
+    static thread_local std::string s_line;
+    s_line.assign(text, len);
+    s_line += '\n';
+    terminal_display_record_write(s_line.data(), s_line.size());
+}
+
+static void plugin_host_emit_record(void *host_ctx, int channel, const void *data, size_t len){
+    (void)host_ctx;
+    if(channel < RTT_SHELL_CHANNEL_RECORD_BASE)
+        return;
+    /* 二进制记录只进入环形缓冲区，不参与文本触发字符串的匹配 */
+    flight_recorder_append(channel, static_cast<const char*>(data), len);
+    /* 插件线程运行期间 s_ops 不会改变 */
+    for(auto &ops : s_ops){
+        if(ops.channel == channel){
+            plugin_host_feed(channel, data, len);
+            break;
+        }
+    }
+}
+
+static int plugin_host_transmit(void *host_ctx, int channel, const void *data, size_t len){
+    (void)host_ctx;
+    return jlink_rtt_transmit_channel(channel, static_cast<const char*>(data), int(len));
+}
+
+}
+
+static void plugin_host_thread(void){
+    std::vector<plugin_batch> work;
+    std::vector<rtt_shell_record> records;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lck(s_mtx);
+            s_cv.wait(lck, []{ return s_pending_records > 0 || s_req_stop; });
+            if(s_pending_records == 0)
+                break;
+            /* 与积压的批次交换缓存，双方都保留容量 */
+            work.resize(s_pending.size());
+            for(size_t i = 0; i < s_pending.size(); i++){
+                work[i].channel = s_pending[i].channel;
+                work[i].data.swap(s_pending[i].data);
+                work[i].records.swap(s_pending[i].records);
+            }
+            s_pending_bytes = 0;
+            s_pending_records = 0;
+        }
+        for(auto &batch : work){
+            if(batch.records.empty())
+                continue;
+            records.clear();
+            for(auto &rec : batch.records)
+                records.push_back({rec.timestamp_us, batch.data.data() + rec.off, rec.len});
+            for(auto &ops : s_ops){
+                if(ops.channel == batch.channel)
+                    ops.process(ops.ctx, batch.channel, records.data(), records.size());
+            }
+            batch.data.clear();
+            batch.records.clear();
+        }
+    }
+}
+
+/**
+ * @brief                   调用插件的注册函数，handle 为空时是编译在程序内的插件
+ */
+static int plugin_host_register(DYNLIB_HANDLE handle, const char *path, rtt_shell_plugin_register_t entry, const char *args){
+    plugin_lib *lib = new plugin_lib;
+    lib->handle = handle;
+    lib->path = path;
+    lib->host.abi_version = RTT_SHELL_PLUGIN_ABI_VERSION;
+    lib->host.host_ctx = const_cast<char*>(lib->path.c_str());
+    lib->host.register_channel = plugin_host_register_channel;
+    lib->host.emit_line = plugin_host_emit_line;
+    lib->host.emit_record = plugin_host_emit_record;
+    lib->host.transmit = plugin_host_transmit;
+    size_t ops_num = s_ops.size();
+    if(entry(&lib->host, args) < 0){
+        std::printf("plugin %s register failed\n", path);
+        for(size_t i = ops_num; i < s_ops.size(); i++){
+            if(s_ops[i].close)
+                s_ops[i].close(s_ops[i].ctx);
+        }
+        s_ops.resize(ops_num);
+        if(handle)
+            DYNLIB_CLOSE(handle);
+        delete lib;
+        return -1;
+    }
+    s_libs.push_back(lib);
+    return 0;
+}
+
+extern "C"{
+
+int plugin_host_load(const char *spec){
+    std::string path = spec;
+    std::string args;
+    /* Windows 盘符中的冒号不是参数分隔符 */
+    size_t from = (path.size() > 2 && path[1] == ':' && (path[2] == '\\' || path[2] == '/')) ? 2 : 0;
+    size_t sep = path.find(':', from);
+    if(sep != std::string::npos){
+        args = path.substr(sep + 1);
+        path.resize(sep);
+    }
+    DYNLIB_HANDLE handle = DYNLIB_OPEN(path.c_str());
+    if(!handle){
+#ifdef _WIN32
+        std::printf("load plugin %s failed\n", path.c_str());
+#else
+        std::printf("load plugin %s failed: %s\n", path.c_str(), dlerror());
+#endif
+        return -1;
+    }
+    auto entry = reinterpret_cast<rtt_shell_plugin_register_t>(DYNLIB_GET(handle, RTT_SHELL_PLUGIN_ENTRY));
+    if(!entry){
+        std::printf("plugin %s has no %s\n", path.c_str(), RTT_SHELL_PLUGIN_ENTRY);
+        DYNLIB_CLOSE(handle);
+        return -1;
+    }
+    return plugin_host_register(handle, path.c_str(), entry, args.c_str());
+}
+
+int plugin_host_add_builtin(const char *name, rtt_shell_plugin_register_t entry, const char *args){
+    return plugin_host_register(nullptr, name, entry, args ? args : "");
+}
+
+int plugin_host_start(int rx_channel){
+    std::vector<int> attached;
+    int ret = 0;
+    if(s_ops.empty())
+        return 0;
+    s_rx_channel = rx_channel;
+    s_terminal_decoder = false;
+    s_terminal_subscribed = false;
+    for(auto &ops : s_ops){
+        if(ops.channel == RTT_SHELL_CHANNEL_TERMINAL)
+            ops.channel = rx_channel;
+        if(ops.channel == rx_channel){
+            s_terminal_subscribed = true;
+            if(ops.kind == RTT_SHELL_DECODER)
+                s_terminal_decoder = true;
+            continue;
+        }
+        if(ops.channel >= RTT_SHELL_CHANNEL_RECORD_BASE)
+            continue;
+        bool found = false;
+        for(int ch : attached)
+            found = found || ch == ops.channel;
+        if(found)
+            continue;
+        if(jlink_rtt_attach_channel(ops.channel, plugin_host_rx_handler) < 0){
+            std::printf("plugin %s: attach channel %d failed\n", ops.name ? ops.name : "", ops.channel);
+            ret = -1;
+            continue;
+        }
+        attached.push_back(ops.channel);
+    }
+    s_req_stop = false;
+    s_dropped_bytes = 0;
+    s_running = true;
+    s_thread = new std::thread(plugin_host_thread);
+    return ret;
+}
+
+int plugin_host_feed_terminal(const char *data, size_t len){
+    /* 停止后 s_ops 会被清空，必须在锁内判断；没有插件处理终端通道时不复制数据 */
+    std::lock_guard<std::mutex> lck(s_mtx);
+    if(!s_running || !s_terminal_subscribed)
+        return 0;
+    plugin_host_feed_locked(s_rx_channel, data, len);
+    return s_terminal_decoder;
+}
+
+void plugin_host_stop(void){
+    if(s_thread){
+        {
+            std::lock_guard<std::mutex> lck(s_mtx);
+            s_running = false;
+            s_terminal_decoder = false;
+            s_terminal_subscribed = false;
+            s_req_stop = true;
+            s_cv.notify_one();
+        }
+        s_thread->join();
+        delete s_thread;
+        s_thread = nullptr;
+        if(s_dropped_bytes)
+            std::printf("plugin: %llu bytes dropped, plugins too slow\n", (unsigned long long)s_dropped_bytes);
+    }
+    for(auto &ops : s_ops){
+        if(ops.close)
+            ops.close(ops.ctx);
+    }
+    s_ops.clear();
+    for(auto lib : s_libs){
+        if(lib->handle)
+            DYNLIB_CLOSE(lib->handle);
+        delete lib;
+    }
+    s_libs.clear();
+    s_pending.clear();
+}
+
+}
@@ -0,0 +1,160 @@
+/**
+ * @file profile.cpp
+ * @brief 探针/设备 profile 配置，保存连接参数以及学习到的 RTT 状态
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <filesystem>
+
+#include "profile.h"
+#include "app_config.h"
+
+#define PROFILE_FILE_NAME "profiles.ini"
+
+struct profile_section{
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> items;
+};
+
+static std::string s_profile_file;
+static std::vector<profile_section> s_sections;
+static int s_selected = -1;
+
+static std::string trim(const std::string &str){
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if(begin == std::string::npos)
+        return std::string();
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+static const std::string *section_get(const profile_section &section, const std::string &key){
+    for(auto &item : section.items){
+        if(item.first == key)
+            return &item.second;
+    }
+    return nullptr;
+}
+
+static int section_find(const std::string &name){
+    for(size_t i = 0; i < s_sections.size(); i++){
+        if(s_sections[i].name == name)
+            return int(i);
+    }
+    return -1;
+}
+
+static void profile_parse(std::ifstream &file){
+    std::string line;
+    s_sections.clear();
+    while(std::getline(file, line)){
+        line = trim(line);
+        if(line.empty() || line[0] == '#' || line[0] == ';')
+            continue;
+        if(line.front() == '[' && line.back() == ']'){
+            s_sections.push_back(profile_section{trim(line.substr(1, line.size() - 2)), {}});
+            continue;
+        }
+        size_t eq = line.find('=');
+        if(eq == std::string::npos || s_sections.empty())
+            continue;
+        s_sections.back().items.emplace_back(trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+    }
+}
+
+extern "C"{
+
+int profile_load(const char *file, const char *name, unsigned int sn){
+    s_selected = -1;
+    if(file){
+        s_profile_file = file;
+    }else{
+        const char *dir = app_config_dir();
+        if(!dir)
+            return -1;
+        s_profile_file = (std::filesystem::path(dir) / PROFILE_FILE_NAME).string();
+    }
+    std::ifstream in(s_profile_file);
+    if(in.is_open())
+        profile_parse(in);
+
+    if(name){
+        s_selected = section_find(name);
+    }else if(sn){
+        for(size_t i = 0; i < s_sections.size(); i++){
+            const std::string *value = section_get(s_sections[i], "sn");
+            if(value && std::strtoul(value->c_str(), nullptr, 0) == sn){
+                s_selected = int(i);
+                break;
+            }
+        }
+    }
+    return s_selected < 0 ? -1 : 0;
+}
+
+void profile_create(const char *name){
+    int index = section_find(name);
+    if(index < 0){
+        profile_section section{name, {}};
+        if(s_selected >= 0)
+            section.items = s_sections[size_t(s_selected)].items;
+        s_sections.push_back(std::move(section));
+        index = int(s_sections.size() - 1);
+    }
+    s_selected = index;
+}
+
+const char *profile_name(void){
+    if(s_selected < 0)
+        return nullptr;
+    return s_sections[size_t(s_selected)].name.c_str();
+}
+
+const char *profile_get(const char *key){
+    if(s_selected < 0)
+        return nullptr;
+    const std::string *value = section_get(s_sections[size_t(s_selected)], key);
+    return value ? value->c_str() : nullptr;
+}
+
+void profile_set(const char *key, const char *value){
+    if(s_selected < 0)
+        return;
+    auto &items = s_sections[size_t(s_selected)].items;
+    for(auto &item : items){
+        if(item.first == key){
+            item.second = value;
+            return;
+        }
+    }
+    items.emplace_back(key, value);
+}
+
+int profile_save(void){
+    if(s_profile_file.empty())
+        return -1;
+    std::ofstream out(s_profile_file, std::ios::out | std::ios::trunc);
+    if(!out.is_open()){
+        std::printf("open profile file %s failed\n", s_profile_file.c_str());
+        return -1;
+    }
+    for(auto &section : s_sections){
+        out << "[" << section.name << "]\n";
+        for(auto &item : section.items)
+            out << item.first << " = " << item.second << "\n";
+        out << "\n";
+    }
+    return 0;
+}
+
+}
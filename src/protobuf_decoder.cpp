@@ -0,0 +1,981 @@
+/**
+ * @file protobuf_decoder.cpp
+ * @brief 遥测通道的 protobuf 解码，消息以 varint 长度前缀分隔(nanopb pb_encode_delimited)
+ *        启动时从 FileDescriptorSet 生成每个消息按字段号直接索引的分发表，解码时不做名称查找或反射
+ *        作为内置插件运行在插件线程中，跨多次读取的消息在内部缓存中拼接
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+
+#include "jlink_api.h"
+#include "jlink_rtt.h"
+#include "mapped_file.h"
+#include "log_jsonl.h"
+#include "protobuf_decoder.h"
+
+#define PB_WIRE_VARINT                  0
+#define PB_WIRE_FIXED64                 1
+#define PB_WIRE_LEN                     2
+#define PB_WIRE_FIXED32                 5
+
+/* FieldDescriptorProto.Type */
+#define PB_TYPE_DOUBLE                  1
+#define PB_TYPE_FLOAT                   2
+#define PB_TYPE_INT64                   3
+#define PB_TYPE_UINT64                  4
+#define PB_TYPE_INT32                   5
+#define PB_TYPE_FIXED64                 6
+#define PB_TYPE_FIXED32                 7
+#define PB_TYPE_BOOL                    8
+#define PB_TYPE_STRING                  9
+#define PB_TYPE_GROUP                   10
+#define PB_TYPE_MESSAGE                 11
+#define PB_TYPE_BYTES                   12
+#define PB_TYPE_UINT32                  13
+#define PB_TYPE_ENUM                    14
+#define PB_TYPE_SFIXED32                15
+#define PB_TYPE_SFIXED64                16
+#define PB_TYPE_SINT32                  17
+#define PB_TYPE_SINT64                  18
+
+#define PB_LABEL_REPEATED               3
+
+#define PB_MESSAGE_SIZE_MAX             (64 * 1024)     // 超过时认为长度前缀损坏，丢弃一个字节重新同步
+#define PB_DISPATCH_DENSE_MAX           1024            // 最大字段号不超过该值时用数组直接索引
+#define PB_NEST_MAX                     32
+#define PB_OUT_FLUSH_SIZE               0x40000
+
+struct pb_field{
+    uint32_t number;
+    uint8_t type;
+    bool repeated;
+    std::string name;
+    std::string json_key;               // 预先生成的 "name":
+    std::string type_name;              // 消息或枚举的全名
+    int message;                        // 子消息在 s_messages 中的下标
+    int enum_index;                     // 枚举在 s_enums 中的下标
+    int repeated_slot;                  // JSON：重复字段在所属消息中的元素缓冲区序号，非重复字段为 -1
+    size_t column;                      // CSV：在所属消息中的列偏移
+    bool csv_leaf;                      // CSV：整个字段占一列(标量、重复字段或递归的子消息)
+};
+
+struct pb_enum{
+    std::string full_name;
+    std::vector<std::pair<int32_t, std::string>> values;    // 按值排序
+};
+
+struct pb_message{
+    std::string full_name;
+    std::vector<pb_field> fields;
+    std::vector<int16_t> dense;                             // 字段号 -> fields 下标，-1 为未知字段
+    std::vector<std::pair<uint32_t, int>> sparse;           // 字段号超过 PB_DISPATCH_DENSE_MAX 时按字段号排序查找
+    std::vector<int> repeated;                              // 重复字段在 fields 中的下标，按 repeated_slot 排列
+    size_t csv_width;
+    int csv_state;                                          // 0 未计算, 1 计算中, 2 已计算
+};
+
+struct pb_reader{
+    const uint8_t *p;
+    const uint8_t *end;
+};
+
+static std::vector<pb_message> s_messages;
+static std::vector<pb_enum> s_enums;
+static int s_root = -1;
+static bool s_csv = false;
+static std::FILE *s_out = nullptr;
+static std::string s_out_buf;
+static std::vector<std::string> s_cells;
+static std::deque<std::string> s_json_slots;    // JSON 重复字段的元素，嵌套的消息依次使用后面的缓冲区；deque 扩大时已有元素的引用不失效
+static size_t s_json_slot_top = 0;
+static std::vector<uint8_t> s_stream;           // 未完成的消息
+static int s_channel = -1;
+static uint64_t s_message_num = 0;
+static uint64_t s_error_num = 0;
+static uint64_t s_byte_num = 0;
+static std::chrono::steady_clock::time_point s_start_time;
+
+static const char s_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief                   读取 varint
+ * @return int              1 成功; 0 数据不足; -1 超过 10 字节
+ */
+static inline int pb_read_varint(struct pb_reader *r, uint64_t *value){
+    uint64_t v = 0;
+    const uint8_t *p = r->p;
+    for(int shift = 0; shift < 70; shift += 7){
+        if(p >= r->end)
+            return 0;
+        uint8_t b = *p++;
+        v |= uint64_t(b & 0x7f) << shift;
+        if(!(b & 0x80)){
+            r->p = p;
+            *value = v;
+            return 1;
+        }
+    }
+    return -1;
+}
+
+static inline bool pb_read_fixed(struct pb_reader *r, int size, uint64_t *value){
+    if(r->end - r->p < size)
+        return false;
+    uint64_t v = 0;
+    for(int i = size - 1; i >= 0; i--)
+        v = (v << 8) | r->p[i];
+    r->p += size;
+    *value = v;
+    return true;
+}
+
+static inline bool pb_read_len(struct pb_reader *r, struct pb_reader *sub){
+    uint64_t len;
+    if(pb_read_varint(r, &len) != 1 || len > uint64_t(r->end - r->p))
+        return false;
+    sub->p = r->p;
+    sub->end = r->p + len;
+    r->p += len;
+    return true;
+}
+
+static bool pb_skip(struct pb_reader *r, uint32_t wire){
+    uint64_t value;
+    struct pb_reader sub;
+    switch(wire){
+        case PB_WIRE_VARINT:    return pb_read_varint(r, &value) == 1;
+        case PB_WIRE_FIXED64:   return pb_read_fixed(r, 8, &value);
+        case PB_WIRE_LEN:       return pb_read_len(r, &sub);
+        case PB_WIRE_FIXED32:   return pb_read_fixed(r, 4, &value);
+        default:                return false;
+    }
+}
+
+static inline std::string pb_string(const struct pb_reader &r){
+    return std::string(reinterpret_cast<const char*>(r.p), size_t(r.end - r.p));
+}
+
+/* ---------------------------------------------------------------------------------------------- */
+/*                                     FileDescriptorSet 解析                                       */
+/* ---------------------------------------------------------------------------------------------- */
+
+static bool pb_desc_enum(struct pb_reader r, const std::string &scope){
+    pb_enum e;
+    uint64_t tag;
+    while(r.p < r.end){
+        struct pb_reader sub;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        if(tag == ((1 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            e.full_name = scope + pb_string(sub);
+        }else if(tag == ((2 << 3) | PB_WIRE_LEN)){
+            /* EnumValueDescriptorProto: name = 1, number = 2 */
+            if(!pb_read_len(&r, &sub))
+                return false;
+            std::string name;
+            uint64_t number = 0;
+            while(sub.p < sub.end){
+                struct pb_reader s;
+                if(pb_read_varint(&sub, &tag) != 1)
+                    return false;
+                if(tag == ((1 << 3) | PB_WIRE_LEN)){
+                    if(!pb_read_len(&sub, &s))
+                        return false;
+                    name = pb_string(s);
+                }else if(tag == ((2 << 3) | PB_WIRE_VARINT)){
+                    if(pb_read_varint(&sub, &number) != 1)
+                        return false;
+                }else if(!pb_skip(&sub, uint32_t(tag & 7))){
+                    return false;
+                }
+            }
+            e.values.emplace_back(int32_t(uint32_t(number)), name);
+        }else if(!pb_skip(&r, uint32_t(tag & 7))){
+            return false;
+        }
+    }
+    std::sort(e.values.begin(), e.values.end(),
+        [](const std::pair<int32_t, std::string> &a, const std::pair<int32_t, std::string> &b){ return a.first < b.first; });
+    s_enums.push_back(std::move(e));
+    return true;
+}
+
+static bool pb_desc_field(struct pb_reader r, pb_field *f){
+    uint64_t tag;
+    uint64_t value;
+    f->number = 0;
+    f->type = 0;
+    f->repeated = false;
+    f->message = -1;
+    f->enum_index = -1;
+    f->repeated_slot = -1;
+    f->column = 0;
+    f->csv_leaf = true;
+    while(r.p < r.end){
+        struct pb_reader sub;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        switch(tag){
+            case (1 << 3) | PB_WIRE_LEN:
+                if(!pb_read_len(&r, &sub))
+                    return false;
+                f->name = pb_string(sub);
+                break;
+            case (3 << 3) | PB_WIRE_VARINT:
+                if(pb_read_varint(&r, &value) != 1)
+                    return false;
+                f->number = uint32_t(value);
+                break;
+            case (4 << 3) | PB_WIRE_VARINT:
+                if(pb_read_varint(&r, &value) != 1)
+                    return false;
+                f->repeated = value == PB_LABEL_REPEATED;
+                break;
+            case (5 << 3) | PB_WIRE_VARINT:
+                if(pb_read_varint(&r, &value) != 1)
+                    return false;
+                f->type = uint8_t(value);
+                break;
+            case (6 << 3) | PB_WIRE_LEN:
+                if(!pb_read_len(&r, &sub))
+                    return false;
+                f->type_name = pb_string(sub);
+                if(!f->type_name.empty() && f->type_name[0] == '.')
+                    f->type_name.erase(0, 1);
+                break;
+            default:
+                if(!pb_skip(&r, uint32_t(tag & 7)))
+                    return false;
+                break;
+        }
+    }
+    /* 键名预先转义，解码时直接追加 */
+    std::string key(f->name.size() * 6, '\0');
+    key.resize(log_jsonl_escape(&key[0], f->name.data(), f->name.size()));
+    f->json_key = "\"" + key + "\":";
+    return f->number > 0;
+}
+
+static bool pb_desc_message(struct pb_reader r, const std::string &scope){
+    pb_message m;
+    std::vector<struct pb_reader> nested;
+    std::vector<struct pb_reader> enums;
+    uint64_t tag;
+    m.csv_width = 0;
+    m.csv_state = 0;
+    while(r.p < r.end){
+        struct pb_reader sub;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        if(tag == ((1 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            m.full_name = scope + pb_string(sub);
+        }else if(tag == ((2 << 3) | PB_WIRE_LEN)){
+            pb_field f;
+            if(!pb_read_len(&r, &sub) || !pb_desc_field(sub, &f))
+                return false;
+            m.fields.push_back(std::move(f));
+        }else if(tag == ((3 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            nested.push_back(sub);
+        }else if(tag == ((4 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            enums.push_back(sub);
+        }else if(!pb_skip(&r, uint32_t(tag & 7))){
+            return false;
+        }
+    }
+    /* 嵌套类型的名称需要外层名称，所以在外层解析完后再解析 */
+    std::string nested_scope = m.full_name + ".";
+    s_messages.push_back(std::move(m));
+    for(auto &sub : nested){
+        if(!pb_desc_message(sub, nested_scope))
+            return false;
+    }
+    for(auto &sub : enums){
+        if(!pb_desc_enum(sub, nested_scope))
+            return false;
+    }
+    return true;
+}
+
+static bool pb_desc_file(struct pb_reader r, int *first_message){
+    std::string scope;
+    std::vector<struct pb_reader> messages;
+    std::vector<struct pb_reader> enums;
+    uint64_t tag;
+    while(r.p < r.end){
+        struct pb_reader sub;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        if(tag == ((2 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            scope = pb_string(sub) + ".";
+        }else if(tag == ((4 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            messages.push_back(sub);
+        }else if(tag == ((5 << 3) | PB_WIRE_LEN)){
+            if(!pb_read_len(&r, &sub))
+                return false;
+            enums.push_back(sub);
+        }else if(!pb_skip(&r, uint32_t(tag & 7))){
+            return false;
+        }
+    }
+    if(!messages.empty())
+        *first_message = int(s_messages.size());
+    for(auto &sub : messages){
+        if(!pb_desc_message(sub, scope))
+            return false;
+    }
+    for(auto &sub : enums){
+        if(!pb_desc_enum(sub, scope))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief                   解析类型名并生成分发表
+ */
+static bool pb_desc_compile(void){
+    std::map<std::string, int> message_index;
+    std::map<std::string, int> enum_index;
+    for(size_t i = 0; i < s_messages.size(); i++)
+        message_index[s_messages[i].full_name] = int(i);
+    for(size_t i = 0; i < s_enums.size(); i++)
+        enum_index[s_enums[i].full_name] = int(i);
+
+    for(auto &m : s_messages){
+        uint32_t max_number = 0;
+        for(auto &f : m.fields){
+            if(f.type == PB_TYPE_MESSAGE){
+                auto it = message_index.find(f.type_name);
+                if(it == message_index.end()){
+                    std::printf("protobuf: %s.%s has unknown type %s\n", m.full_name.c_str(), f.name.c_str(), f.type_name.c_str());
+                    return false;
+                }
+                f.message = it->second;
+            }else if(f.type == PB_TYPE_ENUM){
+                auto it = enum_index.find(f.type_name);
+                if(it != enum_index.end())
+                    f.enum_index = it->second;
+            }else if(f.type == 0 || f.type == PB_TYPE_GROUP || f.type > PB_TYPE_SINT64){
+                std::printf("protobuf: %s.%s has unsupported type %u\n", m.full_name.c_str(), f.name.c_str(), f.type);
+                return false;
+            }
+            max_number = std::max(max_number, f.number);
+        }
+        m.repeated.clear();
+        for(size_t i = 0; i < m.fields.size(); i++){
+            if(m.fields[i].repeated){
+                m.fields[i].repeated_slot = int(m.repeated.size());
+                m.repeated.push_back(int(i));
+            }
+        }
+        if(max_number <= PB_DISPATCH_DENSE_MAX){
+            m.dense.assign(max_number + 1, -1);
+            for(size_t i = 0; i < m.fields.size(); i++)
+                m.dense[m.fields[i].number] = int16_t(i);
+        }else{
+            for(size_t i = 0; i < m.fields.size(); i++)
+                m.sparse.emplace_back(m.fields[i].number, int(i));
+            std::sort(m.sparse.begin(), m.sparse.end());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief                   计算消息展开后的列数，非重复的子消息展开为多列，递归的子消息作为一列
+ */
+static size_t pb_csv_layout(int index){
+    pb_message &m = s_messages[size_t(index)];
+    if(m.csv_state == 2)
+        return m.csv_width;
+    m.csv_state = 1;
+    size_t width = 0;
+    for(auto &f : m.fields){
+        f.column = width;
+        if(f.type == PB_TYPE_MESSAGE && !f.repeated && s_messages[size_t(f.message)].csv_state != 1){
+            f.csv_leaf = false;
+            width += pb_csv_layout(f.message);
+        }else{
+            f.csv_leaf = true;
+            width++;
+        }
+    }
+    m.csv_width = width;
+    m.csv_state = 2;
+    return width;
+}
+
+static void pb_csv_header(int index, const std::string &prefix, std::string &out){
+    for(auto &f : s_messages[size_t(index)].fields){
+        if(!f.csv_leaf){
+            pb_csv_header(f.message, prefix + f.name + ".", out);
+            continue;
+        }
+        out += ',';
+        out += prefix;
+        out += f.name;
+    }
+}
+
+/* ---------------------------------------------------------------------------------------------- */
+/*                                            解码                                                  */
+/* ---------------------------------------------------------------------------------------------- */
+
+static inline const pb_field *pb_find_field(const pb_message &m, uint32_t number){
+    if(!m.dense.empty() || m.sparse.empty()){
+        if(number >= m.dense.size() || m.dense[number] < 0)
+            return nullptr;
+        return &m.fields[size_t(m.dense[number])];
+    }
+    auto it = std::lower_bound(m.sparse.begin(), m.sparse.end(), std::make_pair(number, -1));
+    if(it == m.sparse.end() || it->first != number)
+        return nullptr;
+    return &m.fields[size_t(it->second)];
+}
+
+static inline uint32_t pb_wire_of(uint8_t type){
+    switch(type){
+        case PB_TYPE_DOUBLE:
+        case PB_TYPE_FIXED64:
+        case PB_TYPE_SFIXED64:
+            return PB_WIRE_FIXED64;
+        case PB_TYPE_FLOAT:
+        case PB_TYPE_FIXED32:
+        case PB_TYPE_SFIXED32:
+            return PB_WIRE_FIXED32;
+        case PB_TYPE_STRING:
+        case PB_TYPE_BYTES:
+        case PB_TYPE_MESSAGE:
+            return PB_WIRE_LEN;
+        default:
+            return PB_WIRE_VARINT;
+    }
+}
+
+template <typename T>
+static inline void pb_put_int(std::string &out, T value){
+    char buf[24];
+    out.append(buf, size_t(std::to_chars(buf, buf + sizeof(buf), value).ptr - buf));
+}
+
+static inline void pb_put_double(std::string &out, double value, bool json, int precision){
+    char buf[40];
+    if(std::isnan(value)){
+        out += json ? "\"NaN\"" : "NaN";
+    }else if(std::isinf(value)){
+        out += value > 0 ? (json ? "\"Infinity\"" : "Infinity") : (json ? "\"-Infinity\"" : "-Infinity");
+    }else{
+        int n = std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+        out.append(buf, size_t(n));
+    }
+}
+
+static inline void pb_put_escaped(std::string &out, const uint8_t *data, size_t len){
+    size_t pos = out.size();
+    out.resize(pos + len * 6);
+    out.resize(pos + log_jsonl_escape(&out[pos], reinterpret_cast<const char*>(data), len));
+}
+
+static void pb_put_base64(std::string &out, const uint8_t *data, size_t len){
+    size_t i = 0;
+    for(; i + 3 <= len; i += 3){
+        uint32_t v = uint32_t(data[i]) << 16 | uint32_t(data[i + 1]) << 8 | data[i + 2];
+        out += s_base64[v >> 18];
+        out += s_base64[(v >> 12) & 0x3f];
+        out += s_base64[(v >> 6) & 0x3f];
+        out += s_base64[v & 0x3f];
+    }
+    if(i < len){
+        uint32_t v = uint32_t(data[i]) << 16 | (i + 1 < len ? uint32_t(data[i + 1]) << 8 : 0);
+        out += s_base64[v >> 18];
+        out += s_base64[(v >> 12) & 0x3f];
+        out += i + 1 < len ? s_base64[(v >> 6) & 0x3f] : '=';
+        out += '=';
+    }
+}
+
+static bool pb_decode_json(const pb_message &m, struct pb_reader r, std::string &out, int depth);
+
+/**
+ * @brief                   解码一个值，json 为 false 时字符串与枚举名不加引号(用于 CSV 单元格)
+ */
+static bool pb_decode_value(const pb_field &f, uint32_t wire, struct pb_reader *r, std::string &out, bool json, int depth){
+    uint64_t v;
+    struct pb_reader sub;
+    if(wire != pb_wire_of(f.type))
+        return false;
+    switch(f.type){
+        case PB_TYPE_DOUBLE:
+            if(!pb_read_fixed(r, 8, &v))
+                return false;
+            double d;
+            std::memcpy(&d, &v, sizeof(d));
+            pb_put_double(out, d, json, 17);
+            return true;
+        case PB_TYPE_FLOAT:{
+            if(!pb_read_fixed(r, 4, &v))
+                return false;
+            uint32_t bits = uint32_t(v);
+            float fl;
+            std::memcpy(&fl, &bits, sizeof(fl));
+            pb_put_double(out, double(fl), json, 9);
+            return true;
+        }
+        case PB_TYPE_FIXED64:
+            if(!pb_read_fixed(r, 8, &v))
+                return false;
+            pb_put_int(out, v);
+            return true;
+        case PB_TYPE_SFIXED64:
+            if(!pb_read_fixed(r, 8, &v))
+                return false;
+            pb_put_int(out, int64_t(v));
+            return true;
+        case PB_TYPE_FIXED32:
+            if(!pb_read_fixed(r, 4, &v))
+                return false;
+            pb_put_int(out, uint32_t(v));
+            return true;
+        case PB_TYPE_SFIXED32:
+            if(!pb_read_fixed(r, 4, &v))
+                return false;
+            pb_put_int(out, int32_t(uint32_t(v)));
+            return true;
+        case PB_TYPE_STRING:
+            if(!pb_read_len(r, &sub))
+                return false;
+            if(json){
+                out += '"';
+                pb_put_escaped(out, sub.p, size_t(sub.end - sub.p));
+                out += '"';
+            }else{
+                out.append(reinterpret_cast<const char*>(sub.p), size_t(sub.end - sub.p));
+            }
+            return true;
+        case PB_TYPE_BYTES:
+            if(!pb_read_len(r, &sub))
+                return false;
+            if(json)
+                out += '"';
+            pb_put_base64(out, sub.p, size_t(sub.end - sub.p));
+            if(json)
+                out += '"';
+            return true;
+        case PB_TYPE_MESSAGE:
+            if(!pb_read_len(r, &sub) || depth >= PB_NEST_MAX)
+                return false;
+            return pb_decode_json(s_messages[size_t(f.message)], sub, out, depth + 1);
+        default:
+            break;
+    }
+    if(pb_read_varint(r, &v) != 1)
+        return false;
+    switch(f.type){
+        case PB_TYPE_INT64:     pb_put_int(out, int64_t(v)); break;
+        case PB_TYPE_UINT64:    pb_put_int(out, v); break;
+        case PB_TYPE_INT32:     pb_put_int(out, int32_t(uint32_t(v))); break;
+        case PB_TYPE_UINT32:    pb_put_int(out, uint32_t(v)); break;
+        case PB_TYPE_BOOL:      out += v ? "true" : "false"; break;
+        case PB_TYPE_SINT32:    pb_put_int(out, int32_t(uint32_t(v) >> 1) ^ -int32_t(v & 1)); break;
+        case PB_TYPE_SINT64:    pb_put_int(out, int64_t(v >> 1) ^ -int64_t(v & 1)); break;
+        case PB_TYPE_ENUM:{
+            int32_t value = int32_t(uint32_t(v));
+            if(f.enum_index >= 0){
+                auto &values = s_enums[size_t(f.enum_index)].values;
+                auto it = std::lower_bound(values.begin(), values.end(), value,
+                    [](const std::pair<int32_t, std::string> &a, int32_t b){ return a.first < b; });
+                if(it != values.end() && it->first == value){
+                    if(json)
+                        out += '"';
+                    out += it->second;
+                    if(json)
+                        out += '"';
+                    break;
+                }
+            }
+            pb_put_int(out, value);
+            break;
+        }
+        default:
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief                   解码重复字段，连续出现的同一字段(包括 packed 编码)合并为一个数组，元素以 sep 分隔
+ * @param  first            输入输出，是否还没有输出过元素，多段合并到同一个数组时在各段之间传递
+ */
+static bool pb_decode_repeated(const pb_field &f, uint32_t wire, struct pb_reader *r, std::string &out,
+    const char *sep, bool json, int depth, bool *first){
+    while(true){
+        if(wire == PB_WIRE_LEN && pb_wire_of(f.type) != PB_WIRE_LEN){
+            /* packed */
+            struct pb_reader packed;
+            if(!pb_read_len(r, &packed))
+                return false;
+            while(packed.p < packed.end){
+                if(!*first)
+                    out += sep;
+                *first = false;
+                if(!pb_decode_value(f, pb_wire_of(f.type), &packed, out, json, depth))
+                    return false;
+            }
+        }else{
+            if(!*first)
+                out += sep;
+            *first = false;
+            if(!pb_decode_value(f, wire, r, out, json, depth))
+                return false;
+        }
+        struct pb_reader next = *r;
+        uint64_t tag;
+        if(next.p >= next.end || pb_read_varint(&next, &tag) != 1 || uint32_t(tag >> 3) != f.number)
+            return true;
+        wire = uint32_t(tag & 7);
+        r->p = next.p;
+    }
+}
+
+/**
+ * @brief                   解码消息的字段，重复字段的元素先放到 slots 开始的缓冲区，所有字段解码完后按声明顺序输出
+ *                          同一重复字段不连续出现时也合并为一个数组，只扫描一遍消息
+ */
+static bool pb_decode_json_fields(const pb_message &m, struct pb_reader r, std::string &out, int depth, size_t slots){
+    bool first = true;
+    out += '{';
+    while(r.p < r.end){
+        uint64_t tag;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        uint32_t wire = uint32_t(tag & 7);
+        const pb_field *f = pb_find_field(m, uint32_t(tag >> 3));
+        if(!f){
+            if(!pb_skip(&r, wire))
+                return false;
+            continue;
+        }
+        if(f->repeated){
+            std::string &values = s_json_slots[slots + size_t(f->repeated_slot)];
+            bool first_value = values.empty();
+            if(!pb_decode_repeated(*f, wire, &r, values, ",", true, depth, &first_value))
+                return false;
+            continue;
+        }
+        if(!first)
+            out += ',';
+        first = false;
+        out += f->json_key;
+        if(!pb_decode_value(*f, wire, &r, out, true, depth))
+            return false;
+    }
+    for(size_t i = 0; i < m.repeated.size(); i++){
+        const std::string &values = s_json_slots[slots + i];
+        if(values.empty())
+            continue;
+        if(!first)
+            out += ',';
+        first = false;
+        out += m.fields[size_t(m.repeated[i])].json_key;
+        out += '[';
+        out += values;
+        out += ']';
+    }
+    out += '}';
+    return true;
+}
+
+static bool pb_decode_json(const pb_message &m, struct pb_reader r, std::string &out, int depth){
+    size_t slots = s_json_slot_top;
+    s_json_slot_top += m.repeated.size();
+    if(s_json_slots.size() < s_json_slot_top)
+        s_json_slots.resize(s_json_slot_top);
+    for(size_t i = slots; i < s_json_slot_top; i++)
+        s_json_slots[i].clear();
+    bool ok = pb_decode_json_fields(m, r, out, depth, slots);
+    s_json_slot_top = slots;
+    return ok;
+}
+
+/**
+ * @brief                   解码到 CSV 单元格，base 为消息第一列的下标
+ */
+static bool pb_decode_csv(const pb_message &m, struct pb_reader r, size_t base, int depth){
+    while(r.p < r.end){
+        uint64_t tag;
+        if(pb_read_varint(&r, &tag) != 1)
+            return false;
+        uint32_t wire = uint32_t(tag & 7);
+        const pb_field *f = pb_find_field(m, uint32_t(tag >> 3));
+        if(!f){
+            if(!pb_skip(&r, wire))
+                return false;
+            continue;
+        }
+        if(!f->csv_leaf){
+            struct pb_reader sub;
+            if(wire != PB_WIRE_LEN || !pb_read_len(&r, &sub) || depth >= PB_NEST_MAX)
+                return false;
+            if(!pb_decode_csv(s_messages[size_t(f->message)], sub, base + f->column, depth + 1))
+                return false;
+            continue;
+        }
+        std::string &cell = s_cells[base + f->column];
+        /* 子消息以 JSON 输出；同一字段再次出现时以 ';' 分隔 */
+        bool json = f->type == PB_TYPE_MESSAGE;
+        if(f->repeated){
+            bool first_value = cell.empty();
+            if(!pb_decode_repeated(*f, wire, &r, cell, ";", json, depth, &first_value))
+                return false;
+            continue;
+        }
+        if(!cell.empty())
+            cell += ';';
+        if(!pb_decode_value(*f, wire, &r, cell, json, depth))
+            return false;
+    }
+    return true;
+}
+
+static void pb_put_csv_cell(std::string &out, const std::string &cell){
+    if(cell.find_first_of(",\"\r\n") == std::string::npos){
+        out += cell;
+        return;
+    }
+    out += '"';
+    for(char c : cell){
+        if(c == '"')
+            out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+static void protobuf_decoder_message(const uint8_t *data, size_t len, uint64_t timestamp_us){
+    struct pb_reader r = {data, data + len};
+    const pb_message &root = s_messages[size_t(s_root)];
+    size_t pos = s_out_buf.size();
+    bool ok;
+    if(s_csv){
+        for(auto &cell : s_cells)
+            cell.clear();
+        ok = pb_decode_csv(root, r, 0, 0);
+        if(ok){
+            pb_put_int(s_out_buf, timestamp_us);
+            for(auto &cell : s_cells){
+                s_out_buf += ',';
+                pb_put_csv_cell(s_out_buf, cell);
+            }
+            s_out_buf += '\n';
+        }
+    }else{
+        s_out_buf += "{\"t_us\":";
+        pb_put_int(s_out_buf, timestamp_us);
+        s_out_buf += ",\"msg\":";
+        ok = pb_decode_json(root, r, s_out_buf, 0);
+        s_out_buf += "}\n";
+    }
+    if(!ok){
+        s_out_buf.resize(pos);
+        s_error_num++;
+        return;
+    }
+    s_message_num++;
+}
+
+/**
+ * @brief                   从数据流中取出完整的消息
+ * @return size_t           已处理的字节数，剩余的是不完整的消息
+ */
+static size_t protobuf_decoder_stream(const uint8_t *data, size_t len, uint64_t timestamp_us){
+    struct pb_reader r = {data, data + len};
+    while(r.p < r.end){
+        const uint8_t *start = r.p;
+        uint64_t msg_len;
+        int ret = pb_read_varint(&r, &msg_len);
+        if(ret == 0)
+            return size_t(start - data);
+        if(ret < 0 || msg_len > PB_MESSAGE_SIZE_MAX){
+            /* 长度前缀损坏，跳过一个字节重新同步 */
+            s_error_num++;
+            r.p = start + 1;
+            continue;
+        }
+        if(uint64_t(r.end - r.p) < msg_len)
+            return size_t(start - data);
+        protobuf_decoder_message(r.p, size_t(msg_len), timestamp_us);
+        r.p += msg_len;
+    }
+    return len;
+}
+
+static void protobuf_decoder_flush(void){
+    if(s_out_buf.empty())
+        return;
+    std::fwrite(s_out_buf.data(), 1, s_out_buf.size(), s_out);
+    s_out_buf.clear();
+}
+
+extern "C"{
+
+static void protobuf_decoder_process(void *ctx, int channel, const struct rtt_shell_record *records, size_t num){
+    (void)ctx;
+    (void)channel;
+    for(size_t i = 0; i < num; i++){
+        const struct rtt_shell_record *rec = &records[i];
+        s_byte_num += rec->len;
+        if(s_stream.empty()){
+            /* 没有未完成的消息时直接在接收数据上解码，只复制结尾不完整的部分 */
+            size_t used = protobuf_decoder_stream(rec->data, rec->len, rec->timestamp_us);
+            s_stream.assign(rec->data + used, rec->data + rec->len);
+        }else{
+            s_stream.insert(s_stream.end(), rec->data, rec->data + rec->len);
+            size_t used = protobuf_decoder_stream(s_stream.data(), s_stream.size(), rec->timestamp_us);
+            s_stream.erase(s_stream.begin(), s_stream.begin() + std::ptrdiff_t(used));
+        }
+        if(s_out_buf.size() >= PB_OUT_FLUSH_SIZE)
+            protobuf_decoder_flush();
+    }
+    protobuf_decoder_flush();
+}
+
+static void protobuf_decoder_close(void *ctx){
+    (void)ctx;
+    protobuf_decoder_flush();
+    if(s_out){
+        std::fclose(s_out);
+        s_out = nullptr;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_start_time).count();
+    std::printf("telemetry: %llu messages, %.0f msg/s, %llu bytes, %llu decode errors\n",
+        (unsigned long long)s_message_num, sec > 0 ? double(s_message_num) / sec : 0.0,
+        (unsigned long long)s_byte_num, (unsigned long long)s_error_num);
+}
+
+int protobuf_decoder_load(const char *desc_path, const char *type_name, const char *out_path){
+    mapped_file_t *mf = mapped_file_open(desc_path);
+    if(!mf){
+        std::printf("protobuf: open %s failed\n", desc_path);
+        return -1;
+    }
+    s_messages.clear();
+    s_enums.clear();
+    s_root = -1;
+    int first_message = -1;
+    bool ok = true;
+    struct pb_reader r = {mapped_file_data(mf), mapped_file_data(mf) + mapped_file_size(mf)};
+    /* FileDescriptorSet: repeated FileDescriptorProto file = 1 */
+    while(ok && r.p < r.end){
+        struct pb_reader sub;
+        uint64_t tag;
+        if(pb_read_varint(&r, &tag) != 1){
+            ok = false;
+        }else if(tag == ((1 << 3) | PB_WIRE_LEN)){
+            ok = pb_read_len(&r, &sub) && pb_desc_file(sub, &first_message);
+        }else{
+            ok = pb_skip(&r, uint32_t(tag & 7));
+        }
+    }
+    mapped_file_close(mf);
+    if(!ok || !pb_desc_compile()){
+        std::printf("protobuf: %s is not a valid FileDescriptorSet\n", desc_path);
+        return -1;
+    }
+    if(type_name){
+        for(size_t i = 0; i < s_messages.size(); i++){
+            if(s_messages[i].full_name == type_name)
+                s_root = int(i);
+        }
+    }else if(first_message >= 0){
+        /* 默认取最后一个文件中第一个没有被其它消息引用的消息 */
+        std::vector<bool> referenced(s_messages.size(), false);
+        for(const auto &m : s_messages){
+            for(const auto &f : m.fields){
+                if(f.type == PB_TYPE_MESSAGE)
+                    referenced[size_t(f.message)] = true;
+            }
+        }
+        for(size_t i = size_t(first_message); i < s_messages.size() && s_root < 0; i++){
+            if(!referenced[i])
+                s_root = int(i);
+        }
+        if(s_root < 0)
+            s_root = first_message;
+    }
+    if(s_root < 0){
+        std::printf("protobuf: message type %s not found in %s\n", type_name ? type_name : "", desc_path);
+        return -1;
+    }
+
+    size_t len = std::strlen(out_path);
+    s_csv = len >= 4 && (std::strcmp(out_path + len - 4, ".csv") == 0 || std::strcmp(out_path + len - 4, ".CSV") == 0);
+    s_out = std::fopen(out_path, "wb");
+    if(!s_out){
+        std::printf("protobuf: open %s failed\n", out_path);
+        return -1;
+    }
+    if(s_csv){
+        std::string header = "t_us";
+        s_cells.assign(pb_csv_layout(s_root), std::string());
+        pb_csv_header(s_root, "", header);
+        header += '\n';
+        std::fwrite(header.data(), 1, header.size(), s_out);
+    }
+    s_stream.clear();
+    s_out_buf.clear();
+    s_message_num = 0;
+    s_error_num = 0;
+    s_byte_num = 0;
+    return 0;
+}
+
+int protobuf_decoder_plugin_register(const struct rtt_shell_host *host, const char *args){
+    if(!s_out)
+        return -1;
+    s_channel = (args && *args) ? std::atoi(args) : jlink_rtt_find_buffer(RTT_DIRECTION_UP, PROTOBUF_TELEMETRY_BUFFER_NAME);
+    if(s_channel < 0){
+        std::printf("protobuf: no \"%s\" up buffer, use --telemetry_channel\n", PROTOBUF_TELEMETRY_BUFFER_NAME);
+        std::fclose(s_out);
+        s_out = nullptr;
+        return -1;
+    }
+    struct rtt_shell_channel_ops ops = {};
+    ops.size = sizeof(ops);
+    ops.abi_version = RTT_SHELL_PLUGIN_ABI_VERSION;
+    ops.name = "protobuf";
+    ops.channel = s_channel;
+    ops.kind = RTT_SHELL_DECODER;
+    ops.process = protobuf_decoder_process;
+    ops.close = protobuf_decoder_close;
+    s_start_time = std::chrono::steady_clock::now();
+    return host->register_channel(host->host_ctx, &ops);
+}
+
+}
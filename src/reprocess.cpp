@@ -0,0 +1,427 @@
+/**
+ * @file reprocess.cpp
+ * @brief 离线重新处理 .rttcap 捕获文件：按记录边界分块，多线程解析、过滤、格式化后按顺序输出
+ *        分块只在记录边界切分，一行可能跨过分块：不在行首开始的分块跳过第一个换行之前的数据，
+ *        分块结束时未完成的行继续读取后面的记录直到换行，所以每行只由它开始所在的分块输出
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "capture_file.h"
+#include "mapped_file.h"
+#include "vt_parser.h"
+#include "log_jsonl.h"
+#include "symbolizer.h"
+#include "work_pool.h"
+#include "reprocess.h"
+
+#define ASCII_BACKSPACE                 0x08
+#define ASCII_TAB                       0x09
+#define ASCII_LF                        0x0A
+#define ASCII_CR                        0x0D
+#define ASCII_DEL_LINE                  0x0E
+
+#define REPROCESS_WINDOW_PER_THREAD     4           // 每个线程最多领先写出位置的分块数
+#define REPROCESS_ANNOTATION_SIZE       512
+
+struct reprocess_file{
+    std::string path;
+    std::string session;                // 文件名，作为 JSON 记录的会话
+    mapped_file_t *mf;
+    const uint8_t *end;                 // 最后一条完整记录的结尾
+};
+
+struct reprocess_context;
+
+struct reprocess_chunk{
+    reprocess_context *ctx;
+    const reprocess_file *file;
+    const uint8_t *begin;               // 第一条记录
+    const uint8_t *end;                 // 分块结尾，位于记录边界
+    bool line_start;                    // 分块开始时文本通道位于行首
+    uint64_t lines;                     // 在本分块内开始的行数
+    uint64_t seq;                       // 第一行的序号
+    std::string out;
+    bool done;
+};
+
+struct reprocess_context{
+    struct reprocess_options opt;
+    std::vector<std::string_view> filters;
+    std::vector<reprocess_chunk> chunks;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+/* 一个分块内的行组装，与终端显示的行缓冲规则相同 */
+struct reprocess_line{
+    reprocess_chunk *chunk;
+    std::string text;
+    size_t pos;                         // 插入位置
+    bool started;                       // 当前行已经开始
+    uint64_t time_us;                   // 当前行开始的时间
+    uint64_t record_us;                 // 当前记录的时间
+    uint64_t seq;
+    int64_t date_sec;                   // date 缓存对应的秒
+    char date[32];
+};
+
+static const size_t s_record_header_size = sizeof(struct capture_record_header);
+
+static inline const uint8_t *reprocess_record(const uint8_t *p, struct capture_record_header *hdr){
+    std::memcpy(hdr, p, s_record_header_size);
+    return p + s_record_header_size;
+}
+
+static void reprocess_line_start(reprocess_line *line){
+    if(line->started)
+        return ;
+    line->started = true;
+    line->time_us = line->record_us;
+}
+
+static void reprocess_line_emit(reprocess_line *line){
+    reprocess_chunk *chunk = line->chunk;
+    const reprocess_context *ctx = chunk->ctx;
+    const std::string &text = line->text;
+    uint64_t seq = line->seq++;
+    bool keep = ctx->filters.empty();
+    for(size_t i = 0; i < ctx->filters.size() && !keep; i++)
+        keep = std::string_view(text).find(ctx->filters[i]) != std::string_view::npos;
+    if(keep){
+        char annotation[REPROCESS_ANNOTATION_SIZE];
+        size_t annotation_len = ctx->opt.symbolize ? symbolizer_annotate(text.data(), text.size(), annotation, sizeof(annotation)) : 0;
+        std::string &out = chunk->out;
+        if(ctx->opt.jsonl){
+            struct log_jsonl_record rec = {};
+            rec.seq = seq;
+            rec.host_us = line->time_us;
+            rec.channel = ctx->opt.channel;
+            rec.session = chunk->file->session.c_str();
+            rec.text = text.data();
+            rec.text_len = text.size();
+            rec.note = annotation_len ? annotation : nullptr;
+            rec.note_len = annotation_len;
+            if(!log_jsonl_target_ts(text.data(), text.size(), &rec.target_ts, &rec.target_ts_len))
+                rec.target_ts = nullptr;
+            size_t pos = out.size();
+            out.resize(pos + log_jsonl_bound(&rec));
+            out.resize(pos + log_jsonl_format(&out[pos], &rec));
+        }else{
+            /* 与终端日志相同的 "[时间]>>>  " 前缀，日期部分按秒缓存 */
+            int64_t sec = int64_t(line->time_us / 1000000);
+            if(sec != line->date_sec){
+                std::time_t tt = std::time_t(sec);
+                std::tm bt;
+#if defined(_MSC_VER)
+                localtime_s(&bt, &tt);
+#else
+                localtime_r(&tt, &bt);
+#endif
+                std::strftime(line->date, sizeof(line->date), "[%Y-%m-%d %H:%M:%S", &bt);
+                line->date_sec = sec;
+            }
+            char ms[8];
+            std::snprintf(ms, sizeof(ms), ".%03u]", unsigned(line->time_us / 1000 % 1000));
+            out.append(line->date).append(ms).append(">>>  ").append(text).append(annotation, annotation_len).append("\n");
+        }
+    }
+    line->text.clear();
+    line->pos = 0;
+    line->started = false;
+}
+
+static void reprocess_print(void *ctx, const char *data, size_t len){
+    reprocess_line *line = static_cast<reprocess_line*>(ctx);
+    reprocess_line_start(line);
+    size_t overwrite = std::min(len, line->text.size() - line->pos);
+    line->text.replace(line->pos, overwrite, data, len);
+    line->pos += len;
+}
+
+static void reprocess_execute(void *ctx, uint8_t c){
+    reprocess_line *line = static_cast<reprocess_line*>(ctx);
+    switch (c) {
+        case ASCII_BACKSPACE:
+            if(line->pos > 0){
+                line->text.erase(line->pos - 1, 1);
+                line->pos--;
+            }
+            break;
+        case ASCII_TAB:
+            reprocess_line_start(line);
+            break;
+        case ASCII_LF:
+            reprocess_line_start(line);
+            reprocess_line_emit(line);
+            break;
+        case ASCII_CR:
+            line->pos = 0;
+            break;
+        case ASCII_DEL_LINE:
+            line->text.clear();
+            line->pos = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+static void reprocess_csi(void *ctx, const struct vt_sequence *seq){
+    reprocess_line *line = static_cast<reprocess_line*>(ctx);
+    if(seq->private_marker || seq->intermediate_num || seq->param_num)
+        return ;
+    if(seq->final == 'C' && line->pos < line->text.size())
+        line->pos++;
+    if(seq->final == 'D' && line->pos > 0)
+        line->pos--;
+}
+
+static const struct vt_parser_callbacks s_vt_callbacks = {
+    reprocess_print,
+    reprocess_execute,
+    nullptr,
+    reprocess_csi,
+    nullptr,
+};
+
+/**
+ * @brief                   统计在分块内开始的行数：分块开始时位于行首算一行，之后每个换行之后的数据算一行，
+ *                          最后一个换行之后的行从下一个分块开始时由下一个分块计数
+ */
+static void reprocess_count_task(void *arg){
+    reprocess_chunk *chunk = static_cast<reprocess_chunk*>(arg);
+    int channel = chunk->ctx->opt.channel;
+    uint64_t lf = 0;
+    for(const uint8_t *p = chunk->begin; p < chunk->end; ){
+        struct capture_record_header hdr;
+        const uint8_t *data = reprocess_record(p, &hdr);
+        p = data + hdr.len;
+        if(hdr.channel != channel)
+            continue;
+        for(const uint8_t *q = data; (q = static_cast<const uint8_t*>(std::memchr(q, '\n', size_t(p - q)))) != nullptr; q++)
+            lf++;
+    }
+    chunk->lines = (chunk->line_start ? 1 : 0) + lf;
+}
+
+static void reprocess_chunk_task(void *arg){
+    reprocess_chunk *chunk = static_cast<reprocess_chunk*>(arg);
+    reprocess_context *ctx = chunk->ctx;
+    int channel = ctx->opt.channel;
+    reprocess_line line = {};
+    line.chunk = chunk;
+    line.seq = chunk->seq;
+    line.date_sec = -1;
+    vt_parser_t *vt = vt_parser_create(&s_vt_callbacks, &line);
+    bool skipping = !chunk->line_start;
+    bool line_end = chunk->line_start;          // 最后处理的文本字节是换行
+    const uint8_t *p = chunk->begin;
+
+    for(; p < chunk->end; ){
+        struct capture_record_header hdr;
+        const uint8_t *data = reprocess_record(p, &hdr);
+        p = data + hdr.len;
+        if(hdr.channel != channel || hdr.len == 0)
+            continue;
+        const char *text = reinterpret_cast<const char*>(data);
+        size_t len = hdr.len;
+        line.record_us = hdr.timestamp_us;
+        if(skipping){
+            const char *lf = static_cast<const char*>(std::memchr(text, '\n', len));
+            if(!lf)
+                continue;
+            len -= size_t(lf + 1 - text);
+            text = lf + 1;
+            skipping = false;
+            line_end = true;
+            if(len == 0)
+                continue;
+        }
+        vt_parser_feed(vt, text, len);
+        line_end = text[len - 1] == '\n';
+    }
+
+    /* 分块内没有行开始，或者最后一行已经结束 */
+    if(!skipping && !line_end){
+        for(; p < chunk->file->end; ){
+            struct capture_record_header hdr;
+            const uint8_t *data = reprocess_record(p, &hdr);
+            p = data + hdr.len;
+            if(hdr.channel != channel || hdr.len == 0)
+                continue;
+            const char *text = reinterpret_cast<const char*>(data);
+            const char *lf = static_cast<const char*>(std::memchr(text, '\n', hdr.len));
+            line.record_us = hdr.timestamp_us;
+            vt_parser_feed(vt, text, lf ? size_t(lf + 1 - text) : hdr.len);
+            if(lf)
+                break;
+        }
+        /* 文件结尾没有换行的最后一行 */
+        if(p >= chunk->file->end && line.started)
+            reprocess_line_emit(&line);
+    }
+    vt_parser_destroy(vt);
+
+    std::lock_guard<std::mutex> lck(ctx->mtx);
+    chunk->done = true;
+    ctx->cv.notify_all();
+}
+
+/**
+ * @brief                   检查文件头，按记录边界切分为约 chunk_size 的分块，并记录每个分块开始时是否位于行首
+ */
+static int reprocess_split(reprocess_context *ctx, reprocess_file *file, std::vector<reprocess_chunk> &chunks){
+    const uint8_t *data = mapped_file_data(file->mf);
+    size_t size = mapped_file_size(file->mf);
+    struct capture_file_header file_hdr;
+    if(size < sizeof(file_hdr)){
+        std::printf("%s: not a capture file\n", file->path.c_str());
+        return -1;
+    }
+    std::memcpy(&file_hdr, data, sizeof(file_hdr));
+    if(std::memcmp(file_hdr.magic, CAPTURE_FILE_MAGIC, CAPTURE_FILE_MAGIC_SIZE) != 0 || file_hdr.version != CAPTURE_FILE_VERSION){
+        std::printf("%s: not a capture file\n", file->path.c_str());
+        return -1;
+    }
+
+    const uint8_t *end = data + size;
+    const uint8_t *p = data + sizeof(file_hdr);
+    const uint8_t *chunk_begin = p;
+    size_t chunk_size = ctx->opt.chunk_size ? ctx->opt.chunk_size : REPROCESS_CHUNK_SIZE_DEFAULT;
+    size_t acc = 0;
+    bool line_start = true;
+    bool line_end = true;
+    while(size_t(end - p) >= s_record_header_size){
+        struct capture_record_header hdr;
+        const uint8_t *record = reprocess_record(p, &hdr);
+        if(size_t(end - record) < hdr.len)
+            break;
+        if(acc >= chunk_size){
+            chunks.push_back(reprocess_chunk{ctx, file, chunk_begin, p, line_start, 0, 0, std::string(), false});
+            chunk_begin = p;
+            line_start = line_end;
+            acc = 0;
+        }
+        if(hdr.channel == ctx->opt.channel && hdr.len)
+            line_end = record[hdr.len - 1] == '\n';
+        acc += s_record_header_size + hdr.len;
+        p = record + hdr.len;
+    }
+    if(p < end)
+        std::printf("%s: truncated record at offset %zu\n", file->path.c_str(), size_t(p - data));
+    file->end = p;
+    if(p > chunk_begin)
+        chunks.push_back(reprocess_chunk{ctx, file, chunk_begin, p, line_start, 0, 0, std::string(), false});
+    return 0;
+}
+
+extern "C"{
+
+int reprocess_run(const char *const *paths, size_t num, const char *out_path, const struct reprocess_options *opt){
+    reprocess_context ctx;
+    std::vector<reprocess_file> files(num);
+    std::vector<size_t> file_first_chunk;
+    std::FILE *out = stdout;
+    uint64_t bytes = 0;
+    int ret = 0;
+
+    ctx.opt = *opt;
+    for(size_t i = 0; i < opt->filter_num; i++)
+        ctx.filters.emplace_back(opt->filters[i]);
+    for(size_t i = 0; i < num; i++){
+        files[i].path = paths[i];
+        files[i].session = std::filesystem::path(paths[i]).filename().string();
+        files[i].mf = mapped_file_open(paths[i]);
+        if(!files[i].mf){
+            std::printf("open %s failed\n", paths[i]);
+            ret = -1;
+            goto close;
+        }
+        file_first_chunk.push_back(ctx.chunks.size());
+        if(reprocess_split(&ctx, &files[i], ctx.chunks) < 0){
+            ret = -1;
+            goto close;
+        }
+        bytes += mapped_file_size(files[i].mf);
+    }
+    if(out_path){
+        out = std::fopen(out_path, "wb");
+        if(!out){
+            std::printf("open %s failed\n", out_path);
+            ret = -1;
+            goto close;
+        }
+    }
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        work_pool_t *pool = work_pool_create(opt->jobs);
+        size_t window = size_t(work_pool_threads(pool)) * REPROCESS_WINDOW_PER_THREAD;
+
+        /* JSON 记录的序号在每个文件内连续，先并行统计各分块的行数 */
+        if(opt->jsonl){
+            for(auto &chunk : ctx.chunks)
+                work_pool_submit(pool, reprocess_count_task, &chunk);
+            work_pool_wait(pool);
+            uint64_t seq = 0;
+            for(size_t i = 0; i < ctx.chunks.size(); i++){
+                reprocess_chunk &chunk = ctx.chunks[i];
+                bool last = i + 1 == ctx.chunks.size() || ctx.chunks[i + 1].file != chunk.file;
+                if(i == 0 || ctx.chunks[i - 1].file != chunk.file)
+                    seq = 0;
+                chunk.seq = seq;
+                /* 分块最后一个换行之后的行由下一个分块计数 */
+                seq += chunk.lines - (!last && ctx.chunks[i + 1].line_start ? 1 : 0);
+            }
+        }
+
+        /* 写出位置之后最多 window 个分块在处理中，限制内存占用 */
+        size_t submitted = 0;
+        for(size_t i = 0; i < ctx.chunks.size(); i++){
+            for(; submitted < ctx.chunks.size() && submitted < i + window; submitted++)
+                work_pool_submit(pool, reprocess_chunk_task, &ctx.chunks[submitted]);
+            reprocess_chunk &chunk = ctx.chunks[i];
+            {
+                std::unique_lock<std::mutex> lck(ctx.mtx);
+                ctx.cv.wait(lck, [&chunk]{ return chunk.done; });
+            }
+            if(std::fwrite(chunk.out.data(), 1, chunk.out.size(), out) != chunk.out.size() && ret == 0){
+                std::printf("write output failed\n");
+                ret = -1;
+            }
+            std::string().swap(chunk.out);
+        }
+        int threads = work_pool_threads(pool);
+        work_pool_destroy(pool);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "reprocess: %zu files, %zu chunks, %.1f MB in %.2f s (%.1f MB/s, %d threads)\n", num,
+            ctx.chunks.size(), double(bytes) / 1e6, sec, sec > 0 ? double(bytes) / 1e6 / sec : 0.0, threads);
+    }
+
+close:
+    if(out && out != stdout)
+        std::fclose(out);
+    for(auto &file : files){
+        if(file.mf)
+            mapped_file_close(file.mf);
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,98 @@
+/**
+ * @file rtt_control_block.cpp
+ * @brief 通过内存读取直接访问目标上的 SEGGER RTT 控制块
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "jlink_api.h"
+#include "rtt_control_block.h"
+
+#define RTT_CB_SCAN_CHUNK_SIZE      0x1000
+
+static inline uint32_t get_le32(const uint8_t *p){
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static int rtt_cb_header_valid(const uint8_t *header, int *max_up, int *max_down){
+    if(std::memcmp(header, RTT_CB_ID, sizeof(RTT_CB_ID)) != 0)
+        return -1;
+    uint32_t up = get_le32(header + RTT_CB_ID_SIZE);
+    uint32_t down = get_le32(header + RTT_CB_ID_SIZE + 4);
+    if(up == 0 || up > RTT_CB_MAX_BUFFERS || down > RTT_CB_MAX_BUFFERS)
+        return -1;
+    if(max_up)
+        *max_up = int(up);
+    if(max_down)
+        *max_down = int(down);
+    return 0;
+}
+
+extern "C"{
+
+int rtt_cb_check(unsigned long addr, int *max_up, int *max_down){
+    uint8_t header[RTT_CB_HEADER_SIZE];
+    if(JLINK_ReadMemEx(uint32_t(addr), sizeof(header), header, 0) != int(sizeof(header)))
+        return -1;
+    return rtt_cb_header_valid(header, max_up, max_down);
+}
+
+int rtt_cb_scan(unsigned long addr, unsigned long range, unsigned long *cb_addr){
+    /* 每次多读一个头部长度，避免控制块跨越两次读取 */
+    std::vector<uint8_t> buf(RTT_CB_SCAN_CHUNK_SIZE + RTT_CB_HEADER_SIZE);
+    unsigned long end = addr + range;
+    for(unsigned long pos = addr; pos < end; pos += RTT_CB_SCAN_CHUNK_SIZE){
+        unsigned long len = std::min<unsigned long>(buf.size(), end - pos);
+        if(len < RTT_CB_HEADER_SIZE)
+            break;
+        if(JLINK_ReadMemEx(uint32_t(pos), uint32_t(len), buf.data(), 0) != int(len))
+            continue;
+        /* 控制块按4字节对齐 */
+        for(unsigned long off = 0; off + RTT_CB_HEADER_SIZE <= len; off += 4){
+            if(buf[off] != 'S')
+                continue;
+            if(rtt_cb_header_valid(buf.data() + off, nullptr, nullptr) == 0){
+                *cb_addr = pos + off;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+int rtt_cb_read_buffers(unsigned long cb_addr, int direction, struct rtt_cb_buffer *bufs, int max){
+    int max_up = 0;
+    int max_down = 0;
+    if(rtt_cb_check(cb_addr, &max_up, &max_down) < 0)
+        return -1;
+    std::vector<uint8_t> desc(size_t(max_up + max_down) * RTT_CB_BUFFER_DESC_SIZE);
+    if(JLINK_ReadMemEx(uint32_t(cb_addr + RTT_CB_HEADER_SIZE), uint32_t(desc.size()), desc.data(), 0) != int(desc.size()))
+        return -1;
+
+    int first = direction == RTT_DIRECTION_UP ? 0 : max_up;
+    int num = std::min(direction == RTT_DIRECTION_UP ? max_up : max_down, max);
+    for(int i = 0; i < num; i++){
+        const uint8_t *p = desc.data() + size_t(first + i) * RTT_CB_BUFFER_DESC_SIZE;
+        struct rtt_cb_buffer &buf = bufs[i];
+        uint32_t name_addr = get_le32(p);
+        buf.buffer = get_le32(p + 4);
+        buf.size = get_le32(p + 8);
+        buf.wr_off = get_le32(p + 12);
+        buf.rd_off = get_le32(p + 16);
+        buf.flags = get_le32(p + 20);
+        std::memset(buf.name, 0, sizeof(buf.name));
+        if(name_addr && JLINK_ReadMemEx(name_addr, sizeof(buf.name) - 1, buf.name, 0) != int(sizeof(buf.name) - 1))
+            buf.name[0] = '\0';
+    }
+    return num;
+}
+
+}
@@ -0,0 +1,180 @@
+/**
+ * @file rtt_dump.cpp
+ * @brief 事后提取：直接从目标内存读取 RTT 上行缓冲区中的全部数据，不依赖 J-Link RTT 功能
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+#include "jlink_api.h"
+#include "elf_file.h"
+#include "rtt_control_block.h"
+#include "terminal_display_record.h"
+#include "rtt_dump.h"
+
+#define RTT_DUMP_CHUNK_SIZE         0x10000
+#define RTT_DUMP_MAX_REGIONS        32
+#define RTT_DUMP_SYMBOL             "_SEGGER_RTT"
+
+static int read_target(uint32_t addr, uint8_t *data, uint32_t size){
+    for(uint32_t off = 0; off < size; off += RTT_DUMP_CHUNK_SIZE){
+        uint32_t len = std::min<uint32_t>(RTT_DUMP_CHUNK_SIZE, size - off);
+        if(JLINK_ReadMemEx(addr + off, len, data + off, 0) != int(len))
+            return -1;
+    }
+    return 0;
+}
+
+static void display_write(const std::string &str){
+    terminal_display_record_write(str.data(), str.size());
+}
+
+/**
+ * @brief                   把环形缓冲区按时间顺序拆为历史数据与未读数据
+ */
+static void ring_split(const std::vector<uint8_t> &ring, uint32_t wr_off, uint32_t rd_off,
+    std::string &history, std::string &unread){
+    const char *data = reinterpret_cast<const char*>(ring.data());
+    uint32_t size = uint32_t(ring.size());
+    if(rd_off <= wr_off){
+        history.assign(data + wr_off, size - wr_off);
+        history.append(data, rd_off);
+        unread.assign(data + rd_off, wr_off - rd_off);
+    }else{
+        history.assign(data + wr_off, rd_off - wr_off);
+        unread.assign(data + rd_off, size - rd_off);
+        unread.append(data, wr_off);
+    }
+    /* 缓冲区从未写满时，历史数据开头是未使用的0 */
+    size_t used = history.find_first_not_of('\0');
+    history.erase(0, used == std::string::npos ? history.size() : used);
+}
+
+extern "C"{
+
+int rtt_dump_locate(const char *elf_path, unsigned long cached_addr, unsigned long addr, unsigned long range, unsigned long *cb_addr){
+    elf_file_t *elf = elf_path ? elf_file_open(elf_path) : nullptr;
+    if(elf_path && !elf)
+        std::printf("dump-rtt: open elf %s failed\n", elf_path);
+    if(elf){
+        struct elf_symbol sym;
+        if(elf_file_find_symbol(elf, RTT_DUMP_SYMBOL, &sym) == 0 && rtt_cb_check(sym.addr, nullptr, nullptr) == 0){
+            *cb_addr = sym.addr;
+            elf_file_close(elf);
+            return 0;
+        }
+    }
+    if(cached_addr && rtt_cb_check(cached_addr, nullptr, nullptr) == 0){
+        *cb_addr = cached_addr;
+        elf_file_close(elf);
+        return 0;
+    }
+    if(addr && !range && rtt_cb_check(addr, nullptr, nullptr) == 0){
+        *cb_addr = addr;
+        elf_file_close(elf);
+        return 0;
+    }
+    if(addr && range && rtt_cb_scan(addr, range, cb_addr) == 0){
+        elf_file_close(elf);
+        return 0;
+    }
+    if(elf){
+        struct elf_region regions[RTT_DUMP_MAX_REGIONS];
+        int num = elf_file_ram_regions(elf, regions, RTT_DUMP_MAX_REGIONS);
+        elf_file_close(elf);
+        for(int i = 0; i < num; i++){
+            if(rtt_cb_scan(regions[i].addr, regions[i].size, cb_addr) == 0)
+                return 0;
+        }
+    }
+    return -1;
+}
+
+int rtt_dump(unsigned long cb_addr, int shell_channel, const char *out_dir, int halt){
+    struct rtt_cb_buffer bufs[RTT_CB_MAX_BUFFERS];
+    std::vector<std::vector<uint8_t>> rings;
+    bool halted_by_us = false;
+    int ret = 0;
+
+    if(halt && JLINK_IsHalted() <= 0){
+        if(JLINK_Halt() != 0){
+            std::printf("dump-rtt: halt failed\n");
+            return -1;
+        }
+        halted_by_us = true;
+    }
+    /* 先读取全部描述与缓冲区再恢复运行，文件写入放在之后 */
+    int num = rtt_cb_read_buffers(cb_addr, RTT_DIRECTION_UP, bufs, RTT_CB_MAX_BUFFERS);
+    for(int i = 0; i < num; i++){
+        rings.emplace_back(bufs[i].size);
+        if(bufs[i].size && read_target(bufs[i].buffer, rings.back().data(), bufs[i].size) < 0){
+            std::printf("dump-rtt: read up buffer %d at %#x failed\n", i, bufs[i].buffer);
+            rings.back().clear();
+        }
+    }
+    if(halted_by_us)
+        JLINK_Go();
+    if(num < 0){
+        std::printf("dump-rtt: read control block at %#lx failed\n", cb_addr);
+        return -1;
+    }
+
+    char stamp[32];
+    std::time_t tt = std::time(nullptr);
+    std::tm bt;
+#if defined(_MSC_VER)
+    localtime_s(&bt, &tt);
+#else
+    localtime_r(&tt, &bt);
+#endif
+    std::strftime(stamp, sizeof(stamp), "rtt-dump-%Y%m%d-%H%M%S", &bt);
+
+    std::printf("dump-rtt: control block at %#lx, %d up buffers\n", cb_addr, num);
+    for(int i = 0; i < num; i++){
+        const struct rtt_cb_buffer &buf = bufs[i];
+        if(rings[size_t(i)].empty())
+            continue;
+        if(buf.wr_off >= buf.size || buf.rd_off >= buf.size){
+            std::printf("dump-rtt: up buffer %d has invalid offsets (size %u, wr %u, rd %u)\n", i, buf.size, buf.wr_off, buf.rd_off);
+            ret = -1;
+            continue;
+        }
+        std::string history;
+        std::string unread;
+        ring_split(rings[size_t(i)], buf.wr_off, buf.rd_off, history, unread);
+        std::printf("dump-rtt: up[%d] \"%s\" size %u, %zu bytes history, %zu bytes unread\n", 
+            i, buf.name, buf.size, history.size(), unread.size());
+
+        std::string path = (std::filesystem::path(out_dir ? out_dir : ".") / 
+            (std::string(stamp) + "-up" + std::to_string(i) + ".bin")).string();
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(history.data(), std::streamsize(history.size()));
+        file.write(unread.data(), std::streamsize(unread.size()));
+        if(!file.good()){
+            std::printf("dump-rtt: write %s failed\n", path.c_str());
+            ret = -1;
+        }
+
+        if(i != shell_channel)
+            continue;
+        display_write("\n---- rtt up[" + std::to_string(i) + "] history ----\n");
+        display_write(history);
+        display_write("\n---- rtt up[" + std::to_string(i) + "] unread ----\n");
+        display_write(unread);
+        display_write("\n---- end ----\n");
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,416 @@
+/**
+ * @file scrollback.cpp
+ * @brief 会话内的行历史：行记录先写入未压缩的块，满 SCROLLBACK_BLOCK_SIZE 后用 LZ77 压缩(LZ4 块格式)，
+ *        超过内存预算时丢弃最早的块；读取和搜索时解压所在的块，最近解压的一个块保留在缓存中
+ *        子串搜索用 SSE2 每次比较 16 个位置的首尾字节，两者都相同的位置再完整比较
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCROLLBACK_USE_SSE2 1
+#endif
+
+#if defined(SCROLLBACK_USE_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "scrollback.h"
+
+#define SCROLLBACK_RECORD_HEADER_SIZE   12          // uint64_t 时间 + uint32_t 长度
+#define SCROLLBACK_HASH_BITS            12
+#define SCROLLBACK_MIN_MATCH            4
+#define SCROLLBACK_MAX_OFFSET           0xFFFF
+#define SCROLLBACK_NO_CACHE             UINT64_MAX
+
+struct scrollback_block{
+    uint64_t first;                     // 第一行的序号
+    uint32_t lines;
+    uint32_t raw_size;
+    std::vector<uint8_t> data;          // 压缩后的行记录
+};
+
+/* 一个块中连续的行记录，offsets 为每条记录的起始位置 */
+struct scrollback_view{
+    const char *data;
+    size_t size;
+    const uint32_t *offsets;
+    uint64_t first;
+    uint32_t lines;
+};
+
+struct scrollback{
+    size_t budget;
+    size_t memory;                      // 压缩块占用的内存
+    std::deque<scrollback_block> blocks;
+    std::string open;                   // 正在写入的块
+    std::vector<uint32_t> open_offsets;
+    uint64_t open_first;
+    uint64_t cache_first;               // 缓存中的块，SCROLLBACK_NO_CACHE 为没有
+    std::string cache;
+    std::vector<uint32_t> cache_offsets;
+    std::vector<uint32_t> table;        // 压缩用的散列表，重复使用
+    std::vector<uint8_t> packed;        // 压缩输出，重复使用
+    std::vector<uint8_t> spare;         // 最近丢弃的块的存储，大小合适时给新块使用
+};
+
+static inline uint32_t scrollback_read32(const uint8_t *p){
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void scrollback_put_len(std::vector<uint8_t> &out, size_t len){
+    for(; len >= 255; len -= 255)
+        out.push_back(255);
+    out.push_back(uint8_t(len));
+}
+
+static void scrollback_put_sequence(std::vector<uint8_t> &out, const uint8_t *literal, size_t literal_len, size_t offset, size_t match_len){
+    size_t match_code = match_len ? match_len - SCROLLBACK_MIN_MATCH : 0;
+    out.push_back(uint8_t((std::min<size_t>(literal_len, 15) << 4) | std::min<size_t>(match_code, 15)));
+    if(literal_len >= 15)
+        scrollback_put_len(out, literal_len - 15);
+    out.insert(out.end(), literal, literal + literal_len);
+    if(!match_len)
+        return ;
+    out.push_back(uint8_t(offset));
+    out.push_back(uint8_t(offset >> 8));
+    if(match_code >= 15)
+        scrollback_put_len(out, match_code - 15);
+}
+
+/**
+ * @brief                   LZ77 压缩：每个位置的前 4 字节散列到最近出现的位置，相同则向后扩展匹配
+ *                          输出为 LZ4 块格式，最后一个序列只有字面量
+ */
+static void scrollback_compress(const uint8_t *src, size_t len, std::vector<uint32_t> &table, std::vector<uint8_t> &out){
+    table.assign(size_t(1) << SCROLLBACK_HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t i = 0;
+    out.clear();
+    out.reserve(len / 2 + 16);
+    while(i + SCROLLBACK_MIN_MATCH <= len){
+        uint32_t seq = scrollback_read32(src + i);
+        uint32_t hash = (seq * 2654435761u) >> (32 - SCROLLBACK_HASH_BITS);
+        size_t ref = table[hash];
+        table[hash] = uint32_t(i);
+        if(ref >= i || i - ref > SCROLLBACK_MAX_OFFSET || scrollback_read32(src + ref) != seq){
+            i++;
+            continue;
+        }
+        size_t match_len = SCROLLBACK_MIN_MATCH;
+        while(i + match_len < len && src[ref + match_len] == src[i + match_len])
+            match_len++;
+        scrollback_put_sequence(out, src + anchor, i - anchor, i - ref, match_len);
+        i += match_len;
+        anchor = i;
+    }
+    scrollback_put_sequence(out, src + anchor, len - anchor, 0, 0);
+}
+
+static size_t scrollback_get_len(const uint8_t *&p, const uint8_t *end){
+    size_t len = 0;
+    while(p < end){
+        uint8_t c = *p++;
+        len += c;
+        if(c != 255)
+            break;
+    }
+    return len;
+}
+
+static void scrollback_decompress(const uint8_t *p, size_t len, std::string &out){
+    const uint8_t *end = p + len;
+    out.clear();
+    while(p < end){
+        uint8_t token = *p++;
+        size_t literal_len = token >> 4;
+        if(literal_len == 15)
+            literal_len += scrollback_get_len(p, end);
+        literal_len = std::min(literal_len, size_t(end - p));
+        out.append(reinterpret_cast<const char*>(p), literal_len);
+        p += literal_len;
+        if(end - p < 2)
+            break;
+        size_t offset = size_t(p[0]) | size_t(p[1]) << 8;
+        p += 2;
+        size_t match_len = (token & 15u);
+        if(match_len == 15)
+            match_len += scrollback_get_len(p, end);
+        match_len += SCROLLBACK_MIN_MATCH;
+        if(offset == 0 || offset > out.size())
+            break;
+        /* 匹配可能与输出重叠，逐字节复制 */
+        size_t from = out.size() - offset;
+        for(size_t k = 0; k < match_len; k++)
+            out.push_back(out[from + k]);
+    }
+}
+
+static inline uint32_t scrollback_record_len(const char *record){
+    uint32_t len;
+    std::memcpy(&len, record + sizeof(uint64_t), sizeof(len));
+    return len;
+}
+
+static inline size_t scrollback_line_end(const scrollback_view *view, size_t k){
+    return k + 1 < view->lines ? view->offsets[k + 1] : view->size;
+}
+
+static size_t scrollback_memory_total(const scrollback_t *sb){
+    return sb->memory + sb->open.capacity() + sb->open_offsets.capacity() * sizeof(uint32_t);
+}
+
+static void scrollback_seal(scrollback_t *sb){
+    if(sb->open_offsets.empty())
+        return ;
+    scrollback_block block;
+    block.first = sb->open_first;
+    block.lines = uint32_t(sb->open_offsets.size());
+    block.raw_size = uint32_t(sb->open.size());
+    scrollback_compress(reinterpret_cast<const uint8_t*>(sb->open.data()), sb->open.size(), sb->table, sb->packed);
+    /* 压缩率稳定时丢弃的块能装下新块，内存预算用满后基本不再分配 */
+    size_t packed_size = sb->packed.size();
+    if(sb->spare.capacity() >= packed_size && sb->spare.capacity() <= packed_size + packed_size / 2)
+        block.data.swap(sb->spare);
+    block.data.assign(sb->packed.begin(), sb->packed.end());
+    sb->memory += block.data.capacity();
+    sb->blocks.push_back(std::move(block));
+    sb->open_first += sb->open_offsets.size();
+    sb->open_offsets.clear();
+    /* 超长的行使块变大，不保留多出的容量 */
+    if(sb->open.capacity() > 2 * SCROLLBACK_BLOCK_SIZE){
+        std::string().swap(sb->open);
+        sb->open.reserve(SCROLLBACK_BLOCK_SIZE + SCROLLBACK_RECORD_HEADER_SIZE);
+    }
+    sb->open.clear();
+    while(!sb->blocks.empty() && scrollback_memory_total(sb) > sb->budget){
+        if(sb->cache_first == sb->blocks.front().first)
+            sb->cache_first = SCROLLBACK_NO_CACHE;
+        sb->memory -= sb->blocks.front().data.capacity();
+        sb->spare = std::move(sb->blocks.front().data);
+        sb->blocks.pop_front();
+    }
+}
+
+/**
+ * @brief                   第 block 个块的行记录，block 为块数时是正在写入的块
+ */
+static void scrollback_view_block(scrollback_t *sb, size_t block, scrollback_view *view){
+    if(block >= sb->blocks.size()){
+        view->data = sb->open.data();
+        view->size = sb->open.size();
+        view->offsets = sb->open_offsets.data();
+        view->first = sb->open_first;
+        view->lines = uint32_t(sb->open_offsets.size());
+        return ;
+    }
+    const scrollback_block &b = sb->blocks[block];
+    if(sb->cache_first != b.first){
+        sb->cache.reserve(b.raw_size);
+        scrollback_decompress(b.data.data(), b.data.size(), sb->cache);
+        sb->cache_offsets.clear();
+        for(size_t pos = 0; pos + SCROLLBACK_RECORD_HEADER_SIZE <= sb->cache.size() && sb->cache_offsets.size() < b.lines; ){
+            sb->cache_offsets.push_back(uint32_t(pos));
+            pos += SCROLLBACK_RECORD_HEADER_SIZE + scrollback_record_len(sb->cache.data() + pos);
+        }
+        sb->cache_first = b.first;
+    }
+    view->data = sb->cache.data();
+    view->size = sb->cache.size();
+    view->offsets = sb->cache_offsets.data();
+    view->first = b.first;
+    view->lines = uint32_t(sb->cache_offsets.size());
+}
+
+/**
+ * @brief                   包含第 index 行的块，正在写入的块返回块数
+ */
+static size_t scrollback_block_of(const scrollback_t *sb, uint64_t index){
+    if(index >= sb->open_first)
+        return sb->blocks.size();
+    auto it = std::upper_bound(sb->blocks.begin(), sb->blocks.end(), index,
+        [](uint64_t value, const scrollback_block &b){ return value < b.first; });
+    return size_t(it - sb->blocks.begin()) - 1;
+}
+
+/**
+ * @brief                   匹配位置完整地位于某一行的内容中时返回该行在块内的序号，否则返回 -1
+ */
+static int64_t scrollback_match_line(const scrollback_view *view, size_t pos, size_t pattern_len){
+    size_t k = size_t(std::upper_bound(view->offsets, view->offsets + view->lines, uint32_t(pos)) - view->offsets) - 1;
+    size_t text = view->offsets[k] + SCROLLBACK_RECORD_HEADER_SIZE;
+    if(pos < text || pos + pattern_len > scrollback_line_end(view, k))
+        return -1;
+    return int64_t(k);
+}
+
+#ifdef SCROLLBACK_USE_SSE2
+static inline unsigned scrollback_ctz(unsigned mask){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+extern "C"{
+
+const char *scrollback_find(const char *data, size_t len, const char *pattern, size_t pattern_len){
+    if(pattern_len == 0 || len < pattern_len)
+        return nullptr;
+    if(pattern_len == 1)
+        return static_cast<const char*>(std::memchr(data, pattern[0], len));
+    size_t i = 0;
+#ifdef SCROLLBACK_USE_SSE2
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[pattern_len - 1]);
+    for(; i + pattern_len - 1 + 16 <= len; i += 16){
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + pattern_len - 1));
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+        while(mask){
+            unsigned bit = scrollback_ctz(mask);
+            if(std::memcmp(data + i + bit + 1, pattern + 1, pattern_len - 2) == 0)
+                return data + i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for(; i + pattern_len <= len; i++){
+        if(data[i] == pattern[0] && std::memcmp(data + i, pattern, pattern_len) == 0)
+            return data + i;
+    }
+    return nullptr;
+}
+
+scrollback_t *scrollback_create(size_t budget){
+    scrollback_t *sb = new scrollback_t;
+    /* 至少能容纳正在写入的块和一个压缩块 */
+    sb->budget = std::max<size_t>(budget ? budget : SCROLLBACK_BUDGET_DEFAULT, 2 * SCROLLBACK_BLOCK_SIZE);
+    sb->memory = 0;
+    sb->open.reserve(SCROLLBACK_BLOCK_SIZE + SCROLLBACK_RECORD_HEADER_SIZE);
+    sb->open_first = 0;
+    sb->cache_first = SCROLLBACK_NO_CACHE;
+    return sb;
+}
+
+void scrollback_destroy(scrollback_t *sb){
+    delete sb;
+}
+
+void scrollback_append(scrollback_t *sb, const char *line, size_t len, uint64_t time_us){
+    char header[SCROLLBACK_RECORD_HEADER_SIZE];
+    uint32_t len32 = uint32_t(std::min<size_t>(len, UINT32_MAX - SCROLLBACK_RECORD_HEADER_SIZE));
+    std::memcpy(header, &time_us, sizeof(time_us));
+    std::memcpy(header + sizeof(time_us), &len32, sizeof(len32));
+    /* 放不下时先封块，块缓冲区不扩容 */
+    if(!sb->open.empty() && sb->open.size() + sizeof(header) + len32 > sb->open.capacity())
+        scrollback_seal(sb);
+    sb->open_offsets.push_back(uint32_t(sb->open.size()));
+    sb->open.append(header, sizeof(header)).append(line, len32);
+    if(sb->open.size() >= SCROLLBACK_BLOCK_SIZE)
+        scrollback_seal(sb);
+}
+
+uint64_t scrollback_first(const scrollback_t *sb){
+    return sb->blocks.empty() ? sb->open_first : sb->blocks.front().first;
+}
+
+uint64_t scrollback_end(const scrollback_t *sb){
+    return sb->open_first + sb->open_offsets.size();
+}
+
+int scrollback_get(scrollback_t *sb, uint64_t index, const char **line, size_t *len, uint64_t *time_us){
+    if(index < scrollback_first(sb) || index >= scrollback_end(sb))
+        return -1;
+    scrollback_view view;
+    scrollback_view_block(sb, scrollback_block_of(sb, index), &view);
+    size_t k = size_t(index - view.first);
+    if(k >= view.lines)
+        return -1;
+    const char *record = view.data + view.offsets[k];
+    if(time_us)
+        std::memcpy(time_us, record, sizeof(*time_us));
+    *line = record + SCROLLBACK_RECORD_HEADER_SIZE;
+    *len = scrollback_line_end(&view, k) - view.offsets[k] - SCROLLBACK_RECORD_HEADER_SIZE;
+    return 0;
+}
+
+int64_t scrollback_search(scrollback_t *sb, const char *pattern, size_t pattern_len, uint64_t from, int backward){
+    uint64_t first = scrollback_first(sb);
+    uint64_t end = scrollback_end(sb);
+    if(pattern_len == 0 || first == end)
+        return -1;
+    if(backward){
+        if(from < first)
+            return -1;
+        from = std::min(from, end - 1);
+    }else{
+        from = std::max(from, first);
+        if(from >= end)
+            return -1;
+    }
+
+    /* 块内的记录连续存放，整块查找后检查匹配是否位于一行的内容中 */
+    for(size_t block = scrollback_block_of(sb, from); block <= sb->blocks.size(); ){
+        scrollback_view view;
+        scrollback_view_block(sb, block, &view);
+        if(view.lines){
+            size_t begin = 0;
+            size_t limit = view.size;
+            if(!backward && from > view.first)
+                begin = view.offsets[from - view.first];
+            if(backward && from < view.first + view.lines - 1)
+                limit = scrollback_line_end(&view, size_t(from - view.first));
+            int64_t found = -1;
+            for(size_t pos = begin; pos < limit; ){
+                const char *hit = scrollback_find(view.data + pos, limit - pos, pattern, pattern_len);
+                if(!hit)
+                    break;
+                pos = size_t(hit - view.data);
+                int64_t k = scrollback_match_line(&view, pos, pattern_len);
+                if(k >= 0){
+                    found = k;
+                    if(!backward)
+                        break;
+                    /* 向前搜索取块内最后一个匹配，同一行的其它匹配跳过 */
+                    pos = scrollback_line_end(&view, size_t(k));
+                    continue;
+                }
+                pos++;
+            }
+            if(found >= 0)
+                return int64_t(view.first) + found;
+        }
+        if(backward){
+            if(block == 0)
+                break;
+            block--;
+        }else{
+            block++;
+        }
+    }
+    return -1;
+}
+
+size_t scrollback_memory(const scrollback_t *sb){
+    return scrollback_memory_total(sb);
+}
+
+}
@@ -0,0 +1,342 @@
+/**
+ * @file split_view.cpp
+ * @brief 分屏显示：每个窗格是一个固定位置的虚拟屏幕，接收的数据先暂存，渲染线程按帧时钟解析并只输出变化的单元格
+ *        每帧每个窗格最多解析 SPLIT_VIEW_FEED_MAX 字节，积压过多时丢弃最早的数据，数据量大的窗格不会拖慢其它窗格的显示
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+
+#include "jlink_api.h"
+#include "jlink_rtt.h"
+#include "vscreen.h"
+#include "split_view.h"
+
+#define SPLIT_VIEW_FPS_DEFAULT          30
+#define SPLIT_VIEW_FEED_MAX             (256 * 1024)        // 每帧每个窗格最多解析的数据量
+#define SPLIT_VIEW_BACKLOG_MAX          (4 * 1024 * 1024)   // 窗格积压超过该值时丢弃最早的一半
+#define SPLIT_VIEW_STATUS_MS            1000                // 状态栏速率的统计周期
+
+struct split_view_pane_state{
+    int up_channel;
+    int down_channel;
+    std::string name;
+    std::string pending;                // 还没有解析的数据，受 s_mtx 保护
+    std::string feed;                   // 本帧要解析的数据
+    uint64_t bytes;                     // 统计周期内收到的字节数，受 s_mtx 保护
+    uint64_t skipped;                   // 积压过多丢弃的字节数，受 s_mtx 保护
+    double rate;                        // 上一个统计周期的速率(字节/秒)
+    vscreen_t *vs;
+    int row;                            // 窗格第一行(从1开始)，状态栏在窗格之下
+    int rows;
+    std::string status;                 // 已显示的状态栏，内容不变时不重绘
+};
+
+static std::vector<split_view_pane_state> s_panes;
+static std::mutex s_mtx;                // 保护积压数据、焦点和请求
+static std::mutex s_render_mtx;         // 渲染一帧期间持有，暂停时等待正在输出的一帧完成
+static std::condition_variable s_cv;
+static std::thread *s_thread = nullptr;
+static bool s_req_stop = false;
+static bool s_paused = false;
+static bool s_redraw = false;
+static bool s_resize = false;
+static bool s_update = false;           // 没有新数据也需要渲染一帧(焦点改变)
+static int s_rows = 0;
+static int s_cols = 0;
+static size_t s_focus = 0;
+static std::chrono::steady_clock::duration s_frame_interval;
+static std::string s_out;
+
+/**
+ * @brief                   暂存窗格数据，调用时持有 s_mtx
+ */
+static void split_view_queue(split_view_pane_state &pane, const char *data, size_t len){
+    pane.pending.append(data, len);
+    pane.bytes += len;
+    if(pane.pending.size() > SPLIT_VIEW_BACKLOG_MAX){
+        /* 窗格只能显示最后几屏，积压的旧数据从行首开始丢弃 */
+        size_t lf = pane.pending.find('\n', pane.pending.size() - SPLIT_VIEW_BACKLOG_MAX / 2);
+        size_t drop = lf == std::string::npos ? pane.pending.size() : lf + 1;
+        pane.pending.erase(0, drop);
+        pane.skipped += drop;
+    }
+    s_cv.notify_one();
+}
+
+static void split_view_rx_handler(int channel, const char *data, size_t len){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    for(size_t i = 1; i < s_panes.size(); i++){
+        if(s_panes[i].up_channel == channel){
+            split_view_queue(s_panes[i], data, len);
+            return;
+        }
+    }
+}
+
+static bool split_view_pending(void){
+    for(auto &pane : s_panes){
+        if(!pane.pending.empty())
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief                   从上到下平分终端，每个窗格之下一行状态栏，余下的行分给前面的窗格
+ */
+static void split_view_layout(void){
+    int num = int(s_panes.size());
+    int avail = std::max(s_rows - num, num);
+    int row = 1;
+    for(int i = 0; i < num; i++){
+        split_view_pane_state &pane = s_panes[size_t(i)];
+        pane.row = row;
+        pane.rows = avail / num + (i < avail % num ? 1 : 0);
+        vscreen_resize(pane.vs, pane.rows, s_cols);
+        vscreen_set_origin(pane.vs, pane.row, 1);
+        row += pane.rows + 1;
+    }
+}
+
+static void split_view_size_str(char *buf, size_t size, double bytes){
+    if(bytes >= 1024.0 * 1024.0)
+        std::snprintf(buf, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    else if(bytes >= 1024.0)
+        std::snprintf(buf, size, "%.1f KB", bytes / 1024.0);
+    else
+        std::snprintf(buf, size, "%.0f B", bytes);
+}
+
+/**
+ * @brief                   状态栏：焦点标记、通道号和名字、速率、只读和丢弃提示，反色显示并填满一行
+ */
+static std::string split_view_status(const split_view_pane_state &pane, bool focused){
+    char rate[32];
+    char skipped[32];
+    char text[192];
+    split_view_size_str(rate, sizeof(rate), pane.rate);
+    split_view_size_str(skipped, sizeof(skipped), double(pane.skipped));
+    int n = std::snprintf(text, sizeof(text), "%c ch %d%s%s  %s/s%s", focused ? '*' : ' ', pane.up_channel,
+        pane.name.empty() ? "" : " ", pane.name.c_str(), rate, pane.down_channel < 0 ? "  (read-only)" : "");
+    if(pane.skipped && n > 0 && size_t(n) < sizeof(text))
+        std::snprintf(text + n, sizeof(text) - size_t(n), "  %s skipped", skipped);
+    std::string line(text);
+    line.resize(size_t(s_cols), ' ');
+    return "\x1b[" + std::to_string(pane.row + pane.rows) + ";1H" + (focused ? "\x1b[1;7m" : "\x1b[7m") + line + "\x1b[0m";
+}
+
+static void split_view_append(void *ctx, const char *data, size_t len){
+    static_cast<std::string*>(ctx)->append(data, len);
+}
+
+/**
+ * @brief                   渲染一帧：解析本帧的数据，输出变化的状态栏与窗格，焦点窗格最后输出，光标停在焦点窗格
+ */
+static void split_view_frame(bool redraw, size_t focus, const std::vector<std::string> &status){
+    std::string &out = s_out;
+    out.clear();
+    if(redraw){
+        out += "\x1b[0m\x1b[2J";
+        for(auto &pane : s_panes){
+            vscreen_invalidate(pane.vs);
+            pane.status.clear();
+        }
+    }
+    for(size_t i = 0; i < s_panes.size(); i++){
+        split_view_pane_state &pane = s_panes[i];
+        if(!pane.feed.empty()){
+            vscreen_write(pane.vs, pane.feed.data(), pane.feed.size());
+            pane.feed.clear();
+        }
+        if(status[i] != pane.status){
+            out += status[i];
+            pane.status = status[i];
+        }
+    }
+    for(size_t k = 1; k <= s_panes.size(); k++){
+        split_view_pane_state &pane = s_panes[(focus + k) % s_panes.size()];
+        if(vscreen_dirty(pane.vs) || (k == s_panes.size() && !out.empty()))
+            vscreen_render(pane.vs, split_view_append, &out);
+    }
+    if(!out.empty()){
+        std::cout.write(out.data(), std::streamsize(out.size()));
+        std::cout << std::flush;
+    }
+}
+
+static void split_view_thread(void){
+    auto next_status = std::chrono::steady_clock::now() + std::chrono::milliseconds(SPLIT_VIEW_STATUS_MS);
+    auto next_frame = std::chrono::steady_clock::now();
+    std::vector<std::string> status(s_panes.size());
+    while(1){
+        {
+            std::unique_lock<std::mutex> lck(s_mtx);
+            s_cv.wait_until(lck, next_status, []{
+                return s_req_stop || (!s_paused && (s_redraw || s_resize || s_update || split_view_pending()));
+            });
+            /* 限制帧率，等待期间到达的数据在同一帧中解析 */
+            s_cv.wait_until(lck, next_frame, []{ return s_req_stop; });
+            if(s_req_stop)
+                return;
+        }
+        std::lock_guard<std::mutex> render_lck(s_render_mtx);
+        bool redraw;
+        size_t focus;
+        {
+            std::lock_guard<std::mutex> lck(s_mtx);
+            auto now = std::chrono::steady_clock::now();
+            if(s_paused){
+                next_status = now + std::chrono::milliseconds(SPLIT_VIEW_STATUS_MS);
+                continue;
+            }
+            if(now >= next_status){
+                double seconds = std::chrono::duration<double>(now - next_status).count() + SPLIT_VIEW_STATUS_MS / 1000.0;
+                for(auto &pane : s_panes){
+                    pane.rate = double(pane.bytes) / seconds;
+                    pane.bytes = 0;
+                }
+                next_status = now + std::chrono::milliseconds(SPLIT_VIEW_STATUS_MS);
+            }
+            if(s_resize){
+                split_view_layout();
+                s_resize = false;
+                s_redraw = true;
+            }
+            redraw = s_redraw;
+            s_redraw = false;
+            s_update = false;
+            focus = s_focus;
+            for(size_t i = 0; i < s_panes.size(); i++){
+                split_view_pane_state &pane = s_panes[i];
+                if(pane.pending.size() <= SPLIT_VIEW_FEED_MAX){
+                    pane.feed.swap(pane.pending);
+                }else{
+                    pane.feed.assign(pane.pending, 0, SPLIT_VIEW_FEED_MAX);
+                    pane.pending.erase(0, SPLIT_VIEW_FEED_MAX);
+                }
+                status[i] = split_view_status(pane, i == focus);
+            }
+        }
+        split_view_frame(redraw, focus, status);
+        next_frame = std::chrono::steady_clock::now() + s_frame_interval;
+    }
+}
+
+extern "C"{
+
+int split_view_start(const struct split_view_pane *panes, size_t num, int rows, int cols, int fps){
+    if(num == 0 || rows < int(num) * 2 || cols < 1){
+        std::printf("split view: terminal is too small for %zu panes\r\n", num);
+        return -1;
+    }
+    std::vector<split_view_pane_state> states(num);
+    for(size_t i = 0; i < num; i++){
+        struct rtt_desc desc = {};
+        states[i].up_channel = panes[i].up_channel;
+        states[i].down_channel = panes[i].down_channel;
+        if(jlink_rtt_get_buffer_desc(RTT_DIRECTION_UP, panes[i].up_channel, &desc) == 0){
+            desc.name[sizeof(desc.name) - 1] = '\0';
+            states[i].name = desc.name;
+        }
+        states[i].vs = vscreen_create(1, cols);
+    }
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        s_panes.swap(states);
+        s_rows = rows;
+        s_cols = cols;
+        s_focus = 0;
+        s_req_stop = false;
+        s_paused = false;
+        s_resize = true;
+    }
+    for(size_t i = 1; i < num; i++){
+        if(jlink_rtt_attach_channel(panes[i].up_channel, split_view_rx_handler) < 0)
+            std::printf("split view: attach channel %d failed\r\n", panes[i].up_channel);
+    }
+    if(fps <= 0)
+        fps = SPLIT_VIEW_FPS_DEFAULT;
+    s_frame_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / fps;
+    s_thread = new std::thread(split_view_thread);
+    return 0;
+}
+
+void split_view_stop(void){
+    if(!s_thread)
+        return;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        s_req_stop = true;
+        s_cv.notify_one();
+    }
+    s_thread->join();
+    delete s_thread;
+    s_thread = nullptr;
+    std::cout << "\x1b[0m\x1b[?25h\x1b[" << s_rows << ";1H\r\n" << std::flush;
+    /* 附加的通道在 RTT 停止前仍会回调，清空窗格后回调直接返回 */
+    std::vector<split_view_pane_state> panes;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        panes.swap(s_panes);
+    }
+    for(auto &pane : panes)
+        vscreen_destroy(pane.vs);
+}
+
+void split_view_write(const char *data, size_t len){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    if(s_panes.empty())
+        return;
+    split_view_queue(s_panes[0], data, len);
+}
+
+void split_view_pause(int paused){
+    std::lock_guard<std::mutex> render_lck(s_render_mtx);
+    std::lock_guard<std::mutex> lck(s_mtx);
+    s_paused = paused != 0;
+    /* 暂停期间屏幕被其它输出覆盖，恢复时整屏重绘 */
+    if(!s_paused)
+        s_redraw = true;
+    s_cv.notify_one();
+}
+
+void split_view_resize(int rows, int cols){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    if(rows <= 0 || cols <= 0)
+        return;
+    s_rows = std::max(rows, int(s_panes.size()) * 2);
+    s_cols = cols;
+    s_resize = true;
+    s_cv.notify_one();
+}
+
+void split_view_focus_next(void){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    if(s_panes.empty())
+        return;
+    s_focus = (s_focus + 1) % s_panes.size();
+    s_update = true;
+    s_cv.notify_one();
+}
+
+int split_view_focus_channel(void){
+    std::lock_guard<std::mutex> lck(s_mtx);
+    if(s_panes.empty())
+        return -1;
+    return s_panes[s_focus].down_channel;
+}
+
+}
@@ -0,0 +1,124 @@
+/**
+ * @file status_bar.cpp
+ * @brief 终端底部的状态栏：只读取 relaxed 原子计数，速率由相邻两次采样的差值计算，接收路径没有额外开销
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "jlink_rtt.h"
+#include "terminal_display_record.h"
+#include "status_bar.h"
+
+#define STATUS_BAR_TEXT_SIZE            256
+
+struct status_bar_sample{
+    std::chrono::steady_clock::time_point time;
+    struct jlink_rtt_stats rtt;
+    struct terminal_display_stats display;
+};
+
+static std::mutex s_mtx;
+static std::condition_variable s_cv;
+static bool s_req_stop = false;
+static std::thread *s_thread = nullptr;
+static std::chrono::steady_clock::duration s_interval;
+
+static void status_bar_sample_get(struct status_bar_sample *sample){
+    sample->time = std::chrono::steady_clock::now();
+    jlink_rtt_get_stats(&sample->rtt);
+    terminal_display_record_get_stats(&sample->display);
+}
+
+/**
+ * @brief                   格式化字节数，如 "812 B"、"12.3 KB"、"1.05 MB"
+ */
+static void status_bar_bytes(char *out, size_t size, double bytes){
+    if(bytes < 1024)
+        std::snprintf(out, size, "%.0f B", bytes);
+    else if(bytes < 1024 * 1024)
+        std::snprintf(out, size, "%.1f KB", bytes / 1024);
+    else
+        std::snprintf(out, size, "%.2f MB", bytes / (1024 * 1024));
+}
+
+static size_t status_bar_format(const struct status_bar_sample *prev, const struct status_bar_sample *now, char *out, size_t size){
+    double seconds = std::chrono::duration<double>(now->time - prev->time).count();
+    if(seconds <= 0)
+        seconds = 1;
+    char rx[32], tx[32], backlog[32], fill[16], overflows[24], poll[24];
+    status_bar_bytes(rx, sizeof(rx), double(now->rtt.rx_bytes - prev->rtt.rx_bytes) / seconds);
+    status_bar_bytes(tx, sizeof(tx), double(now->rtt.tx_bytes - prev->rtt.tx_bytes) / seconds);
+    status_bar_bytes(backlog, sizeof(backlog), double(now->display.backlog));
+    if(now->rtt.fill >= 0)
+        std::snprintf(fill, sizeof(fill), "%d%%", now->rtt.fill);
+    else
+        std::snprintf(fill, sizeof(fill), "-");
+    if(now->rtt.host_overflows >= 0)
+        std::snprintf(overflows, sizeof(overflows), "%d", now->rtt.host_overflows);
+    else
+        std::snprintf(overflows, sizeof(overflows), "-");
+    /* 两次采样之间的平均读取间隔，这段时间没有读取时不显示 */
+    uint64_t polls = now->rtt.polls - prev->rtt.polls;
+    if(polls)
+        std::snprintf(poll, sizeof(poll), "%.0f us", double(now->rtt.poll_time_us - prev->rtt.poll_time_us) / double(polls));
+    else
+        std::snprintf(poll, sizeof(poll), "-");
+    int len = std::snprintf(out, size, " rx %s/s  tx %s/s  %.0f lines/s  backlog %s  tx drops %llu  overflows %s  fill %s  poll %s", 
+        rx, tx, double(now->display.lines - prev->display.lines) / seconds, backlog, (unsigned long long)now->rtt.tx_drops, 
+        overflows, fill, poll);
+    return len < 0 ? 0 : std::min(size_t(len), size - 1);
+}
+
+static void status_bar_thread(void){
+    struct status_bar_sample prev, now;
+    char text[STATUS_BAR_TEXT_SIZE];
+    status_bar_sample_get(&prev);
+    std::unique_lock<std::mutex> lck(s_mtx);
+    while(!s_req_stop){
+        if(s_cv.wait_for(lck, s_interval, []{ return s_req_stop; }))
+            break;
+        status_bar_sample_get(&now);
+        size_t len = status_bar_format(&prev, &now, text, sizeof(text));
+        terminal_display_record_set_status(text, len);
+        prev = now;
+    }
+}
+
+extern "C"{
+
+int status_bar_start(int rate){
+    if(s_thread)
+        return -1;
+    if(rate <= 0)
+        rate = STATUS_BAR_RATE_DEFAULT;
+    rate = std::min(rate, STATUS_BAR_RATE_MAX);
+    s_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / rate;
+    s_req_stop = false;
+    s_thread = new std::thread(status_bar_thread);
+    return 0;
+}
+
+void status_bar_stop(void){
+    if(!s_thread)
+        return;
+    {
+        std::unique_lock<std::mutex> lck(s_mtx);
+        s_req_stop = true;
+        s_cv.notify_one();
+    }
+    s_thread->join();
+    delete s_thread;
+    s_thread = nullptr;
+}
+
+}
@@ -0,0 +1,145 @@
+/**
+ * @file stream_pattern.cpp
+ * @brief 流式字符串匹配，支持匹配内容跨越多次数据块
+ *        KMP 状态机保证跨块匹配，状态为0时用 memchr 跳到下一个首字符，常见情况下接近 memchr 的速度
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "stream_pattern.h"
+
+struct stream_pattern{
+    std::string pattern;
+    std::vector<size_t> fail;           // KMP 失配表
+    size_t state;                       // 已匹配的长度
+};
+
+struct stream_pattern_set{
+    std::vector<std::string> patterns;
+    std::map<int, std::vector<stream_pattern_t*>> channels;     // 每个通道的匹配器
+    std::mutex mtx;
+};
+
+static void stream_pattern_set_free(stream_pattern_set_t *set){
+    for(auto &channel : set->channels){
+        for(auto sp : channel.second)
+            stream_pattern_destroy(sp);
+    }
+    set->channels.clear();
+}
+
+extern "C"{
+
+stream_pattern_t *stream_pattern_create(const char *pattern){
+    if(!pattern || !*pattern)
+        return nullptr;
+    stream_pattern_t *sp = new stream_pattern_t;
+    sp->pattern = pattern;
+    sp->fail.assign(sp->pattern.size(), 0);
+    sp->state = 0;
+    for(size_t i = 1, k = 0; i < sp->pattern.size(); i++){
+        while(k > 0 && sp->pattern[i] != sp->pattern[k])
+            k = sp->fail[k - 1];
+        if(sp->pattern[i] == sp->pattern[k])
+            k++;
+        sp->fail[i] = k;
+    }
+    return sp;
+}
+
+void stream_pattern_destroy(stream_pattern_t *sp){
+    delete sp;
+}
+
+const char *stream_pattern_str(const stream_pattern_t *sp){
+    return sp->pattern.c_str();
+}
+
+int stream_pattern_feed(stream_pattern_t *sp, const char *data, size_t len){
+    const char *pattern = sp->pattern.data();
+    const size_t pattern_len = sp->pattern.size();
+    const char *end = data + len;
+    size_t state = sp->state;
+    int matched = 0;
+
+    while(data < end){
+        if(state == 0){
+            data = static_cast<const char*>(std::memchr(data, pattern[0], size_t(end - data)));
+            if(!data)
+                break;
+            state = 1;
+            data++;
+        }else{
+            char c = *data;
+            while(state > 0 && c != pattern[state])
+                state = sp->fail[state - 1];
+            if(c == pattern[state])
+                state++;
+            data++;
+        }
+        if(state == pattern_len){
+            matched++;
+            state = sp->fail[state - 1];
+        }
+    }
+    sp->state = state;
+    return matched;
+}
+
+void stream_pattern_reset(stream_pattern_t *sp){
+    sp->state = 0;
+}
+
+stream_pattern_set_t *stream_pattern_set_create(void){
+    return new stream_pattern_set_t;
+}
+
+void stream_pattern_set_destroy(stream_pattern_set_t *set){
+    if(!set)
+        return;
+    stream_pattern_set_free(set);
+    delete set;
+}
+
+int stream_pattern_set_add(stream_pattern_set_t *set, const char *pattern){
+    if(!pattern || !*pattern)
+        return -1;
+    std::lock_guard<std::mutex> lck(set->mtx);
+    set->patterns.push_back(pattern);
+    for(auto &channel : set->channels)
+        channel.second.push_back(stream_pattern_create(pattern));
+    return 0;
+}
+
+void stream_pattern_set_clear(stream_pattern_set_t *set){
+    std::lock_guard<std::mutex> lck(set->mtx);
+    stream_pattern_set_free(set);
+    set->patterns.clear();
+}
+
+int stream_pattern_set_feed(stream_pattern_set_t *set, int channel, const char *data, size_t len){
+    std::lock_guard<std::mutex> lck(set->mtx);
+    if(set->patterns.empty())
+        return 0;
+    auto it = set->channels.find(channel);
+    if(it == set->channels.end()){
+        it = set->channels.emplace(channel, std::vector<stream_pattern_t*>()).first;
+        for(auto &pattern : set->patterns)
+            it->second.push_back(stream_pattern_create(pattern.c_str()));
+    }
+    int matched = 0;
+    for(auto sp : it->second)
+        matched += stream_pattern_feed(sp, data, len);
+    return matched;
+}
+
+}
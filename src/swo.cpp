@@ -0,0 +1,154 @@
+/**
+ * @file swo.cpp
+ * @brief SWO 数据采集：读取 J-Link SWO 数据并解析 ITM 激励端口输出与 DWT PC 采样
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ * 
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ * 
+ */
+
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <fstream>
+
+#include "jlink_api.h"
+#include "itm_parser.h"
+#include "mapped_file.h"
+#include "pc_histogram.h"
+#include "swo.h"
+
+#define SWO_READ_BUF_SIZE           0x10000
+#define SWO_HOST_BUF_SIZE           0x400000    // J-Link DLL 中的 SWO 缓冲区大小
+#define SWO_IDLE_SLEEP_MS           1
+#define SWO_MAX_SPEED_NUM           32
+
+static uint8_t s_read_buf[SWO_READ_BUF_SIZE];
+static itm_parser_t *s_parser = nullptr;
+static std::ofstream s_record_file;
+static uint32_t s_port_mask = 0;
+static uint32_t s_cb_port_mask = 0xffffffff;
+static bool s_req_stop = false;
+static std::thread *s_thread = nullptr;
+
+extern "C" {
+    static void (*s_rx_cb)(int port, const char *data, size_t len) = nullptr;
+}
+
+static void swo_stimulus(void *ctx, int port, const uint8_t *data, size_t len){
+    (void)ctx;
+    if(s_rx_cb && port < 32 && (s_cb_port_mask & (1u << port)))
+        s_rx_cb(port, reinterpret_cast<const char*>(data), len);
+}
+
+static void swo_pc_sample(void *ctx, uint32_t pc, int sleep){
+    (void)ctx;
+    pc_histogram_add(pc, sleep);
+}
+
+static const struct itm_parser_callbacks s_itm_callbacks = {
+    swo_stimulus,
+    swo_pc_sample,
+    nullptr,
+};
+
+static void swo_print_stats(const char *prefix){
+    struct itm_parser_stats stats;
+    itm_parser_get_stats(s_parser, &stats);
+    std::printf("%s: %llu packets, %llu stimulus bytes, %llu PC samples, %llu overflows, %llu errors\r\n", prefix,
+        (unsigned long long)stats.packets, (unsigned long long)stats.stimulus_bytes, (unsigned long long)stats.pc_samples,
+        (unsigned long long)stats.overflows, (unsigned long long)stats.errors);
+}
+
+static void swo_thread(void){
+    while(!s_req_stop){
+        int num = JLINK_SWO_Control(SWO_CMD_GET_NUM_BYTES, nullptr);
+        if(num <= 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(SWO_IDLE_SLEEP_MS));
+            continue;
+        }
+        uint32_t len = std::min<uint32_t>(uint32_t(num), SWO_READ_BUF_SIZE);
+        JLINK_SWO_Read(s_read_buf, 0, &len);
+        JLINK_SWO_Control(SWO_CMD_FLUSH, &len);
+        if(s_record_file.is_open())
+            s_record_file.write(reinterpret_cast<const char*>(s_read_buf), std::streamsize(len));
+        itm_parser_feed(s_parser, s_read_buf, len);
+    }
+}
+
+extern "C"{
+
+int swo_start(uint32_t cpu_hz, uint32_t swo_hz, uint32_t port_mask, const char *record_path){
+    if(swo_hz == 0){
+        uint32_t speeds[SWO_MAX_SPEED_NUM];
+        int num = JLINK_SWO_GetCompatibleSpeeds(cpu_hz, 0, speeds, SWO_MAX_SPEED_NUM);
+        if(num <= 0){
+            std::printf("swo: no compatible SWO speed for cpu %u Hz\n", cpu_hz);
+            return -1;
+        }
+        swo_hz = speeds[0];
+    }
+    if(record_path){
+        s_record_file.open(record_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!s_record_file.is_open()){
+            std::printf("swo: open %s failed\n", record_path);
+            return -1;
+        }
+    }
+    uint32_t host_buf_size = SWO_HOST_BUF_SIZE;
+    JLINK_SWO_Control(SWO_CMD_SET_BUFFERSIZE_HOST, &host_buf_size);
+    if(JLINK_SWO_EnableTarget(cpu_hz, swo_hz, SWO_INTERFACE_UART, port_mask) < 0){
+        std::printf("swo: enable target SWO at %u baud failed\n", swo_hz);
+        s_record_file.close();
+        return -1;
+    }
+    std::printf("swo: cpu %u Hz, swo %u baud, ports %#x\n", cpu_hz, swo_hz, port_mask);
+    s_port_mask = port_mask;
+    s_parser = itm_parser_create(&s_itm_callbacks, nullptr);
+    s_req_stop = false;
+    s_thread = new std::thread(swo_thread);
+    return 0;
+}
+
+void swo_stop(void){
+    if(!s_thread)
+        return;
+    s_req_stop = true;
+    s_thread->join();
+    delete s_thread;
+    s_thread = nullptr;
+    JLINK_SWO_DisableTarget(s_port_mask);
+    JLINK_SWO_Control(SWO_CMD_STOP, nullptr);
+    if(s_record_file.is_open())
+        s_record_file.close();
+    swo_print_stats("swo");
+    itm_parser_destroy(s_parser);
+    s_parser = nullptr;
+}
+
+void swo_set_recv_callback(uint32_t port_mask, void (*cb)(int port, const char *data, size_t len)){
+    s_cb_port_mask = port_mask;
+    s_rx_cb = cb;
+}
+
+int swo_decode_file(const char *path){
+    mapped_file_t *mf = mapped_file_open(path);
+    if(!mf){
+        std::printf("swo: open %s failed\n", path);
+        return -1;
+    }
+    const uint8_t *data = mapped_file_data(mf);
+    size_t size = mapped_file_size(mf);
+    s_parser = itm_parser_create(&s_itm_callbacks, nullptr);
+    for(size_t off = 0; off < size; off += SWO_READ_BUF_SIZE)
+        itm_parser_feed(s_parser, data + off, std::min<size_t>(SWO_READ_BUF_SIZE, size - off));
+    mapped_file_close(mf);
+    swo_print_stats("swo-decode");
+    itm_parser_destroy(s_parser);
+    s_parser = nullptr;
+    return 0;
+}
+
+}
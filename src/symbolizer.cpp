@@ -0,0 +1,501 @@
+/**
+ * @file symbolizer.cpp
+ * @brief 地址符号化：根据固件 ELF 把日志中的地址转换为 func+off (file:line)
+ *        符号和行号表在加载时整理为按地址排序的数组(地址与信息分开存放)，查询为一次二分查找
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "elf_file.h"
+#include "symbolizer.h"
+
+#define SYMBOLIZER_UNSIZED_MAX      0x1000      // 没有大小信息的符号最多覆盖的范围
+#define SYMBOLIZER_ANNOTATE_MAX     8           // 每行最多注释的地址数量
+
+/* DWARF 常量 */
+#define DW_LNS_copy                 1
+#define DW_LNS_advance_pc           2
+#define DW_LNS_advance_line         3
+#define DW_LNS_set_file             4
+#define DW_LNS_const_add_pc         8
+#define DW_LNS_fixed_advance_pc     9
+#define DW_LNE_end_sequence         1
+#define DW_LNE_set_address          2
+#define DW_LNCT_path                1
+#define DW_FORM_block               0x09
+#define DW_FORM_data1               0x0b
+#define DW_FORM_data2               0x05
+#define DW_FORM_data4               0x06
+#define DW_FORM_data8               0x07
+#define DW_FORM_data16              0x1e
+#define DW_FORM_string              0x08
+#define DW_FORM_strp                0x0e
+#define DW_FORM_udata               0x0f
+#define DW_FORM_line_strp           0x1f
+
+struct sym_info{
+    uint32_t size;
+    uint32_t name;                  // 名字在 s_name_pool 中的偏移
+};
+
+struct line_info{
+    uint32_t line;                  // 0 表示序列结束，该地址之后没有行号信息
+    uint32_t file;                  // 文件名在 s_name_pool 中的偏移
+};
+
+static std::vector<uint32_t> s_sym_addr;
+static std::vector<sym_info> s_sym_info;
+static std::vector<uint32_t> s_line_addr;
+static std::vector<line_info> s_line_info;
+static std::string s_name_pool;
+
+static uint32_t name_pool_add(const char *name){
+    uint32_t off = uint32_t(s_name_pool.size());
+    s_name_pool.append(name);
+    s_name_pool.push_back('\0');
+    return off;
+}
+
+/**
+ * @brief DWARF 数据读取，越界后 ok 置为 false 并一直返回0
+ */
+struct dwarf_reader{
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+
+    bool remain(size_t n){
+        if(size_t(end - p) < n)
+            ok = false;
+        return ok;
+    }
+    uint64_t u(size_t n){
+        if(!remain(n))
+            return 0;
+        uint64_t v = 0;
+        for(size_t i = 0; i < n; i++)
+            v |= uint64_t(p[i]) << (8 * i);
+        p += n;
+        return v;
+    }
+    uint64_t uleb(void){
+        uint64_t v = 0;
+        unsigned shift = 0;
+        while(remain(1)){
+            uint8_t b = *p++;
+            if(shift < 64)
+                v |= uint64_t(b & 0x7f) << shift;
+            shift += 7;
+            if(!(b & 0x80))
+                break;
+        }
+        return v;
+    }
+    int64_t sleb(void){
+        int64_t v = 0;
+        unsigned shift = 0;
+        uint8_t b = 0;
+        while(remain(1)){
+            b = *p++;
+            if(shift < 64)
+                v |= int64_t(b & 0x7f) << shift;
+            shift += 7;
+            if(!(b & 0x80))
+                break;
+        }
+        if(shift < 64 && (b & 0x40))
+            v |= -(int64_t(1) << shift);
+        return v;
+    }
+    const char *str(void){
+        if(!remain(1))
+            return "";
+        const char *s = reinterpret_cast<const char*>(p);
+        const uint8_t *nul = static_cast<const uint8_t*>(std::memchr(p, 0, size_t(end - p)));
+        if(!nul){
+            ok = false;
+            return "";
+        }
+        p = nul + 1;
+        return s;
+    }
+    void skip(size_t n){
+        if(remain(n))
+            p += n;
+    }
+};
+
+struct dwarf_sections{
+    const uint8_t *line_str;
+    uint32_t line_str_size;
+    const uint8_t *str;
+    uint32_t str_size;
+};
+
+static const char *dwarf_section_str(const uint8_t *section, uint32_t size, uint64_t off){
+    if(!section || off >= size || !std::memchr(section + off, 0, size - off))
+        return "";
+    return reinterpret_cast<const char*>(section + off);
+}
+
+static const char *base_name(const char *path){
+    const char *name = path;
+    for(const char *p = path; *p; p++){
+        if(*p == '/' || *p == '\\')
+            name = p + 1;
+    }
+    return name;
+}
+
+/**
+ * @brief                   读取 DWARF5 目录/文件表中的一个条目，返回路径
+ */
+static const char *dwarf5_entry(dwarf_reader &r, const std::vector<std::pair<uint64_t, uint64_t>> &formats,
+    const dwarf_sections &sections, bool dwarf64){
+    const char *path = "";
+    for(auto &format : formats){
+        const char *s = nullptr;
+        switch(format.second){
+            case DW_FORM_string:    s = r.str(); break;
+            case DW_FORM_line_strp: s = dwarf_section_str(sections.line_str, sections.line_str_size, r.u(dwarf64 ? 8 : 4)); break;
+            case DW_FORM_strp:      s = dwarf_section_str(sections.str, sections.str_size, r.u(dwarf64 ? 8 : 4)); break;
+            case DW_FORM_udata:     r.uleb(); break;
+            case DW_FORM_data1:     r.skip(1); break;
+            case DW_FORM_data2:     r.skip(2); break;
+            case DW_FORM_data4:     r.skip(4); break;
+            case DW_FORM_data8:     r.skip(8); break;
+            case DW_FORM_data16:    r.skip(16); break;
+            case DW_FORM_block:     r.skip(size_t(r.uleb())); break;
+            default:                r.ok = false; break;
+        }
+        if(s && format.first == DW_LNCT_path)
+            path = s;
+    }
+    return path;
+}
+
+/**
+ * @brief                   解析一个 .debug_line 单元(DWARF 2-5)，输出行号表
+ */
+static void dwarf_line_unit(dwarf_reader &r, const dwarf_sections &sections,
+    std::vector<std::pair<uint32_t, line_info>> &rows){
+    std::vector<uint32_t> files;
+    bool dwarf64 = false;
+    uint64_t unit_length = r.u(4);
+    if(unit_length == 0xffffffff){
+        dwarf64 = true;
+        unit_length = r.u(8);
+    }
+    if(!r.remain(size_t(unit_length))){
+        return;
+    }
+    dwarf_reader unit = {r.p, r.p + unit_length, true};
+    r.p += unit_length;
+
+    uint16_t version = uint16_t(unit.u(2));
+    if(version < 2 || version > 5)
+        return;
+    if(version >= 5)
+        unit.skip(2);                       // address_size, segment_selector_size
+    uint64_t header_length = unit.u(dwarf64 ? 8 : 4);
+    if(!unit.remain(size_t(header_length)))
+        return;
+    const uint8_t *program = unit.p + header_length;
+    uint8_t min_inst_len = uint8_t(unit.u(1));
+    if(version >= 4)
+        unit.skip(1);                       // maximum_operations_per_instruction
+    unit.skip(1);                           // default_is_stmt
+    int8_t line_base = int8_t(unit.u(1));
+    uint8_t line_range = uint8_t(unit.u(1));
+    uint8_t opcode_base = uint8_t(unit.u(1));
+    std::vector<uint8_t> opcode_lengths(opcode_base ? opcode_base - 1u : 0u);
+    for(auto &len : opcode_lengths)
+        len = uint8_t(unit.u(1));
+    if(line_range == 0)
+        return;
+
+    if(version >= 5){
+        std::vector<std::pair<uint64_t, uint64_t>> formats(size_t(unit.u(1)));
+        for(auto &format : formats){
+            format.first = unit.uleb();
+            format.second = unit.uleb();
+        }
+        uint64_t dir_count = unit.uleb();
+        for(uint64_t i = 0; i < dir_count && unit.ok; i++)
+            dwarf5_entry(unit, formats, sections, dwarf64);
+        formats.resize(size_t(unit.u(1)));
+        for(auto &format : formats){
+            format.first = unit.uleb();
+            format.second = unit.uleb();
+        }
+        uint64_t file_count = unit.uleb();
+        for(uint64_t i = 0; i < file_count && unit.ok; i++)
+            files.push_back(name_pool_add(base_name(dwarf5_entry(unit, formats, sections, dwarf64))));
+    }else{
+        while(unit.ok && *unit.str())
+            ;                               // include_directories
+        /* DWARF 2-4 的文件索引从1开始 */
+        files.push_back(name_pool_add("??"));
+        while(unit.ok){
+            const char *name = unit.str();
+            if(!*name)
+                break;
+            unit.uleb();
+            unit.uleb();
+            unit.uleb();
+            files.push_back(name_pool_add(base_name(name)));
+        }
+    }
+    if(!unit.ok || program > unit.end)
+        return;
+
+    unit.p = program;
+    uint64_t addr = 0;
+    int64_t line = 1;
+    uint64_t file = 1;
+    auto emit = [&](bool end_sequence){
+        line_info info;
+        info.line = end_sequence ? 0 : uint32_t(line);
+        info.file = file < files.size() ? files[size_t(file)] : 0;
+        rows.emplace_back(uint32_t(addr), info);
+    };
+    while(unit.ok && unit.p < unit.end){
+        uint8_t op = uint8_t(unit.u(1));
+        if(op >= opcode_base){
+            uint8_t adjusted = uint8_t(op - opcode_base);
+            addr += uint64_t(adjusted / line_range) * min_inst_len;
+            line += line_base + adjusted % line_range;
+            emit(false);
+            continue;
+        }
+        switch(op){
+            case 0:{
+                uint64_t len = unit.uleb();
+                if(len == 0 || !unit.remain(size_t(len)))
+                    break;
+                const uint8_t *next = unit.p + len;
+                uint8_t sub = uint8_t(unit.u(1));
+                if(sub == DW_LNE_end_sequence){
+                    emit(true);
+                    addr = 0;
+                    line = 1;
+                    file = 1;
+                }else if(sub == DW_LNE_set_address){
+                    addr = unit.u(size_t(len - 1));
+                }
+                unit.p = next;
+                break;
+            }
+            case DW_LNS_copy:
+                emit(false);
+                break;
+            case DW_LNS_advance_pc:
+                addr += unit.uleb() * min_inst_len;
+                break;
+            case DW_LNS_advance_line:
+                line += unit.sleb();
+                break;
+            case DW_LNS_set_file:
+                file = unit.uleb();
+                break;
+            case DW_LNS_const_add_pc:
+                addr += uint64_t((255 - opcode_base) / line_range) * min_inst_len;
+                break;
+            case DW_LNS_fixed_advance_pc:
+                addr += unit.u(2);
+                break;
+            default:
+                for(uint8_t i = 0; i < opcode_lengths[op - 1u]; i++)
+                    unit.uleb();
+                break;
+        }
+    }
+}
+
+static void symbolizer_load_lines(const elf_file_t *elf){
+    uint32_t size = 0;
+    const uint8_t *debug_line = elf_file_section(elf, ".debug_line", &size);
+    if(!debug_line)
+        return;
+    dwarf_sections sections = {};
+    sections.line_str = elf_file_section(elf, ".debug_line_str", &sections.line_str_size);
+    sections.str = elf_file_section(elf, ".debug_str", &sections.str_size);
+
+    std::vector<std::pair<uint32_t, line_info>> rows;
+    dwarf_reader r = {debug_line, debug_line + size, true};
+    while(r.ok && r.p < r.end)
+        dwarf_line_unit(r, sections, rows);
+
+    /* 同一地址上序列结束行排在前面，保证查找到的是新序列的起始行 */
+    std::stable_sort(rows.begin(), rows.end(), [](const std::pair<uint32_t, line_info> &a, const std::pair<uint32_t, line_info> &b){
+        if(a.first != b.first)
+            return a.first < b.first;
+        return a.second.line == 0 && b.second.line != 0;
+    });
+    s_line_addr.reserve(rows.size());
+    s_line_info.reserve(rows.size());
+    for(auto &row : rows){
+        s_line_addr.push_back(row.first);
+        s_line_info.push_back(row.second);
+    }
+}
+
+static bool is_hex(char c){
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_word(char c){
+    return is_hex(c) || (c >= 'g' && c <= 'z') || (c >= 'G' && c <= 'Z') || c == '_';
+}
+
+static uint32_t hex_value(char c){
+    if(c <= '9')
+        return uint32_t(c - '0');
+    return uint32_t((c | 0x20) - 'a' + 10);
+}
+
+extern "C"{
+
+int symbolizer_load(const char *elf_path, int with_lines){
+    elf_file_t *elf = elf_file_open(elf_path);
+    if(!elf){
+        std::printf("symbolizer: open elf %s failed\n", elf_path);
+        return -1;
+    }
+    symbolizer_unload();
+
+    struct sym_entry{
+        uint32_t addr;
+        uint32_t size;
+        uint32_t name;
+        uint8_t type;
+    };
+    std::vector<sym_entry> entries;
+    elf_file_for_each_symbol(elf, [](void *ctx, const struct elf_symbol *sym){
+        auto list = static_cast<std::vector<sym_entry>*>(ctx);
+        list->push_back({sym->addr, sym->size, name_pool_add(sym->name), sym->type});
+    }, &entries);
+    /* 同一地址的别名只保留一个，优先有大小的函数符号 */
+    std::sort(entries.begin(), entries.end(), [](const sym_entry &a, const sym_entry &b){
+        if(a.addr != b.addr)
+            return a.addr < b.addr;
+        if(a.type != b.type)
+            return a.type == ELF_STT_FUNC;
+        return a.size > b.size;
+    });
+    for(size_t i = 0; i < entries.size(); i++){
+        if(i > 0 && entries[i].addr == entries[i - 1].addr)
+            continue;
+        uint32_t size = entries[i].size;
+        if(size == 0){
+            uint32_t next = i + 1 < entries.size() ? entries[i + 1].addr : entries[i].addr + SYMBOLIZER_UNSIZED_MAX;
+            size = std::min<uint32_t>(next - entries[i].addr, SYMBOLIZER_UNSIZED_MAX);
+        }
+        s_sym_addr.push_back(entries[i].addr);
+        s_sym_info.push_back({size, entries[i].name});
+    }
+
+    if(with_lines)
+        symbolizer_load_lines(elf);
+    elf_file_close(elf);
+    return int(s_sym_addr.size());
+}
+
+void symbolizer_unload(void){
+    s_sym_addr.clear();
+    s_sym_info.clear();
+    s_line_addr.clear();
+    s_line_info.clear();
+    s_name_pool.clear();
+}
+
+const char *symbolizer_function(uint32_t addr, uint32_t *offset){
+    auto it = std::upper_bound(s_sym_addr.begin(), s_sym_addr.end(), addr);
+    if(it == s_sym_addr.begin())
+        return nullptr;
+    size_t index = size_t(it - s_sym_addr.begin() - 1);
+    const sym_info &info = s_sym_info[index];
+    uint32_t off = addr - s_sym_addr[index];
+    if(off >= info.size)
+        return nullptr;
+    if(offset)
+        *offset = off;
+    return s_name_pool.c_str() + info.name;
+}
+
+int symbolizer_lookup(uint32_t addr, char *out, size_t size){
+    uint32_t off = 0;
+    const char *name = symbolizer_function(addr, &off);
+    if(!name)
+        return -1;
+
+    int len = std::snprintf(out, size, "%s+%#x", name, off);
+    auto line_it = std::upper_bound(s_line_addr.begin(), s_line_addr.end(), addr);
+    if(line_it != s_line_addr.begin() && len > 0 && size_t(len) < size){
+        const line_info &line = s_line_info[size_t(line_it - s_line_addr.begin() - 1)];
+        if(line.line)
+            len += std::snprintf(out + len, size - size_t(len), " (%s:%u)", s_name_pool.c_str() + line.file, line.line);
+    }
+    if(len < 0)
+        return -1;
+    return std::min(len, int(size) - 1);
+}
+
+size_t symbolizer_annotate(const char *line, size_t len, char *out, size_t size){
+    char sym[256];
+    size_t out_len = 0;
+    int count = 0;
+    if(s_sym_addr.empty() || size == 0)
+        return 0;
+
+    for(size_t i = 0; i < len && count < SYMBOLIZER_ANNOTATE_MAX; ){
+        /* 只在单词边界开始匹配 */
+        if(i > 0 && is_word(line[i - 1])){
+            i++;
+            continue;
+        }
+        size_t start = i;
+        size_t digits_begin = i;
+        if(i + 2 < len && line[i] == '0' && (line[i + 1] == 'x' || line[i + 1] == 'X'))
+            digits_begin = i + 2;
+        size_t end = digits_begin;
+        uint64_t value = 0;
+        while(end < len && is_hex(line[end]) && end - digits_begin < 9){
+            value = value << 4 | hex_value(line[end]);
+            end++;
+        }
+        size_t digits = end - digits_begin;
+        bool is_token = (end >= len || !is_word(line[end])) && digits > 0 && digits <= 8 &&
+            (digits_begin != start || digits == 8);
+        if(!is_token){
+            i = end > i ? end : i + 1;
+            continue;
+        }
+        i = end;
+        int sym_len = symbolizer_lookup(uint32_t(value), sym, sizeof(sym));
+        if(sym_len < 0)
+            continue;
+        int n = std::snprintf(out + out_len, size - out_len, "%s%.*s=%s", count ? ", " : " <",
+            int(end - start), line + start, sym);
+        if(n < 0 || out_len + size_t(n) + 2 >= size)
+            break;
+        out_len += size_t(n);
+        count++;
+    }
+    if(count == 0)
+        return 0;
+    out[out_len++] = '>';
+    out[out_len] = '\0';
+    return out_len;
+}
+
+}
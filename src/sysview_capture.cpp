@@ -0,0 +1,158 @@
+/**
+ * @file sysview_capture.cpp
+ * @brief SystemView 通道采集：与交互终端同时运行，把 SystemView 上行通道的数据保存为 .SVDat 文件
+ *        .SVDat 由 ';' 开头的文本头与之后的原始 SystemView 数据流组成
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <fstream>
+
+#include "jlink_api.h"
+#include "jlink_rtt.h"
+#include "sysview_capture.h"
+
+#define SYSVIEW_COMMAND_ID_START        1
+#define SYSVIEW_COMMAND_ID_STOP         2
+#define SYSVIEW_START_RETRY_MS          1000        // 目标没有数据时重发开始命令的间隔
+#define SYSVIEW_START_RETRY_COUNT       10
+#define SYSVIEW_FILE_BUF_SIZE           0x40000
+
+static std::ofstream s_file;
+static char s_file_buf[SYSVIEW_FILE_BUF_SIZE];
+static std::mutex s_file_mtx;
+static std::mutex s_mtx;
+static std::condition_variable s_cv;
+static bool s_req_stop = false;
+static std::atomic<uint64_t> s_bytes{0};
+static std::chrono::steady_clock::time_point s_start_time;
+static std::string s_path;
+static int s_up_channel = -1;
+static int s_down_channel = -1;
+static std::thread *s_thread = nullptr;
+
+static void sysview_send_command(uint8_t cmd){
+    char data = char(cmd);
+    if(jlink_rtt_transmit_channel(s_down_channel, &data, 1) < 0)
+        std::printf("sysview: send command %u on channel %d failed\r\n", cmd, s_down_channel);
+}
+
+static void sysview_rx_handler(int channel, const char *data, size_t len){
+    (void)channel;
+    std::lock_guard<std::mutex> lck(s_file_mtx);
+    if(!s_file.is_open())
+        return;
+    s_file.write(data, std::streamsize(len));
+    s_bytes.fetch_add(len, std::memory_order_relaxed);
+}
+
+/**
+ * @brief                   目标端 SystemView 可能还未初始化，收到数据之前周期性重发开始命令
+ */
+static void sysview_capture_thread(void){
+    std::unique_lock<std::mutex> lck(s_mtx);
+    for(int i = 0; i < SYSVIEW_START_RETRY_COUNT; i++){
+        if(s_cv.wait_for(lck, std::chrono::milliseconds(SYSVIEW_START_RETRY_MS), []{ return s_req_stop; }))
+            return;
+        if(s_bytes.load() > 0)
+            return;
+        sysview_send_command(SYSVIEW_COMMAND_ID_START);
+    }
+    std::printf("sysview: no data from channel %d, is SystemView running on the target?\r\n", s_up_channel);
+}
+
+static void sysview_file_header(uint32_t up_size){
+    char time_str[64];
+    std::time_t tt = std::time(nullptr);
+    std::tm bt;
+#if defined(_MSC_VER)
+    localtime_s(&bt, &tt);
+#else
+    localtime_r(&tt, &bt);
+#endif
+    std::strftime(time_str, sizeof(time_str), "%d %b %Y %H:%M:%S", &bt);
+    s_file << ";\n"
+           << "; Version     rtt-shell " << RTT_SHELL_VERSION << "\n"
+           << "; Recorded    " << time_str << "\n"
+           << "; Connection  J-Link RTT, up channel " << s_up_channel << ", down channel " << s_down_channel << "\n"
+           << "; BufferSize  " << up_size << "\n"
+           << ";\n";
+}
+
+extern "C"{
+
+int sysview_capture_start(const char *path, int up_channel, int down_channel){
+    struct rtt_desc desc = {};
+
+    if(up_channel < 0)
+        up_channel = jlink_rtt_find_buffer(RTT_DIRECTION_UP, SYSVIEW_BUFFER_NAME);
+    if(up_channel < 0){
+        std::printf("sysview: no \"%s\" up buffer found\n", SYSVIEW_BUFFER_NAME);
+        return -1;
+    }
+    if(down_channel < 0)
+        down_channel = jlink_rtt_find_buffer(RTT_DIRECTION_DOWN, SYSVIEW_BUFFER_NAME);
+    if(down_channel < 0)
+        down_channel = up_channel;
+    s_up_channel = up_channel;
+    s_down_channel = down_channel;
+    jlink_rtt_get_buffer_desc(RTT_DIRECTION_UP, up_channel, &desc);
+
+    s_file.rdbuf()->pubsetbuf(s_file_buf, sizeof(s_file_buf));
+    s_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!s_file.is_open()){
+        std::printf("sysview: open %s failed\n", path);
+        return -1;
+    }
+    sysview_file_header(desc.size);
+    s_path = path;
+    s_bytes.store(0);
+    s_start_time = std::chrono::steady_clock::now();
+
+    if(jlink_rtt_attach_channel(up_channel, sysview_rx_handler) < 0){
+        std::printf("sysview: attach channel %d failed\n", up_channel);
+        s_file.close();
+        return -1;
+    }
+    sysview_send_command(SYSVIEW_COMMAND_ID_START);
+    s_req_stop = false;
+    s_thread = new std::thread(sysview_capture_thread);
+    std::printf("sysview: capturing channel %d to %s\n", up_channel, path);
+    return 0;
+}
+
+void sysview_capture_stop(void){
+    if(!s_thread)
+        return;
+    {
+        std::lock_guard<std::mutex> lck(s_mtx);
+        s_req_stop = true;
+    }
+    s_cv.notify_one();
+    s_thread->join();
+    delete s_thread;
+    s_thread = nullptr;
+
+    sysview_send_command(SYSVIEW_COMMAND_ID_STOP);
+    {
+        std::lock_guard<std::mutex> lck(s_file_mtx);
+        s_file.close();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_start_time).count();
+    uint64_t bytes = s_bytes.load();
+    std::printf("sysview: saved %llu bytes to %s (%.1f KB/s)\r\n", (unsigned long long)bytes, s_path.c_str(),
+        seconds > 0 ? double(bytes) / seconds / 1024.0 : 0.0);
+}
+
+}
@@ -8,352 +8,1106 @@
  * 
  */
 
-#include <iomanip>
 #include <iostream>
 #include <string>
-#include <queue>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <thread>
-#include <fstream>
-#include <sstream>
-
-enum ehshell_escape_char{
-    ESCAPE_CHAR_NUL                 = 0x00,
-    ESCAPE_CHAR_CTRL_A              = 0x01,
-    ESCAPE_CHAR_CTRL_C_SIGINT       = 0x03,     /* 发送退出信号 */
-    ESCAPE_CHAR_CTRL_BACKSPACE_0    = 0x08,     /* 删除前一个字符 */
-    ESCAPE_CHAR_CTRL_TAB            = 0x09,     /* 可用于TAB补全 */
-    ESCAPE_CHAR_CTRL_J_LF           = 0x0A,     /* 换行 Enter*/
-    ESCAPE_CHAR_CTRL_L_CLS          = 0x0C,     /* 清除屏 */
-    ESCAPE_CHAR_CTRL_M_CR           = 0x0D,     /* 回到行首 */
-    ESCAPE_CHAR_CTRL_U_DEL_LINE     = 0x0E,     /* 删除当前行 */
-    ESCAPE_CHAR_CTRL_W_DEL_WORD     = 0x0F,     /* 删除当前单词 */
-    ESCAPE_CHAR_CTRL_Z              = 0x1A,     /* 发送退出信号 */
-    ESCAPE_CHAR_CTRL_BACKSPACE_1    = 0x7f,     /* 删除前一个字符 */
-    ESCAPE_CHAR_CTRL_UTF8_START     = 0x80,     /* UTF-8 多字节字符开始 */
-    ESCAPE_CHAR_CTRL_NOSTD_START    = 0xFF,     /* 非标准转义字符 */
-    ESCAPE_CHAR_CTRL_RESET,                     /* 重置终端 */
-    ESCAPE_CHAR_CTRL_HOME,                      /* 移动光标到行首 */
-    ESCAPE_CHAR_CTRL_END,                       /* 移动光标到行尾 */
-    ESCAPE_CHAR_CTRL_LEFT,                      /* 移动光标左 */
-    ESCAPE_CHAR_CTRL_RIGHT,                     /* 移动光标右 */
-    ESCAPE_CHAR_CTRL_UP,                        /* 移动光标上 */
-    ESCAPE_CHAR_CTRL_DOWN,                      /* 移动光标下 */
-    ESCAPE_CHAR_CTRL_DELETE,                    /* 删除光标后面的字符 */
-    ESCAPE_CHAR_CTRL_OTHER ,                    /* 其他转义字符 */
-    ESCAPE_CHAR_CTRL_UTF8,                      /* UTF-8 多字节字符 */
-};
-
-
+#include <atomic>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <random>
 
-#define TERMINAL_ESCAPE_MATCH_INCOMPLETE             0xfe
-#define TERMINAL_ESCAPE_MATCH_FAIL                   0xff
+#include "vt_parser.h"
+#include "vscreen.h"
+#include "line_collapse.h"
+#include "log_jsonl.h"
+#include "hexdump.h"
+#include "scrollback.h"
+#include "alloc_stats.h"
+#include "terminal_display_record.h"
 
+#define ASCII_CTRL_C_SIGINT          0x03        /* 发送退出信号 */
+#define ASCII_BACKSPACE              0x08        /* 删除前一个字符 */
+#define ASCII_TAB                    0x09
+#define ASCII_LF                     0x0A        /* 换行 */
+#define ASCII_CR                     0x0D        /* 回到行首 */
+#define ASCII_DEL_LINE               0x0E        /* 删除当前行 */
 
-#define TERMINAL_ESCAPE_MATCH_NONE                   ((uint16_t)0x00)
-#define TERMINAL_ESCAPE_MATCH_ESC                    ((uint16_t)0x01)        
-#define TERMINAL_ESCAPE_MATCH_ESC_OSC                ((uint16_t)0x02)        // after ESC ]
-#define TERMINAL_ESCAPE_MATCH_ESC_DCS                ((uint16_t)0x03)        // after ESC P    
-#define TERMINAL_ESCAPE_MATCH_ESC_PM                 ((uint16_t)0x04)        // after ESC ^    
-#define TERMINAL_ESCAPE_MATCH_ESC_APC                ((uint16_t)0x05)        // after ESC _    
-#define TERMINAL_ESCAPE_MATCH_ESC_SS3                ((uint16_t)0x06)        // after ESC O    
-#define TERMINAL_ESCAPE_MATCH_ESC_CSI                ((uint16_t)0x07)        // after ESC [
-#define TERMINAL_ESCAPE_MATCH_ESC_STRING_WAIT_ST     ((uint16_t)0x08)        // expecting ESC '\' terminator
+#define TERMINAL_LINE_ANNOTATION_SIZE       512
+#define TERMINAL_VSCREEN_FPS_DEFAULT        30
+#define TERMINAL_COLLAPSE_HOLD_MS           50          // 可能重复的未完成行在显示前最多暂存的时间
+#define TERMINAL_COLLAPSE_TIMEOUT_DEFAULT   1000
+#define TERMINAL_HEXDUMP_RATE_DEFAULT       1000        // 十六进制显示每秒最多输出的行数
+#define TERMINAL_HEXDUMP_BURST_MS           100         // 超过限速时每隔这么久输出一次最新的行
+#define TERMINAL_PAGER_ROWS_DEFAULT         24          // 不知道终端大小时分页显示的行数
+#define TERMINAL_TIME_STR_SIZE              32          // "[YYYY-mm-dd HH:MM:SS.mmm]"
 
-#define TERMINAL_ESCAPE_CHAR_PARSE_BUF_SIZE 64
-
-static std::ofstream s_log_file;
+static std::FILE *s_log_file = nullptr;
+static std::string s_log_batch;                     // 本次处理要写入日志的数据
+static terminal_log_format_t s_log_format = TERMINAL_LOG_TEXT;
+static int s_log_channel = 0;
+static uint64_t s_log_seq = 0;
+static char s_log_session[17];
 static std::mutex s_mtx;
 static std::condition_variable s_cv;
-static std::queue<std::vector<char>> s_rtt_rx_queue;
+static std::vector<char> s_rtt_rx_pending;        // 等待处理的数据，与线程的处理缓冲区交换使用，容量保留
 static bool s_req_stop = false;
-static uint16_t  s_escape_char_match_state;
-static char s_escape_char_parse_buf[TERMINAL_ESCAPE_CHAR_PARSE_BUF_SIZE];
-static std::string s_escape_char_parse_buf_str;
+static vt_parser_t *s_vt_parser = nullptr;
+static bool s_is_quit_sigint = false;
 static std::vector<char> s_linebuf;
 static uint32_t          s_linebuf_insert_pos = 0;
 static bool              s_is_new_line = true;
 static std::string       s_linebuf_current_time_str;
+static uint64_t          s_linebuf_time_us = 0;
 static std::thread *s_thread = nullptr;
+static std::string       s_display;                 // 本次处理要输出到终端的数据
+static vscreen_t        *s_vscreen = nullptr;
+static int               s_vscreen_rows = 0;
+static int               s_vscreen_cols = 0;
+static bool              s_vscreen_resize = false;
+static std::chrono::steady_clock::duration s_frame_interval;
+static std::chrono::steady_clock::time_point s_next_frame;
+static bool              s_collapse_display = false;
+static bool              s_collapse_log = false;
+static line_collapse_t  *s_display_collapse = nullptr;
+static line_collapse_t  *s_log_collapse = nullptr;
+static std::chrono::steady_clock::duration s_collapse_timeout = std::chrono::milliseconds(TERMINAL_COLLAPSE_TIMEOUT_DEFAULT);
+static bool              s_display_holding = false;         // 当前行是上一行的前缀，显示暂存在 s_display_hold
+static size_t            s_display_hold_pos = 0;            // 当前行在 s_display 中的起始位置
+static std::string       s_display_hold;
+static std::chrono::steady_clock::time_point s_display_hold_deadline;
+static std::chrono::steady_clock::time_point s_display_run_deadline;
+static std::chrono::steady_clock::time_point s_log_run_deadline;
+static bool              s_hexdump = false;                 // 请求的显示模式，受 s_mtx 保护
+static bool              s_hexdump_active = false;          // 线程当前的显示模式
+static bool              s_hexdump_highlight = false;
+static int               s_hexdump_rate = TERMINAL_HEXDUMP_RATE_DEFAULT;
+static uint64_t          s_hex_offset = 0;                  // s_hex_row 在流中的偏移
+static uint8_t           s_hex_row[HEXDUMP_ROW_SIZE];       // 不足一行的数据
+static size_t            s_hex_row_len = 0;
+static bool              s_hex_row_shown = false;           // 不足一行的数据显示在当前行，下次输出前先清除
+static uint8_t           s_hex_prev[HEXDUMP_ROW_SIZE];      // 最近的整行，用于高亮变化的字节
+static bool              s_hex_prev_valid = false;
+static std::vector<uint8_t> s_hex_pending;                  // 因限速还没有显示的最新若干整行
+static uint64_t          s_hex_pending_offset = 0;
+static uint8_t           s_hex_pending_prev[HEXDUMP_ROW_SIZE];  // s_hex_pending 第一行的上一行
+static bool              s_hex_pending_prev_valid = false;
+static uint64_t          s_hex_skipped = 0;                 // 限速丢弃、还没有提示的字节数
+static double            s_hex_budget = 0;                  // 还可以显示的行数
+static std::chrono::steady_clock::time_point s_hex_budget_time;
+static std::chrono::steady_clock::time_point s_hex_flush_deadline;
+static std::string       s_notice;                          // 等待插入显示的提示，受 s_mtx 保护
+static scrollback_t     *s_scrollback = nullptr;
+static size_t            s_scrollback_budget = SCROLLBACK_BUDGET_DEFAULT;   // 0 不保存行历史
+static std::string       s_scrollback_line;                 // 有注释时拼接行内容和注释
+static int               s_term_rows = 0;                   // 终端大小，受 s_mtx 保护
+static int               s_term_cols = 0;
+static bool              s_pager = false;                   // 请求的分页模式，受 s_mtx 保护
+static bool              s_pager_redraw = false;            // 分页显示需要重绘，受 s_mtx 保护
+static std::vector<int>  s_pager_keys;                      // 分页模式的按键，受 s_mtx 保护
+static bool              s_pager_active = false;            // 线程当前是否在分页模式，实时显示暂停
+static int               s_pager_rows = TERMINAL_PAGER_ROWS_DEFAULT;
+static uint64_t          s_pager_top = 0;                   // 页面第一行的行序号
+static uint64_t          s_pager_paused_end = 0;            // 暂停时的行数
+static std::string       s_pager_pattern;                   // 上一次搜索的字符串
+static std::string       s_pager_input;                     // 正在输入的搜索字符串
+static bool              s_pager_inputting = false;
+static bool              s_pager_backward = false;
+static uint64_t          s_pager_origin = 0;                // 增量搜索的起点
+static uint64_t          s_pager_origin_top = 0;            // 取消搜索时恢复的页面位置
+static int64_t           s_pager_match = -1;                // 当前匹配的行
+static std::string       s_pager_message;
+static std::time_t       s_time_cache_sec = -1;             // s_time_cache 对应的秒
+static char              s_time_cache[TERMINAL_TIME_STR_SIZE];  // 时间戳到秒的部分
+static size_t            s_time_cache_len = 0;
+static std::atomic<uint64_t> s_stat_bytes{0};
+static std::atomic<uint64_t> s_stat_lines{0};
+static std::atomic<uint64_t> s_stat_allocs{0};             // 接收到记录路径上的堆分配次数
+static bool              s_status_bar = false;              // 最后一行保留给状态栏
+static std::string       s_status;                          // 状态栏内容，受 s_mtx 保护
+static bool              s_status_update = false;           // 状态栏内容或终端大小改变，受 s_mtx 保护
+static std::string       s_status_text;                     // 线程当前显示的状态栏内容
+static int               s_status_rows = 0;                 // 线程设置滚动区域时的终端大小，0 为还没有设置
+static int               s_status_cols = 0;
+static std::string       s_status_out;
 
 extern "C" {
     static void (*s_quit_signal_callback)(void);
+    static size_t (*s_line_annotator)(const char *line, size_t len, char *out, size_t size);
+    static void (*s_line_callback)(const char *line, size_t len, uint64_t time_us);
+    static void (*s_display_output)(const char *data, size_t len);
+    static void (*s_display_pause)(int paused);
 }
 
-static inline int is_csi_final(uint8_t c){ return c >= 0x40 && c <= 0x7E; }
-static inline int is_middle_byte(uint8_t c){ return c >= 0x20 && c <= 0x2F; }
-static inline int is_param_byte(uint8_t c){ return (c >= '0' && c <= '9') || c == ';' || c == '?' || c == '>' || c == '<'; }
-
-static std::string get_current_time_str() {
+/**
+ * @brief                   格式化为 "[YYYY-mm-dd HH:MM:SS.mmm]"，同一秒内只改写毫秒部分，每行调用不分配内存
+ * @param  buf              至少 TERMINAL_TIME_STR_SIZE 字节
+ * @return size_t           长度
+ */
+static size_t get_current_time_str(std::chrono::system_clock::time_point now, char *buf) {
     using namespace std::chrono;
 
-    // 1. 获取当前时间点
-    auto now = system_clock::now();
-    
-    // 2. 转换为 time_t (秒)
+    // 1. 转换为 time_t (秒)
     auto tt = system_clock::to_time_t(now);
-    auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+    int ms = int(duration_cast<milliseconds>(now.time_since_epoch()).count() % 1000);
 
-    // 3. 转换为本地时间结构体
-    std::tm bt;
+    // 2. 秒变化时才转换为本地时间并格式化
+    if(tt != s_time_cache_sec){
+        std::tm bt;
 #if defined(_MSC_VER) // Windows 环境安全版本
-    localtime_s(&bt, &tt);
+        localtime_s(&bt, &tt);
 #else // Linux/Unix 环境安全版本
-    localtime_r(&tt, &bt);
+        localtime_r(&tt, &bt);
 #endif
+        s_time_cache_len = std::strftime(s_time_cache, sizeof(s_time_cache) - 5, "[%Y-%m-%d %H:%M:%S", &bt);
+        s_time_cache_sec = tt;
+    }
 
-    // 4. 格式化输出
-    std::ostringstream oss;
-    oss << std::put_time(&bt, "[%Y-%m-%d %H:%M:%S");
-    oss << '.' << std::setfill('0') << std::setw(3) << ms.count() << "]";
-    
-    return oss.str();
+    // 3. 追加毫秒
+    size_t len = s_time_cache_len;
+    std::memcpy(buf, s_time_cache, len);
+    buf[len++] = '.';
+    buf[len++] = char('0' + ms / 100);
+    buf[len++] = char('0' + ms / 10 % 10);
+    buf[len++] = char('0' + ms % 10);
+    buf[len++] = ']';
+    return len;
 }
 
 /**
- * @brief                   尝试匹配转义字符
- * @param  input            输入字符
- * @return uint32_t 
+ * @brief                   输出显示的重复统计，当前行暂存时插在当前行之前
  */
-static enum ehshell_escape_char ehshell_escape_char_parse(const char input){
-    if(s_escape_char_match_state != TERMINAL_ESCAPE_MATCH_NONE)
-        s_escape_char_parse_buf_str += input;
-    switch (s_escape_char_match_state){
-        case TERMINAL_ESCAPE_MATCH_NONE:{
-            if(input == 0x1B){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC;
-                s_escape_char_parse_buf[0] = '\0';
-                s_escape_char_parse_buf_str = "\x1B";
-                break;
-            }
-            return (enum ehshell_escape_char)(uint8_t)input;
+static void terminal_display_collapse_summary(void){
+    char summary[LINE_COLLAPSE_SUMMARY_SIZE];
+    size_t summary_len = line_collapse_flush(s_display_collapse, summary, sizeof(summary));
+    if(summary_len == 0)
+        return ;
+    std::string line = std::string("\x1B[2m").append(summary, summary_len).append("\x1B[0m\n");
+    if(s_display_holding){
+        s_display.insert(s_display_hold_pos, line);
+        s_display_hold_pos += line.size();
+    }else{
+        s_display += line;
+    }
+}
+
+/**
+ * @brief                   结束显示的重复统计，并放出暂存的当前行
+ */
+static void terminal_display_collapse_release(void){
+    terminal_display_collapse_summary();
+    if(s_display_holding){
+        s_display.insert(s_display_hold_pos, s_display_hold);
+        s_display_hold.clear();
+        s_display_holding = false;
+    }
+}
+
+/**
+ * @brief                   追加一条日志记录到 s_log_batch，每批数据处理完后一次写入文件
+ */
+static void terminal_log_record(const char *text, size_t len, const char *note, size_t note_len, const char *kind){
+    if(!s_log_file)
+        return ;
+    if(s_log_format == TERMINAL_LOG_JSONL){
+        struct log_jsonl_record rec = {};
+        rec.seq = s_log_seq++;
+        rec.host_us = s_linebuf_time_us;
+        rec.channel = s_log_channel;
+        rec.session = s_log_session;
+        rec.kind = kind;
+        rec.text = text;
+        rec.text_len = len;
+        rec.note = note_len ? note : nullptr;
+        rec.note_len = note_len;
+        if(!kind && !log_jsonl_target_ts(text, len, &rec.target_ts, &rec.target_ts_len))
+            rec.target_ts = nullptr;
+        size_t pos = s_log_batch.size();
+        s_log_batch.resize(pos + log_jsonl_bound(&rec));
+        s_log_batch.resize(pos + log_jsonl_format(&s_log_batch[pos], &rec));
+        return ;
+    }
+    if(!kind)
+        s_log_batch.append(s_linebuf_current_time_str).append(">>>  ");
+    s_log_batch.append(text, len).append(note, note_len).append("\n");
+}
+
+static void terminal_log_write(void){
+    if(s_log_batch.empty())
+        return ;
+    std::fwrite(s_log_batch.data(), 1, s_log_batch.size(), s_log_file);
+    std::fflush(s_log_file);
+    s_log_batch.clear();
+}
+
+static void terminal_log_collapse_flush(void){
+    char summary[LINE_COLLAPSE_SUMMARY_SIZE];
+    size_t summary_len = line_collapse_flush(s_log_collapse, summary, sizeof(summary));
+    if(summary_len)
+        terminal_log_record(summary, summary_len, "", 0, "repeat");
+}
+
+/**
+ * @brief                   重复统计超时或暂存的行等待过久时输出，force 时全部输出
+ */
+static void terminal_display_collapse_poll(bool force){
+    auto now = std::chrono::steady_clock::now();
+    if(s_display_collapse){
+        if(line_collapse_pending(s_display_collapse) && (force || now >= s_display_run_deadline))
+            terminal_display_collapse_summary();
+        if(s_display_holding && (force || now >= s_display_hold_deadline)){
+            /* 已经显示出来的行不能再折叠，重新开始比较 */
+            terminal_display_collapse_release();
+            line_collapse_reset(s_display_collapse);
         }
-        case TERMINAL_ESCAPE_MATCH_ESC:{
-            if(input == '['){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_CSI;
-                break;
-            }else if(input == ']'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_OSC;
-                break;
-            }else if(input == 'P'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_DCS;
-                break;
-            }else if(input == '^'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_PM;
-                break;
-            }else if(input == '_'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_APC;
-                break;
-            }else if(input == 'O'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_SS3;
-                break;
-            }
-            /* 双字节转义字符，目前没有我们想用的，直接忽略返回 */
-            s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
+    }
+    if(s_log_collapse && line_collapse_pending(s_log_collapse) && (force || now >= s_log_run_deadline))
+        terminal_log_collapse_flush();
+}
+
+/**
+ * @brief                   下一次需要检查重复统计超时的时间点，不早于 deadline 时不修改
+ */
+static void terminal_display_collapse_deadline(std::chrono::steady_clock::time_point *deadline){
+    if(s_display_collapse){
+        if(line_collapse_pending(s_display_collapse))
+            *deadline = std::min(*deadline, s_display_run_deadline);
+        if(s_display_holding)
+            *deadline = std::min(*deadline, s_display_hold_deadline);
+    }
+    if(s_log_collapse && line_collapse_pending(s_log_collapse))
+        *deadline = std::min(*deadline, s_log_run_deadline);
+}
+
+static void terminal_display_try_update_timestamp(void){
+    if(s_is_new_line == false)
+        return ;
+    s_is_new_line = false;
+    auto now = std::chrono::system_clock::now();
+    char time_str[TERMINAL_TIME_STR_SIZE];
+    s_linebuf_current_time_str.assign(time_str, get_current_time_str(now, time_str));
+    s_linebuf_time_us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+    /* 新行可能与上一行重复，先暂存显示，确定不重复后再输出 */
+    if(s_display_collapse && line_collapse_is_prefix(s_display_collapse, "", 0)){
+        s_display_holding = true;
+        s_display_hold_pos = s_display.size();
+        s_display_hold_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TERMINAL_COLLAPSE_HOLD_MS);
+    }
+    s_display += s_linebuf_current_time_str;
+    s_display += ">>>  ";
+}
+
+static void terminal_display_print(void *ctx, const char *data, size_t len){
+    (void)ctx;
+    terminal_display_try_update_timestamp();
+    s_display.append(data, len);
+    /* 行buf s_linebuf_insert_pos处覆盖或追加 */
+    size_t overwrite = std::min(len, s_linebuf.size() - s_linebuf_insert_pos);
+    std::copy(data, data + overwrite, s_linebuf.begin() + s_linebuf_insert_pos);
+    s_linebuf.insert(s_linebuf.end(), data + overwrite, data + len);
+    s_linebuf_insert_pos += uint32_t(len);
+    if(s_display_holding && !line_collapse_is_prefix(s_display_collapse, s_linebuf.data(), s_linebuf.size()))
+        terminal_display_collapse_release();
+}
+
+static void terminal_display_execute(void *ctx, uint8_t c){
+    (void)ctx;
+    switch (c) {
+        case ASCII_CTRL_C_SIGINT:
+            s_is_quit_sigint = true;
             break;
-        }
-        case TERMINAL_ESCAPE_MATCH_ESC_OSC:
-        case TERMINAL_ESCAPE_MATCH_ESC_DCS:
-        case TERMINAL_ESCAPE_MATCH_ESC_PM :
-        case TERMINAL_ESCAPE_MATCH_ESC_APC:{
-            if(input == 0x07){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
-                break;
-            }else if(input == 0x1B){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_ESC_STRING_WAIT_ST;
-                break;
+        case ASCII_BACKSPACE:
+            if(s_linebuf_insert_pos > 0){
+                s_linebuf.erase(s_linebuf.begin() + s_linebuf_insert_pos - 1);
+                s_linebuf_insert_pos--;
+                s_display += "\b \b";
             }
-            s_escape_char_parse_buf[0]++;
-            if( (uint32_t)s_escape_char_parse_buf[0] >= TERMINAL_ESCAPE_CHAR_PARSE_BUF_SIZE - 1)
-                goto reset;
-            /* 一个和多个字符序列，直接忽略 */
             break;
-        }
-        case TERMINAL_ESCAPE_MATCH_ESC_SS3:{
-            /* 匹配到任意字符后，直接忽略，正常来说会匹配 0x40..0x7E */
-            if(is_csi_final((uint8_t)input)){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
-                break;
-            }
-            goto reset;
-        }
-        case TERMINAL_ESCAPE_MATCH_ESC_CSI:{
-            if(s_escape_char_parse_buf[0] < TERMINAL_ESCAPE_CHAR_PARSE_BUF_SIZE -1){
-                s_escape_char_parse_buf[s_escape_char_parse_buf[0]+1] = input;
-                s_escape_char_parse_buf[0]++;
-            }else{
-                goto reset;
-            }
-            if(is_csi_final((uint8_t)input)){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
-                /* 开始解析存有的字符 */
-                if(s_escape_char_parse_buf[0] == 2 && s_escape_char_parse_buf[2] == '~'){
-                    switch (s_escape_char_parse_buf[1]) {
-                        case '1':
-                            return ESCAPE_CHAR_CTRL_HOME;
-                        case '3':
-                            return ESCAPE_CHAR_CTRL_DELETE;
-                        case '4':
-                            return ESCAPE_CHAR_CTRL_END;
-                        default:
-                            return ESCAPE_CHAR_CTRL_OTHER;
+        case ASCII_TAB:
+            terminal_display_try_update_timestamp();
+            s_display += "\t";
+            break;
+        case ASCII_LF:{
+            char annotation[TERMINAL_LINE_ANNOTATION_SIZE];
+            size_t annotation_len = 0;
+            bool display_repeat = false;
+            bool log_repeat = false;
+            terminal_display_try_update_timestamp();
+            if(s_line_annotator)
+                annotation_len = s_line_annotator(s_linebuf.data(), s_linebuf.size(), annotation, sizeof(annotation));
+            if(s_line_callback)
+                s_line_callback(s_linebuf.data(), s_linebuf.size(), s_linebuf_time_us);
+            s_stat_lines.fetch_add(1, std::memory_order_relaxed);
+            if(s_display_collapse || s_log_collapse){
+                /* 时间戳去掉方括号后用于重复统计 */
+                char timestamp[TERMINAL_TIME_STR_SIZE];
+                size_t timestamp_len = s_linebuf_current_time_str.size() > 2 ? s_linebuf_current_time_str.size() - 2 : 0;
+                std::memcpy(timestamp, s_linebuf_current_time_str.data() + 1, timestamp_len);
+                timestamp[timestamp_len] = '\0';
+                auto now = std::chrono::steady_clock::now();
+                if(s_display_collapse){
+                    int repeat = line_collapse_push(s_display_collapse, s_linebuf.data(), s_linebuf.size(), timestamp);
+                    if(repeat && !s_display_holding){
+                        /* 暂存超时后已经显示，作为新行重新开始比较 */
+                        line_collapse_reset(s_display_collapse);
+                        repeat = line_collapse_push(s_display_collapse, s_linebuf.data(), s_linebuf.size(), timestamp);
                     }
-                }else if(s_escape_char_parse_buf[0] == 1){
-                    switch (s_escape_char_parse_buf[1]) {
-                        case 'A':
-                            return ESCAPE_CHAR_CTRL_UP;
-                        case 'B':
-                            return ESCAPE_CHAR_CTRL_DOWN;
-                        case 'C':
-                            return ESCAPE_CHAR_CTRL_RIGHT;
-                        case 'D':
-                            return ESCAPE_CHAR_CTRL_LEFT;
-                        case 'F':
-                            return ESCAPE_CHAR_CTRL_END;
-                        case 'H':
-                            return ESCAPE_CHAR_CTRL_HOME;
-                        default:
-                            return ESCAPE_CHAR_CTRL_OTHER;
+                    if(repeat){
+                        s_display.resize(s_display_hold_pos);
+                        s_display_hold.clear();
+                        s_display_holding = false;
+                        display_repeat = true;
+                        if(repeat == 1)
+                            s_display_run_deadline = now + s_collapse_timeout;
+                    }else{
+                        terminal_display_collapse_release();
                     }
                 }
-
-                break;
+                if(s_log_collapse){
+                    int repeat = line_collapse_push(s_log_collapse, s_linebuf.data(), s_linebuf.size(), timestamp);
+                    if(repeat == 1)
+                        s_log_run_deadline = now + s_collapse_timeout;
+                    if(!repeat)
+                        terminal_log_collapse_flush();
+                    log_repeat = repeat > 0;
+                }
+            }
+            if(!display_repeat){
+                if(annotation_len)
+                    s_display.append("\x1B[2m").append(annotation).append("\x1B[0m");
+                s_display += "\n";
+            }
+            if(!log_repeat)
+                terminal_log_record(s_linebuf.data(), s_linebuf.size(), annotation, annotation_len, nullptr);
+            if(s_scrollback && annotation_len){
+                s_scrollback_line.assign(s_linebuf.data(), s_linebuf.size()).append(annotation, annotation_len);
+                scrollback_append(s_scrollback, s_scrollback_line.data(), s_scrollback_line.size(), s_linebuf_time_us);
+            }else if(s_scrollback){
+                scrollback_append(s_scrollback, s_linebuf.data(), s_linebuf.size(), s_linebuf_time_us);
             }
-            if(!is_middle_byte((uint8_t)input) && !is_param_byte((uint8_t)input))
-                goto reset;
+            s_linebuf.clear();
+            s_linebuf_insert_pos = 0;
+            s_is_new_line = true;
             break;
         }
-        case TERMINAL_ESCAPE_MATCH_ESC_STRING_WAIT_ST:{
-            if (input == '\\'){
-                s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
+        case ASCII_CR:
+            s_display.append("\r").append(s_linebuf_current_time_str).append(">>>  ");
+            s_linebuf_insert_pos = 0;
+            break;
+        case ASCII_DEL_LINE:
+            s_display += "\x0e\r";
+            s_linebuf_insert_pos = 0;
+            s_linebuf.clear();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief                   CSI 序列：左右移动同步行buf的插入位置，光标上下/行首/行尾/删除丢弃，其余原样输出
+ */
+static void terminal_display_csi(void *ctx, const struct vt_sequence *seq){
+    (void)ctx;
+    bool plain = seq->private_marker == 0 && seq->intermediate_num == 0;
+    if(plain && seq->param_num == 0){
+        switch (seq->final) {
+            case 'C':
+                if(s_linebuf_insert_pos < s_linebuf.size()){
+                    s_linebuf_insert_pos++;
+                    s_display += "\x1B[C";
+                }
+                return;
+            case 'D':
+                if(s_linebuf_insert_pos > 0){
+                    s_linebuf_insert_pos--;
+                    s_display += "\x1B[D";
+                }
+                return;
+            case 'A':
+            case 'B':
+            case 'F':
+            case 'H':
+                return;
+            default:
                 break;
-            }
-            goto reset;
         }
-    
+    }else if(plain && seq->param_num == 1 && seq->final == '~' &&
+        (seq->params[0] == 1 || seq->params[0] == 3 || seq->params[0] == 4)){
+        return;
     }
-    if(s_escape_char_match_state == TERMINAL_ESCAPE_MATCH_NONE)
-        return ESCAPE_CHAR_CTRL_OTHER;
-    return ESCAPE_CHAR_NUL;
-reset:
-    s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
-    return ESCAPE_CHAR_CTRL_RESET;
+    s_display.append(seq->data, seq->len);
 }
 
+static void terminal_display_sequence(void *ctx, const struct vt_sequence *seq){
+    (void)ctx;
+    s_display.append(seq->data, seq->len);
+}
 
-static void terminal_display_try_update_timestamp(void){
-    if(s_is_new_line == false)
+static const struct vt_parser_callbacks s_vt_callbacks = {
+    terminal_display_print,
+    terminal_display_execute,
+    terminal_display_sequence,
+    terminal_display_csi,
+    terminal_display_sequence,
+};
+
+static size_t terminal_hexdump_burst(void){
+    return std::max<size_t>(1, size_t(s_hexdump_rate) * TERMINAL_HEXDUMP_BURST_MS / 1000);
+}
+
+/**
+ * @brief                   清除当前行显示的不足一行的数据
+ */
+static void terminal_hexdump_clear_row(void){
+    if(s_hex_row_shown){
+        s_display += "\r\x1B[K";
+        s_hex_row_shown = false;
+    }
+}
+
+static void terminal_hexdump_show(uint64_t offset, const uint8_t *row, size_t len, const uint8_t *prev){
+    char line[HEXDUMP_LINE_SIZE_MAX];
+    s_display.append(line, hexdump_format_row(line, offset, row, len, s_hexdump_highlight ? prev : nullptr));
+}
+
+/**
+ * @brief                   显示等待中的整行，之前因限速丢弃的字节数以暗色提示
+ */
+static void terminal_hexdump_show_pending(void){
+    size_t rows = s_hex_pending.size() / HEXDUMP_ROW_SIZE;
+    if(rows == 0)
         return ;
-    s_is_new_line = false;
-    s_linebuf_current_time_str = get_current_time_str();
-    std::cout << s_linebuf_current_time_str << ">>>  ";
+    terminal_hexdump_clear_row();
+    if(s_hex_skipped){
+        s_display.append("\x1B[2m-- ").append(std::to_string(s_hex_skipped)).append(" bytes skipped --\x1B[0m\n");
+        s_hex_skipped = 0;
+    }
+    const uint8_t *prev = s_hex_pending_prev_valid ? s_hex_pending_prev : nullptr;
+    for(size_t i = 0; i < rows; i++){
+        const uint8_t *row = s_hex_pending.data() + i * HEXDUMP_ROW_SIZE;
+        terminal_hexdump_show(s_hex_pending_offset + i * HEXDUMP_ROW_SIZE, row, HEXDUMP_ROW_SIZE, prev);
+        s_display += '\n';
+        prev = row;
+    }
+    s_hex_budget = std::max(0.0, s_hex_budget - double(rows));
+    s_hex_pending.clear();
+}
+
+/**
+ * @brief                   记录一行十六进制数据到日志和行历史
+ */
+static void terminal_hexdump_record(uint64_t offset, const uint8_t *row, size_t len){
+    if(!s_log_file && !s_scrollback)
+        return ;
+    char line[HEXDUMP_LINE_SIZE_MAX];
+    size_t line_len = hexdump_format_row(line, offset, row, len, nullptr);
+    terminal_log_record(line, line_len, "", 0, nullptr);
+    if(s_scrollback)
+        scrollback_append(s_scrollback, line, line_len, s_linebuf_time_us);
+}
+
+/**
+ * @brief                   一个整行：完整记录到日志和行历史，显示则先放入等待队列
+ */
+static void terminal_hexdump_row(const uint8_t *row){
+    terminal_hexdump_record(s_hex_offset, row, HEXDUMP_ROW_SIZE);
+    if(s_hex_pending.empty()){
+        s_hex_pending_offset = s_hex_offset;
+        s_hex_pending_prev_valid = s_hex_prev_valid;
+        std::copy(s_hex_prev, s_hex_prev + HEXDUMP_ROW_SIZE, s_hex_pending_prev);
+    }
+    s_hex_pending.insert(s_hex_pending.end(), row, row + HEXDUMP_ROW_SIZE);
+    std::copy(row, row + HEXDUMP_ROW_SIZE, s_hex_prev);
+    s_hex_prev_valid = true;
+    s_hex_offset += HEXDUMP_ROW_SIZE;
+}
+
+/**
+ * @brief                   十六进制显示，每秒最多显示 s_hexdump_rate 行；超过时只保留最新的一批，
+ *                          每隔 TERMINAL_HEXDUMP_BURST_MS 输出一次，日志中记录全部数据
+ * @param  force            忽略限速，并把不足一行的数据作为最后一行输出
+ */
+static void terminal_hexdump_feed(const uint8_t *data, size_t len, bool force){
+    auto now = std::chrono::steady_clock::now();
+    if((s_log_file || s_scrollback) && len){
+        auto wall = std::chrono::system_clock::now();
+        char time_str[TERMINAL_TIME_STR_SIZE];
+        s_linebuf_current_time_str.assign(time_str, get_current_time_str(wall, time_str));
+        s_linebuf_time_us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(wall.time_since_epoch()).count());
+    }
+    if(s_hex_row_len){
+        size_t fill = std::min(len, HEXDUMP_ROW_SIZE - s_hex_row_len);
+        std::copy(data, data + fill, s_hex_row + s_hex_row_len);
+        s_hex_row_len += fill;
+        data += fill;
+        len -= fill;
+        if(s_hex_row_len == HEXDUMP_ROW_SIZE){
+            terminal_hexdump_row(s_hex_row);
+            s_hex_row_len = 0;
+        }
+    }
+    while(len >= HEXDUMP_ROW_SIZE){
+        terminal_hexdump_row(data);
+        data += HEXDUMP_ROW_SIZE;
+        len -= HEXDUMP_ROW_SIZE;
+    }
+    std::copy(data, data + len, s_hex_row + s_hex_row_len);
+    s_hex_row_len += len;
+
+    /* 等待的行超过一批时丢弃最早的 */
+    size_t burst = terminal_hexdump_burst();
+    size_t rows = s_hex_pending.size() / HEXDUMP_ROW_SIZE;
+    if(rows > burst){
+        size_t drop = (rows - burst) * HEXDUMP_ROW_SIZE;
+        std::copy(s_hex_pending.begin() + long(drop - HEXDUMP_ROW_SIZE), s_hex_pending.begin() + long(drop), s_hex_pending_prev);
+        s_hex_pending_prev_valid = true;
+        s_hex_pending.erase(s_hex_pending.begin(), s_hex_pending.begin() + long(drop));
+        s_hex_pending_offset += drop;
+        s_hex_skipped += drop;
+        rows = burst;
+    }
+    double elapsed = std::chrono::duration<double>(now - s_hex_budget_time).count();
+    s_hex_budget = std::min(double(burst), s_hex_budget + elapsed * s_hexdump_rate);
+    s_hex_budget_time = now;
+    if(force || double(rows) <= s_hex_budget){
+        terminal_hexdump_show_pending();
+    }else{
+        s_hex_flush_deadline = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>((double(rows) - s_hex_budget) / s_hexdump_rate));
+    }
+
+    /* 不足一行的数据显示在最后一行，有等待的行时不显示，避免限速期间反复重绘 */
+    terminal_hexdump_clear_row();
+    if(!s_hex_row_len || !s_hex_pending.empty())
+        return ;
+    terminal_hexdump_show(s_hex_offset, s_hex_row, s_hex_row_len, s_hex_prev_valid ? s_hex_prev : nullptr);
+    if(!force){
+        s_hex_row_shown = true;
+        return ;
+    }
+    s_display += '\n';
+    terminal_hexdump_record(s_hex_offset, s_hex_row, s_hex_row_len);
+    s_hex_offset += s_hex_row_len;
+    s_hex_row_len = 0;
 }
 
-static void terminal_display_record_process_data(std::vector<char>& data)
+/**
+ * @brief                   切换文本/十六进制显示，结束当前的行
+ */
+static void terminal_display_switch_mode(bool hexdump){
+    if(hexdump == s_hexdump_active)
+        return ;
+    if(hexdump){
+        if(!s_is_new_line)
+            terminal_display_execute(nullptr, ASCII_LF);
+        terminal_display_collapse_poll(true);
+        s_hex_budget = double(terminal_hexdump_burst());
+        s_hex_budget_time = std::chrono::steady_clock::now();
+    }else{
+        terminal_hexdump_feed(nullptr, 0, true);
+        vt_parser_reset(s_vt_parser);
+    }
+    s_hexdump_active = hexdump;
+}
+
+/**
+ * @brief                   重新显示未完成的当前行，光标回到插入位置
+ */
+static void terminal_display_redraw_line(std::string &out){
+    out.append(s_linebuf_current_time_str).append(">>>  ").append(s_linebuf.data(), s_linebuf.size());
+    if(s_linebuf_insert_pos < s_linebuf.size())
+        out.append("\x1B[").append(std::to_string(s_linebuf.size() - s_linebuf_insert_pos)).append("D");
+}
+
+/**
+ * @brief                   在行之间插入提示，当前行已经显示一部分时先清除，提示之后重新显示
+ */
+static void terminal_display_notice(const std::string &notice){
+    if(notice.empty())
+        return ;
+    if(s_hexdump_active){
+        /* 不足一行的数据在本批处理中重新显示 */
+        terminal_hexdump_clear_row();
+        s_display.append("\x1B[2m").append(notice).append("\x1B[0m");
+        return ;
+    }
+    if(s_display_holding){
+        /* 暂存的行还没有显示，提示插在它之前 */
+        s_display.append("\x1B[2m").append(notice).append("\x1B[0m");
+        s_display_hold_pos = s_display.size();
+        return ;
+    }
+    if(s_is_new_line){
+        s_display.append("\x1B[2m").append(notice).append("\x1B[0m");
+        return ;
+    }
+    s_display.append("\r\x1B[K\x1B[2m").append(notice).append("\x1B[0m");
+    terminal_display_redraw_line(s_display);
+}
+
+static void terminal_display_record_process_data(std::vector<char>& data, bool hexdump, const std::string &notice)
 {
-    enum ehshell_escape_char ch;
-    bool is_quit_sigint = false;
-    
-    for(auto c : data){
-        ch = ehshell_escape_char_parse(c);
-        if(ch <= 0xFF && (std::isprint(ch) || ch >= ESCAPE_CHAR_CTRL_UTF8_START)){
-            terminal_display_try_update_timestamp();
-            std::cout << char(ch);
-            /* 行buf s_linebuf_insert_pos处插入字符 */
-            if (s_linebuf_insert_pos < s_linebuf.size()) {
-                s_linebuf[s_linebuf_insert_pos] = char(ch);
-            }else{
-                s_linebuf.insert(s_linebuf.begin() + s_linebuf_insert_pos, char(ch));
+    s_is_quit_sigint = false;
+    terminal_display_switch_mode(hexdump);
+    terminal_display_notice(notice);
+    if(s_hexdump_active){
+        /* 二进制数据中的 0x03 不作为退出信号 */
+        terminal_hexdump_feed(reinterpret_cast<const uint8_t*>(data.data()), data.size(), false);
+    }else{
+        vt_parser_feed(s_vt_parser, data.data(), data.size());
+        terminal_display_collapse_poll(false);
+    }
+    terminal_log_write();
+    /* 暂存的行留到下一批数据，本批只输出之前的部分 */
+    if(s_display_holding){
+        s_display_hold.append(s_display, s_display_hold_pos, std::string::npos);
+        s_display.resize(s_display_hold_pos);
+        s_display_hold_pos = 0;
+    }
+    /* 分页时虚拟屏幕照常更新只是不渲染，直接输出的数据丢弃，恢复时从行历史重新显示 */
+    if(s_vscreen){
+        vscreen_write(s_vscreen, s_display.data(), s_display.size());
+    }else if(s_display_output){
+        s_display_output(s_display.data(), s_display.size());
+    }else if(!s_pager_active){
+        std::cout.write(s_display.data(), std::streamsize(s_display.size()));
+        std::cout << std::flush;
+    }
+    s_display.clear();
+    if(s_is_quit_sigint && s_quit_signal_callback)
+        s_quit_signal_callback();
+}
+
+static void terminal_display_out(void *ctx, const char *data, size_t len){
+    (void)ctx;
+    std::cout.write(data, std::streamsize(len));
+    std::cout << std::flush;
+}
+
+static void terminal_display_render(void){
+    {
+        std::unique_lock<std::mutex> lck(s_mtx);
+        if(s_vscreen_resize){
+            vscreen_resize(s_vscreen, s_vscreen_rows, s_vscreen_cols);
+            s_vscreen_resize = false;
+        }
+    }
+    vscreen_render(s_vscreen, terminal_display_out, nullptr);
+    s_next_frame = std::chrono::steady_clock::now() + s_frame_interval;
+}
+
+/**
+ * @brief                   状态栏：滚动区域设为状态栏以上的行，保存和恢复光标，不影响正在显示的内容
+ * @param  region           是否重新设置滚动区域(设置滚动区域会移动光标)
+ */
+static void terminal_status_bar_draw(std::string &out, bool region){
+    if(s_status_rows < 2 || s_status_cols <= 0)
+        return ;
+    out.append("\x1B" "7");
+    if(region)
+        out.append("\x1B[1;").append(std::to_string(s_status_rows - 1)).append("r");
+    out.append("\x1B[").append(std::to_string(s_status_rows)).append(";1H\x1B[0;7m");
+    size_t len = std::min(s_status_text.size(), size_t(s_status_cols));
+    out.append(s_status_text, 0, len).append(size_t(s_status_cols) - len, ' ');
+    out.append("\x1B[0m\x1B" "8");
+}
+
+/**
+ * @brief                   显示新的状态栏内容，终端大小改变时重新设置滚动区域
+ */
+static void terminal_status_bar_update(const std::string &text, int rows, int cols){
+    bool region = rows != s_status_rows;
+    s_status_out.clear();
+    /* 第一次设置时先滚动一行，避免光标在最后一行时被挡住 */
+    if(!s_status_rows && !s_vscreen)
+        s_status_out.append("\n\x1B[1A");
+    s_status_text.assign(text);
+    s_status_rows = rows;
+    s_status_cols = cols;
+    if(s_pager_active)
+        return ;
+    terminal_status_bar_draw(s_status_out, region);
+    std::cout.write(s_status_out.data(), std::streamsize(s_status_out.size()));
+    std::cout << std::flush;
+}
+
+/**
+ * @brief                   退出时清除状态栏并恢复整屏滚动
+ */
+static void terminal_status_bar_clear(void){
+    if(!s_status_rows)
+        return ;
+    std::cout << "\x1B" "7\x1B[r\x1B[" << s_status_rows << ";1H\x1B[2K\x1B" "8" << std::flush;
+    s_status_rows = 0;
+}
+
+static size_t terminal_pager_page(void){
+    return size_t(std::max(1, s_pager_rows - 1));
+}
+
+static void terminal_pager_clamp(void){
+    uint64_t first = scrollback_first(s_scrollback);
+    uint64_t end = scrollback_end(s_scrollback);
+    uint64_t page = terminal_pager_page();
+    s_pager_top = std::min(s_pager_top, end > first + page ? end - page : first);
+    s_pager_top = std::max(s_pager_top, first);
+}
+
+/**
+ * @brief                   行历史中的一行，pattern 的出现位置反色显示
+ */
+static void terminal_pager_line(std::string &out, uint64_t time_us, const char *line, size_t len, const std::string &pattern){
+    auto time = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(time_us)));
+    char time_str[TERMINAL_TIME_STR_SIZE];
+    out.append(time_str, get_current_time_str(time, time_str)).append(">>>  ");
+    const char *end = line + len;
+    while(!pattern.empty()){
+        const char *hit = scrollback_find(line, size_t(end - line), pattern.data(), pattern.size());
+        if(!hit)
+            break;
+        out.append(line, hit).append("\x1B[7m").append(pattern).append("\x1B[27m");
+        line = hit + pattern.size();
+    }
+    out.append(line, end);
+}
+
+/**
+ * @brief                   整页重绘：关闭自动换行，超出宽度的部分由终端截断，最后一行是状态或搜索输入
+ */
+static void terminal_pager_render(void){
+    terminal_pager_clamp();
+    const std::string &pattern = s_pager_inputting ? s_pager_input : s_pager_pattern;
+    uint64_t end = scrollback_end(s_scrollback);
+    size_t page = terminal_pager_page();
+    std::string out;
+    for(size_t r = 0; r < page; r++){
+        const char *line;
+        size_t len;
+        uint64_t time_us;
+        out.append("\x1B[").append(std::to_string(r + 1)).append(";1H\x1B[2K");
+        if(scrollback_get(s_scrollback, s_pager_top + r, &line, &len, &time_us) == 0)
+            terminal_pager_line(out, time_us, line, len, pattern);
+    }
+    out.append("\x1B[").append(std::to_string(s_pager_rows)).append(";1H\x1B[2K");
+    if(s_pager_inputting){
+        out.append(s_pager_backward ? "?" : "/").append(s_pager_input);
+        if(!s_pager_message.empty())
+            out.append("  \x1B[2m").append(s_pager_message).append("\x1B[0m");
+    }else{
+        char status[128];
+        std::snprintf(status, sizeof(status), "-- PAUSED -- lines %llu-%llu of %llu, %llu new", 
+            (unsigned long long)s_pager_top + 1, (unsigned long long)std::min<uint64_t>(s_pager_top + page, end),
+            (unsigned long long)end, (unsigned long long)(end - s_pager_paused_end));
+        out.append("\x1B[7m").append(status);
+        if(!s_pager_message.empty())
+            out.append("  ").append(s_pager_message);
+        out.append("  (q resume, / ? search, n N next)\x1B[0m");
+    }
+    std::cout.write(out.data(), std::streamsize(out.size()));
+    std::cout << std::flush;
+}
+
+/**
+ * @brief                   从 from 开始搜索，到头后从另一端继续，找到时匹配行显示在页面上方三分之一处
+ */
+static void terminal_pager_search(const std::string &pattern, int64_t from, bool backward){
+    int64_t found = from < 0 ? -1 : scrollback_search(s_scrollback, pattern.data(), pattern.size(), uint64_t(from), backward);
+    s_pager_message.clear();
+    if(found < 0){
+        found = scrollback_search(s_scrollback, pattern.data(), pattern.size(), 
+            backward ? scrollback_end(s_scrollback) : scrollback_first(s_scrollback), backward);
+        s_pager_message = found < 0 ? "pattern not found" : "search wrapped";
+        if(found < 0)
+            return ;
+    }
+    s_pager_match = found;
+    uint64_t above = terminal_pager_page() / 3;
+    s_pager_top = uint64_t(found) > above ? uint64_t(found) - above : 0;
+}
+
+static void terminal_pager_open(void){
+    s_pager_active = true;
+    s_pager_paused_end = scrollback_end(s_scrollback);
+    s_pager_top = s_pager_paused_end;
+    s_pager_inputting = false;
+    s_pager_match = -1;
+    s_pager_message.clear();
+    /* 备用屏幕，恢复时终端还原暂停前的内容 */
+    if(s_display_pause)
+        s_display_pause(1);
+    /* 分页使用整个屏幕 */
+    if(s_status_rows)
+        std::cout << "\x1B" "7\x1B[r\x1B" "8";
+    std::cout << "\x1B[?1049h\x1B[?7l\x1B[?25l";
+    terminal_pager_render();
+}
+
+/**
+ * @brief                   退出分页，直接输出时显示暂停期间的最后一页并重新显示当前行，虚拟屏幕则渲染一帧
+ */
+static void terminal_pager_close(void){
+    std::string out = "\x1B[2J\x1B[?7h\x1B[?25h\x1B[?1049l";
+    s_pager_active = false;
+    terminal_status_bar_draw(out, true);
+    if(!s_vscreen && !s_display_output){
+        uint64_t end = scrollback_end(s_scrollback);
+        uint64_t page = terminal_pager_page();
+        uint64_t from = std::max(s_pager_paused_end, scrollback_first(s_scrollback));
+        from = std::max(from, end > page - 1 ? end - (page - 1) : 0);
+        out.append("\r\x1B[K");
+        if(from > s_pager_paused_end){
+            out.append("\x1B[2m-- ").append(std::to_string(from - s_pager_paused_end))
+                .append(" lines received while paused are not shown --\x1B[0m\n");
+        }
+        for(uint64_t i = from; i < end; i++){
+            const char *line;
+            size_t len;
+            uint64_t time_us;
+            if(scrollback_get(s_scrollback, i, &line, &len, &time_us) == 0){
+                terminal_pager_line(out, time_us, line, len, std::string());
+                out += '\n';
             }
-            s_linebuf_insert_pos++;
-            continue;
         }
-        switch (ch) {
-            case ESCAPE_CHAR_CTRL_C_SIGINT:
-                is_quit_sigint = true;
-                continue;
-            case ESCAPE_CHAR_CTRL_BACKSPACE_0:
-                if(s_linebuf_insert_pos > 0){
-                    s_linebuf.erase(s_linebuf.begin() + s_linebuf_insert_pos - 1);
-                    s_linebuf_insert_pos--;
-                    std::cout << "\b \b";
-                }
-                continue;
-            case ESCAPE_CHAR_CTRL_TAB:
-                terminal_display_try_update_timestamp();
-                std::cout << "\t";
-                continue;
-            case ESCAPE_CHAR_CTRL_J_LF:
-                terminal_display_try_update_timestamp();
-                std::cout << "\n";
-                s_linebuf.push_back('\0');
-                s_log_file << s_linebuf_current_time_str << ">>>  " << (const char*)s_linebuf.data() << "\n" << std::flush;
-                s_linebuf.clear();
-                s_linebuf_insert_pos = 0;
-                s_is_new_line = true;
-                continue;
-            case ESCAPE_CHAR_CTRL_M_CR:
-                std::cout << "\r" << s_linebuf_current_time_str << ">>>  ";
-                s_linebuf_insert_pos = 0;
-                continue;
-            case ESCAPE_CHAR_CTRL_U_DEL_LINE:
-                std::cout << "\x0e\r";
-                s_linebuf_insert_pos = 0;
-                s_linebuf.clear();
-                continue;
-            case ESCAPE_CHAR_CTRL_LEFT:
-                if(s_linebuf_insert_pos > 0){
-                    s_linebuf_insert_pos--;
-                    std::cout << "\x1B[D";
-                }
-                continue;
-            case ESCAPE_CHAR_CTRL_RIGHT:
-                if(s_linebuf_insert_pos < s_linebuf.size()){
-                    s_linebuf_insert_pos++;
-                    std::cout << "\x1B[C";
-                }
-                continue;
-            case ESCAPE_CHAR_CTRL_OTHER:
-                std::cout << s_escape_char_parse_buf_str;
-                continue;
+        /* 暂存的行会在确定不重复后整行输出 */
+        if(!s_hexdump_active && !s_is_new_line && !s_display_holding)
+            terminal_display_redraw_line(out);
+        s_hex_row_shown = false;
+    }
+    std::cout.write(out.data(), std::streamsize(out.size()));
+    std::cout << std::flush;
+    if(s_vscreen)
+        terminal_display_render();
+    if(s_display_pause)
+        s_display_pause(0);
+}
+
+/**
+ * @brief                   分页模式的按键：less 风格的移动和搜索，输入搜索字符串时每次修改都从起点重新搜索
+ * @return bool             按键退出了分页模式
+ */
+static bool terminal_pager_key(int key){
+    uint64_t page = terminal_pager_page();
+    if(s_pager_inputting){
+        switch (key) {
+            case TERMINAL_PAGER_KEY_ENTER:
+                s_pager_inputting = false;
+                if(!s_pager_input.empty())
+                    s_pager_pattern = s_pager_input;
+                return false;
+            case TERMINAL_PAGER_KEY_ESC:
+                s_pager_inputting = false;
+                s_pager_top = s_pager_origin_top;
+                s_pager_message.clear();
+                return false;
+            case TERMINAL_PAGER_KEY_BACKSPACE:
+                if(!s_pager_input.empty())
+                    s_pager_input.pop_back();
+                break;
             default:
-                continue;
+                if(key < 0x20 || key > 0x7e)
+                    return false;
+                s_pager_input += char(key);
+                break;
         }
+        s_pager_match = -1;
+        s_pager_message.clear();
+        s_pager_top = s_pager_origin_top;
+        if(!s_pager_input.empty())
+            terminal_pager_search(s_pager_input, int64_t(s_pager_origin), s_pager_backward);
+        return false;
     }
-    std::cout << std::flush;
-    if(is_quit_sigint && s_quit_signal_callback)
-        s_quit_signal_callback();
+    s_pager_message.clear();
+    switch (key) {
+        case TERMINAL_PAGER_KEY_UP:
+        case 'k':
+            s_pager_top = s_pager_top > 0 ? s_pager_top - 1 : 0;
+            break;
+        case TERMINAL_PAGER_KEY_DOWN:
+        case TERMINAL_PAGER_KEY_ENTER:
+        case 'j':
+            s_pager_top++;
+            break;
+        case TERMINAL_PAGER_KEY_PAGE_UP:
+        case 'b':
+            s_pager_top = s_pager_top > page ? s_pager_top - page : 0;
+            break;
+        case TERMINAL_PAGER_KEY_PAGE_DOWN:
+        case ' ':
+        case 'f':
+            s_pager_top += page;
+            break;
+        case TERMINAL_PAGER_KEY_HOME:
+        case 'g':
+            s_pager_top = 0;
+            break;
+        case TERMINAL_PAGER_KEY_END:
+        case 'G':
+            s_pager_top = scrollback_end(s_scrollback);
+            break;
+        case '/':
+        case '?':
+            s_pager_inputting = true;
+            s_pager_input.clear();
+            s_pager_backward = key == '?';
+            s_pager_origin_top = s_pager_top;
+            s_pager_origin = s_pager_backward ? s_pager_top + page - 1 : s_pager_top;
+            break;
+        case 'n':
+        case 'N':{
+            if(s_pager_pattern.empty())
+                break;
+            bool backward = s_pager_backward != (key == 'N');
+            int64_t from = int64_t(backward ? s_pager_top + page - 1 : s_pager_top);
+            if(s_pager_match >= 0)
+                from = backward ? s_pager_match - 1 : s_pager_match + 1;
+            terminal_pager_search(s_pager_pattern, from, backward);
+            break;
+        }
+        case 'q':
+        case TERMINAL_PAGER_KEY_ESC:
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+/**
+ * @brief                   进入、退出分页模式并处理按键
+ */
+static void terminal_pager_process(bool pager, const std::vector<int> &keys, bool redraw){
+    if(pager && !s_pager_active){
+        terminal_pager_open();
+        redraw = false;
+    }
+    for(int key : keys){
+        if(!pager || !s_pager_active)
+            break;
+        if(terminal_pager_key(key)){
+            std::unique_lock<std::mutex> lck(s_mtx);
+            s_pager = false;
+            pager = false;
+        }
+        redraw = true;
+    }
+    if(!pager && s_pager_active)
+        terminal_pager_close();
+    else if(redraw && s_pager_active)
+        terminal_pager_render();
 }
 
 static void terminal_display_record_thread(void)
 {
     std::vector<char> data;
+    std::string notice;
+    std::vector<int> pager_keys;
+    bool hexdump = false;
+    bool pager = false;
+    bool pager_redraw = false;
+    std::string status;
+    bool status_update = false;
+    int status_rows = 0;
+    int status_cols = 0;
     while(true){
         while(true){
             std::unique_lock<std::mutex> lck(s_mtx);
+            if(s_status_update){
+                status.assign(s_status);
+                status_rows = s_term_rows;
+                status_cols = s_term_cols;
+                status_update = true;
+                s_status_update = false;
+            }
+            hexdump = s_hexdump;
+            pager = s_pager;
+            pager_keys.swap(s_pager_keys);
+            pager_redraw = s_pager_redraw;
+            s_pager_redraw = false;
+            if(s_term_rows > 0)
+                s_pager_rows = s_term_rows;
 
-            if(!s_rtt_rx_queue.empty()){
-                /* 合并queue里面的多个数据包到data */
-                while(!s_rtt_rx_queue.empty()){
-                    data.insert(data.end(), s_rtt_rx_queue.front().begin(), s_rtt_rx_queue.front().end());
-                    s_rtt_rx_queue.pop();
-                }
+            if(!s_rtt_rx_pending.empty()){
+                /* 取走积累的全部数据，两个缓冲区交替使用，稳定后不再分配 */
+                data.swap(s_rtt_rx_pending);
                 goto process_data;
             }
 
             if(s_req_stop)
                 goto stop;
+            if(hexdump != s_hexdump_active)
+                goto process_data;
+            if(!s_notice.empty()){
+                notice.swap(s_notice);
+                goto process_data;
+            }
+            if(pager != s_pager_active || !pager_keys.empty() || pager_redraw || status_update)
+                goto process_data;
 
+            /* 虚拟屏幕有变化时最迟在下一帧的时间点渲染，终端大小改变时立即重绘，分页时不渲染 */
+            if(s_vscreen_resize && !s_pager_active)
+                goto render;
+            auto wake = std::chrono::steady_clock::time_point::max();
+            if(s_vscreen && vscreen_dirty(s_vscreen) && !s_pager_active)
+                wake = s_next_frame;
+            terminal_display_collapse_deadline(&wake);
+            if(s_hexdump_active && !s_hex_pending.empty())
+                wake = std::min(wake, s_hex_flush_deadline);
+            if(wake != std::chrono::steady_clock::time_point::max()){
+                /* 超时后以空数据处理一次，输出到期的重复统计并渲染 */
+                if(s_cv.wait_until(lck, wake) == std::cv_status::timeout)
+                    goto process_data;
+                continue;
+            }
             s_cv.wait(lck);
         }
     process_data:
-        terminal_display_record_process_data(data);
+    {
+        uint64_t allocs = alloc_stats_thread();
+        terminal_display_record_process_data(data, hexdump, notice);
+        s_stat_allocs.fetch_add(alloc_stats_thread() - allocs, std::memory_order_relaxed);
+        s_stat_bytes.fetch_add(data.size(), std::memory_order_relaxed);
+    }
+        terminal_pager_process(pager, pager_keys, pager_redraw);
+        if(status_update){
+            terminal_status_bar_update(status, status_rows, status_cols);
+            status_update = false;
+        }
         data.clear();
+        notice.clear();
+        pager_keys.clear();
+        if(!s_vscreen || s_pager_active || std::chrono::steady_clock::now() < s_next_frame)
+            continue;
+    render:
+        terminal_display_render();
     }
 stop:
+    if(s_pager_active)
+        terminal_pager_close();
+    if(s_hexdump_active)
+        terminal_hexdump_feed(nullptr, 0, true);
+    terminal_display_collapse_poll(true);
+    terminal_log_write();
+    if(!s_display.empty()){
+        if(s_vscreen){
+            vscreen_write(s_vscreen, s_display.data(), s_display.size());
+        }else if(s_display_output){
+            s_display_output(s_display.data(), s_display.size());
+        }else{
+            std::cout.write(s_display.data(), std::streamsize(s_display.size()));
+            std::cout << std::flush;
+        }
+        s_display.clear();
+    }
+    if(s_vscreen && vscreen_dirty(s_vscreen))
+        terminal_display_render();
+    terminal_status_bar_clear();
     return ;
 }
 
@@ -365,21 +1119,58 @@ int terminal_display_record_start(const char* log_file_path)
 {
     if(log_file_path){
         /* 检查路径是否存在，不存在则创建，存在就正常打开并追加写入 */
-        s_log_file = std::ofstream(log_file_path, std::ios::out | std::ios::app);
-        if(!s_log_file.is_open()){
+        s_log_file = std::fopen(log_file_path, "ab");
+        if(!s_log_file){
             std::printf("open log file %s failed\n", log_file_path);
             return -1;
         }
+        /* 会话 ID 区分同一日志文件中的多次连接 */
+        std::random_device rd;
+        uint64_t session = (uint64_t(rd()) << 32) ^ rd() ^ uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+        std::snprintf(s_log_session, sizeof(s_log_session), "%016llx", (unsigned long long)session);
+        s_log_seq = 0;
     }
-    s_rtt_rx_queue = std::queue<std::vector<char>>();
+    s_log_batch.clear();
+    s_rtt_rx_pending.clear();
     s_req_stop = false;
-    s_escape_char_match_state = TERMINAL_ESCAPE_MATCH_NONE;
-    s_escape_char_parse_buf[0] = '\0';
-    s_escape_char_parse_buf_str = "";
+    if(!s_vt_parser)
+        s_vt_parser = vt_parser_create(&s_vt_callbacks, nullptr);
+    vt_parser_reset(s_vt_parser);
     s_linebuf.clear();
     s_linebuf_insert_pos = 0;
     s_is_new_line = true;
     s_linebuf_current_time_str = "";
+    s_display.clear();
+    s_display_holding = false;
+    s_display_hold.clear();
+    s_hexdump_active = false;
+    s_hex_offset = 0;
+    s_hex_row_len = 0;
+    s_hex_row_shown = false;
+    s_hex_prev_valid = false;
+    s_hex_pending.clear();
+    s_hex_skipped = 0;
+    if(s_collapse_display)
+        s_display_collapse = line_collapse_create();
+    if(s_collapse_log && s_log_file)
+        s_log_collapse = line_collapse_create();
+    if(s_scrollback_budget)
+        s_scrollback = scrollback_create(s_scrollback_budget);
+    s_pager = false;
+    s_pager_active = false;
+    s_pager_keys.clear();
+    /* 状态栏不能与 terminal_display_record_set_output 同时使用 */
+    if(s_display_output)
+        s_status_bar = false;
+    s_status_rows = 0;
+    s_status_update = false;
+    if(s_vscreen_rows > 0 && s_vscreen_cols > 0){
+        if(s_status_bar)
+            s_vscreen_rows = std::max(1, s_vscreen_rows - 1);
+        s_vscreen = vscreen_create(s_vscreen_rows, s_vscreen_cols);
+        s_vscreen_resize = false;
+        s_next_frame = std::chrono::steady_clock::now();
+    }
     s_thread = new std::thread(terminal_display_record_thread);
 
     return 0;
@@ -394,8 +1185,31 @@ void terminal_display_record_stop()
         delete s_thread;
         s_thread = nullptr;
     }
-    if(s_log_file.is_open()){
-        s_log_file.close();
+    if(s_vt_parser){
+        if(vt_parser_invalid_bytes(s_vt_parser))
+            std::printf("%llu invalid UTF-8 bytes were shown as U+FFFD\n", (unsigned long long)vt_parser_invalid_bytes(s_vt_parser));
+        vt_parser_destroy(s_vt_parser);
+        s_vt_parser = nullptr;
+    }
+    if(s_vscreen){
+        vscreen_destroy(s_vscreen);
+        s_vscreen = nullptr;
+    }
+    if(s_display_collapse){
+        line_collapse_destroy(s_display_collapse);
+        s_display_collapse = nullptr;
+    }
+    if(s_log_collapse){
+        line_collapse_destroy(s_log_collapse);
+        s_log_collapse = nullptr;
+    }
+    if(s_scrollback){
+        scrollback_destroy(s_scrollback);
+        s_scrollback = nullptr;
+    }
+    if(s_log_file){
+        std::fclose(s_log_file);
+        s_log_file = nullptr;
     }
 }
 
@@ -405,7 +1219,9 @@ void terminal_display_record_write(const char* data, size_t size){
         return;
     }
     std::unique_lock<std::mutex> lck(s_mtx);
-    s_rtt_rx_queue.push(std::vector<char>(data, data + size));
+    uint64_t allocs = alloc_stats_thread();
+    s_rtt_rx_pending.insert(s_rtt_rx_pending.end(), data, data + size);
+    s_stat_allocs.fetch_add(alloc_stats_thread() - allocs, std::memory_order_relaxed);
     s_cv.notify_one();
 }
 
@@ -415,5 +1231,139 @@ void terminal_display_record_quit_signal_set_callback(void (*callback)(void))
     s_quit_signal_callback = callback;
 }
 
+void terminal_display_record_set_line_annotator(size_t (*annotator)(const char *line, size_t len, char *out, size_t size))
+{
+    s_line_annotator = annotator;
+}
+
+void terminal_display_record_set_line_callback(void (*callback)(const char *line, size_t len, uint64_t time_us))
+{
+    s_line_callback = callback;
+}
+
+void terminal_display_record_notice(const char *text, size_t len)
+{
+    if(!text || len == 0)
+        return;
+    std::unique_lock<std::mutex> lck(s_mtx);
+    s_notice.append(text, len);
+    s_cv.notify_one();
+}
+
+void terminal_display_record_set_vscreen(int rows, int cols, int fps)
+{
+    s_vscreen_rows = rows;
+    s_vscreen_cols = cols;
+    if(fps <= 0)
+        fps = TERMINAL_VSCREEN_FPS_DEFAULT;
+    s_frame_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / fps;
+}
+
+void terminal_display_record_get_stats(struct terminal_display_stats *stats)
+{
+    stats->bytes = s_stat_bytes.load(std::memory_order_relaxed);
+    stats->lines = s_stat_lines.load(std::memory_order_relaxed);
+    stats->allocations = s_stat_allocs.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lck(s_mtx);
+    stats->backlog = s_rtt_rx_pending.size();
+}
+
+void terminal_display_record_set_output(void (*output)(const char *data, size_t len), void (*pause)(int paused))
+{
+    s_display_output = output;
+    s_display_pause = pause;
+}
+
+void terminal_display_record_set_collapse(int display, int log, int timeout_ms)
+{
+    s_collapse_display = display != 0;
+    s_collapse_log = log != 0;
+    if(timeout_ms <= 0)
+        timeout_ms = TERMINAL_COLLAPSE_TIMEOUT_DEFAULT;
+    s_collapse_timeout = std::chrono::milliseconds(timeout_ms);
+}
+
+void terminal_display_record_set_log_format(terminal_log_format_t format, int channel)
+{
+    s_log_format = format;
+    s_log_channel = channel;
+}
+
+void terminal_display_record_set_hexdump(int enable, int highlight, int rate)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    s_hexdump = enable != 0;
+    s_hexdump_highlight = highlight != 0;
+    s_hexdump_rate = rate > 0 ? rate : TERMINAL_HEXDUMP_RATE_DEFAULT;
+    s_cv.notify_one();
+}
+
+void terminal_display_record_toggle_hexdump(void)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    s_hexdump = !s_hexdump;
+    s_cv.notify_one();
+}
+
+void terminal_display_record_resize(int rows, int cols)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(rows <= 0 || cols <= 0)
+        return;
+    s_term_rows = rows;
+    s_term_cols = cols;
+    s_pager_redraw = s_pager;
+    if(s_vscreen){
+        s_vscreen_rows = s_status_bar ? std::max(1, rows - 1) : rows;
+        s_vscreen_cols = cols;
+        s_vscreen_resize = true;
+    }
+    s_status_update = s_status_bar && !s_status.empty();
+    s_cv.notify_one();
+}
+
+void terminal_display_record_set_status_bar(int enable)
+{
+    s_status_bar = enable != 0;
+}
+
+void terminal_display_record_set_status(const char *text, size_t len)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(!s_status_bar || s_term_rows < 2)
+        return;
+    s_status.assign(text, len);
+    s_status_update = true;
+    s_cv.notify_one();
+}
+
+void terminal_display_record_set_scrollback(size_t budget)
+{
+    s_scrollback_budget = budget;
+}
+
+void terminal_display_record_toggle_pager(void)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(!s_scrollback)
+        return;
+    s_pager = !s_pager;
+    s_cv.notify_one();
+}
+
+int terminal_display_record_pager_active(void)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    return s_pager ? 1 : 0;
+}
 
-}
\ No newline at end of file
+void terminal_display_record_pager_key(int key)
+{
+    std::unique_lock<std::mutex> lck(s_mtx);
+    if(!s_pager)
+        return;
+    s_pager_keys.push_back(key);
+    s_cv.notify_one();
+}
+
+}
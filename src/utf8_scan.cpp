@@ -0,0 +1,254 @@
+/**
+ * @file utf8_scan.cpp
+ * @brief 可显示文本段的扫描与 UTF-8 校验
+ *        SSE2 每次检查 16 字节中是否有控制字符，纯 ASCII 块直接跳过；
+ *        运行的 CPU 支持 SSSE3 时，含多字节字符的块用查表法(Keiser & Lemire)校验，否则交给逐字符校验
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF8_SCAN_USE_SSE2 1
+#endif
+
+/* SSSE3 部分单独按 SSSE3 编译，运行时检查 CPU 后才使用，其余代码只需要 SSE2 */
+#if defined(UTF8_SCAN_USE_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#include <tmmintrin.h>
+#define UTF8_SCAN_USE_SSSE3 1
+#if defined(__GNUC__) && !defined(__SSSE3__)
+#define UTF8_SCAN_SSSE3 __attribute__((target("ssse3")))
+#else
+#define UTF8_SCAN_SSSE3
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "utf8_scan.h"
+
+#ifdef UTF8_SCAN_USE_SSSE3
+
+/* 错误类型，每个字节对(前一字节, 当前字节)按三张表查出的位相与，非0即为错误 */
+#define UTF8_TOO_SHORT              (1 << 0)    // 多字节字符缺少后续字节
+#define UTF8_TOO_LONG               (1 << 1)    // ASCII 之后出现后续字节
+#define UTF8_OVERLONG_3             (1 << 2)
+#define UTF8_TOO_LARGE              (1 << 3)
+#define UTF8_SURROGATE              (1 << 4)
+#define UTF8_OVERLONG_2             (1 << 5)
+#define UTF8_TOO_LARGE_1000         (1 << 6)
+#define UTF8_OVERLONG_4             (1 << 6)
+#define UTF8_TWO_CONTS              (1 << 7)    // 连续两个后续字节，3/4 字节字符中是合法的
+#define UTF8_CARRY                  (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static bool utf8_cpu_has_ssse3(void){
+#if defined(__SSSE3__) || defined(__AVX__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] >> 9) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static const bool s_has_ssse3 = utf8_cpu_has_ssse3();
+
+UTF8_SCAN_SSSE3 static inline __m128i utf8_high_nibble(__m128i v){
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+}
+
+UTF8_SCAN_SSSE3 static inline __m128i utf8_check_block(__m128i input, __m128i prev_input){
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        char(UTF8_TWO_CONTS), char(UTF8_TWO_CONTS), char(UTF8_TWO_CONTS), char(UTF8_TWO_CONTS),
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        char(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+        char(UTF8_CARRY | UTF8_OVERLONG_2),
+        char(UTF8_CARRY),
+        char(UTF8_CARRY),
+        char(UTF8_CARRY | UTF8_TOO_LARGE),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        char(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000));
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        char(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+        char(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+        char(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+        char(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    __m128i special_cases = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte_1_high_table, utf8_high_nibble(prev1)),
+            _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0f)))),
+        _mm_shuffle_epi8(byte_2_high_table, utf8_high_nibble(input)));
+
+    /* 3/4 字节字符的第3、4个字节必须是后续字节，与 TWO_CONTS 抵消 */
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xe0 - 0x80)));
+    __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xf0 - 0x80)));
+    __m128i must23_80 = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(char(0x80)));
+    return _mm_xor_si128(must23_80, special_cases);
+}
+
+/**
+ * @brief                   块结尾是否有不完整的多字节字符
+ */
+UTF8_SCAN_SSSE3 static inline __m128i utf8_block_incomplete(__m128i input){
+    const __m128i max_value = _mm_setr_epi8(
+        char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff),
+        char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xf0 - 1), char(0xe0 - 1), char(0xc0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+#endif
+
+#ifdef UTF8_SCAN_USE_SSE2
+static inline bool utf8_any(__m128i v){
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xffff;
+}
+
+static inline bool utf8_block_has_ctrl(__m128i v){
+    const __m128i ctrl_max = _mm_set1_epi8(0x1f);
+    __m128i ctrl = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, ctrl_max), ctrl_max), _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+    return _mm_movemask_epi8(ctrl) != 0;
+}
+
+/**
+ * @brief                   只跳过纯 ASCII 块
+ */
+static const uint8_t *utf8_scan_sse2(const uint8_t *p, const uint8_t *end){
+    while(end - p >= UTF8_SCAN_BLOCK_SIZE){
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if(utf8_block_has_ctrl(v) || _mm_movemask_epi8(v) != 0)
+            break;
+        p += UTF8_SCAN_BLOCK_SIZE;
+    }
+    return p;
+}
+#endif
+
+#ifdef UTF8_SCAN_USE_SSSE3
+/**
+ * @brief                   跳过纯 ASCII 块和校验通过的多字节字符块
+ */
+UTF8_SCAN_SSSE3 static const uint8_t *utf8_scan_ssse3(const uint8_t *p, const uint8_t *end){
+    __m128i prev = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+
+    while(end - p >= UTF8_SCAN_BLOCK_SIZE){
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if(utf8_block_has_ctrl(v))
+            break;
+        if(_mm_movemask_epi8(v) == 0){
+            /* 上一块结尾的字符没有后续字节 */
+            if(utf8_any(prev_incomplete))
+                break;
+            prev = v;
+            p += UTF8_SCAN_BLOCK_SIZE;
+            continue;
+        }
+        if(utf8_any(utf8_check_block(v, prev)))
+            break;
+        prev_incomplete = utf8_block_incomplete(v);
+        prev = v;
+        p += UTF8_SCAN_BLOCK_SIZE;
+    }
+    return p;
+}
+#endif
+
+extern "C"{
+
+size_t utf8_scan_text(const char *data, size_t len){
+    const uint8_t *start = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t *p = start;
+#ifdef UTF8_SCAN_USE_SSE2
+#ifdef UTF8_SCAN_USE_SSSE3
+    if(s_has_ssse3){
+        p = utf8_scan_ssse3(p, start + len);
+    }else{
+        p = utf8_scan_sse2(p, start + len);
+    }
+#else
+    p = utf8_scan_sse2(p, start + len);
+#endif
+
+    /* 回退到最后一个多字节字符的起始位置，跨块或未校验完的字符交给逐字符校验 */
+    while(p > start && (p[-1] & 0xc0) == 0x80)
+        p--;
+    if(p > start && p[-1] >= 0xc0)
+        p--;
+#else
+    (void)len;
+#endif
+    return size_t(p - start);
+}
+
+int utf8_sequence_check(const char *data, size_t len){
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+    uint8_t lo = 0x80;
+    uint8_t hi = 0xbf;
+    int need;
+
+    if(p[0] < 0x80)
+        return 1;
+    if(p[0] < 0xc2)
+        return -1;
+    if(p[0] < 0xe0){
+        need = 2;
+    }else if(p[0] < 0xf0){
+        need = 3;
+        if(p[0] == 0xe0){
+            lo = 0xa0;
+        }else if(p[0] == 0xed){
+            hi = 0x9f;
+        }
+    }else if(p[0] < 0xf5){
+        need = 4;
+        if(p[0] == 0xf0){
+            lo = 0x90;
+        }else if(p[0] == 0xf4){
+            hi = 0x8f;
+        }
+    }else{
+        return -1;
+    }
+
+    for(int i = 1; i < need; i++){
+        if(size_t(i) >= len)
+            return 0;
+        if(p[i] < lo || p[i] > hi)
+            return -i;
+        lo = 0x80;
+        hi = 0xbf;
+    }
+    return need;
+}
+
+}
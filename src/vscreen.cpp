@@ -0,0 +1,826 @@
+/**
+ * @file vscreen.cpp
+ * @brief 虚拟屏幕：在内存中维护终端单元格，按帧输出与上一帧的差异
+ *        back 为解析器写入的屏幕，front 为主机终端上已经显示的内容，渲染时只输出两者不同的单元格，
+ *        两帧之间被覆盖的中间画面不会输出到主机终端
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "vt_parser.h"
+#include "vscreen.h"
+
+#define VSCREEN_ATTR_BOLD           0x01
+#define VSCREEN_ATTR_DIM            0x02
+#define VSCREEN_ATTR_ITALIC         0x04
+#define VSCREEN_ATTR_UNDERLINE      0x08
+#define VSCREEN_ATTR_BLINK          0x10
+#define VSCREEN_ATTR_REVERSE        0x20
+#define VSCREEN_ATTR_HIDDEN         0x40
+#define VSCREEN_ATTR_STRIKE         0x80
+
+#define VSCREEN_COLOR_DEFAULT       0x00000000
+#define VSCREEN_COLOR_INDEX         0x01000000  // 低8位为 256 色索引
+#define VSCREEN_COLOR_RGB           0x02000000  // 低24位为 RGB
+
+#define VSCREEN_CELL_INVALID        0xff        // front 中内容未知的单元格，与任何单元格都不同
+#define VSCREEN_TAB_WIDTH           8
+#define VSCREEN_SPAN_GAP            8           // 行内连续相同的单元格超过该数量时分段输出
+
+struct vscreen_attr{
+    uint8_t flags;
+    uint32_t fg;
+    uint32_t bg;
+
+    bool operator==(const vscreen_attr &other) const {
+        return flags == other.flags && fg == other.fg && bg == other.bg;
+    }
+    bool operator!=(const vscreen_attr &other) const {
+        return !(*this == other);
+    }
+};
+
+struct vscreen_cell{
+    char ch[4];                         // 字符的 UTF-8 编码
+    uint8_t len;
+    uint8_t width;                      // 1 或 2，宽字符的第二列为0
+    struct vscreen_attr attr;
+
+    bool operator==(const vscreen_cell &other) const {
+        return len == other.len && width == other.width && attr == other.attr && std::memcmp(ch, other.ch, len) == 0;
+    }
+    bool operator!=(const vscreen_cell &other) const {
+        return !(*this == other);
+    }
+};
+
+struct vscreen{
+    int rows;
+    int cols;
+    int origin_row;                     // 固定区域在主机屏幕上的起始行(从1开始)，0 为跟随光标的区域
+    int origin_col;
+    std::vector<vscreen_cell> back;
+    std::vector<vscreen_cell> front;
+    int used_rows;                      // back 中从区域顶部开始使用的行数
+    int front_rows;                     // 主机终端上区域已有的行数
+    int front_cur_row;                  // 主机终端光标所在的区域行
+    int cur_row;
+    int cur_col;
+    bool wrap_pending;                  // 写到最后一列后，下一个字符才换行
+    int saved_row;
+    int saved_col;
+    struct vscreen_attr attr;
+    struct vscreen_attr saved_attr;
+    bool cursor_visible;
+    bool dirty;
+    std::string committed;              // 上一帧之后滚出区域顶部的行，每行带擦除和换行，清空时保留容量
+    size_t committed_lines;
+    std::string passthrough;            // 无法在单元格中表示的序列(标题、模式等)，下一帧原样输出
+    std::string render_buf;
+    char utf8[4];
+    uint8_t utf8_len;
+    uint8_t utf8_need;
+    vt_parser_t *parser;
+};
+
+struct vscreen_range{
+    uint32_t first;
+    uint32_t last;
+};
+
+/* 零宽字符(组合符号、零宽空格、变体选择符) */
+static const vscreen_range s_zero_width[] = {
+    {0x0300, 0x036f}, {0x200b, 0x200f}, {0xfe00, 0xfe0f},
+};
+
+/* 东亚宽字符与常用 emoji */
+static const vscreen_range s_wide[] = {
+    {0x1100, 0x115f}, {0x2e80, 0x303e}, {0x3041, 0x33ff}, {0x3400, 0x4dbf}, {0x4e00, 0x9fff},
+    {0xa000, 0xa4cf}, {0xac00, 0xd7a3}, {0xf900, 0xfaff}, {0xfe30, 0xfe4f}, {0xff00, 0xff60},
+    {0xffe0, 0xffe6}, {0x1f300, 0x1f64f}, {0x1f900, 0x1f9ff}, {0x20000, 0x3fffd},
+};
+
+static bool vscreen_in_ranges(const vscreen_range *ranges, size_t num, uint32_t cp){
+    for(size_t i = 0; i < num; i++){
+        if(cp >= ranges[i].first && cp <= ranges[i].last)
+            return true;
+    }
+    return false;
+}
+
+static int vscreen_char_width(uint32_t cp){
+    if(cp < 0x300)
+        return 1;
+    if(vscreen_in_ranges(s_zero_width, sizeof(s_zero_width) / sizeof(s_zero_width[0]), cp))
+        return 0;
+    if(vscreen_in_ranges(s_wide, sizeof(s_wide) / sizeof(s_wide[0]), cp))
+        return 2;
+    return 1;
+}
+
+static vscreen_cell vscreen_blank(const vscreen_attr &attr){
+    vscreen_cell cell = {};
+    cell.ch[0] = ' ';
+    cell.len = 1;
+    cell.width = 1;
+    cell.attr.bg = attr.bg;
+    return cell;
+}
+
+static vscreen_cell vscreen_invalid(void){
+    vscreen_cell cell = {};
+    cell.width = VSCREEN_CELL_INVALID;
+    return cell;
+}
+
+static vscreen_cell *vscreen_line(std::vector<vscreen_cell> &cells, int cols, int row){
+    return cells.data() + size_t(row) * size_t(cols);
+}
+
+/**
+ * @brief                   行尾最后一个非默认空白单元格之后的列
+ */
+static int vscreen_line_end(const vscreen_cell *line, int cols){
+    const vscreen_cell blank = vscreen_blank(vscreen_attr{});
+    while(cols > 0 && line[cols - 1] == blank)
+        cols--;
+    return cols;
+}
+
+static void vscreen_touch(vscreen_t *vs){
+    vs->used_rows = std::max(vs->used_rows, vs->cur_row + 1);
+    vs->dirty = true;
+}
+
+static void vscreen_sgr_color(std::string &out, uint32_t color, int base, int bright, int ext){
+    uint32_t value = color & 0xffffff;
+    if(color & VSCREEN_COLOR_INDEX){
+        if(value < 8){
+            out += ';' + std::to_string(base + int(value));
+        }else if(value < 16){
+            out += ';' + std::to_string(bright + int(value) - 8);
+        }else{
+            out += ';' + std::to_string(ext) + ";5;" + std::to_string(value);
+        }
+    }else if(color & VSCREEN_COLOR_RGB){
+        out += ';' + std::to_string(ext) + ";2;" + std::to_string(value >> 16) + ';' +
+            std::to_string((value >> 8) & 0xff) + ';' + std::to_string(value & 0xff);
+    }
+}
+
+static void vscreen_sgr(std::string &out, const vscreen_attr &attr){
+    static const char *codes[8] = {"1", "2", "3", "4", "5", "7", "8", "9"};
+    out += "\x1b[0";
+    for(int i = 0; i < 8; i++){
+        if(attr.flags & (1 << i)){
+            out += ';';
+            out += codes[i];
+        }
+    }
+    vscreen_sgr_color(out, attr.fg, 30, 90, 38);
+    vscreen_sgr_color(out, attr.bg, 40, 100, 48);
+    out += 'm';
+}
+
+/**
+ * @brief                   输出 [c0, c1) 的单元格，属性变化时插入 SGR
+ * @param  cur              主机终端当前的属性
+ */
+static void vscreen_emit_cells(std::string &out, const vscreen_cell *line, int c0, int c1, vscreen_attr &cur){
+    for(int c = c0; c < c1; c++){
+        if(line[c].width == 0)
+            continue;
+        if(line[c].attr != cur){
+            vscreen_sgr(out, line[c].attr);
+            cur = line[c].attr;
+        }
+        out.append(line[c].ch, line[c].len);
+    }
+}
+
+/**
+ * @brief                   擦除 [c0, c1)，被擦除一半的宽字符整体擦除
+ */
+static void vscreen_erase(vscreen_t *vs, int row, int c0, int c1){
+    vscreen_cell *line = vscreen_line(vs->back, vs->cols, row);
+    vscreen_cell blank = vscreen_blank(vs->attr);
+    c0 = std::max(c0, 0);
+    c1 = std::min(c1, vs->cols);
+    if(c0 >= c1)
+        return;
+    if(c0 > 0 && line[c0].width == 0)
+        line[c0 - 1] = blank;
+    if(c1 < vs->cols && line[c1].width == 0)
+        line[c1] = blank;
+    std::fill(line + c0, line + c1, blank);
+    vs->dirty = true;
+}
+
+/**
+ * @brief                   区域顶部的行滚出，保存为带 SGR 的文本，下一帧输出到主机终端
+ */
+static void vscreen_scroll_up(vscreen_t *vs){
+    vscreen_cell *line = vscreen_line(vs->back, vs->cols, 0);
+    vscreen_attr cur = {};
+    vs->committed += "\x1b[K";
+    vscreen_emit_cells(vs->committed, line, 0, vscreen_line_end(line, vs->cols), cur);
+    if(cur != vscreen_attr{})
+        vs->committed += "\x1b[0m";
+    vs->committed += "\r\n";
+    vs->committed_lines++;
+
+    std::copy(vs->back.begin() + vs->cols, vs->back.end(), vs->back.begin());
+    std::fill(vs->back.end() - vs->cols, vs->back.end(), vscreen_blank(vs->attr));
+    vs->dirty = true;
+}
+
+static void vscreen_linefeed(vscreen_t *vs){
+    if(vs->cur_row + 1 >= vs->rows){
+        vscreen_scroll_up(vs);
+    }else{
+        vs->cur_row++;
+    }
+    vs->wrap_pending = false;
+    vscreen_touch(vs);
+}
+
+static void vscreen_put(vscreen_t *vs, const char *ch, uint8_t len, int width){
+    /* 零宽字符不占单元格，直接丢弃 */
+    if(width == 0 || width > vs->cols)
+        return;
+    if(vs->wrap_pending || vs->cur_col + width > vs->cols){
+        vs->cur_col = 0;
+        vscreen_linefeed(vs);
+    }
+    vscreen_cell *line = vscreen_line(vs->back, vs->cols, vs->cur_row);
+    int col = vs->cur_col;
+    int last = col + width - 1;
+    /* 覆盖宽字符的一半时另一半变为空白 */
+    if(line[col].width == 0 && col > 0)
+        line[col - 1] = vscreen_blank(vs->attr);
+    if(line[last].width == 2 && last + 1 < vs->cols)
+        line[last + 1] = vscreen_blank(vs->attr);
+
+    vscreen_cell &cell = line[col];
+    std::memcpy(cell.ch, ch, len);
+    cell.len = len;
+    cell.width = uint8_t(width);
+    cell.attr = vs->attr;
+    if(width == 2){
+        line[col + 1] = vscreen_cell{};
+        line[col + 1].attr = vs->attr;
+    }
+
+    col += width;
+    if(col >= vs->cols){
+        vs->cur_col = vs->cols - 1;
+        vs->wrap_pending = true;
+    }else{
+        vs->cur_col = col;
+    }
+    vscreen_touch(vs);
+}
+
+static void vscreen_put_utf8(vscreen_t *vs){
+    const uint8_t *b = reinterpret_cast<const uint8_t*>(vs->utf8);
+    uint32_t cp;
+    if(vs->utf8_len == 2){
+        cp = uint32_t(b[0] & 0x1f) << 6 | uint32_t(b[1] & 0x3f);
+    }else if(vs->utf8_len == 3){
+        cp = uint32_t(b[0] & 0x0f) << 12 | uint32_t(b[1] & 0x3f) << 6 | uint32_t(b[2] & 0x3f);
+    }else{
+        cp = uint32_t(b[0] & 0x07) << 18 | uint32_t(b[1] & 0x3f) << 12 | uint32_t(b[2] & 0x3f) << 6 | uint32_t(b[3] & 0x3f);
+    }
+    vscreen_put(vs, vs->utf8, vs->utf8_len, vscreen_char_width(cp));
+}
+
+static void vscreen_print(void *ctx, const char *data, size_t len){
+    vscreen_t *vs = static_cast<vscreen_t*>(ctx);
+    for(size_t i = 0; i < len; i++){
+        uint8_t b = uint8_t(data[i]);
+        if(vs->utf8_need){
+            if((b & 0xc0) == 0x80){
+                vs->utf8[vs->utf8_len++] = char(b);
+                if(vs->utf8_len == vs->utf8_need){
+                    vscreen_put_utf8(vs);
+                    vs->utf8_need = 0;
+                }
+                continue;
+            }
+            /* 不完整的多字节字符 */
+            vscreen_put(vs, "\xef\xbf\xbd", 3, 1);
+            vs->utf8_need = 0;
+        }
+        if(b < 0x80){
+            vscreen_put(vs, &data[i], 1, 1);
+            continue;
+        }
+        uint8_t need = b >= 0xf0 && b < 0xf5 ? 4 : b >= 0xe0 && b < 0xf0 ? 3 : b >= 0xc2 && b < 0xe0 ? 2 : 0;
+        if(!need){
+            vscreen_put(vs, "\xef\xbf\xbd", 3, 1);
+            continue;
+        }
+        vs->utf8[0] = char(b);
+        vs->utf8_len = 1;
+        vs->utf8_need = need;
+    }
+}
+
+static void vscreen_execute(void *ctx, uint8_t c){
+    vscreen_t *vs = static_cast<vscreen_t*>(ctx);
+    switch(c){
+        case 0x07:
+            vs->passthrough += char(c);
+            vs->dirty = true;
+            break;
+        case 0x08:
+            if(vs->wrap_pending){
+                vs->wrap_pending = false;
+            }else if(vs->cur_col > 0){
+                vs->cur_col--;
+            }
+            vs->dirty = true;
+            break;
+        case 0x09:
+            vs->cur_col = std::min(vs->cols - 1, (vs->cur_col / VSCREEN_TAB_WIDTH + 1) * VSCREEN_TAB_WIDTH);
+            vs->wrap_pending = false;
+            vs->dirty = true;
+            break;
+        case 0x0a:
+        case 0x0b:
+        case 0x0c:
+            /* 主机终端保留了输出处理(OPOST)，换行同时回到行首 */
+            vs->cur_col = 0;
+            vscreen_linefeed(vs);
+            break;
+        case 0x0d:
+            vs->cur_col = 0;
+            vs->wrap_pending = false;
+            vs->dirty = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void vscreen_passthrough(vscreen_t *vs, const struct vt_sequence *seq){
+    vs->passthrough.append(seq->data, seq->len);
+    vs->dirty = true;
+}
+
+static int vscreen_param(const struct vt_sequence *seq, int index, int def){
+    if(index >= seq->param_num || seq->params[index] == 0)
+        return def;
+    return seq->params[index];
+}
+
+static uint32_t vscreen_sgr_ext_color(const struct vt_sequence *seq, int &i){
+    if(i + 2 < seq->param_num && seq->params[i + 1] == 5){
+        i += 2;
+        return VSCREEN_COLOR_INDEX | (seq->params[i] & 0xffu);
+    }
+    if(i + 4 < seq->param_num && seq->params[i + 1] == 2){
+        i += 4;
+        return VSCREEN_COLOR_RGB | uint32_t(seq->params[i - 2] & 0xff) << 16 |
+            uint32_t(seq->params[i - 1] & 0xff) << 8 | uint32_t(seq->params[i] & 0xff);
+    }
+    i = seq->param_num;
+    return VSCREEN_COLOR_DEFAULT;
+}
+
+static void vscreen_sgr_apply(vscreen_t *vs, const struct vt_sequence *seq){
+    static const uint8_t flag_on[10] = {0, VSCREEN_ATTR_BOLD, VSCREEN_ATTR_DIM, VSCREEN_ATTR_ITALIC,
+        VSCREEN_ATTR_UNDERLINE, VSCREEN_ATTR_BLINK, 0, VSCREEN_ATTR_REVERSE, VSCREEN_ATTR_HIDDEN, VSCREEN_ATTR_STRIKE};
+    vscreen_attr &attr = vs->attr;
+    if(seq->param_num == 0){
+        attr = vscreen_attr{};
+        return;
+    }
+    for(int i = 0; i < seq->param_num; i++){
+        int p = seq->params[i];
+        if(p == 0){
+            attr = vscreen_attr{};
+        }else if(p < 10){
+            attr.flags |= flag_on[p];
+        }else if(p == 22){
+            attr.flags &= uint8_t(~(VSCREEN_ATTR_BOLD | VSCREEN_ATTR_DIM));
+        }else if(p >= 23 && p <= 29 && p != 26){
+            attr.flags &= uint8_t(~flag_on[p - 20]);
+        }else if(p >= 30 && p <= 37){
+            attr.fg = VSCREEN_COLOR_INDEX | uint32_t(p - 30);
+        }else if(p == 38){
+            attr.fg = vscreen_sgr_ext_color(seq, i);
+        }else if(p == 39){
+            attr.fg = VSCREEN_COLOR_DEFAULT;
+        }else if(p >= 40 && p <= 47){
+            attr.bg = VSCREEN_COLOR_INDEX | uint32_t(p - 40);
+        }else if(p == 48){
+            attr.bg = vscreen_sgr_ext_color(seq, i);
+        }else if(p == 49){
+            attr.bg = VSCREEN_COLOR_DEFAULT;
+        }else if(p >= 90 && p <= 97){
+            attr.fg = VSCREEN_COLOR_INDEX | uint32_t(p - 90 + 8);
+        }else if(p >= 100 && p <= 107){
+            attr.bg = VSCREEN_COLOR_INDEX | uint32_t(p - 100 + 8);
+        }
+    }
+}
+
+static void vscreen_erase_display(vscreen_t *vs, int mode){
+    int first = 0;
+    int last = vs->rows;
+    if(mode == 0){
+        vscreen_erase(vs, vs->cur_row, vs->cur_col, vs->cols);
+        first = vs->cur_row + 1;
+    }else if(mode == 1){
+        vscreen_erase(vs, vs->cur_row, 0, vs->cur_col + 1);
+        last = vs->cur_row;
+    }
+    for(int row = first; row < last; row++)
+        vscreen_erase(vs, row, 0, vs->cols);
+}
+
+static void vscreen_private_mode(vscreen_t *vs, const struct vt_sequence *seq){
+    if(seq->final != 'h' && seq->final != 'l'){
+        vscreen_passthrough(vs, seq);
+        return;
+    }
+    for(int i = 0; i < seq->param_num; i++){
+        switch(seq->params[i]){
+            case 25:
+                vs->cursor_visible = seq->final == 'h';
+                vs->dirty = true;
+                break;
+            case 47:
+            case 1047:
+            case 1049:
+                /* 备用屏幕会离开当前区域，不支持 */
+                break;
+            default:
+                vscreen_passthrough(vs, seq);
+                return;
+        }
+    }
+}
+
+static void vscreen_csi(void *ctx, const struct vt_sequence *seq){
+    vscreen_t *vs = static_cast<vscreen_t*>(ctx);
+    int n = vscreen_param(seq, 0, 1);
+    vscreen_cell *line = vscreen_line(vs->back, vs->cols, vs->cur_row);
+
+    if(seq->private_marker == '?' && seq->intermediate_num == 0){
+        vscreen_private_mode(vs, seq);
+        return;
+    }
+    if(seq->private_marker || seq->intermediate_num){
+        vscreen_passthrough(vs, seq);
+        return;
+    }
+    if(seq->final == 'm'){
+        vscreen_sgr_apply(vs, seq);
+        return;
+    }
+
+    switch(seq->final){
+        case 'A':
+            vs->cur_row = std::max(0, vs->cur_row - n);
+            break;
+        case 'B':
+            vs->cur_row = std::min(vs->rows - 1, vs->cur_row + n);
+            break;
+        case 'C':
+            vs->cur_col = std::min(vs->cols - 1, vs->cur_col + n);
+            break;
+        case 'D':
+            vs->cur_col = std::max(0, vs->cur_col - n);
+            break;
+        case 'E':
+            vs->cur_row = std::min(vs->rows - 1, vs->cur_row + n);
+            vs->cur_col = 0;
+            break;
+        case 'F':
+            vs->cur_row = std::max(0, vs->cur_row - n);
+            vs->cur_col = 0;
+            break;
+        case 'G':
+        case '`':
+            vs->cur_col = std::min(vs->cols, n) - 1;
+            break;
+        case 'd':
+            vs->cur_row = std::min(vs->rows, n) - 1;
+            break;
+        case 'H':
+        case 'f':
+            vs->cur_row = std::min(vs->rows, n) - 1;
+            vs->cur_col = std::min(vs->cols, vscreen_param(seq, 1, 1)) - 1;
+            break;
+        case 'J':
+            vscreen_erase_display(vs, vscreen_param(seq, 0, 0));
+            break;
+        case 'K':{
+            int mode = vscreen_param(seq, 0, 0);
+            vscreen_erase(vs, vs->cur_row, mode == 0 ? vs->cur_col : 0, mode == 1 ? vs->cur_col + 1 : vs->cols);
+            break;
+        }
+        case 'X':
+            vscreen_erase(vs, vs->cur_row, vs->cur_col, vs->cur_col + n);
+            break;
+        case 'P':
+            n = std::min(n, vs->cols - vs->cur_col);
+            std::copy(line + vs->cur_col + n, line + vs->cols, line + vs->cur_col);
+            std::fill(line + vs->cols - n, line + vs->cols, vscreen_blank(vs->attr));
+            break;
+        case '@':
+            n = std::min(n, vs->cols - vs->cur_col);
+            std::copy_backward(line + vs->cur_col, line + vs->cols - n, line + vs->cols);
+            std::fill(line + vs->cur_col, line + vs->cur_col + n, vscreen_blank(vs->attr));
+            break;
+        case 's':
+            vs->saved_row = vs->cur_row;
+            vs->saved_col = vs->cur_col;
+            vs->saved_attr = vs->attr;
+            break;
+        case 'u':
+            vs->cur_row = vs->saved_row;
+            vs->cur_col = vs->saved_col;
+            vs->attr = vs->saved_attr;
+            break;
+        case 'r':
+        case 'S':
+        case 'T':
+            /* 滚动区域与区域滚动不在模型中，丢弃 */
+            return;
+        default:
+            vscreen_passthrough(vs, seq);
+            return;
+    }
+    vs->wrap_pending = false;
+    vscreen_touch(vs);
+}
+
+static void vscreen_esc(void *ctx, const struct vt_sequence *seq){
+    vscreen_t *vs = static_cast<vscreen_t*>(ctx);
+    if(seq->intermediate_num){
+        vscreen_passthrough(vs, seq);
+        return;
+    }
+    switch(seq->final){
+        case '7':
+            vs->saved_row = vs->cur_row;
+            vs->saved_col = vs->cur_col;
+            vs->saved_attr = vs->attr;
+            break;
+        case '8':
+            vs->cur_row = vs->saved_row;
+            vs->cur_col = vs->saved_col;
+            vs->attr = vs->saved_attr;
+            break;
+        case 'D':
+            vscreen_linefeed(vs);
+            break;
+        case 'E':
+            vs->cur_col = 0;
+            vscreen_linefeed(vs);
+            break;
+        case 'M':
+            vs->cur_row = std::max(0, vs->cur_row - 1);
+            break;
+        case 'c':
+            vs->attr = vscreen_attr{};
+            vscreen_erase_display(vs, 2);
+            vs->cur_row = 0;
+            vs->cur_col = 0;
+            break;
+        default:
+            vscreen_passthrough(vs, seq);
+            return;
+    }
+    vs->wrap_pending = false;
+    vscreen_touch(vs);
+}
+
+static void vscreen_string(void *ctx, const struct vt_sequence *seq){
+    vscreen_passthrough(static_cast<vscreen_t*>(ctx), seq);
+}
+
+static const struct vt_parser_callbacks s_vscreen_callbacks = {
+    vscreen_print,
+    vscreen_execute,
+    vscreen_esc,
+    vscreen_csi,
+    vscreen_string,
+};
+
+/**
+ * @brief                   移动主机光标到区域的 row 行，超出已有行时用换行创建新行
+ * @param  host_row         主机光标当前所在的区域行
+ * @param  existing         主机终端上区域已有的行数
+ */
+static void vscreen_move_row(std::string &out, int &host_row, int row, int &existing){
+    if(row < host_row){
+        out += "\x1b[" + std::to_string(host_row - row) + "A";
+    }else if(row > host_row){
+        int reach = std::min(row, existing - 1);
+        if(reach > host_row)
+            out += "\x1b[" + std::to_string(reach - host_row) + "B";
+        for(int r = std::max(reach, host_row); r < row; r++)
+            out += "\r\n";
+        existing = std::max(existing, row + 1);
+    }
+    host_row = row;
+}
+
+extern "C"{
+
+vscreen_t *vscreen_create(int rows, int cols){
+    if(rows < 1 || cols < 1)
+        return nullptr;
+    vscreen_t *vs = new vscreen_t();
+    vs->rows = rows;
+    vs->cols = cols;
+    vs->back.assign(size_t(rows) * size_t(cols), vscreen_blank(vscreen_attr{}));
+    vs->front = vs->back;
+    vs->used_rows = 1;
+    vs->cursor_visible = true;
+    vs->parser = vt_parser_create(&s_vscreen_callbacks, vs);
+    return vs;
+}
+
+void vscreen_destroy(vscreen_t *vs){
+    if(!vs)
+        return;
+    vt_parser_destroy(vs->parser);
+    delete vs;
+}
+
+void vscreen_write(vscreen_t *vs, const char *data, size_t len){
+    vt_parser_feed(vs->parser, data, len);
+}
+
+void vscreen_resize(vscreen_t *vs, int rows, int cols){
+    if(rows < 1 || cols < 1 || (rows == vs->rows && cols == vs->cols))
+        return;
+    /* 行数减少时，光标之上的行先滚出 */
+    while(vs->cur_row >= rows){
+        vscreen_scroll_up(vs);
+        vs->cur_row--;
+        vs->used_rows--;
+    }
+    std::vector<vscreen_cell> back(size_t(rows) * size_t(cols), vscreen_blank(vscreen_attr{}));
+    int copy_rows = std::min(rows, vs->rows);
+    int copy_cols = std::min(cols, vs->cols);
+    for(int row = 0; row < copy_rows; row++){
+        vscreen_cell *src = vscreen_line(vs->back, vs->cols, row);
+        vscreen_cell *dst = vscreen_line(back, cols, row);
+        std::copy(src, src + copy_cols, dst);
+        if(dst[copy_cols - 1].width == 2)
+            dst[copy_cols - 1] = vscreen_blank(vscreen_attr{});
+    }
+    vs->back.swap(back);
+    /* 主机终端改变大小后会重新排版，内容未知，整屏重绘 */
+    vs->front.assign(size_t(rows) * size_t(cols), vscreen_invalid());
+    vs->rows = rows;
+    vs->cols = cols;
+    vs->used_rows = std::min(vs->used_rows, rows);
+    vs->front_rows = std::min(vs->front_rows, rows);
+    vs->front_cur_row = std::min(vs->front_cur_row, rows - 1);
+    vs->cur_col = std::min(vs->cur_col, cols - 1);
+    vs->saved_row = std::min(vs->saved_row, rows - 1);
+    vs->saved_col = std::min(vs->saved_col, cols - 1);
+    vs->wrap_pending = false;
+    vs->dirty = true;
+}
+
+void vscreen_set_origin(vscreen_t *vs, int row, int col){
+    vs->origin_row = std::max(row, 0);
+    vs->origin_col = std::max(col, 1);
+    vscreen_invalidate(vs);
+}
+
+void vscreen_invalidate(vscreen_t *vs){
+    vs->front.assign(size_t(vs->rows) * size_t(vs->cols), vscreen_invalid());
+    vs->dirty = true;
+}
+
+int vscreen_dirty(const vscreen_t *vs){
+    return vs->dirty ? 1 : 0;
+}
+
+void vscreen_render(vscreen_t *vs, void (*out)(void *ctx, const char *data, size_t len), void *ctx){
+    std::string &buf = vs->render_buf;
+    vscreen_attr cur = {};
+    int cols = vs->cols;
+
+    buf.clear();
+    /* 固定区域与其它区域共用屏幕，标题、模式等序列会影响整个屏幕，丢弃 */
+    if(!vs->origin_row)
+        buf += vs->passthrough;
+    vs->passthrough.clear();
+    if(vs->cursor_visible)
+        buf += "\x1b[?25l";
+
+    int host_row = 0;
+    int existing = vs->rows;
+    int last_row = vs->rows;
+    if(vs->origin_row){
+        /* 固定区域的主机屏幕不随之滚动，滚出的行直接丢弃，由逐格比较重绘 */
+        vs->committed.clear();
+        vs->committed_lines = 0;
+    }else{
+        /* 回到区域顶部，滚出的行覆盖顶部的行后换行，主机终端随之滚动，这些行进入回滚历史 */
+        if(vs->front_cur_row > 0)
+            buf += "\x1b[" + std::to_string(vs->front_cur_row) + "A";
+        buf += '\r';
+        buf += vs->committed;
+        /* front 随之上移，主机终端上还不存在的行按空白处理 */
+        int shift = int(std::min(vs->committed_lines, size_t(vs->front_rows)));
+        existing = std::max(vs->front_rows - shift, 1);
+        std::copy(vs->front.begin() + shift * cols, vs->front.end(), vs->front.begin());
+        std::fill(vs->front.begin() + existing * cols, vs->front.end(), vscreen_blank(vscreen_attr{}));
+        if(vs->committed_lines >= size_t(vs->front_rows))
+            std::fill(vs->front.begin(), vs->front.begin() + cols, vscreen_blank(vscreen_attr{}));
+        vs->committed.clear();
+        vs->committed_lines = 0;
+        last_row = vs->used_rows;
+    }
+
+    for(int row = 0; row < last_row; row++){
+        vscreen_cell *back = vscreen_line(vs->back, cols, row);
+        vscreen_cell *front = vscreen_line(vs->front, cols, row);
+        int line_end = vscreen_line_end(back, cols);
+        int col = 0;
+        while(col < cols){
+            if(back[col] == front[col]){
+                col++;
+                continue;
+            }
+            int start = col;
+            int end = col + 1;
+            int same = 0;
+            while(start > 0 && back[start].width == 0)
+                start--;
+            for(int c = col + 1; c < cols && same < VSCREEN_SPAN_GAP; c++){
+                if(back[c] == front[c]){
+                    same++;
+                }else{
+                    same = 0;
+                    end = c + 1;
+                }
+            }
+            while(end < cols && back[end].width == 0)
+                end++;
+
+            if(vs->origin_row){
+                buf += "\x1b[" + std::to_string(vs->origin_row + row) + ";" + std::to_string(vs->origin_col + start) + "H";
+            }else{
+                vscreen_move_row(buf, host_row, row, existing);
+                buf += "\x1b[" + std::to_string(start + 1) + "G";
+            }
+            if(end >= line_end && line_end < cols){
+                /* 剩余部分都是空白，用擦除到行尾代替输出空格，固定区域右侧可能有其它内容，只擦除区域内的列 */
+                vscreen_emit_cells(buf, back, start, std::max(start, line_end), cur);
+                if(cur != vscreen_attr{}){
+                    buf += "\x1b[0m";
+                    cur = vscreen_attr{};
+                }
+                if(vs->origin_row)
+                    buf += "\x1b[" + std::to_string(cols - std::max(start, line_end)) + "X";
+                else
+                    buf += "\x1b[K";
+                break;
+            }
+            vscreen_emit_cells(buf, back, start, end, cur);
+            col = end;
+        }
+        std::copy(back, back + cols, front);
+    }
+
+    if(vs->origin_row){
+        buf += "\x1b[" + std::to_string(vs->origin_row + vs->cur_row) + ";" + std::to_string(vs->origin_col + vs->cur_col) + "H";
+    }else{
+        /* 区域的所有行都要在主机终端上存在，区域占满屏幕时顶部才能与主机屏幕顶部对齐 */
+        if(existing < vs->used_rows)
+            vscreen_move_row(buf, host_row, vs->used_rows - 1, existing);
+        vscreen_move_row(buf, host_row, vs->cur_row, existing);
+        buf += "\x1b[" + std::to_string(vs->cur_col + 1) + "G";
+        vs->front_rows = std::max(existing, vs->used_rows);
+        vs->front_cur_row = vs->cur_row;
+    }
+    if(cur != vscreen_attr{})
+        buf += "\x1b[0m";
+    if(vs->cursor_visible)
+        buf += "\x1b[?25h";
+
+    vs->dirty = false;
+    out(ctx, buf.data(), buf.size());
+}
+
+}
@@ -0,0 +1,397 @@
+/**
+ * @file vt_parser.cpp
+ * @brief 表驱动的 VT500 兼容转义序列解析器
+ *        状态转移表参考 DEC VT500 状态机，每个表项为 (动作 << 4) | 下一状态
+ *        UTF-8 流中 0x80-0x9F 不作为 C1 控制字符，在 GROUND 状态下作为文本输出
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+
+#include "utf8_scan.h"
+#include "vt_parser.h"
+
+enum vt_state{
+    VT_STATE_GROUND = 0,
+    VT_STATE_ESCAPE,
+    VT_STATE_ESCAPE_INTERMEDIATE,
+    VT_STATE_CSI_ENTRY,
+    VT_STATE_CSI_PARAM,
+    VT_STATE_CSI_INTERMEDIATE,
+    VT_STATE_CSI_IGNORE,
+    VT_STATE_STRING,                    // OSC/DCS/SOS/PM/APC，只需要找到结束位置
+    VT_STATE_NUM,
+};
+
+enum vt_action{
+    VT_ACTION_NONE = 0,
+    VT_ACTION_PRINT,
+    VT_ACTION_EXECUTE,
+    VT_ACTION_CLEAR,                    // 新序列开始
+    VT_ACTION_COLLECT,
+    VT_ACTION_PRIVATE,
+    VT_ACTION_PARAM,
+    VT_ACTION_ESC_DISPATCH,
+    VT_ACTION_CSI_DISPATCH,
+    VT_ACTION_STRING_START,
+    VT_ACTION_STRING_END,               // BEL 结束字符串
+    VT_ACTION_STRING_END_ESC,           // ESC 结束字符串并开始新序列(ST)
+    VT_ACTION_DROP,                     // 丢弃当前序列
+};
+
+#define VT_ENTRY(action, state)     uint8_t((action) << 4 | (state))
+#define VT_ENTRY_ACTION(entry)      vt_action((entry) >> 4)
+#define VT_ENTRY_STATE(entry)       vt_state((entry) & 0x0f)
+
+struct vt_parser{
+    struct vt_parser_callbacks cb;
+    void *ctx;
+    vt_state state;
+    struct vt_sequence seq;
+    const char *seq_start;              // 当前数据块中序列的起始位置，序列已部分存入内部缓冲区时为NULL
+    const char *seq_rest;               // seq_start 为NULL时，当前数据块中尚未存入缓冲区的序列字节的起始位置
+    size_t seq_buf_len;
+    bool seq_overflow;
+    char seq_buf[VT_PARSER_SEQ_BUF_SIZE];
+    char utf8_carry[4];                 // 数据块结尾不完整的 UTF-8 字符
+    size_t utf8_carry_len;
+    uint64_t invalid_bytes;
+};
+
+class vt_table{
+public:
+    uint8_t entry[VT_STATE_NUM][256];
+
+    vt_table(){
+        for(int s = 0; s < VT_STATE_NUM; s++)
+            set(vt_state(s), 0x00, 0xff, VT_ACTION_NONE, vt_state(s));
+
+        set(VT_STATE_GROUND, 0x00, 0x1f, VT_ACTION_EXECUTE, VT_STATE_GROUND);
+        set(VT_STATE_GROUND, 0x20, 0xff, VT_ACTION_PRINT, VT_STATE_GROUND);
+        set(VT_STATE_GROUND, 0x7f, 0x7f, VT_ACTION_NONE, VT_STATE_GROUND);
+
+        /* 序列中的 C0 控制字符直接执行 */
+        for(vt_state s : {VT_STATE_ESCAPE, VT_STATE_ESCAPE_INTERMEDIATE, VT_STATE_CSI_ENTRY,
+            VT_STATE_CSI_PARAM, VT_STATE_CSI_INTERMEDIATE, VT_STATE_CSI_IGNORE}){
+            set(s, 0x00, 0x1f, VT_ACTION_EXECUTE, s);
+        }
+
+        set(VT_STATE_ESCAPE, 0x20, 0x2f, VT_ACTION_COLLECT, VT_STATE_ESCAPE_INTERMEDIATE);
+        set(VT_STATE_ESCAPE, 0x30, 0x7e, VT_ACTION_ESC_DISPATCH, VT_STATE_GROUND);
+        set(VT_STATE_ESCAPE, '[', '[', VT_ACTION_NONE, VT_STATE_CSI_ENTRY);
+        for(uint8_t c : {uint8_t('P'), uint8_t('X'), uint8_t(']'), uint8_t('^'), uint8_t('_')})
+            set(VT_STATE_ESCAPE, c, c, VT_ACTION_STRING_START, VT_STATE_STRING);
+
+        set(VT_STATE_ESCAPE_INTERMEDIATE, 0x20, 0x2f, VT_ACTION_COLLECT, VT_STATE_ESCAPE_INTERMEDIATE);
+        set(VT_STATE_ESCAPE_INTERMEDIATE, 0x30, 0x7e, VT_ACTION_ESC_DISPATCH, VT_STATE_GROUND);
+
+        set(VT_STATE_CSI_ENTRY, 0x20, 0x2f, VT_ACTION_COLLECT, VT_STATE_CSI_INTERMEDIATE);
+        set(VT_STATE_CSI_ENTRY, 0x30, 0x3b, VT_ACTION_PARAM, VT_STATE_CSI_PARAM);
+        set(VT_STATE_CSI_ENTRY, 0x3c, 0x3f, VT_ACTION_PRIVATE, VT_STATE_CSI_PARAM);
+        set(VT_STATE_CSI_ENTRY, 0x40, 0x7e, VT_ACTION_CSI_DISPATCH, VT_STATE_GROUND);
+
+        set(VT_STATE_CSI_PARAM, 0x20, 0x2f, VT_ACTION_COLLECT, VT_STATE_CSI_INTERMEDIATE);
+        set(VT_STATE_CSI_PARAM, 0x30, 0x3b, VT_ACTION_PARAM, VT_STATE_CSI_PARAM);
+        set(VT_STATE_CSI_PARAM, 0x3c, 0x3f, VT_ACTION_NONE, VT_STATE_CSI_IGNORE);
+        set(VT_STATE_CSI_PARAM, 0x40, 0x7e, VT_ACTION_CSI_DISPATCH, VT_STATE_GROUND);
+
+        set(VT_STATE_CSI_INTERMEDIATE, 0x20, 0x2f, VT_ACTION_COLLECT, VT_STATE_CSI_INTERMEDIATE);
+        set(VT_STATE_CSI_INTERMEDIATE, 0x30, 0x3f, VT_ACTION_NONE, VT_STATE_CSI_IGNORE);
+        set(VT_STATE_CSI_INTERMEDIATE, 0x40, 0x7e, VT_ACTION_CSI_DISPATCH, VT_STATE_GROUND);
+
+        set(VT_STATE_CSI_IGNORE, 0x40, 0x7e, VT_ACTION_DROP, VT_STATE_GROUND);
+
+        set(VT_STATE_STRING, 0x07, 0x07, VT_ACTION_STRING_END, VT_STATE_GROUND);
+
+        /* 任意状态: CAN/SUB 取消序列，ESC 开始新序列 */
+        for(int s = 0; s < VT_STATE_NUM; s++){
+            set(vt_state(s), 0x18, 0x18, VT_ACTION_EXECUTE, VT_STATE_GROUND);
+            set(vt_state(s), 0x1a, 0x1a, VT_ACTION_EXECUTE, VT_STATE_GROUND);
+            set(vt_state(s), 0x1b, 0x1b, VT_ACTION_CLEAR, VT_STATE_ESCAPE);
+        }
+        set(VT_STATE_STRING, 0x1b, 0x1b, VT_ACTION_STRING_END_ESC, VT_STATE_ESCAPE);
+    }
+
+private:
+    void set(vt_state state, uint8_t first, uint8_t last, vt_action action, vt_state next){
+        for(int c = first; c <= last; c++)
+            entry[state][c] = VT_ENTRY(action, next);
+    }
+};
+
+static const vt_table s_table;
+
+static void vt_seq_clear(vt_parser_t *vt, const char *start){
+    vt->seq.private_marker = 0;
+    vt->seq.intermediate_num = 0;
+    vt->seq.param_num = 0;
+    vt->seq_start = start;
+    vt->seq_buf_len = 0;
+    vt->seq_overflow = false;
+}
+
+static void vt_seq_append(vt_parser_t *vt, const char *data, size_t len){
+    if(vt->seq_buf_len + len > sizeof(vt->seq_buf)){
+        vt->seq_overflow = true;
+        return;
+    }
+    std::memcpy(vt->seq_buf + vt->seq_buf_len, data, len);
+    vt->seq_buf_len += len;
+}
+
+/**
+ * @brief                   将当前数据块中 end 之前的序列字节存入内部缓冲区
+ */
+static void vt_seq_save(vt_parser_t *vt, const char *end){
+    if(vt->seq_start){
+        vt_seq_append(vt, vt->seq_start, size_t(end - vt->seq_start));
+        vt->seq_start = nullptr;
+    }else{
+        vt_seq_append(vt, vt->seq_rest, size_t(end - vt->seq_rest));
+    }
+}
+
+/**
+ * @brief                   序列中执行的 C0 控制字符不属于序列，之前的字节存入内部缓冲区，从下一个字节继续
+ */
+static void vt_seq_skip(vt_parser_t *vt, const char *p){
+    vt_seq_save(vt, p);
+    vt->seq_rest = p + 1;
+}
+
+/**
+ * @brief                   确定序列的范围 [序列开始, end)，序列跨越数据块或包含控制字符时拼接到内部缓冲区
+ * @return bool             false 序列过长已被丢弃
+ */
+static bool vt_seq_finish(vt_parser_t *vt, const char *end){
+    if(vt->seq_start){
+        vt->seq.data = vt->seq_start;
+        vt->seq.len = size_t(end - vt->seq_start);
+        return true;
+    }
+    vt_seq_append(vt, vt->seq_rest, size_t(end - vt->seq_rest));
+    vt->seq.data = vt->seq_buf;
+    vt->seq.len = vt->seq_buf_len;
+    return !vt->seq_overflow;
+}
+
+static void vt_param(vt_parser_t *vt, uint8_t c){
+    struct vt_sequence &seq = vt->seq;
+    if(seq.param_num == 0){
+        seq.param_num = 1;
+        seq.params[0] = 0;
+    }
+    if(c == ';' || c == ':'){
+        if(seq.param_num < VT_PARSER_MAX_PARAMS){
+            seq.params[seq.param_num] = 0;
+            seq.param_num++;
+        }
+        return;
+    }
+    uint32_t value = uint32_t(seq.params[seq.param_num - 1]) * 10 + uint32_t(c - '0');
+    seq.params[seq.param_num - 1] = uint16_t(value > 0xffff ? 0xffff : value);
+}
+
+#define VT_UTF8_REPLACEMENT         "\xef\xbf\xbd"     // U+FFFD
+
+static void vt_print(vt_parser_t *vt, const char *data, size_t len){
+    if(len && vt->cb.print)
+        vt->cb.print(vt->ctx, data, len);
+}
+
+static void vt_print_invalid(vt_parser_t *vt, size_t len){
+    vt->invalid_bytes += len;
+    vt_print(vt, VT_UTF8_REPLACEMENT, sizeof(VT_UTF8_REPLACEMENT) - 1);
+}
+
+/**
+ * @brief                   用新数据补全上一个数据块结尾不完整的字符
+ * @return const char*      处理后的位置
+ */
+static const char *vt_utf8_complete(vt_parser_t *vt, const char *p, const char *end){
+    while(vt->utf8_carry_len && p < end){
+        char buf[4];
+        size_t take = std::min(sizeof(buf) - vt->utf8_carry_len, size_t(end - p));
+        size_t len = vt->utf8_carry_len + take;
+        std::memcpy(buf, vt->utf8_carry, vt->utf8_carry_len);
+        std::memcpy(buf + vt->utf8_carry_len, p, take);
+        int ret = utf8_sequence_check(buf, len);
+        if(ret > 0){
+            vt_print(vt, buf, size_t(ret));
+            p += size_t(ret) - vt->utf8_carry_len;
+            vt->utf8_carry_len = 0;
+        }else if(ret == 0){
+            std::memcpy(vt->utf8_carry + vt->utf8_carry_len, p, take);
+            vt->utf8_carry_len += take;
+            p += take;
+        }else if(size_t(-ret) >= vt->utf8_carry_len){
+            vt_print_invalid(vt, size_t(-ret));
+            p += size_t(-ret) - vt->utf8_carry_len;
+            vt->utf8_carry_len = 0;
+        }else{
+            /* 非法部分都在保存的字节中，剩下的字节重新校验 */
+            vt_print_invalid(vt, size_t(-ret));
+            vt->utf8_carry_len -= size_t(-ret);
+            std::memmove(vt->utf8_carry, vt->utf8_carry + size_t(-ret), vt->utf8_carry_len);
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief                   输出一段可显示文本，合法的部分以输入范围回调，非法字节替换为 U+FFFD
+ *                          结尾不完整的字符保存到下一个数据块
+ * @return const char*      控制字符的位置或 end
+ */
+static const char *vt_print_text(vt_parser_t *vt, const char *p, const char *end){
+    const char *text = p;
+    const char *scalar_end = p;
+
+    while(p < end){
+        /* 向量扫描停下的位置之后一个块内逐字符处理 */
+        if(p >= scalar_end){
+            p += utf8_scan_text(p, size_t(end - p));
+            scalar_end = p + UTF8_SCAN_BLOCK_SIZE;
+            if(p == end)
+                break;
+        }
+        uint8_t c = uint8_t(*p);
+        if(c < 0x80){
+            if(c < 0x20 || c == 0x7f)
+                break;
+            p++;
+            continue;
+        }
+        int ret = utf8_sequence_check(p, size_t(end - p));
+        if(ret > 0){
+            p += ret;
+            continue;
+        }
+        vt_print(vt, text, size_t(p - text));
+        if(ret == 0){
+            vt->utf8_carry_len = size_t(end - p);
+            std::memcpy(vt->utf8_carry, p, vt->utf8_carry_len);
+            return end;
+        }
+        vt_print_invalid(vt, size_t(-ret));
+        p += -ret;
+        text = p;
+    }
+    vt_print(vt, text, size_t(p - text));
+    return p;
+}
+
+extern "C"{
+
+vt_parser_t *vt_parser_create(const struct vt_parser_callbacks *cb, void *ctx){
+    vt_parser_t *vt = new vt_parser_t;
+    vt->cb = cb ? *cb : vt_parser_callbacks{};
+    vt->ctx = ctx;
+    vt->invalid_bytes = 0;
+    vt_parser_reset(vt);
+    return vt;
+}
+
+void vt_parser_destroy(vt_parser_t *vt){
+    delete vt;
+}
+
+void vt_parser_reset(vt_parser_t *vt){
+    vt->state = VT_STATE_GROUND;
+    vt->seq = vt_sequence{};
+    vt_seq_clear(vt, nullptr);
+    vt->utf8_carry_len = 0;
+}
+
+void vt_parser_feed(vt_parser_t *vt, const char *data, size_t len){
+    const char *p = data;
+    const char *end = data + len;
+
+    vt->seq_rest = data;
+    while(p < end){
+        /* 文本快速路径：一次找出整段可显示字符并校验 UTF-8 */
+        if(vt->state == VT_STATE_GROUND){
+            if(vt->utf8_carry_len){
+                p = vt_utf8_complete(vt, p, end);
+                if(p == end)
+                    break;
+            }
+            p = vt_print_text(vt, p, end);
+            if(p == end)
+                break;
+        }
+
+        uint8_t c = uint8_t(*p);
+        uint8_t entry = s_table.entry[vt->state][c];
+        vt_state next = VT_ENTRY_STATE(entry);
+        switch(VT_ENTRY_ACTION(entry)){
+            case VT_ACTION_NONE:
+                break;
+            case VT_ACTION_PRINT:
+                if(vt->cb.print)
+                    vt->cb.print(vt->ctx, p, 1);
+                break;
+            case VT_ACTION_EXECUTE:
+                if(vt->state != VT_STATE_GROUND && next != VT_STATE_GROUND)
+                    vt_seq_skip(vt, p);
+                if(vt->cb.execute)
+                    vt->cb.execute(vt->ctx, c);
+                break;
+            case VT_ACTION_CLEAR:
+                vt_seq_clear(vt, p);
+                break;
+            case VT_ACTION_COLLECT:
+                if(vt->seq.intermediate_num < VT_PARSER_MAX_INTERMEDIATES)
+                    vt->seq.intermediates[vt->seq.intermediate_num++] = c;
+                break;
+            case VT_ACTION_PRIVATE:
+                vt->seq.private_marker = c;
+                break;
+            case VT_ACTION_PARAM:
+                vt_param(vt, c);
+                break;
+            case VT_ACTION_ESC_DISPATCH:
+                vt->seq.final = c;
+                if(vt_seq_finish(vt, p + 1) && vt->cb.esc_dispatch)
+                    vt->cb.esc_dispatch(vt->ctx, &vt->seq);
+                break;
+            case VT_ACTION_CSI_DISPATCH:
+                vt->seq.final = c;
+                if(vt_seq_finish(vt, p + 1) && vt->cb.csi_dispatch)
+                    vt->cb.csi_dispatch(vt->ctx, &vt->seq);
+                break;
+            case VT_ACTION_STRING_START:
+                vt->seq.final = c;
+                break;
+            case VT_ACTION_STRING_END:
+                if(vt_seq_finish(vt, p + 1) && vt->cb.string_dispatch)
+                    vt->cb.string_dispatch(vt->ctx, &vt->seq);
+                break;
+            case VT_ACTION_STRING_END_ESC:
+                if(vt_seq_finish(vt, p) && vt->cb.string_dispatch)
+                    vt->cb.string_dispatch(vt->ctx, &vt->seq);
+                vt_seq_clear(vt, p);
+                break;
+            case VT_ACTION_DROP:
+                break;
+        }
+        vt->state = next;
+        p++;
+    }
+
+    /* 未完成的序列保存到内部缓冲区，下一个数据块从头开始 */
+    if(vt->state != VT_STATE_GROUND)
+        vt_seq_save(vt, end);
+}
+
+uint64_t vt_parser_invalid_bytes(const vt_parser_t *vt){
+    return vt->invalid_bytes;
+}
+
+}
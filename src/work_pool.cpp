@@ -0,0 +1,138 @@
+/**
+ * @file work_pool.cpp
+ * @brief 任务窃取线程池：每个线程有自己的任务队列，空闲时从其它线程的队列中取任务
+ *        队列各自加锁，提交与取任务不经过全局锁；只有线程休眠和唤醒使用池的锁
+ * @author simon.xiaoapeng (simon.xiaoapeng@gmail.com)
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026  simon.xiaoapeng@gmail.com
+ *
+ */
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "work_pool.h"
+
+struct work_item{
+    void (*fn)(void *arg);
+    void *arg;
+};
+
+struct work_queue{
+    std::mutex mtx;
+    std::deque<work_item> items;
+};
+
+struct work_pool{
+    std::vector<std::unique_ptr<work_queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable cv;             // 有新任务或停止
+    std::condition_variable idle_cv;        // 任务全部完成
+    std::atomic<size_t> queued{0};          // 队列中的任务数
+    std::atomic<size_t> pending{0};         // 已提交未完成的任务数
+    std::atomic<size_t> next{0};            // 下一个任务放入的队列
+    bool stop = false;
+};
+
+static bool work_queue_pop(work_queue *queue, work_item *item){
+    std::lock_guard<std::mutex> lck(queue->mtx);
+    if(queue->items.empty())
+        return false;
+    *item = queue->items.front();
+    queue->items.pop_front();
+    return true;
+}
+
+/**
+ * @brief                   先取自己队列中的任务，没有时依次从其它线程的队列中窃取
+ */
+static bool work_pool_take(work_pool_t *pool, size_t index, work_item *item){
+    size_t num = pool->queues.size();
+    for(size_t i = 0; i < num; i++){
+        if(work_queue_pop(pool->queues[(index + i) % num].get(), item)){
+            pool->queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void work_pool_thread(work_pool_t *pool, size_t index){
+    while(true){
+        work_item item;
+        if(work_pool_take(pool, index, &item)){
+            item.fn(item.arg);
+            if(pool->pending.fetch_sub(1) == 1){
+                std::lock_guard<std::mutex> lck(pool->mtx);
+                pool->idle_cv.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lck(pool->mtx);
+        pool->cv.wait(lck, [pool]{ return pool->stop || pool->queued.load() > 0; });
+        if(pool->stop && pool->queued.load() == 0)
+            return ;
+    }
+}
+
+extern "C"{
+
+work_pool_t *work_pool_create(int threads){
+    if(threads <= 0)
+        threads = int(std::thread::hardware_concurrency());
+    if(threads <= 0)
+        threads = 1;
+    work_pool_t *pool = new work_pool_t;
+    for(int i = 0; i < threads; i++)
+        pool->queues.push_back(std::make_unique<work_queue>());
+    for(int i = 0; i < threads; i++)
+        pool->threads.emplace_back(work_pool_thread, pool, size_t(i));
+    return pool;
+}
+
+void work_pool_destroy(work_pool_t *pool){
+    if(!pool)
+        return ;
+    work_pool_wait(pool);
+    {
+        std::lock_guard<std::mutex> lck(pool->mtx);
+        pool->stop = true;
+    }
+    pool->cv.notify_all();
+    for(auto &t : pool->threads)
+        t.join();
+    delete pool;
+}
+
+int work_pool_threads(const work_pool_t *pool){
+    return int(pool->threads.size());
+}
+
+void work_pool_submit(work_pool_t *pool, void (*fn)(void *arg), void *arg){
+    work_queue *queue = pool->queues[pool->next.fetch_add(1) % pool->queues.size()].get();
+    pool->pending.fetch_add(1);
+    /* 先计数再入队，取任务时的减计数不会先于加计数 */
+    {
+        std::lock_guard<std::mutex> lck(pool->mtx);
+        pool->queued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lck(queue->mtx);
+        queue->items.push_back(work_item{fn, arg});
+    }
+    pool->cv.notify_one();
+}
+
+void work_pool_wait(work_pool_t *pool){
+    std::unique_lock<std::mutex> lck(pool->mtx);
+    pool->idle_cv.wait(lck, [pool]{ return pool->pending.load() == 0; });
+}
+
+}